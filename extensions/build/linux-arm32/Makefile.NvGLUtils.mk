@@ -4,11 +4,20 @@ ProjectName = NvGLUtils
 NvGLUtils_cppfiles   += ./../../src/NvGLUtils/BlockDXT.cpp
 NvGLUtils_cppfiles   += ./../../src/NvGLUtils/ColorBlock.cpp
 NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvFilePtr.cpp
+NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvGLSLPreprocessor.cpp
 NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvGLSLProgram.cpp
+NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvGLSLProgramRegistry.cpp
+NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvGLSLShaderWatcher.cpp
+NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvGPUSort.cpp
+NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvGridIndexBuffer.cpp
 NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvImage.cpp
 NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvImageDDS.cpp
 NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvImageGL.cpp
+NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvMultiDraw.cpp
+NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvProfiler.cpp
+NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvStreamingBuffer.cpp
 NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvTimers.cpp
+NvGLUtils_cppfiles   += ./../../src/NvGLUtils/NvVertexPacking.cpp
 
 NvGLUtils_debug_hpaths    := 
 NvGLUtils_debug_hpaths    += ./../../src/NvGLUtils
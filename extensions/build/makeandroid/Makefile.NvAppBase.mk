@@ -8,9 +8,16 @@ NvAppBase_cppfiles   += ./../../src/NvAppBase/MainLinux.cpp
 NvAppBase_cppfiles   += ./../../src/NvAppBase/MainMacOSX.cpp
 NvAppBase_cppfiles   += ./../../src/NvAppBase/MainWin32.cpp
 NvAppBase_cppfiles   += ./../../src/NvAppBase/NvAppBase.cpp
+NvAppBase_cppfiles   += ./../../src/NvAppBase/NvFixedTimestep.cpp
+NvAppBase_cppfiles   += ./../../src/NvAppBase/NvFrameTimeStats.cpp
 NvAppBase_cppfiles   += ./../../src/NvAppBase/NvFramerateCounter.cpp
+NvAppBase_cppfiles   += ./../../src/NvAppBase/NvIncrementalSort.cpp
 NvAppBase_cppfiles   += ./../../src/NvAppBase/NvInputTransformer.cpp
+NvAppBase_cppfiles   += ./../../src/NvAppBase/NvJobSystem.cpp
 NvAppBase_cppfiles   += ./../../src/NvAppBase/NvLogs.cpp
+NvAppBase_cppfiles   += ./../../src/NvAppBase/NvNoiseVolume.cpp
+NvAppBase_cppfiles   += ./../../src/NvAppBase/NvQualityTuner.cpp
+NvAppBase_cppfiles   += ./../../src/NvAppBase/NvRadixSort.cpp
 NvAppBase_cppfiles   += ./../../src/NvAppBase/NvSampleApp.cpp
 NvAppBase_cfiles   += ./../../src/NvAppBase/NvAndroidNativeAppGlue.c
 
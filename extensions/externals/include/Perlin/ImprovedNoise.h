@@ -3,9 +3,22 @@
     http://mrl.nyu.edu/~perlin/noise/
 */
 
+#ifndef IMPROVED_NOISE_H
+#define IMPROVED_NOISE_H
+
 #include "NV/NvMath.h"
 using namespace nv;
 
+// The batched functions below evaluate 4 points per step with SSE2 or NEON where the compiler targets them,
+// and fall back to the scalar functions otherwise.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define IMPROVED_NOISE_SSE 1
+#elif defined(NV_ARM_NEON) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define IMPROVED_NOISE_NEON 1
+#endif
+
 static int permutation[] = { 151,160,137,91,90,15,
 131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
 190, 6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,
@@ -40,6 +53,85 @@ static float g[][3] = {
     0,-1,-1,
 };
 
+#if defined(IMPROVED_NOISE_SSE)
+typedef __m128 noise_f4;
+typedef __m128i noise_i4;
+
+static inline noise_f4 noise_load(const float* p)               { return _mm_loadu_ps(p); }
+static inline void noise_store(float* p, noise_f4 a)            { _mm_storeu_ps(p, a); }
+static inline noise_f4 noise_set1(float a)                      { return _mm_set1_ps(a); }
+static inline noise_f4 noise_add(noise_f4 a, noise_f4 b)        { return _mm_add_ps(a, b); }
+static inline noise_f4 noise_sub(noise_f4 a, noise_f4 b)        { return _mm_sub_ps(a, b); }
+static inline noise_f4 noise_mul(noise_f4 a, noise_f4 b)        { return _mm_mul_ps(a, b); }
+static inline noise_i4 noise_loadi(const int* p)                { return _mm_loadu_si128((const __m128i*)p); }
+static inline void noise_storei(int* p, noise_i4 a)             { _mm_storeu_si128((__m128i*)p, a); }
+
+// floor, returned both as float and as int
+static inline noise_f4 noise_floor(noise_f4 x, noise_i4& ix)
+{
+    const noise_i4 t = _mm_cvttps_epi32(x);
+    const noise_f4 ft = _mm_cvtepi32_ps(t);
+    const noise_f4 up = _mm_cmpgt_ps(ft, x);                        // truncation went up (negative x)
+    ix = _mm_add_epi32(t, _mm_castps_si128(up));                    // mask is -1
+    return _mm_sub_ps(ft, _mm_and_ps(up, _mm_set1_ps(1.0f)));
+}
+
+// the g[] table of ImprovedNoise::grad as bit logic: u = h<8 ? x : y, v = h<4 ? y : (h==12||h==14) ? x : z,
+// with the signs of u and v from bits 0 and 1
+static inline noise_f4 noise_grad(noise_i4 hash, noise_f4 x, noise_f4 y, noise_f4 z)
+{
+    const noise_i4 h = _mm_and_si128(hash, _mm_set1_epi32(15));
+    const noise_f4 lt8 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8)));
+    const noise_f4 lt4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+    const noise_f4 vx = _mm_castsi128_ps(_mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14))));
+    const noise_f4 u = _mm_or_ps(_mm_and_ps(lt8, x), _mm_andnot_ps(lt8, y));
+    const noise_f4 xz = _mm_or_ps(_mm_and_ps(vx, x), _mm_andnot_ps(vx, z));
+    const noise_f4 v = _mm_or_ps(_mm_and_ps(lt4, y), _mm_andnot_ps(lt4, xz));
+    const noise_f4 su = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+    const noise_f4 sv = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+    return _mm_add_ps(_mm_xor_ps(u, su), _mm_xor_ps(v, sv));
+}
+#elif defined(IMPROVED_NOISE_NEON)
+typedef float32x4_t noise_f4;
+typedef int32x4_t noise_i4;
+
+static inline noise_f4 noise_load(const float* p)               { return vld1q_f32(p); }
+static inline void noise_store(float* p, noise_f4 a)            { vst1q_f32(p, a); }
+static inline noise_f4 noise_set1(float a)                      { return vdupq_n_f32(a); }
+static inline noise_f4 noise_add(noise_f4 a, noise_f4 b)        { return vaddq_f32(a, b); }
+static inline noise_f4 noise_sub(noise_f4 a, noise_f4 b)        { return vsubq_f32(a, b); }
+static inline noise_f4 noise_mul(noise_f4 a, noise_f4 b)        { return vmulq_f32(a, b); }
+static inline noise_i4 noise_loadi(const int* p)                { return vld1q_s32(p); }
+static inline void noise_storei(int* p, noise_i4 a)             { vst1q_s32(p, a); }
+
+static inline noise_f4 noise_floor(noise_f4 x, noise_i4& ix)
+{
+    const noise_i4 t = vcvtq_s32_f32(x);
+    const noise_f4 ft = vcvtq_f32_s32(t);
+    const uint32x4_t up = vcgtq_f32(ft, x);
+    ix = vaddq_s32(t, vreinterpretq_s32_u32(up));
+    return vsubq_f32(ft, vreinterpretq_f32_u32(vandq_u32(up, vreinterpretq_u32_f32(vdupq_n_f32(1.0f)))));
+}
+
+static inline noise_f4 noise_grad(noise_i4 hash, noise_f4 x, noise_f4 y, noise_f4 z)
+{
+    const noise_i4 h = vandq_s32(hash, vdupq_n_s32(15));
+    const uint32x4_t lt8 = vcltq_s32(h, vdupq_n_s32(8));
+    const uint32x4_t lt4 = vcltq_s32(h, vdupq_n_s32(4));
+    const uint32x4_t vx = vorrq_u32(vceqq_s32(h, vdupq_n_s32(12)), vceqq_s32(h, vdupq_n_s32(14)));
+    const noise_f4 u = vbslq_f32(lt8, x, y);
+    const noise_f4 v = vbslq_f32(lt4, y, vbslq_f32(vx, x, z));
+    const uint32x4_t su = vshlq_n_u32(vandq_u32(vreinterpretq_u32_s32(h), vdupq_n_u32(1)), 31);
+    const uint32x4_t sv = vshlq_n_u32(vandq_u32(vreinterpretq_u32_s32(h), vdupq_n_u32(2)), 30);
+    return vaddq_f32(vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(u), su)),
+                     vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(v), sv)));
+}
+#endif
+
+#if defined(IMPROVED_NOISE_SSE) || defined(IMPROVED_NOISE_NEON)
+#define IMPROVED_NOISE_SIMD 1
+#endif
+
 class ImprovedNoise {
 public:
     ImprovedNoise() {
@@ -47,6 +139,19 @@ public:
         for (int i=0; i < 256 ; i++) p[256+i] = p[i] = permutation[i];
     }
 
+    // Ken Perlin's table shuffled by seed, for independent noise fields that are the same on every platform
+    explicit ImprovedNoise(unsigned int seed) {
+        p = new int[512];
+        for (int i=0; i < 256 ; i++) p[i] = permutation[i];
+        unsigned int state = seed;
+        for (int i=255; i > 0; i--) {
+            state = state * 1664525u + 1013904223u;         // Numerical Recipes LCG
+            const int j = (int)((state >> 8) % (unsigned int)(i + 1));
+            const int t = p[i]; p[i] = p[j]; p[j] = t;
+        }
+        for (int i=0; i < 256 ; i++) p[256+i] = p[i];
+    }
+
     ~ImprovedNoise() {
         delete [] p;
     }
@@ -125,6 +230,87 @@ public:
 	    return sum;
     }
 
+    // Batched versions of noise, fBm and fBm3f: n points given as separate x, y and z arrays (z may be NULL
+    // for points on the z=0 plane).  n need not be a multiple of 4.  The SIMD paths do the same operations in
+    // the same order as the scalar functions, so results agree to within float rounding.
+    void noise(const float* x, const float* y, const float* z, float* result, int n)
+    {
+#ifdef IMPROVED_NOISE_SIMD
+        for (int i=0; i < n; i+=4) {
+            float px[4], py[4], pz[4], r[4];
+            const int count = loadPoints(x, y, z, i, n, px, py, pz);
+            noise_store(r, noise4(noise_load(px), noise_load(py), noise_load(pz)));
+            for (int k=0; k < count; k++) result[i+k] = r[k];
+        }
+#else
+        for (int i=0; i < n; i++)
+            result[i] = noise(x[i], y[i], z ? z[i] : 0.0f);
+#endif
+    }
+
+    void fBm(const float* x, const float* y, const float* z, float* result, int n, int octaves = 4, float lacunarity = 2.0, float gain = 0.5)
+    {
+#ifdef IMPROVED_NOISE_SIMD
+        for (int i=0; i < n; i+=4) {
+            float px[4], py[4], pz[4], r[4];
+            const int count = loadPoints(x, y, z, i, n, px, py, pz);
+            const noise_f4 vx = noise_load(px), vy = noise_load(py), vz = noise_load(pz);
+            float freq = 1.0, amp = 0.5;
+            noise_f4 sum = noise_set1(0.0f);
+            for(int o=0; o<octaves; o++) {
+                const noise_f4 f = noise_set1(freq);
+                sum = noise_add(sum, noise_mul(noise4(noise_mul(vx, f), noise_mul(vy, f), noise_mul(vz, f)), noise_set1(amp)));
+                freq *= lacunarity;
+                amp *= gain;
+            }
+            noise_store(r, sum);
+            for (int k=0; k < count; k++) result[i+k] = r[k];
+        }
+#else
+        for (int i=0; i < n; i++)
+            result[i] = fBm(vec3f(x[i], y[i], z ? z[i] : 0.0f), octaves, lacunarity, gain);
+#endif
+    }
+
+    void fBm3f(const float* x, const float* y, const float* z, float* resultX, float* resultY, float* resultZ, int n,
+               int octaves = 4, float lacunarity = 2.0, float gain = 0.5)
+    {
+#ifdef IMPROVED_NOISE_SIMD
+        for (int i=0; i < n; i+=4) {
+            float px[4], py[4], pz[4], rx[4], ry[4], rz[4];
+            const int count = loadPoints(x, y, z, i, n, px, py, pz);
+            const noise_f4 vx = noise_load(px), vy = noise_load(py), vz = noise_load(pz);
+            float freq = 1.0, amp = 0.5;
+            noise_f4 sumX = noise_set1(0.0f), sumY = sumX, sumZ = sumX;
+            for(int o=0; o<octaves; o++) {
+                // noise3f: three noise lookups at offset positions
+                const noise_f4 f = noise_set1(freq), a = noise_set1(amp);
+                const noise_f4 qx = noise_mul(vx, f), qy = noise_mul(vy, f), qz = noise_mul(vz, f);
+                sumX = noise_add(sumX, noise_mul(noise4(qx, qy, qz), a));
+                sumY = noise_add(sumY, noise_mul(noise4(noise_add(qx, noise_set1(32)), noise_add(qy, noise_set1(78)), noise_add(qz, noise_set1(7))), a));
+                sumZ = noise_add(sumZ, noise_mul(noise4(noise_add(qx, noise_set1(123)), noise_add(qy, noise_set1(11)), noise_add(qz, noise_set1(96))), a));
+                freq *= lacunarity;
+                amp *= gain;
+            }
+            noise_store(rx, sumX);
+            noise_store(ry, sumY);
+            noise_store(rz, sumZ);
+            for (int k=0; k < count; k++) {
+                resultX[i+k] = rx[k];
+                resultY[i+k] = ry[k];
+                resultZ[i+k] = rz[k];
+            }
+        }
+#else
+        for (int i=0; i < n; i++) {
+            const vec3f r = fBm3f(vec3f(x[i], y[i], z ? z[i] : 0.0f), octaves, lacunarity, gain);
+            resultX[i] = r.x;
+            resultY[i] = r.y;
+            resultZ[i] = r.z;
+        }
+#endif
+    }
+
    float noise(float x, float y, float z, float w) {
         int X = (int)floor(x) & 255,                  // FIND UNIT HYPERCUBE
             Y = (int)floor(y) & 255,                  // THAT CONTAINS POINT.
@@ -220,4 +406,61 @@ public:
    }
 
    int *p;
+
+private:
+#ifdef IMPROVED_NOISE_SIMD
+   // Copies up to 4 points starting at i into px/py/pz, padding a short tail with zeros.  Returns the count.
+   static inline int loadPoints(const float* x, const float* y, const float* z, int i, int n,
+                                float* px, float* py, float* pz) {
+        const int count = (n - i < 4) ? (n - i) : 4;
+        for (int k=0; k < 4; k++) {
+            const int j = (k < count) ? (i + k) : i;
+            px[k] = x[j];
+            py[k] = y[j];
+            pz[k] = z ? z[j] : 0.0f;
+        }
+        return count;
+   }
+
+   inline noise_f4 fade4(noise_f4 t) {
+        const noise_f4 t3 = noise_mul(noise_mul(t, t), t);
+        return noise_mul(t3, noise_add(noise_mul(t, noise_sub(noise_mul(t, noise_set1(6)), noise_set1(15))), noise_set1(10)));
+   }
+   inline noise_f4 lerp4(noise_f4 t, noise_f4 a, noise_f4 b) { return noise_add(a, noise_mul(t, noise_sub(b, a))); }
+
+   // noise(x, y, z) for 4 points.  The cube corner hashing stays scalar (SSE2 and NEON have no gathers).
+   inline noise_f4 noise4(noise_f4 x, noise_f4 y, noise_f4 z) {
+        noise_i4 ix, iy, iz;
+        x = noise_sub(x, noise_floor(x, ix));
+        y = noise_sub(y, noise_floor(y, iy));
+        z = noise_sub(z, noise_floor(z, iz));
+        int X[4], Y[4], Z[4];
+        noise_storei(X, ix);
+        noise_storei(Y, iy);
+        noise_storei(Z, iz);
+
+        int h[8][4];
+        for (int k=0; k < 4; k++) {
+            const int Xk = X[k] & 255, Yk = Y[k] & 255, Zk = Z[k] & 255;
+            const int A = p[Xk  ]+Yk, AA = p[A]+Zk, AB = p[A+1]+Zk,
+                      B = p[Xk+1]+Yk, BA = p[B]+Zk, BB = p[B+1]+Zk;
+            h[0][k] = p[AA  ]; h[1][k] = p[BA  ]; h[2][k] = p[AB  ]; h[3][k] = p[BB  ];
+            h[4][k] = p[AA+1]; h[5][k] = p[BA+1]; h[6][k] = p[AB+1]; h[7][k] = p[BB+1];
+        }
+
+        const noise_f4 one = noise_set1(1.0f);
+        const noise_f4 x1 = noise_sub(x, one), y1 = noise_sub(y, one), z1 = noise_sub(z, one);
+        const noise_f4 u = fade4(x), v = fade4(y), w = fade4(z);
+        return lerp4(w, lerp4(v, lerp4(u, noise_grad(noise_loadi(h[0]), x , y , z ),
+                                          noise_grad(noise_loadi(h[1]), x1, y , z )),
+                                 lerp4(u, noise_grad(noise_loadi(h[2]), x , y1, z ),
+                                          noise_grad(noise_loadi(h[3]), x1, y1, z ))),
+                        lerp4(v, lerp4(u, noise_grad(noise_loadi(h[4]), x , y , z1),
+                                          noise_grad(noise_loadi(h[5]), x1, y , z1)),
+                                 lerp4(u, noise_grad(noise_loadi(h[6]), x , y1, z1),
+                                          noise_grad(noise_loadi(h[7]), x1, y1, z1))));
+   }
+#endif
 };
+
+#endif
@@ -38,6 +38,9 @@
 
 #include <stdio.h>
 #include "R3/thread.h"
+#if !USE_WIN32_THREADS
+# include <unistd.h>
+#endif
 
 using namespace r3;
 
@@ -95,7 +98,8 @@ namespace r3 {
 	void Thread::WaitForExit()
 	{
 #if USE_WIN32_THREADS
-
+		WaitForSingleObject(threadHandle, INFINITE);
+		CloseHandle(threadHandle);
 #else
 		pthread_join(threadId, NULL);
 #endif
@@ -109,4 +113,16 @@ namespace r3 {
 		mainThreadMutex.Release();
 		return n;
 	}
+
+	int getNumCPUCores()
+	{
+#if USE_WIN32_THREADS
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		int n = (int)info.dwNumberOfProcessors;
+#else
+		int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+		return (n > 0) ? n : 1;
+	}
 }
@@ -199,6 +199,14 @@ public:
     /// \return true on success, false on failure.
     bool writeLogFile(const std::string& path, bool append, const char* fmt, ...);
 
+    /// Write a data file.
+    /// Writes the given contents verbatim to a file alongside the log files
+    /// \param[in] path the partial path and filename (no extension) to write.
+    /// \param[in] extension the filename extension, including the dot, e.g. ".json"
+    /// \param[in] contents the data to be written; the file is replaced
+    /// \return true on success, false on failure.
+    bool writeDataFile(const std::string& path, const char* extension, const std::string& contents);
+
     /// Linker hack.
     /// An empty function that ensures the linker does not strip the framework
     // Function must be called in the concrete app subclass constructor to avoid link issues
@@ -0,0 +1,167 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvFixedTimestep.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_FIXED_TIMESTEP_H
+#define NV_FIXED_TIMESTEP_H
+
+#include <NvFoundation.h>
+#include "NvAppBase/NvJobSystem.h"
+
+/// \file
+/// Fixed-timestep simulation scheduler, decoupled from the frame rate
+
+/// A fixed step entry point
+/// \param[in] data the user pointer passed to #NvFixedTimestep::setStepFunction
+/// \param[in] dt the step length in seconds
+/// \param[in] step the index of this step in the batch started by #NvFixedTimestep::begin
+/// \param[in] steps the number of steps in the batch
+typedef void (*NvFixedStepFunction)(void* data, float dt, int32_t step, int32_t steps);
+
+/// Runs a simulation in fixed steps, however long the frames are.
+/// Each frame, #begin adds the frame time to an accumulator and starts as many
+/// whole steps as it holds (at most a cap, so a slow frame cannot snowball)
+/// as one job; the steps run one after the other on the job system while the
+/// frame renders, and may split themselves further with #NvJobSystem::parallelFor.
+/// #wait, at the start of the next frame, finishes them.
+///
+/// The time left in the accumulator is a fraction of a step, #getAlpha.  Drawing
+/// the state that fraction of the way from the one before the last step to the last
+/// one keeps motion smooth when the frame and step rates differ; the drawn state
+/// lags real time by up to a step.
+///
+/// Given the same frame times (e.g. the fixed 1/60s of test mode) the same steps
+/// are run, so results are reproducible whatever the machine's frame rate.
+class NvFixedTimestep
+{
+public:
+    /// Constructor
+    /// \param[in] stepSeconds the step length
+    /// \param[in] maxSteps the most steps run for one frame; time beyond that is dropped
+    NvFixedTimestep(float stepSeconds = 1.0f / 60.0f, int32_t maxSteps = 4);
+
+    /// Destructor - waits for steps still running
+    ~NvFixedTimestep();
+
+    /// Sets the function run for each step
+    /// \param[in] func the step entry point
+    /// \param[in] data the user pointer passed to func
+    /// \param[in] name the profiler scope name of a batch; must be a string literal or otherwise outlive the scheduler
+    void setStepFunction(NvFixedStepFunction func, void* data, const char* name);
+
+    /// Sets the step length.  Must not be called while steps are running
+    void setStepSeconds(float stepSeconds) { m_stepSeconds = stepSeconds; }
+    /// \return the step length in seconds
+    float getStepSeconds() const { return m_stepSeconds; }
+
+    /// Sets the most steps run for one frame
+    void setMaxSteps(int32_t maxSteps) { m_maxSteps = maxSteps; }
+    /// \return the most steps run for one frame
+    int32_t getMaxSteps() const { return m_maxSteps; }
+
+    /// Adds a frame's time and starts the steps that are due.  Call once per frame,
+    /// the state the steps write must not be touched until the next #wait
+    /// \param[in] frameSeconds the time since the last call
+    /// \param[in] overlap true to run the steps as a job and return at once; false
+    /// to run them on the calling thread before returning
+    /// \return the number of steps started
+    int32_t begin(float frameSeconds, bool overlap = true);
+
+    /// The first half of #begin: adds a frame's time and returns the steps due, so
+    /// that their output can be prepared (e.g. a vertex buffer mapped) before #start.
+    /// Steps not started before the next #advance or #wait are dropped
+    /// \param[in] frameSeconds the time since the last call
+    /// \return the number of steps #start will run
+    int32_t advance(float frameSeconds);
+
+    /// The second half of #begin: starts the steps returned by #advance
+    /// \param[in] overlap as for #begin
+    void start(bool overlap = true);
+
+    /// Waits for the steps started by #begin, running jobs meanwhile.  Returns at
+    /// once if none are running
+    void wait();
+
+    /// \return true between #begin starting steps and #wait
+    bool isRunning() const { return m_batchStarted; }
+
+    /// \return the fraction of a step in the accumulator after the last #begin, in [0, 1);
+    /// where to draw between the states before and after the last step
+    float getAlpha() const { return (float)(m_accumulator / m_stepSeconds); }
+
+    /// Drops the accumulated time.  Must not be called while steps are running
+    void reset() { m_accumulator = 0.0f; }
+
+    ///@{
+    /// Totals for this scheduler
+    uint32_t getStepCount() const { return m_stepCount; }
+    uint32_t getDroppedStepCount() const { return m_droppedSteps; }
+    /// The time spent running steps (not the time #wait blocked), in milliseconds
+    float getStepMs() const { return m_stepMs; }
+    ///@}
+
+    ///@{
+    /// Totals over all schedulers
+    static uint32_t getTotalStepCount() { return ms_totalSteps; }
+    static uint32_t getTotalDroppedStepCount() { return ms_totalDroppedSteps; }
+    static float getTotalStepMs() { return ms_totalStepMs; }
+    ///@}
+
+protected:
+    /// \privatesection
+    NvFixedTimestep(const NvFixedTimestep&);
+    NvFixedTimestep& operator=(const NvFixedTimestep&);
+
+    static void batchJob(void* data);
+    void runBatch();
+
+    NvFixedStepFunction m_func;
+    void* m_data;
+    const char* m_name;
+    float m_stepSeconds;
+    int32_t m_maxSteps;
+    double m_accumulator;
+    int32_t m_batchSteps;
+    bool m_batchStarted;
+    float m_batchMs;
+    NvJobCounter m_counter;
+    uint32_t m_stepCount;
+    uint32_t m_droppedSteps;
+    float m_stepMs;
+
+    static uint32_t ms_totalSteps;
+    static uint32_t ms_totalDroppedSteps;
+    static float ms_totalStepMs;
+};
+
+#endif
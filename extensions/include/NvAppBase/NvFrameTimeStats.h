@@ -0,0 +1,163 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvFrameTimeStats.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_FRAME_TIME_STATS_H
+#define NV_FRAME_TIME_STATS_H
+
+#include <NvFoundation.h>
+#include <string>
+#include <vector>
+
+/// \file
+/// Per-frame timing capture with percentile, histogram and stutter reporting
+
+/// Records the CPU (and optionally GPU) time of every frame in a preallocated
+/// buffer and reports the distribution.  Used by #NvSampleApp in test mode, where
+/// a mean frame rate alone hides hitches.
+class NvFrameTimeStats
+{
+public:
+    /// Distribution of one series of frame times, in milliseconds
+    struct Summary {
+        int32_t count; ///< The number of frames in the series
+        float mean; ///< Mean frame time
+        float min; ///< Fastest frame
+        float median; ///< 50th percentile
+        float p90; ///< 90th percentile
+        float p99; ///< 99th percentile
+        float p999; ///< 99.9th percentile
+        float max; ///< Slowest frame
+    };
+
+    /// Constructor.
+    /// \param[in] capacity the number of frames to preallocate; frames recorded
+    /// beyond this are counted but not stored
+    NvFrameTimeStats(int32_t capacity);
+
+    /// Sets the frame times above which a frame counts as a stutter.
+    /// The defaults are 33.3, 50 and 100ms
+    /// \param[in] thresholdsMs the thresholds in milliseconds
+    void setStutterThresholds(const std::vector<float>& thresholdsMs) { m_stutterThresholds = thresholdsMs; }
+
+    /// Parses a comma-separated list of thresholds such as "20,33.3,50"
+    /// \param[in] list the null-terminated list
+    /// \return true if at least one threshold was parsed
+    bool setStutterThresholds(const char* list);
+
+    /// Records a frame
+    /// \param[in] cpuMs the CPU (wall clock) time of the frame in milliseconds
+    void addFrame(float cpuMs);
+
+    /// Records a GPU time.  GPU results arrive later than the frame they belong to
+    /// and some may be missing, so each is tagged with the frame it measured.
+    /// Must be called in increasing frame order
+    /// \param[in] frame the index of the frame, counting the calls to #addFrame from 0
+    /// \param[in] gpuMs the GPU time of the frame in milliseconds
+    void addGPUFrame(int32_t frame, float gpuMs);
+
+    /// Records a named per-frame counter (e.g. the mean time of a profiler scope)
+    /// to be included in the reports.  Values added under the same name are summed
+    /// \param[in] name the counter name
+    /// \param[in] value the counter value
+    void addCounter(const std::string& name, float value);
+
+    /// Returns the number of frames recorded, including any that did not fit
+    /// \return the frame count
+    int32_t getFrameCount() const { return m_frames; }
+
+    /// Computes the CPU frame time distribution
+    /// \param[out] summary receives the distribution
+    /// \return false if no frames were recorded
+    bool getCPUSummary(Summary& summary) const { return summarize(m_cpuMs, m_cpuCount, summary); }
+
+    /// Computes the GPU frame time distribution
+    /// \param[out] summary receives the distribution
+    /// \return false if no GPU times were recorded
+    bool getGPUSummary(Summary& summary) const { return summarize(m_gpuMs, m_gpuCount, summary); }
+
+    /// Returns the number of CPU frames slower than the given threshold
+    /// \param[in] thresholdMs the threshold in milliseconds
+    /// \return the number of stutter frames
+    int32_t countStutters(float thresholdMs) const;
+
+    /// Formats a human-readable report with percentiles, a histogram and stutter counts
+    /// \param[out] text receives the report
+    void formatReport(std::string& text) const;
+
+    /// Formats the summaries, histogram and stutter counts as JSON
+    /// \param[in] name the test name recorded in the file
+    /// \param[out] text receives the JSON
+    void formatJSON(const std::string& name, std::string& text) const;
+
+    /// Formats every recorded frame as CSV (frame,cpu_ms,gpu_ms).  The GPU column
+    /// is empty for frames whose GPU time was not recorded
+    /// \param[out] text receives the CSV
+    void formatCSV(std::string& text) const;
+
+    /// Reads the CPU and GPU summaries from a file written by #formatJSON
+    /// \param[in] filename the path of the JSON file
+    /// \param[out] cpu receives the CPU summary
+    /// \param[out] gpu receives the GPU summary; its count is zero if the file has none
+    /// \return true if at least the CPU summary was read
+    static bool readBaseline(const char* filename, Summary& cpu, Summary& gpu);
+
+    /// Compares the recorded frames against a baseline.
+    /// The median, p90 and p99 of each series may each be up to
+    /// tolerance slower than the baseline
+    /// \param[in] cpu the baseline CPU summary
+    /// \param[in] gpu the baseline GPU summary; skipped if its count is zero
+    /// \param[in] tolerance the allowed relative regression, e.g. 0.05 for 5%
+    /// \param[out] report receives one line per compared value
+    /// \return true if no value regressed beyond the tolerance
+    bool compareToBaseline(const Summary& cpu, const Summary& gpu, float tolerance, std::string& report) const;
+
+protected:
+    /// \privatesection
+    static bool summarize(const std::vector<float>& samples, int32_t count, Summary& summary);
+    static void appendSummaryJSON(const char* key, const Summary& summary, std::string& text);
+    static bool compareSeries(const char* series, const Summary& current, const Summary& baseline,
+        float tolerance, std::string& report);
+
+    std::vector<float> m_cpuMs;
+    std::vector<float> m_gpuMs;
+    std::vector<int32_t> m_gpuFrames;
+    int32_t m_cpuCount;
+    int32_t m_gpuCount;
+    int32_t m_frames;
+    std::vector<float> m_stutterThresholds;
+    std::vector<std::string> m_counterNames;
+    std::vector<float> m_counterValues;
+};
+
+#endif
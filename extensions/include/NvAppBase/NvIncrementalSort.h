@@ -0,0 +1,159 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvIncrementalSort.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_INCREMENTAL_SORT_H
+#define NV_INCREMENTAL_SORT_H
+
+#include <NvFoundation.h>
+#include "NvAppBase/NvRadixSort.h"
+
+/// \file
+/// Sorting of keys that change little between calls, starting from the last order
+
+/// Sorts the same set of keys call after call (e.g. particle depths, frame after
+/// frame), starting from the permutation of the previous call.
+///
+/// The keys are gathered in the previous order and walked once.  The keys that are
+/// still in order stay where they are.  A key that fell a few places behind (a
+/// particle that crossed its neighbours) is inserted back into place; the others (a
+/// particle that wrapped around) are taken out, sorted on their own and merged back
+/// in.  That costs a gather and a merge when few keys move, instead of three radix
+/// passes.  When more than #getMaxDisorder of the keys would have to be taken out,
+/// or the insertions shift too many keys, the keys are radix sorted from scratch and
+/// the next few sorts do not try to merge.  A change of count is radix sorted too.
+///
+/// Equal keys keep their order from the previous call, rather than the order of
+/// their indices, so ties do not flicker from frame to frame.
+///
+/// A sorter must not be used from two threads at once.  The totals are updated
+/// without synchronization; sort from one thread at a time if they are read.
+class NvIncrementalSort
+{
+public:
+    /// How a sort was done
+    enum Path {
+        PATH_NONE,      ///< Nothing sorted yet
+        PATH_RADIX,     ///< Radix sorted from scratch
+        PATH_SORTED,    ///< The previous order still sorted the keys
+        PATH_MERGE,     ///< Keys out of order were inserted back, or taken out, sorted and merged back
+        PATH_COUNT
+    };
+
+    /// Constructor
+    /// \param[in] maxDisorder the fraction of the keys that may be out of order before
+    /// they are radix sorted from scratch
+    NvIncrementalSort(float maxDisorder = 0.125f);
+    ~NvIncrementalSort();
+
+    /// Sorts keys
+    /// \param[in] keys count keys, indexed as in the previous call; unchanged
+    /// \param[in] count the number of keys
+    /// \param[out] indices count indices, the permutation that sorts the keys
+    void sort(const uint32_t* keys, int32_t count, uint32_t* indices);
+
+    /// Sorts keys into 16 bit indices
+    /// \param[in] keys count keys, indexed as in the previous call; unchanged
+    /// \param[in] count the number of keys, at most 65536
+    /// \param[out] indices count indices, the permutation that sorts the keys
+    void sort(const uint32_t* keys, int32_t count, uint16_t* indices);
+
+    /// Forgets the previous order; the next sort is a radix sort.  Call when the keys
+    /// are no longer those of the previous call (e.g. the particles were respawned)
+    void reset() { m_count = 0; m_skip = 0; m_backoff = 0; }
+
+    /// Sets the fraction of the keys that may be out of order before they are radix sorted
+    void setMaxDisorder(float fraction) { m_maxDisorder = fraction; }
+
+    /// \return the fraction of the keys that may be out of order before they are radix sorted
+    float getMaxDisorder() const { return m_maxDisorder; }
+
+    /// \return how the last sort was done
+    Path getLastPath() const { return m_lastPath; }
+
+    /// \return the number of keys the last sort found out of order and moved into place
+    int32_t getLastMovedCount() const { return m_lastMoved; }
+
+    /// \return the number of keys the last sort shifted to insert keys into place
+    int32_t getLastShiftedCount() const { return m_lastShifted; }
+
+    /// \return the number of sorts by any sorter that took a path
+    static uint32_t getTotalSortCount(Path path) { return ms_totalSorts[path]; }
+
+    /// \return the number of keys moved by the merges of every sorter
+    static uint64_t getTotalMovedCount() { return ms_totalMoved; }
+
+    /// \return the number of keys shifted by the insertions of every sorter
+    static uint64_t getTotalShiftedCount() { return ms_totalShifted; }
+
+    /// \return the name of a path, for logs
+    static const char* getPathName(Path path);
+
+protected:
+    /// \privatesection
+    NvIncrementalSort(const NvIncrementalSort&);
+    NvIncrementalSort& operator=(const NvIncrementalSort&);
+
+    template <class IndexT> void sortKeys(const uint32_t* keys, int32_t count, IndexT* indices);
+    bool mergeSort(const uint32_t* keys, int32_t count);
+    void reserve(int32_t count);
+
+    NvRadixSort m_radix;
+    float m_maxDisorder;
+
+    // the permutation of the last sort, and room for the next one
+    uint32_t* m_order[2];
+    int32_t m_current;
+    int32_t m_count;
+
+    // the keys in the previous order, then the ones taken out of it
+    uint32_t* m_keys;
+    uint32_t* m_movedKeys;
+    uint32_t* m_movedValues;
+    uint32_t* m_movedOrder;
+    int32_t m_capacity;
+
+    // sorts left to go straight to the radix sort, and how many were skipped last time
+    int32_t m_skip;
+    int32_t m_backoff;
+
+    Path m_lastPath;
+    int32_t m_lastMoved;
+    int32_t m_lastShifted;
+
+    static uint32_t ms_totalSorts[PATH_COUNT];
+    static uint64_t ms_totalMoved;
+    static uint64_t ms_totalShifted;
+};
+
+#endif
@@ -0,0 +1,206 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvJobSystem.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_JOB_SYSTEM_H
+#define NV_JOB_SYSTEM_H
+
+#include <NvFoundation.h>
+#include <vector>
+
+/// \file
+/// Work-stealing job system with task graphs, parallel-for and fences
+
+/// A job entry point
+/// \param[in] data the user pointer passed when the job was submitted
+typedef void (*NvJobFunction)(void* data);
+
+/// A parallel-for entry point; called once per chunk of the range
+/// \param[in] data the user pointer passed to #NvJobSystem::parallelFor
+/// \param[in] begin the first index of the chunk
+/// \param[in] end one past the last index of the chunk
+typedef void (*NvJobRangeFunction)(void* data, int32_t begin, int32_t end);
+
+/// Counts the outstanding jobs submitted against it.  Used as a fence: submit a
+/// frame's jobs against one counter, then #NvJobSystem::wait on it (or poll
+/// #isDone) before the results are consumed.
+class NvJobCounter
+{
+public:
+    NvJobCounter() : m_count(0) { }
+
+    /// \return true once every job submitted against the counter has completed
+    bool isDone() const { return m_count == 0; }
+
+    /// \return the number of jobs still outstanding
+    int32_t getCount() const { return m_count; }
+
+    /// \privatesection
+    volatile int32_t m_count;
+
+private:
+    NvJobCounter(const NvJobCounter&);
+    NvJobCounter& operator=(const NvJobCounter&);
+};
+
+/// A set of tasks with dependencies between them.  A task is scheduled as soon
+/// as all of the tasks it depends on have completed.  Graphs are built once and
+/// may be submitted again (e.g. every frame) once the previous submission is done.
+class NvJobGraph
+{
+public:
+    NvJobGraph() { }
+
+    /// Adds a task
+    /// \param[in] func the task entry point
+    /// \param[in] data the user pointer passed to func
+    /// \param[in] name the profiler scope name; must be a string literal or otherwise outlive the graph
+    /// \return the task index, for #addDependency
+    int32_t addTask(NvJobFunction func, void* data, const char* name);
+
+    /// Makes one task wait for another
+    /// \param[in] before the task that must complete first
+    /// \param[in] after the task that depends on it
+    void addDependency(int32_t before, int32_t after);
+
+    /// Removes all tasks
+    void clear() { m_tasks.clear(); }
+
+    /// \return the number of tasks in the graph
+    int32_t getTaskCount() const { return (int32_t)m_tasks.size(); }
+
+    /// Schedules every task.  The graph must not be changed or submitted again until #isDone
+    void submit();
+
+    /// \return true once every task of the last submission has completed
+    bool isDone() const { return m_counter.isDone(); }
+
+    /// Waits for the last submission, running jobs on the calling thread meanwhile
+    void wait();
+
+    /// \privatesection
+    struct Task {
+        NvJobFunction func;
+        void* data;
+        const char* name;
+        NvJobGraph* graph;
+        std::vector<int32_t> successors;
+        int32_t predecessors;
+        volatile int32_t pending;
+    };
+    std::vector<Task> m_tasks;
+    NvJobCounter m_counter;
+};
+
+/// Process-wide pool of worker threads.  Each worker owns a queue: jobs
+/// submitted from a worker go to the back of its own queue and are popped from
+/// there (most recent first, while the data is still in cache); idle workers take
+/// jobs from the front of the shared queue used by non-worker threads, then
+/// steal from the front of the other workers' queues.  Workers sleep when there
+/// is no work.  Threads that wait on a counter run queued jobs until it is done,
+/// so waiting from inside a job cannot deadlock.
+///
+/// When profiling is enabled each job is timed as a CPU scope named after the job
+/// on the worker's own profiler track.
+///
+/// All functions are static.  Before #globalInit (or with no workers) jobs run
+/// immediately on the submitting thread.
+class NvJobSystem
+{
+public:
+    /// Starts the workers
+    /// \param[in] workers the number of worker threads; a negative count uses one
+    /// less than the number of CPU cores (the submitting thread also runs jobs)
+    /// \return true if the job system is running
+    static bool globalInit(int32_t workers = -1);
+
+    /// Waits for the workers to finish their current jobs and stops them.
+    /// Jobs still queued are run on the calling thread first
+    static void globalShutdown();
+
+    /// Stops the workers and starts a different number of them, e.g. to time
+    /// the same work on several thread counts.  No jobs may be pending
+    /// \param[in] workers the number of worker threads, as for #globalInit
+    /// \return true if the job system is running
+    static bool restart(int32_t workers);
+
+    /// \return the number of worker threads (0 when jobs run inline)
+    static int32_t getWorkerCount() { return ms_workerCount; }
+
+    /// \return 1..#getWorkerCount on a worker thread, 0 on any other thread
+    static int32_t getThreadIndex();
+
+    /// Submits a job
+    /// \param[in] func the job entry point
+    /// \param[in] data the user pointer passed to func
+    /// \param[in] name the profiler scope name; must be a string literal or otherwise outlive the job system
+    /// \param[in] counter if not NULL, incremented now and decremented when the job completes
+    static void run(NvJobFunction func, void* data, const char* name, NvJobCounter* counter);
+
+    /// Waits for a counter to reach zero, running queued jobs on the calling thread meanwhile.
+    /// When there is nothing left to run, the thread yields briefly and then blocks
+    /// until the counter is done or more jobs are queued
+    /// \param[in] counter the counter to wait for
+    static void wait(NvJobCounter* counter);
+
+    /// Splits [0, count) into chunks of at most grain indices and calls func on
+    /// each, in parallel, returning once all chunks are done.  The calling thread
+    /// takes part; chunks are claimed dynamically, so uneven chunks balance out.
+    /// \param[in] func the chunk entry point
+    /// \param[in] data the user pointer passed to func
+    /// \param[in] count the number of indices
+    /// \param[in] grain the maximum chunk size
+    /// \param[in] name the profiler scope name
+    static void parallelFor(NvJobRangeFunction func, void* data, int32_t count, int32_t grain, const char* name);
+
+    /// Checks the scheduler under load: many small jobs, jobs that spawn and wait
+    /// on jobs, parallel-for over uneven ranges and repeated task graphs, all
+    /// verified for lost, duplicated or misordered work
+    /// \param[in] iterations the number of rounds
+    /// \return true if every round produced the expected results
+    static bool runStressTest(int32_t iterations);
+
+    /// Logs the cost of submitting and completing jobs: empty-job throughput,
+    /// single-job round trip latency and parallel-for overhead
+    static void runDispatchBenchmark();
+
+    /// Jobs each queue can hold; a job submitted to a full queue runs immediately
+    static const int32_t QUEUE_CAPACITY = 4096;
+    /// Maximum number of worker threads
+    static const int32_t MAX_WORKERS = 63;
+
+protected:
+    static int32_t ms_workerCount;
+};
+
+#endif
@@ -0,0 +1,162 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvNoiseVolume.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_NOISE_VOLUME_H
+#define NV_NOISE_VOLUME_H
+
+#include <NvFoundation.h>
+#include "NV/NvPlatformGL.h"
+#include <string>
+
+class ImprovedNoise;
+
+/// \file
+/// Seeded 3D noise volumes, generated on the job system and cached on disk
+
+/// A 3D noise texture built on the CPU.  The volume is a pure function of its #Desc:
+/// the same description gives the same bits on every run and any number of threads,
+/// so a generated volume can be written to the cache directory (see #setCacheDirectory)
+/// and loaded from there by later runs instead of being generated again.
+///
+/// Slices are generated in parallel across the #NvJobSystem, a row at a time through
+/// the batched (SSE2/NEON) ImprovedNoise functions, and stored as half floats or
+/// signed normalized bytes: a quarter or an eighth of a float RGBA volume.
+/// #createTexture uploads the whole volume with a single glTexImage3D.
+class NvNoiseVolume
+{
+public:
+    /// The noise in each texel
+    enum Type {
+        TYPE_VALUE,     ///< Independent uniform random values in [-amplitude, amplitude]
+        TYPE_PERLIN,    ///< Improved Perlin noise
+        TYPE_FBM        ///< Fractal sum of octaves of Perlin noise
+    };
+
+    /// The storage of each channel
+    enum Format {
+        FORMAT_HALF,    ///< 16 bit float (GL_R16F .. GL_RGBA16F)
+        FORMAT_SNORM8   ///< 8 bit signed normalized, clamped to [-1, 1] (GL_R8_SNORM .. GL_RGBA8_SNORM)
+    };
+
+    /// Everything that determines the contents of a volume
+    struct Desc {
+        /// Constructor - a 32^3 RGBA half float volume of value noise
+        Desc();
+
+        Type type;          ///< The noise
+        Format format;      ///< The storage of each channel
+        int32_t width;      ///< Texels along x
+        int32_t height;     ///< Texels along y
+        int32_t depth;      ///< Texels along z
+        int32_t channels;   ///< Channels per texel, 1 to 4; each channel is an independent field
+        uint32_t seed;      ///< Selects the random values (value noise) or the permutation (Perlin, fBm)
+        float frequency;    ///< Perlin and fBm: the noise lattice cells across the volume along each axis
+        int32_t octaves;    ///< fBm: the number of octaves
+        float lacunarity;   ///< fBm: the frequency multiplier between octaves
+        float gain;         ///< fBm: the amplitude multiplier between octaves
+        float amplitude;    ///< Scales the noise before it is stored
+    };
+
+    NvNoiseVolume();
+    ~NvNoiseVolume();
+
+    /// Fills the volume, from the cache if it holds this description, or by generating it
+    /// (and then writing it to the cache)
+    /// \param[in] desc the volume to build
+    /// \return false if the description is invalid
+    bool generate(const Desc& desc);
+
+    /// Frees the texels
+    void release();
+
+    /// Creates a GL_TEXTURE_3D holding the volume, with linear filtering and repeat
+    /// wrapping, and leaves it bound to the active texture unit
+    /// \return the texture name, or 0 if the volume is empty
+    GLuint createTexture() const;
+
+    /// Reads all texels back as floats
+    /// \param[out] out width*height*depth*channels floats, x fastest, channels interleaved
+    void decode(float* out) const;
+
+    /// \return the description of the current contents
+    const Desc& getDesc() const { return m_desc; }
+
+    /// \return the texels, x fastest and channels interleaved, or NULL if empty
+    const void* getData() const { return m_data; }
+
+    /// \return the size of the texels in bytes
+    size_t getDataSize() const { return m_dataSize; }
+
+    /// \return true if the last #generate loaded the volume from the cache
+    bool wasLoadedFromCache() const { return m_fromCache; }
+
+    /// \return the time the last #generate took, in milliseconds
+    float getBuildMs() const { return m_buildMs; }
+
+    /// Sets the directory that generated volumes are cached in.  Caching is off until a
+    /// directory is set; the sample framework sets it from the -noisecache command line option
+    /// \param[in] dir an existing, writable directory, or NULL to disable the cache
+    static void setCacheDirectory(const char* dir);
+
+    /// Generates a volume and creates its texture
+    /// \param[in] desc the volume to build
+    /// \return the texture name, or 0 if the description is invalid
+    static GLuint createTexture(const Desc& desc);
+
+    /// \return the GL internal format of a volume with the given format and channel count
+    static GLint getInternalFormat(Format format, int32_t channels);
+
+protected:
+    /// \privatesection
+    NvNoiseVolume(const NvNoiseVolume&);
+    NvNoiseVolume& operator=(const NvNoiseVolume&);
+
+    static void generateSlices(void* data, int32_t begin, int32_t end);
+    std::string getCachePath() const;
+    bool loadCache();
+    void saveCache() const;
+
+    Desc m_desc;
+    void* m_data;
+    size_t m_dataSize;
+    bool m_fromCache;
+    float m_buildMs;
+
+    // the Perlin permutation while the slices are generated
+    ImprovedNoise* m_noise;
+
+    static std::string ms_cacheDirectory;
+};
+
+#endif
@@ -0,0 +1,148 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvQualityTuner.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+
+#ifndef NV_QUALITY_TUNER_H
+#define NV_QUALITY_TUNER_H
+
+#include <NvFoundation.h>
+#include <string>
+#include <vector>
+
+/// \file
+/// Steps through a ladder of quality settings to keep the frame time within a budget
+
+/// Picks a quality level from a ladder ordered from the cheapest to the most expensive
+/// (e.g. resolution divisors and upsampling filters), so that the frame fits a time budget.
+///
+/// The caller averages its frame timers over a window of frames (the sample's stats
+/// interval) and passes the means to #addWindow.  The frame takes as long as the slower
+/// of the CPU and the GPU.  The tuner steps down one level when a window is over budget.
+/// It steps up one level when the next level is expected to fit with room to spare:
+/// - the expected time is the current time scaled by the cost ratio of the two levels
+/// - the ratio is measured on each step and assumed until then
+/// The gap between the step-down and step-up thresholds keeps noise from flipping the
+/// level back and forth.  After a change, the windows still holding timer results from
+/// the old level are skipped.  A level that goes over budget right after being stepped
+/// up to is not tried again for a hold period, which doubles each time it happens.
+///
+/// Every change is logged with the times that caused it.  The tuner only sees the
+/// numbers it is given, so it can be driven by synthetic timer traces as well as by
+/// the sample's timers.
+class NvQualityTuner
+{
+public:
+    /// Thresholds and timing of the decisions
+    struct Params {
+        Params()
+        : budgetMs(1000.0f / 60.0f)
+        , upperFraction(1.0f)
+        , lowerFraction(0.8f)
+        , assumedStepCost(1.5f)
+        , settleWindows(1)
+        , holdWindows(4)
+        , maxHoldWindows(64)
+        {
+        }
+        float budgetMs; ///< The frame time to stay within, in milliseconds
+        float upperFraction; ///< Steps down when a window takes longer than budgetMs * upperFraction
+        float lowerFraction; ///< Steps up when the next level is expected to take less than budgetMs * lowerFraction
+        float assumedStepCost; ///< The cost ratio of neighbouring levels until it has been measured
+        int32_t settleWindows; ///< Windows skipped after a change
+        int32_t holdWindows; ///< Windows before retrying a level that went over budget as soon as it was reached
+        int32_t maxHoldWindows; ///< The longest hold, reached by doubling
+    };
+
+    NvQualityTuner();
+
+    /// Sets the ladder and the starting level, and forgets any measured costs
+    /// \param[in] names the level names, cheapest first (copied)
+    /// \param[in] count the number of levels
+    /// \param[in] level the starting level
+    void setLevels(const char* const* names, int32_t count, int32_t level);
+
+    /// Sets the thresholds
+    /// \param[in] params the new thresholds; take effect from the next window
+    void setParams(const Params& params) { m_params = params; }
+
+    /// Returns the thresholds
+    /// \return the current parameters
+    const Params& getParams() const { return m_params; }
+
+    /// Restarts from a level, e.g. after the settings were changed by hand.  Measured
+    /// costs are kept
+    /// \param[in] level the level the settings now match
+    void reset(int32_t level);
+
+    /// Feeds the mean frame times of one window and decides
+    /// \param[in] gpuMs the mean GPU time of a frame in the window, in milliseconds (0 if unknown)
+    /// \param[in] cpuMs the mean CPU time of a frame in the window, in milliseconds
+    /// \return true if the level changed; the caller applies #getLevel
+    bool addWindow(float gpuMs, float cpuMs);
+
+    /// \return the current level
+    int32_t getLevel() const { return m_level; }
+
+    /// \return the number of levels
+    int32_t getLevelCount() const { return (int32_t)m_names.size(); }
+
+    /// \param[in] level a level in [0, #getLevelCount)
+    /// \return the level's name
+    const char* getLevelName(int32_t level) const;
+
+    /// \return the number of level changes since #setLevels
+    uint32_t getChangeCount() const { return m_changes; }
+
+protected:
+    /// \privatesection
+    void change(int32_t level, float frameMs);
+
+    Params m_params;
+    std::vector<std::string> m_names;
+    std::vector<float> m_stepCost;  // measured cost of level + 1 over level; 0 until measured
+    std::vector<int32_t> m_hold;    // the current hold of each level
+    std::vector<int32_t> m_heldUntil; // the window before which a level is not stepped up to
+
+    int32_t m_level;
+    int32_t m_window;           // windows decided on
+    int32_t m_settle;           // windows left to skip
+    int32_t m_windowsAtLevel;   // windows decided on since the last change
+    int32_t m_previousLevel;    // the level before the last change, -1 if none
+    float m_previousMs;         // its last frame time
+    bool m_steppedUp;           // whether the last change was a step up
+    bool m_loggedLowest;        // whether being over budget at level 0 was logged
+    uint32_t m_changes;
+};
+
+#endif
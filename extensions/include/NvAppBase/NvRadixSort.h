@@ -0,0 +1,160 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvRadixSort.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_RADIX_SORT_H
+#define NV_RADIX_SORT_H
+
+#include <NvFoundation.h>
+
+/// \file
+/// Multi-threaded radix sort of 32 bit keys, and SIMD depth keys for sorting points
+
+/// Stable least-significant-digit radix sort of 32 bit keys.  The keys are sorted in
+/// three passes of 11 bit digits, and a pass is skipped when every key has the same
+/// digit (e.g. the exponent bits of depths in a narrow range).
+///
+/// The sort produces the permutation that orders the keys: indices[i] is the
+/// index of the i-th smallest key, ties in their original order.  The last pass writes
+/// the indices directly in the type asked for, so 16 bit index buffers need no extra pass.
+///
+/// Arrays of at least #PARALLEL_MIN_KEYS keys are split into one chunk per thread
+/// of the #NvJobSystem.  Each chunk histograms its own keys, and the chunks then
+/// scatter in parallel to disjoint, precomputed offsets, so the result is the same for
+/// any number of threads.
+///
+/// A sorter keeps its buffers between calls; it must not be used from two threads at once.
+class NvRadixSort
+{
+public:
+    NvRadixSort();
+    ~NvRadixSort();
+
+    /// Sorts keys
+    /// \param[in] keys count keys; unchanged
+    /// \param[in] count the number of keys
+    /// \param[out] indices count indices, the permutation that sorts the keys
+    void sort(const uint32_t* keys, int32_t count, uint32_t* indices);
+
+    /// Sorts keys into 16 bit indices
+    /// \param[in] keys count keys; unchanged
+    /// \param[in] count the number of keys, at most 65536
+    /// \param[out] indices count indices, the permutation that sorts the keys
+    void sort(const uint32_t* keys, int32_t count, uint16_t* indices);
+
+    /// \return the number of digit passes the last sort ran (0 to 3)
+    int32_t getPassCount() const { return m_passCount; }
+
+    /// \return the number of chunks the last sort was split into
+    int32_t getChunkCount() const { return m_chunkCount; }
+
+    /// Converts a float to a key; keys compare as unsigned integers in the order of the
+    /// floats (-0 sorts before +0; NaNs sort beyond the infinities)
+    static uint32_t floatToKey(float f);
+
+    /// Converts a key back to its float
+    static float keyToFloat(uint32_t key);
+
+    /// Computes the keys of the distances of points along an axis, floatToKey(dot(axis, p)).
+    /// Sorting them orders the points from the back to the front of the axis; pass the negated
+    /// view direction to draw back to front.  Large arrays are split across the job system
+    /// \param[in] points count points; the xyz of each at the start of an element of stride floats
+    /// \param[in] stride the distance between points in floats (e.g. 4 for xyzw), at least 3
+    /// \param[in] count the number of points
+    /// \param[in] axis the xyz of the axis
+    /// \param[out] keys count keys
+    static void computeDepthKeys(const float* points, int32_t stride, int32_t count, const float* axis, uint32_t* keys);
+
+    /// Computes depth keys, as above, of points stored as separate arrays of coordinates
+    /// \param[in] x count x coordinates
+    /// \param[in] y count y coordinates
+    /// \param[in] z count z coordinates
+    /// \param[in] count the number of points
+    /// \param[in] axis the xyz of the axis
+    /// \param[out] keys count keys
+    static void computeDepthKeys(const float* x, const float* y, const float* z, int32_t count, const float* axis, uint32_t* keys);
+
+    /// Disables the SIMD paths, to compare them with the scalar one
+    /// \param[in] enabled false to compute keys with scalar code only
+    static void setSIMDEnabled(bool enabled) { ms_simd = enabled; }
+
+    /// \return the name of the SIMD path in use ("SSE2", "NEON" or "scalar")
+    static const char* getSIMDName();
+
+    /// Bits per digit
+    static const int32_t DIGIT_BITS = 11;
+    /// Buckets per digit
+    static const int32_t BUCKETS = 1 << DIGIT_BITS;
+    /// Digit passes over 32 bit keys
+    static const int32_t PASSES = 3;
+    /// The smallest number of keys per chunk worth a job of its own
+    static const int32_t PARALLEL_MIN_KEYS = 32768;
+
+protected:
+    /// \privatesection
+    NvRadixSort(const NvRadixSort&);
+    NvRadixSort& operator=(const NvRadixSort&);
+
+    template <class IndexT> void sortKeys(const uint32_t* keys, int32_t count, IndexT* indices);
+    template <class IndexT> static void scatterChunk(void* data, int32_t begin, int32_t end);
+    static void histogramChunk(void* data, int32_t begin, int32_t end);
+    static void depthKeysRange(void* data, int32_t begin, int32_t end);
+    static void depthKeysSoARange(void* data, int32_t begin, int32_t end);
+    void reserve(int32_t count, int32_t chunks);
+    int32_t getChunkBegin(int32_t chunk) const;
+
+    uint32_t* m_keys[2];
+    uint32_t* m_values[2];
+    int32_t m_capacity;
+
+    // per chunk: the digit histograms (then the scatter offsets) of every pass
+    uint32_t* m_histograms;
+    int32_t m_histogramChunks;
+
+    // the pass being run, shared by the chunk jobs
+    int32_t m_count;
+    int32_t m_chunkCount;
+    int32_t m_pass;
+    bool m_allPasses;
+    const uint32_t* m_srcKeys;
+    const uint32_t* m_srcValues;
+    uint32_t* m_dstKeys;
+    uint32_t* m_dstValues;
+    void* m_dstIndices;
+
+    int32_t m_passCount;
+
+    static bool ms_simd;
+};
+
+#endif
@@ -43,6 +43,7 @@
 #include "NvGLAppContext.h"
 #include "NvPlatformContext.h"
 #include "NvGamepad/NvGamepad.h"
+#include "NvGLUtils/NvProfiler.h"
 #include "NvUI/NvUI.h"
 #include "NvUI/NvTweakVar.h"
 #include <map>
@@ -51,10 +52,17 @@
 /// Sample app base class.
 
 class NvFramerateCounter;
+class NvFrameTimeStats;
 class NvInputTransformer;
 class NvSimpleFBO;
 class NvTweakBar;
 
+/// A benchmark or self test that a sample runs instead of itself, see
+/// NvSampleApp::addBenchmarkMode.  It logs its own results.
+/// \param[in] stopWatch a timer for the benchmark's use
+/// \return true if every check passed
+typedef bool (*NvBenchmarkFunction)(NvStopWatch* stopWatch);
+
 /// Base class for sample apps.
 /// Adds numerous features to NvAppBase that are of use to most or all sample apps
 class NvSampleApp : public NvAppBase 
@@ -182,6 +190,16 @@ protected:
     /// \return true if the app is running in a timed test harness
     bool isTestMode() { return mTestMode; }
 
+    /// Benchmark mode declaration.
+    /// Call from the constructor.  If the command line holds the flag, the app runs
+    /// the benchmark once GL is initialized, in place of initRendering and the main
+    /// loop, then exits with status 0 if it passed and 1 if it failed.  Nothing else
+    /// is using the job system meanwhile, so the benchmark may #NvJobSystem::restart
+    /// it with other worker counts.  If several modes are given, the first declared runs.
+    /// \param[in] flag the command line flag, e.g. "-sortbench"
+    /// \param[in] func the benchmark
+    void addBenchmarkMode(const char* flag, NvBenchmarkFunction func);
+
     // Do not override these virtuals - overide the "handle" ones above
     bool pointerInput(NvInputDeviceType::Enum device, NvPointerActionType::Enum action, 
         uint32_t modifiers, int32_t count, NvPointerEvent* points); // we have base impl.
@@ -202,6 +220,7 @@ protected:
     NvUIValueText *mFPSText;
     NvTweakBar *mTweakBar;
     NvUIButton *mTweakTab;
+    NvUIText *mProfilerText;
 
     NvInputTransformer* m_transformer;
 
@@ -222,11 +241,18 @@ protected:
     void baseDrawUI(void);
     void baseFocusChanged(bool focused);
     void baseHandleReaction(void);
-    void logTestResults(float frameRate, int32_t frames);
+    void baseEndFrame(void);
+    bool logTestResults(float frameRate, int32_t frames);
+    void beginTestGPUFrame(int32_t frame);
+    void endTestGPUFrame();
+    void collectTestGPUFrames(uint32_t maxPending);
 
     void SwapBuffers();
 
 private:
+    // frames whose GPU times may be in flight at once in test mode
+    const static int32_t TESTMODE_GPU_QUERY_FRAMES = 8;
+
     GLuint mMainFBO;
     bool mUseFBOPair;
     int32_t mCurrentFBOIndex;
@@ -242,7 +268,48 @@ private:
     bool mTestMode;
     float mTestDuration;
     int32_t mTestRepeatFrames;
+    int32_t mTestFrameLimit;
     std::string mTestName;
+    std::string mTestBaseline;
+    float mTestTolerance;
+    std::string mTestStutterThresholds;
+    NvFrameTimeStats* mTestFrameStats;
+    NvProfiler::GPUBackend* mTestGPUQueries;
+    int32_t mTestGPUFrames[TESTMODE_GPU_QUERY_FRAMES];
+    uint32_t mTestGPUHead;
+    uint32_t mTestGPUTail;
+
+    // the running totals reported by logTestResults, snapshotted when timing starts
+    // so that the warm-up frames are left out
+    struct TestCounters {
+        uint32_t streamWrites;
+        uint32_t streamStalls;
+        float streamStallMs;
+        uint64_t streamBytes;
+        uint32_t simSteps;
+        uint32_t simDroppedSteps;
+        float simStepMs;
+        uint32_t sortRadix;
+        uint32_t sortSorted;
+        uint32_t sortMerge;
+        uint64_t sortMoved;
+        uint64_t sortShifted;
+
+        void read();
+    };
+    TestCounters mTestCounters;
+
+    int32_t mProfileCaptureFrames;
+    std::string mProfileTraceFile;
+    bool mProfileNullGPU;
+
+    int32_t mJobWorkers;
+    bool mJobSystemTest;
+    std::string mBenchmarkFlag;
+    NvBenchmarkFunction mBenchmarkFunction;
+
+    int32_t mStreamingMethod;
+    int32_t mMultiDrawMethod;
 
     enum {
         TEST_MODE_ISSUE_NONE = 0x00000000,
@@ -107,6 +107,17 @@ bool NvAssetLoaderRemoveSearchPath(const char *path);
 /// with free or delete[]
 char *NvAssetLoaderRead(const char *filePath, int32_t &length);
 
+/// Finds the file that #NvAssetLoaderRead would open for an asset.
+/// Only meaningful on path-based platforms (Linux and Windows), where it
+/// can be used to watch asset files for changes
+/// \param[in] filePath the partial path (below "assets") to the file
+/// \param[out] fullPath buffer receiving the null-terminated path of the file,
+/// relative to the application's current working directory
+/// \param[in] maxLength the size of the fullPath buffer in bytes
+/// \return true if the file was found and the path fits in the buffer, false if
+/// not or if the platform does not store assets as files
+bool NvAssetLoaderFindFile(const char *filePath, char *fullPath, int32_t maxLength);
+
 /// Frees a block returned from #NvAssetLoaderRead.
 /// \param[in] asset a pointer returned from #NvAssetLoaderRead
 /// \return true on success and false on failure
@@ -0,0 +1,192 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGLSLPreprocessor.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_GLSL_PREPROCESSOR_H
+#define NV_GLSL_PREPROCESSOR_H
+
+#include <NvFoundation.h>
+#include "NvGLUtils/NvGLSLProgram.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/// \file
+/// GLSL include/define preprocessing and permutation caching
+
+/// Called when a source registered with #NvGLSLPreprocessor::watchSource is expanded
+/// \param[in] source the expanded source
+/// \param[in] userData the pointer passed to #NvGLSLPreprocessor::watchSource
+/// \return true if the source was built successfully
+typedef bool (*NvGLSLSourceFunction)(const char* source, void* userData);
+
+/// Shared GLSL source preprocessor.
+/// Expands <tt>#include "file"</tt> directives through #NvAssetLoaderRead (paths are
+/// relative to the including file), injects <tt>#define</tt>s for shader permutations
+/// directly after the <tt>#version</tt> line, and records which files each program was
+/// built from.  Each included file is wrapped in <tt>#line</tt> directives that number it
+/// as its own source string (the root file is 0), so compile errors report positions
+/// in the original files.  The directives follow the GLSL 3.30 / ESSL 3.00 rule that
+/// the line after <tt>#line n</tt> is line n.
+///
+/// Programs created through the preprocessor are cached by a hash of their final
+/// sources, so requesting the same permutation twice returns the same program instead
+/// of compiling it again.  The preprocessor owns the programs it creates.  When a
+/// source file changes (see #NvGLSLShaderWatcher), #fileChanged rebuilds only the
+/// programs that depend on it, in place, via #NvGLSLProgram::relink.
+class NvGLSLPreprocessor
+{
+public:
+    /// A shader stage read from an asset file
+    struct ShaderFile {
+        const char* filename; ///< partial path (below "assets") of the root source file
+        GLint type; ///< The GL_*_SHADER enum representing the shader type
+    };
+
+    NvGLSLPreprocessor();
+
+    /// Destructor.  Deletes all programs created by the preprocessor
+    ~NvGLSLPreprocessor();
+
+    /// Adds a define that is injected into every shader processed from now on
+    /// \param[in] name the null-terminated name of the macro
+    /// \param[in] value the null-terminated replacement text
+    void setDefine(const char* name, const char* value = "1");
+
+    /// Removes all defines added with #setDefine
+    void clearDefines();
+
+    /// Expands a shader source file
+    /// \param[in] filename the partial path (below "assets") of the root source file
+    /// \param[in] defines optional permutation defines, separated by ';' in the form
+    /// "NAME" or "NAME=VALUE"; may be NULL
+    /// \param[out] result the expanded source
+    /// \param[out] dependencies if not NULL, receives every file read, including the root
+    /// \return true on success, false if the root or an included file could not be read
+    bool preprocess(const char* filename, const char* defines, std::string& result,
+        std::set<std::string>* dependencies = NULL);
+
+    /// Creates (or finds in the cache) a program built from preprocessed files
+    /// \param[in] files the shader stages of the program
+    /// \param[in] count the number of elements in #files
+    /// \param[in] defines optional permutation defines; see #preprocess
+    /// \param[in] strict passed to the program; see #NvGLSLProgram::setSourceFromStrings
+    /// \return the program or NULL on failure.  The program is owned by the preprocessor
+    NvGLSLProgram* createProgram(const ShaderFile* files, int32_t count, const char* defines = NULL, bool strict = false);
+
+    /// Creates (or finds in the cache) a program from generated source strings.
+    /// Programs created this way have no file dependencies and are never rebuilt
+    /// \param[in] src the shader sources
+    /// \param[in] count the number of elements in #src
+    /// \param[in] strict passed to the program; see #NvGLSLProgram::setSourceFromStrings
+    /// \return the program or NULL on failure.  The program is owned by the preprocessor
+    NvGLSLProgram* createProgramFromStrings(NvGLSLProgram::ShaderSourceItem* src, int32_t count, bool strict = false);
+
+    /// Expands a shader source file for code that builds its own GL objects from it,
+    /// such as separable pipeline programs, and calls #callback with the expanded
+    /// source now and again whenever the file or one of its includes changes
+    /// \param[in] filename the partial path (below "assets") of the root source file
+    /// \param[in] defines optional permutation defines; see #preprocess
+    /// \param[in] callback the function that builds from the source
+    /// \param[in] userData passed to #callback, and the key for #unwatchSource
+    /// \return the result of the first call to #callback, or false if the file could not be read.
+    /// The callback must not call #watchSource or #unwatchSource
+    bool watchSource(const char* filename, const char* defines, NvGLSLSourceFunction callback, void* userData);
+
+    /// Removes every source registered with #watchSource for the given user data
+    /// \param[in] userData the pointer passed to #watchSource
+    void unwatchSource(void* userData);
+
+    /// Rebuilds the programs and watched sources that depend on a changed file.
+    /// Must be called with the GL context bound
+    /// \param[in] filename the partial path (below "assets") of the changed file
+    /// \return the number of programs and watched sources that were rebuilt
+    int32_t fileChanged(const char* filename);
+
+    /// Returns every file that any cached program depends on
+    /// \param[out] files receives the partial paths of the files
+    void getDependencies(std::set<std::string>& files) const;
+
+    /// Bumped whenever the set of dependency files may have grown
+    /// \return the dependency set generation counter
+    uint32_t getDependencyGeneration() const { return m_dependencyGeneration; }
+
+    /// Number of program requests that were satisfied from the cache
+    uint32_t getCacheHits() const { return m_cacheHits; }
+
+    /// Number of program requests that required a compile
+    uint32_t getCacheMisses() const { return m_cacheMisses; }
+
+    /// 64-bit FNV-1a hash, used as the permutation cache key
+    /// \param[in] data the bytes to hash
+    /// \param[in] size the number of bytes
+    /// \param[in] seed the running hash, to chain several blocks
+    /// \return the hash value
+    static uint64_t hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ULL);
+
+protected:
+    /// \privatesection
+    struct Entry {
+        std::vector<std::string> filenames;
+        std::vector<GLint> types;
+        std::string defines;
+        bool strict;
+        std::set<std::string> dependencies;
+        uint64_t key;
+        NvGLSLProgram* program;
+    };
+
+    struct Watch {
+        std::string filename;
+        std::string defines;
+        std::set<std::string> dependencies;
+        uint64_t key;
+        NvGLSLSourceFunction callback;
+        void* userData;
+    };
+
+    bool expand(const std::string& filename, std::string& result, std::vector<std::string>& included);
+    bool buildSources(Entry& entry, std::vector<std::string>& sources);
+    static uint64_t hashSources(const std::vector<std::string>& sources, const GLint* types, bool strict);
+
+    std::vector<std::pair<std::string, std::string> > m_defines;
+    std::vector<Entry*> m_entries;
+    std::vector<Watch> m_watches;
+    std::map<uint64_t, Entry*> m_cache;
+    uint32_t m_dependencyGeneration;
+    uint32_t m_cacheHits;
+    uint32_t m_cacheMisses;
+};
+
+#endif
@@ -37,6 +37,7 @@
 
 #include <NvFoundation.h>
 #include "NV/NvPlatformGL.h"
+#include "KHR/khrplatform.h"
 
 /// \file
 /// GLSL shader program wrapper
@@ -109,6 +110,57 @@ public:
     /// \return true on success and false on failure
     bool setSourceFromStrings(ShaderSourceItem* src, int32_t count, bool strict = false);
 
+    /// Starts building the shader object from a pair of filenames/paths without waiting
+    /// for the result.  Uses #NvAssetLoaderRead to load the files.  See #beginSourceFromStrings
+    /// \param[in] vertFilename the filename and partial path to the text file containing the vertex shader source
+    /// \param[in] fragFilename the filename and partial path to the text file containing the fragment shader source
+    /// \param[in] strict if set to true, then later calls to retrieve the locations of non-
+    /// existent uniforms and vertex attributes will log a warning to the output
+    /// \return true if the build was issued and false if the files could not be read
+    bool beginSourceFromFiles(const char* vertFilename, const char* fragFilename, bool strict = false);
+
+    /// Starts building the shader object from an array of #ShaderSourceItem source objects
+    /// without waiting for the result.  All compiles and the link are issued to the driver,
+    /// but no status is queried, so the driver is free to build several programs in parallel
+    /// (on its own threads when GL_KHR_parallel_shader_compile is supported).  The build
+    /// must be completed with #finishBuild before the program is used
+    /// \param[in] src an array of #ShaderSourceItem objects containing the shaders sources to
+    /// be loaded
+    /// \param[in] count the number of elements in #src array; at most #MAX_SHADER_STAGES
+    /// \param[in] strict if set to true, then later calls to retrieve the locations of non-
+    /// existent uniforms and vertex attributes will log a warning to the output
+    /// \return true if the build was issued and false on failure
+    bool beginSourceFromStrings(ShaderSourceItem* src, int32_t count, bool strict = false);
+
+    /// Returns whether a build started with #beginSourceFromStrings is waiting for #finishBuild
+    /// \return true if a build is pending, false if not
+    bool isBuildPending() const { return m_pendingShaderCount > 0; }
+
+    /// Non-blocking query of a pending build.  Without GL_KHR_parallel_shader_compile
+    /// the driver cannot report progress, and this always returns true so that callers
+    /// simply fall through to #finishBuild
+    /// \return true if #finishBuild can be called without stalling
+    bool isBuildComplete();
+
+    /// Completes a build started with #beginSourceFromStrings.  Queries the link status,
+    /// logging the compile and link errors on failure.  Blocks if the driver has not
+    /// finished building the program
+    /// \return true on success and false on failure
+    bool finishBuild();
+
+    /// Static initialization of the parallel compile extension.  Must be called with the
+    /// intended OpenGL context bound
+    /// \param[in] api the OpenGL extensions retrieval interface object
+    static void globalInit(NvGLExtensionsAPI& api);
+
+    /// Returns whether the driver compiles shaders on its own threads
+    /// \return true if GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile
+    /// was found by #globalInit
+    static bool isParallelCompileSupported() { return ms_glMaxShaderCompilerThreads != NULL; }
+
+    /// The maximum number of shader stages in a single #beginSourceFromStrings call
+    const static int32_t MAX_SHADER_STAGES = 6;
+
     /// Binds the given shader program as current in the GL context
     void enable();
 
@@ -283,6 +335,14 @@ public:
     /// Relinks an existing shader program to update based on external changes
     bool relink();
 
+    /// Replaces the shaders of an existing program with new sources and relinks it.
+    /// The GL program object is kept, so handles held by the application stay valid.
+    /// If any of the new shaders fails to compile, the program is left untouched
+    /// \param[in] src an array of #ShaderSourceItem objects containing the new sources
+    /// \param[in] count the number of elements in #src array; at most #MAX_SHADER_STAGES
+    /// \return true on success and false on failure
+    bool relink(ShaderSourceItem* src, int32_t count);
+
     /// Enables logging of missing uniforms even for non-strict shaders
     /// \param[in] logMissing if set to true, missing uniforms are logged when set,
     /// even if the shader was not created with the strict flag
@@ -292,11 +352,22 @@ protected:
     bool checkCompileError(GLuint object, int32_t target);
     GLuint compileProgram(const char *vsource, const char *fsource);
     GLuint compileProgram(ShaderSourceItem* src, int32_t count);
+    void releasePendingShaders();
 
     bool m_strict;
     GLuint m_program;
 
+    GLuint m_pendingShaders[MAX_SHADER_STAGES];
+    GLint m_pendingTypes[MAX_SHADER_STAGES];
+    int32_t m_pendingShaderCount;
+
     static bool ms_logAllMissing;
+
+    const static unsigned int NV_COMPLETION_STATUS = 0x91B1;
+
+    typedef void (KHRONOS_APIENTRY* NV_PFNGLMAXSHADERCOMPILERTHREADSPROC) (GLuint count);
+
+    static NV_PFNGLMAXSHADERCOMPILERTHREADSPROC ms_glMaxShaderCompilerThreads;
 };
 
 #endif // NV_GLSL_PROGRAM_H
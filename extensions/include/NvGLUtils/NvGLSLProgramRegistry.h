@@ -0,0 +1,125 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGLSLProgramRegistry.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_GLSL_PROGRAM_REGISTRY_H
+#define NV_GLSL_PROGRAM_REGISTRY_H
+
+#include <NvFoundation.h>
+#include "NvGLUtils/NvGLSLProgram.h"
+#include <string>
+#include <vector>
+
+/// \file
+/// Batched creation and startup warm-up of GLSL programs
+
+class NvStopWatch;
+class NvStopWatchFactory;
+
+/// Registry of named GLSL programs that are built as one batch.
+/// Samples declare all of their programs up front and then call #warmUp, which
+/// issues every compile and link before querying any status.  This lets the
+/// driver overlap the builds (on its own threads when GL_KHR_parallel_shader_compile
+/// is supported), instead of finishing each program before starting the next.
+/// The registry owns the programs it creates.
+class NvGLSLProgramRegistry
+{
+public:
+    /// Constructor.
+    /// \param[in] factory the stopwatch factory used to time the builds, normally the app
+    NvGLSLProgramRegistry(NvStopWatchFactory* factory);
+
+    /// Destructor.  Deletes all of the registered programs
+    ~NvGLSLProgramRegistry();
+
+    /// Declares a program built from a vertex/fragment file pair.
+    /// The program is not built until #warmUp is called
+    /// \param[in] name the null-terminated name used to find the program and in the report
+    /// \param[in] vertFilename the filename and partial path to the vertex shader source
+    /// \param[in] fragFilename the filename and partial path to the fragment shader source
+    /// \param[in] strict passed to the program; see #NvGLSLProgram::setSourceFromFiles
+    /// \return the (not yet built) program object
+    NvGLSLProgram* addFromFiles(const char* name, const char* vertFilename, const char* fragFilename, bool strict = false);
+
+    /// Declares a program built from an array of #NvGLSLProgram::ShaderSourceItem.
+    /// The sources are copied, so the caller's strings need not outlive the call
+    /// \param[in] name the null-terminated name used to find the program and in the report
+    /// \param[in] src an array of shader sources
+    /// \param[in] count the number of elements in #src array
+    /// \param[in] strict passed to the program; see #NvGLSLProgram::setSourceFromStrings
+    /// \return the (not yet built) program object
+    NvGLSLProgram* addFromStrings(const char* name, NvGLSLProgram::ShaderSourceItem* src, int32_t count, bool strict = false);
+
+    /// Builds every program declared since the last call.  Must be called with the
+    /// GL context bound.  Logs a per-program timing report
+    /// \return true if every program in this batch built successfully (or there was
+    /// nothing new to build), false if any failed
+    bool warmUp();
+
+    /// Finds a program by name
+    /// \param[in] name the name the program was declared with
+    /// \return the program or NULL if there is no such program, or it failed to build
+    NvGLSLProgram* get(const char* name);
+
+    /// Logs the timing of the most recent #warmUp
+    void logReport();
+
+    /// Number of registered programs
+    /// \return the number of declared programs
+    int32_t getProgramCount() const { return (int32_t)m_entries.size(); }
+
+protected:
+    /// \privatesection
+    struct Entry {
+        std::string name;
+        std::string vertFilename;
+        std::string fragFilename;
+        std::vector<std::string> sources;
+        std::vector<GLint> types;
+        bool strict;
+        bool built;
+        bool succeeded;
+        NvGLSLProgram* program;
+        float submitTime; ///< CPU time spent issuing the build, in ms
+        float readyTime;  ///< time from the start of the batch until the program was ready, in ms
+    };
+
+    bool submit(Entry& entry);
+
+    std::vector<Entry> m_entries;
+    NvStopWatch* m_submitWatch;
+    NvStopWatch* m_batchWatch;
+    float m_batchTime;
+};
+
+#endif
@@ -0,0 +1,81 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGLSLShaderWatcher.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_GLSL_SHADER_WATCHER_H
+#define NV_GLSL_SHADER_WATCHER_H
+
+#include <NvFoundation.h>
+#include <map>
+#include <string>
+
+/// \file
+/// Shader source hot reloading
+
+class NvGLSLPreprocessor;
+
+/// Watches the source files of the programs created by an #NvGLSLPreprocessor
+/// and rebuilds the affected programs when a file is saved.
+/// Backed by inotify on Linux; on other platforms #isSupported returns false
+/// and #poll does nothing.  Only files that are found as loose files through
+/// #NvAssetLoaderFindFile can be watched.
+class NvGLSLShaderWatcher
+{
+public:
+    /// Constructor
+    /// \param[in] preprocessor the preprocessor whose programs are to be watched
+    NvGLSLShaderWatcher(NvGLSLPreprocessor* preprocessor);
+    ~NvGLSLShaderWatcher();
+
+    /// Whether file watching is available on this platform
+    /// \return true if changes can be detected
+    bool isSupported() const { return m_fd >= 0; }
+
+    /// Checks for changed files without blocking and rebuilds the programs that
+    /// depend on them.  Picks up files added to the preprocessor since the last call.
+    /// Call once per frame from the thread that has the GL context bound
+    /// \return the number of programs rebuilt
+    int32_t poll();
+
+protected:
+    /// \privatesection
+    void updateWatches();
+
+    NvGLSLPreprocessor* m_preprocessor;
+    int32_t m_fd;
+    uint32_t m_generation;
+    std::map<int32_t, std::string> m_dirs;        ///< watch descriptor to directory
+    std::map<std::string, std::string> m_assets;  ///< file path to asset name
+};
+
+#endif
@@ -0,0 +1,169 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGPUSort.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_GPU_SORT_H
+#define NV_GPU_SORT_H
+
+#include <NvFoundation.h>
+#include "NV/NvPlatformGL.h"
+
+/// \file
+/// Key/value radix sort in compute shaders, with a CPU emulation of the same algorithm.
+
+class NvGLExtensionsAPI;
+class NvGLSLProgram;
+class NvStopWatch;
+
+/// Stable least-significant-digit radix sort of 32 bit keys and 32 bit values held in
+/// GL buffers, run in compute shaders (GL 4.3 or ES 3.1).  Each of the #PASSES passes
+/// sorts one #DIGIT_BITS bit digit in three dispatches:
+/// - count: every block of #BLOCK_SIZE keys histograms its digits
+/// - scan: one work group turns the histograms, stored digit by digit, into the
+///   offset at which each block's keys of each digit go
+/// - scatter: every block sorts its keys by the digit with one bit split per digit
+///   bit, then writes each key to its digit's offset plus its rank within the digit
+///
+/// The keys can be depth keys computed from a buffer of points (e.g. the vertex buffer
+/// of a particle system) with the values set to the point indices, so the values
+/// buffer can be drawn from as 32 bit indices, back to front, without the points
+/// ever being read back.
+///
+/// #emulate runs the same blocks, digits and splits on the CPU, so the algorithm can be
+/// checked (#runSelfTest) on machines without a GPU that runs compute shaders.
+///
+/// Sorters must be created, used and released with the GL context bound.
+class NvGPUSort
+{
+public:
+    NvGPUSort();
+    ~NvGPUSort();
+
+    /// Compiles the shaders.  Buffers are allocated on first use
+    /// \return true on success; false if compute shaders are not supported or do not build
+    bool init();
+
+    /// Deletes the programs and buffers
+    void release();
+
+    /// Computes the keys of the distances of points along an axis, as
+    /// NvRadixSort::computeDepthKeys does, and sets the values to the point indices
+    /// \param[in] points the GL buffer holding the points
+    /// \param[in] offset the byte offset of the first point in the buffer, a multiple of
+    /// GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+    /// \param[in] stride the distance between points in floats (e.g. 4 for xyzw), at least 3
+    /// \param[in] count the number of points
+    /// \param[in] axis the xyz of the axis
+    void computeDepthKeys(GLuint points, size_t offset, int32_t stride, int32_t count, const float* axis);
+
+    /// Uploads keys and values to sort
+    /// \param[in] keys count keys
+    /// \param[in] values count values, or NULL for the indices 0 to count-1
+    /// \param[in] count the number of keys
+    void setKeys(const uint32_t* keys, const uint32_t* values, int32_t count);
+
+    /// Sorts the keys set by #computeDepthKeys or #setKeys, and their values
+    void sort();
+
+    /// Reads the sorted keys and values back.  Waits for the GPU; for tests only
+    /// \param[out] keys receives the sorted keys, or NULL
+    /// \param[out] values receives the values in key order, or NULL
+    /// \return true on success
+    bool readResults(uint32_t* keys, uint32_t* values);
+
+    /// \return the buffer of the sorted values (GLuint), e.g. to draw from as indices
+    GLuint getValueBuffer() const { return m_values[0]; }
+
+    /// \return the buffer of the sorted keys (GLuint)
+    GLuint getKeyBuffer() const { return m_keys[0]; }
+
+    /// \return the number of keys set by the last #computeDepthKeys or #setKeys
+    int32_t getCount() const { return m_count; }
+
+    /// Sorts keys and values on the CPU with the blocks, digits and splits of the shaders
+    /// \param[in] keys count keys
+    /// \param[in] values count values
+    /// \param[in] count the number of keys
+    /// \param[out] sortedKeys count keys, sorted
+    /// \param[out] sortedValues count values, in the order of their keys
+    static void emulate(const uint32_t* keys, const uint32_t* values, int32_t count,
+        uint32_t* sortedKeys, uint32_t* sortedValues);
+
+    /// Checks #emulate, and the shaders when supported, against a reference stable sort
+    /// over several sizes and key distributions, and logs the GPU sort time.  Samples
+    /// that sort with this class run it as their -gpusorttest benchmark mode
+    /// \param[in] stopWatch the timer for the GPU sorts
+    /// \return true if every sort matched the reference
+    static bool runSelfTest(NvStopWatch* stopWatch);
+
+    /// Loads the entry points.  Must be called with the intended OpenGL context bound.
+    /// \param[in] api the OpenGL extensions retrieval interface object
+    static void globalInit(NvGLExtensionsAPI& api);
+
+    /// \return true if the context runs compute shaders with storage buffers
+    static bool isSupported() { return ms_supported; }
+
+    /// Keys per block (work group)
+    static const int32_t BLOCK_SIZE = 256;
+    /// Bits per digit
+    static const int32_t DIGIT_BITS = 4;
+    /// Buckets per digit
+    static const int32_t BUCKETS = 1 << DIGIT_BITS;
+    /// Digit passes over 32 bit keys
+    static const int32_t PASSES = 32 / DIGIT_BITS;
+
+protected:
+    /// \privatesection
+    NvGPUSort(const NvGPUSort&);
+    NvGPUSort& operator=(const NvGPUSort&);
+
+    void reserve(int32_t count);
+
+    NvGLSLProgram* m_keysProg;
+    NvGLSLProgram* m_countProg;
+    NvGLSLProgram* m_scanProg;
+    NvGLSLProgram* m_scatterProg;
+
+    // keys and values, sorted back and forth between the pairs; the results end in [0]
+    GLuint m_keys[2];
+    GLuint m_values[2];
+    // per digit, per block: the key counts, then the offsets
+    GLuint m_counts;
+    int32_t m_capacity;
+    int32_t m_count;
+
+    static bool ms_supported;
+    static bool ms_es;
+};
+
+#endif
@@ -0,0 +1,198 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGridIndexBuffer.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_GRID_INDEX_BUFFER_H
+#define NV_GRID_INDEX_BUFFER_H
+
+#include <NvFoundation.h>
+#include "NV/NvPlatformGL.h"
+
+/// \file
+/// Shared, cached index buffers for regular vertex grids.
+
+class NvGLExtensionsAPI;
+
+/// A GL index buffer triangulating a regular grid of vertices, shared by every
+/// user of the same grid shape.  The indices depend only on the shape, so all
+/// terrain tiles or water surfaces of one size draw from a single buffer
+/// instead of each building and uploading its own.
+///
+/// Each quad is split along the diagonal from its top right to its bottom left
+/// vertex, and its triangles are wound (r,c) (r,c+1) (r+1,c) and
+/// (r+1,c) (r,c+1) (r+1,c+1), where (r,c) is the vertex at row r and column c.
+///
+/// Two layouts are available:
+/// - triangles: a list ordered in column blocks that fit the post-transform
+///   vertex cache, each walked row by row.  The block width is picked by
+///   simulating a FIFO cache of #VERTEX_CACHE_SIZE entries
+/// - strips: one strip per column of quads, separated by primitive restart
+///   (ES 3.0, GL 4.3 or GL_ARB_ES3_compatibility) or else joined with
+///   degenerate triangles.  About half the indices of a list, but every
+///   vertex is transformed about twice
+///
+/// Indices are 16 bit while every vertex index fits below the 16 bit restart
+/// index, and 32 bit beyond that where the context supports them.
+///
+/// Buffers must be acquired, drawn and released with the GL context bound.
+class NvGridIndexBuffer
+{
+public:
+    /// Ways of triangulating the grid
+    enum Layout {
+        LAYOUT_TRIANGLES = 0,
+        LAYOUT_STRIPS
+    };
+
+    /// The grid shape; buffers are shared between equal descriptions
+    struct Desc {
+        int32_t columns;        ///< Vertices along a row, at least 2
+        int32_t rows;           ///< Rows of vertices, at least 2
+        int32_t rowStride;      ///< Index distance between vertically adjacent vertices, at least columns
+        int32_t firstVertex;    ///< Index of the vertex at row 0, column 0
+        bool skirts;            ///< Also draw a skirt below the grid edges; see #getSkirtVertex
+        Layout layout;          ///< How the grid is triangulated
+
+        /// Describes a tightly packed grid starting at vertex 0
+        Desc(int32_t columns_, int32_t rows_, Layout layout_ = LAYOUT_TRIANGLES) :
+            columns(columns_), rows(rows_), rowStride(columns_), firstVertex(0), skirts(false), layout(layout_) { }
+
+        bool operator<(const Desc& rhs) const;
+    };
+
+    /// Returns the buffer for a grid shape, building it on first use
+    /// \param[in] desc the grid shape
+    /// \return the shared buffer, or NULL if the grid needs 32 bit indices the context lacks.
+    /// Each successful call must be matched by a call to #release
+    static NvGridIndexBuffer* acquire(const Desc& desc);
+
+    /// Drops a reference taken by #acquire; the last one deletes the buffer
+    /// \param[in] buffer the buffer, or NULL
+    static void release(NvGridIndexBuffer* buffer);
+
+    /// Binds the buffer to GL_ELEMENT_ARRAY_BUFFER and draws the grid from the
+    /// vertex attributes currently set up.  The buffer is left bound
+    void draw() const;
+
+    /// Returns the vertex index of a skirt vertex.  The skirt vertices follow the
+    /// grid, from index firstVertex + rows * rowStride; skirt vertex n must copy
+    /// the position of the grid vertex returned here, lowered.  The order is the
+    /// top row, the bottom row, the left column then the right column, each in
+    /// increasing order, 2 * (columns + rows) vertices in all
+    /// \param[in] desc the grid shape
+    /// \param[in] n the skirt vertex, in [0, 2 * (columns + rows))
+    /// \return the index of the grid vertex below which it hangs
+    static int32_t getSkirtVertex(const Desc& desc, int32_t n);
+
+    /// \return the grid shape
+    const Desc& getDesc() const { return m_desc; }
+
+    /// \return the GL buffer name
+    GLuint getBuffer() const { return m_buffer; }
+
+    /// \return the primitive type drawn (GL_TRIANGLES or GL_TRIANGLE_STRIP)
+    GLenum getMode() const { return m_mode; }
+
+    /// \return the index type (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+    GLenum getIndexType() const { return m_indexType; }
+
+    /// \return the number of indices drawn
+    int32_t getIndexCount() const { return m_indexCount; }
+
+    /// \return the size of the buffer in bytes
+    size_t getBytes() const;
+
+    /// \return the number of users holding the buffer
+    int32_t getRefCount() const { return m_refCount; }
+
+    /// Average cache miss ratio: vertices transformed per triangle drawn with a
+    /// FIFO vertex cache of #VERTEX_CACHE_SIZE entries.  0.5 is the best a large
+    /// grid can reach, 3 means no reuse at all
+    /// \return the ACMR measured when the buffer was built
+    float getACMR() const { return m_acmr; }
+
+    /// Simulates a FIFO vertex cache over an index list
+    /// \param[in] indices the indices
+    /// \param[in] count the number of indices
+    /// \param[in] mode GL_TRIANGLES or GL_TRIANGLE_STRIP
+    /// \param[in] cacheSize the number of cache entries
+    /// \return the ACMR; degenerate triangles and restarts count as no triangle
+    static float computeACMR(const uint32_t* indices, int32_t count, GLenum mode, int32_t cacheSize);
+
+    /// Finds the primitive restart and 32 bit index support.  Must be called
+    /// with the intended OpenGL context bound.
+    /// \param[in] api the OpenGL extensions retrieval interface object
+    static void globalInit(NvGLExtensionsAPI& api);
+
+    ///@{
+    /// Totals over the live buffers
+    static int32_t getBufferCount();
+    static size_t getTotalBytes();
+    ///@}
+
+    /// Bytes the live buffers would take if each user had its own copy
+    /// \return the sum of the buffer sizes times their reference counts
+    static size_t getUnsharedBytes();
+
+    /// Entries in the simulated post-transform vertex cache
+    static const int32_t VERTEX_CACHE_SIZE = 16;
+
+    /// The restart index of 16 bit indices; vertex indices stay below it
+    static const uint32_t RESTART_INDEX_16 = 0xFFFF;
+
+protected:
+    /// \privatesection
+    NvGridIndexBuffer(const Desc& desc);
+    ~NvGridIndexBuffer();
+    NvGridIndexBuffer(const NvGridIndexBuffer&);
+    NvGridIndexBuffer& operator=(const NvGridIndexBuffer&);
+
+    bool build();
+    static void buildTriangles(const Desc& desc, int32_t blockWidth, uint32_t* indices, int32_t& count);
+    static void buildStrips(const Desc& desc, bool restart, uint32_t* indices, int32_t& count);
+    static void buildSkirts(const Desc& desc, bool strips, bool restart, uint32_t* indices, int32_t& count);
+
+    Desc m_desc;
+    GLuint m_buffer;
+    GLenum m_mode;
+    GLenum m_indexType;
+    int32_t m_indexCount;
+    int32_t m_refCount;
+    float m_acmr;
+
+    static bool ms_restart;
+    static bool ms_restartAlwaysOn;
+    static bool ms_uint32;
+};
+
+#endif
@@ -0,0 +1,199 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvMultiDraw.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_MULTI_DRAW_H
+#define NV_MULTI_DRAW_H
+
+#include <NvFoundation.h>
+#include "NV/NvPlatformGL.h"
+#include <vector>
+
+/// \file
+/// Several ranges of one vertex source drawn with as few GL calls as the context allows.
+
+class NvGLExtensionsAPI;
+
+/// Draws ranges (e.g. the depth slices of a particle system) of one vertex
+/// attribute array and an optional index buffer.
+///
+/// The vertex source is recorded once in a vertex array object where the context
+/// has them (GL 3.0, ES 3.0, GL_ARB_vertex_array_object or GL_OES_vertex_array_object),
+/// and recorded again only when it changes, so binding it costs one call.
+/// Without them, #bind sets the attributes and buffers up directly.  The same
+/// vertices may feed several attribute locations, so programs that place the
+/// attribute differently can draw from one bound source.
+///
+/// The ranges are set once per frame with #setRanges, and #draw draws any run of
+/// them with the method picked once per context by #globalInit:
+/// - indirect: one glMultiDraw*Indirect from a buffer of draw commands that is
+///   only rewritten when the ranges change (GL 4.3, GL_ARB_multi_draw_indirect
+///   or GL_EXT_multi_draw_indirect)
+/// - multi: one glMultiDrawElements or glMultiDrawArrays (GL, or ES with
+///   GL_EXT_multi_draw_arrays)
+/// - loop: one glDrawElements or glDrawArrays per range
+///
+/// Every GL call made through the object is counted, so callers can show the
+/// per-frame cost of their state changes and draws.
+///
+/// Typical use, once per frame:
+/// \code
+///     draw.setVertices(vbo, vboOffset, 4, ebo, &attr, 1);
+///     draw.setRanges(first, count, slices, GL_UNSIGNED_INT, eboOffset);
+///     draw.bind();
+///     for (int32_t i = 0; i < slices; i++)
+///         draw.draw(GL_POINTS, i, 1);     // or draw.draw(GL_POINTS, 0, slices)
+///     draw.unbind();
+/// \endcode
+class NvMultiDraw
+{
+public:
+    /// Ways of drawing the ranges, from the fewest to the most GL calls
+    enum Method {
+        METHOD_INDIRECT = 0,
+        METHOD_MULTI,
+        METHOD_LOOP
+    };
+
+    NvMultiDraw();
+    ~NvMultiDraw();
+
+    /// Creates the vertex array object and the draw command buffer, as the context
+    /// allows.  Must be called with the GL context bound.
+    void init();
+
+    /// Deletes the GL objects
+    void release();
+
+    /// Sets the vertex source: float attributes, tightly packed.  Changes are
+    /// recorded on the next #bind.
+    /// \param[in] vertexBuffer the GL_ARRAY_BUFFER holding the attribute
+    /// \param[in] offset the byte offset of the first vertex in vertexBuffer
+    /// \param[in] size the components per vertex
+    /// \param[in] indexBuffer the GL_ELEMENT_ARRAY_BUFFER, or 0 to draw arrays
+    /// \param[in] attribs the attribute locations fed with the vertices; duplicates are ignored
+    /// \param[in] attribCount the number of locations, at most #MAX_ATTRIBS
+    void setVertices(GLuint vertexBuffer, size_t offset, GLint size, GLuint indexBuffer,
+        const GLint* attribs, int32_t attribCount);
+
+    /// Sets the ranges #draw picks from.  For indirect draws the commands are
+    /// uploaded here, and only if they changed.
+    /// \param[in] first rangeCount first indices (relative to indexOffset) or first vertices
+    /// \param[in] count rangeCount index or vertex counts
+    /// \param[in] rangeCount the number of ranges
+    /// \param[in] indexType GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, or 0 to draw arrays
+    /// \param[in] indexOffset the byte offset of index 0 in the index buffer; a multiple of the index size
+    void setRanges(const GLint* first, const GLsizei* count, int32_t rangeCount,
+        GLenum indexType = 0, size_t indexOffset = 0);
+
+    /// Makes the vertex source (and the command buffer) current
+    void bind();
+
+    /// Restores the default vertex state after #bind
+    void unbind();
+
+    /// Draws a run of the ranges from the bound source
+    /// \param[in] mode the primitive type
+    /// \param[in] begin the first range
+    /// \param[in] count the number of ranges
+    void draw(GLenum mode, int32_t begin, int32_t count);
+
+    /// \return the GL calls made since the last #resetCallCount
+    uint32_t getCallCount() const { return m_calls; }
+
+    /// \return the draw calls among them
+    uint32_t getDrawCallCount() const { return m_drawCalls; }
+
+    /// Restarts the counts
+    void resetCallCount() { m_calls = 0; m_drawCalls = 0; }
+
+    /// \return the method this object draws with
+    Method getMethod() const { return m_method; }
+
+    /// Picks the draw method and loads the entry points.  Must be called with
+    /// the intended OpenGL context bound.
+    /// \param[in] api the OpenGL extensions retrieval interface object
+    static void globalInit(NvGLExtensionsAPI& api);
+
+    /// Restricts new objects to \p method or one making more calls, to exercise
+    /// the fallbacks on capable drivers
+    /// \param[in] method the method with the fewest calls to allow
+    static void limitMethod(Method method);
+
+    /// \return the method new objects draw with
+    static Method getDefaultMethod() { return ms_defaultMethod; }
+
+    /// \return true if the context has vertex array objects
+    static bool hasVertexArrays();
+
+    /// \return a short name for \p method
+    static const char* getMethodName(Method method);
+
+    /// The most attribute locations one vertex source feeds
+    static const int32_t MAX_ATTRIBS = 4;
+
+protected:
+    /// \privatesection
+    NvMultiDraw(const NvMultiDraw&);
+    NvMultiDraw& operator=(const NvMultiDraw&);
+
+    void setupVertices();
+
+    Method m_method;
+    GLuint m_vao;
+    GLuint m_commandBuffer;
+    bool m_dirty;
+
+    GLuint m_vertexBuffer;
+    size_t m_offset;
+    GLint m_size;
+    GLuint m_indexBuffer;
+    GLint m_attribs[MAX_ATTRIBS];
+    int32_t m_attribCount;
+
+    // the ranges, as the multi and loop draws take them
+    GLenum m_indexType;
+    std::vector<GLint> m_first;
+    std::vector<GLsizei> m_count;
+    std::vector<const void*> m_indices;
+
+    // the commands last written to m_commandBuffer
+    std::vector<GLuint> m_commands;
+
+    uint32_t m_calls;
+    uint32_t m_drawCalls;
+
+    static Method ms_defaultMethod;
+};
+
+#endif
@@ -0,0 +1,246 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvProfiler.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_PROFILER_H
+#define NV_PROFILER_H
+
+#include <NvFoundation.h>
+#include <string>
+#include <vector>
+
+/// \file
+/// Hierarchical CPU/GPU scope profiler with Chrome trace export.
+
+class NvGLExtensionsAPI;
+
+/// Hierarchical, named scope profiler.
+/// CPU scopes may be opened on any thread with #NV_PROFILE_SCOPE; each thread
+/// records into its own fixed-size ring buffer, so recording never takes a lock.
+/// GPU scopes (#NV_PROFILE_GPU_SCOPE) must be opened on the thread that owns the
+/// GL context.  They take a pair of timestamp queries from a pool that is several
+/// frames deep, and their results are collected without stalling once the GPU has
+/// caught up.
+///
+/// Once per frame, #endFrame drains all of the buffers.  It updates the per-scope
+/// summary shown by the sample framework's overlay, and, while a capture is
+/// active, keeps the events for #writeChromeTrace.
+///
+/// All functions are static; the profiler is disabled (and scopes cost a single
+/// branch) until #globalInit is called.
+class NvProfiler
+{
+public:
+    /// Source of GPU timestamps.  The profiler owns the backend passed to #globalInit
+    class GPUBackend {
+    public:
+        virtual ~GPUBackend() { }
+
+        /// Allocates the timestamp queries.  Called with the GL context bound
+        /// \param[in] count the number of timestamps that may be in flight at once
+        /// \return true on success
+        virtual bool init(int32_t count) = 0;
+
+        /// Records a timestamp into the given query slot once the GPU reaches it
+        /// \param[in] slot the query slot in [0, count)
+        virtual void timestamp(int32_t slot) = 0;
+
+        /// Returns whether the timestamp in the given slot has been written
+        /// \param[in] slot the query slot in [0, count)
+        /// \return true if #getTimestamp may be called without blocking
+        virtual bool isAvailable(int32_t slot) = 0;
+
+        /// Returns the timestamp in the given slot
+        /// \param[in] slot the query slot in [0, count)
+        /// \return the timestamp in nanoseconds
+        virtual uint64_t getTimestamp(int32_t slot) = 0;
+    };
+
+    /// Summary of one scope, averaged over the frames it covers
+    struct ScopeSummary {
+        std::string name; ///< The scope name
+        int32_t depth; ///< The nesting depth at which the scope was opened
+        bool gpu; ///< true for GPU scopes
+        float meanMs; ///< Mean time per frame spent in the scope, in milliseconds
+        float maxMs; ///< Maximum time spent in the scope in one frame, in milliseconds
+        float callsPerFrame; ///< Mean number of times the scope was entered per frame
+    };
+
+    /// Enables the profiler.
+    /// Must be called with the GL context bound if the backend uses GL
+    /// \param[in] gpu the GPU timestamp backend; the profiler takes ownership.  If NULL,
+    /// the null backend is used
+    static void globalInit(GPUBackend* gpu);
+
+    /// Disables the profiler and deletes the GPU backend.  Pending GPU scopes are discarded
+    static void globalShutdown();
+
+    /// Returns whether #globalInit has been called
+    /// \return true if scopes are being recorded
+    static bool isEnabled() { return ms_enabled; }
+
+    /// Creates a GPU backend using GL timestamp queries
+    /// \param[in] api the OpenGL extensions retrieval interface object
+    /// \return the backend, or NULL if the context cannot record timestamps
+    static GPUBackend* createGLBackend(NvGLExtensionsAPI& api);
+
+    /// Creates a GPU backend that needs no GPU.  Its "timestamps" are taken from
+    /// the CPU clock when the scope is recorded, so GPU scopes report their submission time
+    /// \return the backend
+    static GPUBackend* createNullBackend();
+
+    /// Names the calling thread in traces
+    /// \param[in] name the null-terminated thread name (copied)
+    static void setThreadName(const char* name);
+
+    /// Collects the events recorded since the last call, resolves completed GPU
+    /// scopes and updates the summary.  Call once per frame from the GL thread,
+    /// after the frame has been submitted
+    static void endFrame();
+
+    /// Starts capturing events for a trace
+    /// \param[in] frames the number of frames to capture
+    static void beginCapture(int32_t frames);
+
+    /// Returns whether a capture has been started and not yet finished
+    /// \return true while frames are still being captured
+    static bool isCapturing() { return ms_captureFramesLeft > 0; }
+
+    /// Returns whether a finished capture is waiting to be written
+    /// \return true if #writeChromeTrace has events to write
+    static bool hasCapture();
+
+    /// Writes the captured events as Chrome trace-event JSON (load in chrome://tracing)
+    /// and clears the capture
+    /// \param[in] filename the path of the file to write
+    /// \return true on success
+    static bool writeChromeTrace(const char* filename);
+
+    /// Returns the per-scope summary for the last complete summary interval, in
+    /// the order the scopes were first seen
+    /// \param[out] scopes receives the summaries
+    static void getSummary(std::vector<ScopeSummary>& scopes);
+
+    /// Restarts the whole-run totals returned by #getTotals
+    static void resetTotals();
+
+    /// Returns the per-scope summary of every frame since #resetTotals.
+    /// GPU scopes are counted when their results arrive, a few frames after the CPU ones
+    /// \param[out] scopes receives the summaries
+    /// \param[out] frames receives the number of frames summarized
+    static void getTotals(std::vector<ScopeSummary>& scopes, int32_t& frames);
+
+    /// Formats the summary as indented text, one scope per line
+    /// \param[out] text receives the report
+    static void formatSummary(std::string& text);
+
+    /// Returns the number of events lost to full ring buffers or an exhausted query pool
+    /// \return the dropped event count since #globalInit
+    static uint32_t getDroppedEventCount();
+
+    /// Returns the profiler clock
+    /// \return a monotonic time in nanoseconds
+    static uint64_t getTimeNs();
+
+    /// \privatesection
+    static void beginCPU(int32_t& depth);
+    static void endCPU(const char* name, int32_t depth, uint64_t startNs);
+    static int32_t beginGPU(const char* name);
+    static void endGPU(int32_t pair);
+
+    /// Timestamp query pairs in the GPU pool; deep enough for several frames in flight
+    static const int32_t GPU_QUERY_PAIRS = 256;
+    /// Events each thread can hold between calls to #endFrame
+    static const int32_t THREAD_BUFFER_EVENTS = 4096;
+    /// Frames averaged in each summary
+    static const int32_t SUMMARY_FRAMES = 30;
+
+protected:
+    static bool ms_enabled;
+    static int32_t ms_captureFramesLeft;
+};
+
+/// A CPU profiler scope; use through #NV_PROFILE_SCOPE
+struct NvProfilerCPUScope {
+    /// Constructor - opens the scope
+    /// \param [in] name the scope name; must be a string literal or otherwise outlive the profiler
+    NvProfilerCPUScope(const char* name) : m_name(NULL) {
+        if (NvProfiler::isEnabled()) {
+            m_name = name;
+            NvProfiler::beginCPU(m_depth);
+            m_start = NvProfiler::getTimeNs();
+        }
+    }
+    /// Destructor - closes the scope
+    ~NvProfilerCPUScope() {
+        if (m_name)
+            NvProfiler::endCPU(m_name, m_depth, m_start);
+    }
+    /// \privatesection
+    const char* m_name;
+    int32_t m_depth;
+    uint64_t m_start;
+};
+
+/// A GPU profiler scope; use through #NV_PROFILE_GPU_SCOPE
+struct NvProfilerGPUScope {
+    /// Constructor - opens the scope (the next OpenGL call will be the first timed)
+    /// \param [in] name the scope name; must be a string literal or otherwise outlive the profiler
+    NvProfilerGPUScope(const char* name)
+        : m_pair(NvProfiler::isEnabled() ? NvProfiler::beginGPU(name) : -1) { }
+    /// Destructor - closes the scope
+    ~NvProfilerGPUScope() {
+        if (m_pair >= 0)
+            NvProfiler::endGPU(m_pair);
+    }
+    /// \privatesection
+    int32_t m_pair;
+};
+
+#define NV_PROFILE_CONCAT_INNER(a, b) a##b
+#define NV_PROFILE_CONCAT(a, b) NV_PROFILE_CONCAT_INNER(a, b)
+
+/// Profiles the rest of the enclosing block on the CPU
+/// \code
+///     {
+///         NV_PROFILE_SCOPE("simulate");
+///         // ... my block of timed code
+///     }
+/// \endcode
+#define NV_PROFILE_SCOPE(name) NvProfilerCPUScope NV_PROFILE_CONCAT(nvProfileScope, __LINE__)(name)
+
+/// Profiles the GL commands issued in the rest of the enclosing block on the GPU.
+/// Must only be used on the thread that owns the GL context
+#define NV_PROFILE_GPU_SCOPE(name) NvProfilerGPUScope NV_PROFILE_CONCAT(nvProfileGPUScope, __LINE__)(name)
+
+#endif
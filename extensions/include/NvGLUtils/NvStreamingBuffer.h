@@ -0,0 +1,192 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvStreamingBuffer.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_STREAMING_BUFFER_H
+#define NV_STREAMING_BUFFER_H
+
+#include <NvFoundation.h>
+#include "NV/NvPlatformGL.h"
+
+/// \file
+/// Ring-buffered streaming of per-frame data into a GL buffer object.
+
+class NvGLExtensionsAPI;
+
+/// A GL buffer that is rewritten by the CPU every frame without stalling on
+/// the GPU reads of earlier frames.  The buffer is split into several slots;
+/// each frame writes the next slot while the GPU may still be drawing from the
+/// previous ones, and a fence placed after the draws that read a slot keeps
+/// it from being rewritten too early.  The write pointer may be handed to
+/// other threads, so producers can write their results straight into the slot.
+///
+/// The method is picked once per context by #globalInit:
+/// - persistent: one buffer from glBufferStorage, mapped coherently for its
+///   whole lifetime (GL 4.4, GL_ARB_buffer_storage or GL_EXT_buffer_storage)
+/// - unsynchronized: each write maps its slot with GL_MAP_UNSYNCHRONIZED_BIT,
+///   relying on the slot fences (GL 3.2 or ES 3.0)
+/// - orphan: a single slot whose storage is orphaned with glBufferData before
+///   each write, leaving the renaming to the driver (ES 2.0 and older GL)
+///
+/// Typical use, once per frame:
+/// \code
+///     float* dst = (float*)buffer.beginWrite();
+///     // ... fill dst, possibly from job system workers
+///     buffer.endWrite();
+///     glBindBuffer(GL_ARRAY_BUFFER, buffer.getBuffer());
+///     glVertexAttribPointer(attr, 4, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)buffer.getReadOffset());
+///     // ... draw
+///     buffer.fenceRead();
+/// \endcode
+class NvStreamingBuffer
+{
+public:
+    /// Ways of streaming, from the most to the least efficient
+    enum Method {
+        METHOD_PERSISTENT = 0,
+        METHOD_UNSYNCHRONIZED,
+        METHOD_ORPHAN
+    };
+
+    NvStreamingBuffer();
+    ~NvStreamingBuffer();
+
+    /// Creates the GL buffer.  Must be called with the GL context bound.
+    /// \param[in] target the binding point used to update the buffer (e.g. GL_ARRAY_BUFFER)
+    /// \param[in] slotSize the bytes written per frame
+    /// \param[in] slotCount the number of frames that may be in flight (forced to 1 when orphaning)
+    /// \param[in] initialData optional contents for every slot, slotSize bytes
+    /// \return true on success
+    bool init(GLenum target, size_t slotSize, int32_t slotCount = DEFAULT_SLOT_COUNT,
+        const void* initialData = NULL);
+
+    /// Deletes the GL buffer and fences
+    void release();
+
+    /// Starts writing the next slot, waiting for the GPU first if it is still
+    /// reading that slot (counted as a stall).
+    /// \return a write-only pointer to slotSize bytes, valid until #endWrite.
+    /// Never read through it; it may point to uncached memory.
+    void* beginWrite();
+
+    /// Finishes the write started by #beginWrite.  The slot becomes the one
+    /// returned by #getReadOffset.  Must be called on the GL thread once all
+    /// writers have finished.
+    void endWrite();
+
+    /// Fences the slot at #getReadOffset; call once after the draws that read it
+    void fenceRead();
+
+    /// \return the GL buffer name
+    GLuint getBuffer() const { return m_buffer; }
+
+    /// \return the byte offset of the most recently written slot in the buffer
+    size_t getReadOffset() const { return (size_t)m_readSlot * m_slotStride; }
+
+    /// \return the bytes written per frame
+    size_t getSlotSize() const { return m_slotSize; }
+
+    /// \return the number of slots
+    int32_t getSlotCount() const { return m_slotCount; }
+
+    /// \return the method this buffer streams with
+    Method getMethod() const { return m_method; }
+
+    /// \return the number of writes that had to wait for the GPU
+    uint32_t getStallCount() const { return m_stallCount; }
+
+    /// \return the total time spent waiting for the GPU, in milliseconds
+    float getStallMs() const { return m_stallMs; }
+
+    /// Picks the streaming method and loads its entry points.  Must be called
+    /// with the intended OpenGL context bound.
+    /// \param[in] api the OpenGL extensions retrieval interface object
+    static void globalInit(NvGLExtensionsAPI& api);
+
+    /// Restricts new buffers to \p method or a less efficient one, to exercise
+    /// the fallbacks on capable drivers
+    /// \param[in] method the most efficient method to allow
+    static void limitMethod(Method method);
+
+    /// \return the method new buffers stream with
+    static Method getDefaultMethod() { return ms_defaultMethod; }
+
+    /// \return a short name for \p method
+    static const char* getMethodName(Method method);
+
+    ///@{
+    /// Totals over all buffers since #globalInit
+    static uint32_t getTotalWriteCount() { return ms_totalWrites; }
+    static uint32_t getTotalStallCount() { return ms_totalStalls; }
+    static float getTotalStallMs() { return ms_totalStallMs; }
+    static uint64_t getTotalWriteBytes() { return ms_totalWriteBytes; }
+    ///@}
+
+    /// Slots used when none are requested: one being written, one queued and one being drawn
+    static const int32_t DEFAULT_SLOT_COUNT = 3;
+
+    /// The most slots a buffer can have
+    static const int32_t MAX_SLOTS = 8;
+
+protected:
+    /// \privatesection
+    NvStreamingBuffer(const NvStreamingBuffer&);
+    NvStreamingBuffer& operator=(const NvStreamingBuffer&);
+
+    bool create(Method method, const void* initialData);
+    void waitForSlot(int32_t slot);
+
+    GLenum m_target;
+    GLuint m_buffer;
+    Method m_method;
+    size_t m_slotSize;
+    size_t m_slotStride;
+    int32_t m_slotCount;
+    int32_t m_readSlot;
+    int32_t m_writeSlot;
+    uint8_t* m_persistent;
+    uint8_t* m_staging;
+    bool m_writing;
+    bool m_mapped;
+    void* m_fences[MAX_SLOTS];
+    uint32_t m_stallCount;
+    float m_stallMs;
+
+    static Method ms_defaultMethod;
+    static uint32_t ms_totalWrites;
+    static uint32_t ms_totalStalls;
+    static float ms_totalStallMs;
+    static uint64_t ms_totalWriteBytes;
+};
+
+#endif
@@ -120,6 +120,8 @@ public:
 
 protected:
     /// \privatesection
+    friend class NvProfilerGLBackend; // shares the timestamp query entry points
+
     void getResults() {
         // Make a pass over all timers - if any are pending results ("in flight"), then
         // grab the the time diff and add to the accumulator.  Then, mark the timer as 
@@ -166,11 +168,13 @@ protected:
     const static unsigned int NV_TIMESTAMP = 0x8E28;
 
     typedef void (KHRONOS_APIENTRY* NV_PFNGLGENQUERIESPROC) (GLsizei n, GLuint *ids);
+    typedef void (KHRONOS_APIENTRY* NV_PFNGLDELETEQUERIESPROC) (GLsizei n, const GLuint *ids);
     typedef void (KHRONOS_APIENTRY* NV_PFNGLQUERYCOUNTERPROC) (GLuint id, GLenum target);
     typedef void (KHRONOS_APIENTRY* NV_PFNGLGETQUERYOBJECTUIVPROC) (GLuint id, GLenum pname, GLuint *params);
     typedef void (KHRONOS_APIENTRY* NV_PFNGLGETQUERYOBJECTUI64VPROC) (GLuint id, GLenum pname, uint64_t *params);
 
     static NV_PFNGLGENQUERIESPROC          m_glGenQueries;
+    static NV_PFNGLDELETEQUERIESPROC       m_glDeleteQueries;
     static NV_PFNGLQUERYCOUNTERPROC        m_glQueryCounter;
     static NV_PFNGLGETQUERYOBJECTUIVPROC   m_glGetQueryObjectuiv;
     static NV_PFNGLGETQUERYOBJECTUI64VPROC m_glGetQueryObjectui64v;
@@ -0,0 +1,163 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvVertexPacking.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_VERTEX_PACKING_H
+#define NV_VERTEX_PACKING_H
+
+#include <NvFoundation.h>
+#include "NV/NvPlatformGL.h"
+
+/// \file
+/// A compact vertex format for streamed height fields, and the converters that fill it.
+
+class NvGLExtensionsAPI;
+
+/// A height field vertex in 32 bits: the height as a half float, then the unit
+/// normal as an octahedral vector in two signed normalized bytes.  The y (up)
+/// axis is the octahedron's pole, so upward normals never fold.  Decode in GLSL with
+/// \code
+///     vec3 decodeNormal(vec2 e)
+///     {
+///         vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+///         if (n.y < 0.0)
+///             n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+///         return normalize(n);
+///     }
+/// \endcode
+struct NvPackedHeightVertex {
+    uint16_t height;    ///< The height, half float
+    int8_t normal[2];   ///< The octahedral x and z of the normal, snorm8
+};
+
+/// The layout streamed instead of #NvPackedHeightVertex where the context cannot
+/// read half float attributes: the height and the unquantized octahedral normal
+/// as floats, 12 bytes.  The shaders decode both layouts alike.
+struct NvFloatHeightVertex {
+    float height;       ///< The height
+    float normal[2];    ///< The octahedral x and z of the normal
+};
+
+/// Converters from float heights and normals (or gradients) to #NvPackedHeightVertex,
+/// vectorized with SSE2 or NEON where available.  All paths produce the same bits,
+/// apart from the NaN payloads of the AArch64 half conversion.
+class NvVertexPacking
+{
+public:
+    /// Packs heights and unit normals
+    /// \param[in] heights count heights
+    /// \param[in] normals count normals, interleaved xyz
+    /// \param[in] count the number of vertices
+    /// \param[out] out count packed vertices; may be write-combined memory
+    static void packNormals(const float* heights, const float* normals, int32_t count, NvPackedHeightVertex* out);
+
+    /// Converts heights and unit normals to the float fallback layout
+    /// \param[in] heights count heights
+    /// \param[in] normals count normals, interleaved xyz
+    /// \param[in] count the number of vertices
+    /// \param[out] out count vertices; may be write-combined memory
+    static void packNormals(const float* heights, const float* normals, int32_t count, NvFloatHeightVertex* out);
+
+    /// Packs heights and unit normals in the layout setAttribPointers() reads:
+    /// #NvPackedHeightVertex if isSupported(), else #NvFloatHeightVertex
+    /// \param[in] heights count heights
+    /// \param[in] normals count normals, interleaved xyz
+    /// \param[in] count the number of vertices
+    /// \param[out] out count vertices of getVertexSize() bytes
+    static void writeNormals(const float* heights, const float* normals, int32_t count, void* out);
+
+    /// Packs heights and the normals of height field gradients: the normal of
+    /// gradient (gx, gz) is normalize(gx, 1, gz)
+    /// \param[in] heights count heights
+    /// \param[in] gradients count gradients, interleaved xz
+    /// \param[in] count the number of vertices
+    /// \param[out] out count packed vertices; may be write-combined memory
+    static void packGradients(const float* heights, const float* gradients, int32_t count, NvPackedHeightVertex* out);
+
+    /// Packs a single vertex
+    /// \param[in] height the height
+    /// \param[in] nx,ny,nz the unit normal
+    /// \return the packed vertex
+    static NvPackedHeightVertex pack(float height, float nx, float ny, float nz);
+
+    /// Converts a single vertex to the float fallback layout
+    /// \param[in] height the height
+    /// \param[in] nx,ny,nz the unit normal
+    /// \return the vertex
+    static NvFloatHeightVertex packFloat(float height, float nx, float ny, float nz);
+
+    /// Unpacks a vertex, as the shaders do
+    /// \param[in] v the packed vertex
+    /// \param[out] height the height
+    /// \param[out] normal the unit normal, xyz
+    static void unpack(const NvPackedHeightVertex& v, float& height, float* normal);
+
+    /// Converts a float to a half float, rounding to nearest even
+    static uint16_t floatToHalf(float f);
+
+    /// Converts a half float to a float
+    static float halfToFloat(uint16_t h);
+
+    /// Disables the SIMD paths, to compare them with the scalar one
+    /// \param[in] enabled false to pack with scalar code only
+    static void setSIMDEnabled(bool enabled) { ms_simd = enabled; }
+
+    /// \return the name of the SIMD path in use ("SSE2", "NEON" or "scalar")
+    static const char* getSIMDName();
+
+    /// \return the size of the vertices writeNormals() writes and setAttribPointers() reads
+    static size_t getVertexSize() { return isSupported() ? sizeof(NvPackedHeightVertex) : sizeof(NvFloatHeightVertex); }
+
+    /// Sets up the vertex attributes of the vertices in the bound GL_ARRAY_BUFFER,
+    /// #NvPackedHeightVertex if isSupported(), else #NvFloatHeightVertex
+    /// \param[in] heightAttr the float attribute receiving the height
+    /// \param[in] normalAttr the vec2 attribute receiving the octahedral normal
+    /// \param[in] offset the byte offset of the first vertex in the buffer
+    static void setAttribPointers(GLuint heightAttr, GLuint normalAttr, size_t offset);
+
+    /// Finds the half float vertex attribute type.  Must be called with the
+    /// intended OpenGL context bound.
+    /// \param[in] api the OpenGL extensions retrieval interface object
+    static void globalInit(NvGLExtensionsAPI& api);
+
+    /// \return true if the context can read half float vertex attributes
+    /// (GL 3.0, ES 3.0 or GL_OES_vertex_half_float), and so #NvPackedHeightVertex
+    static bool isSupported() { return ms_halfFloatType != 0; }
+
+protected:
+    /// \privatesection
+    static bool ms_simd;
+    static GLenum ms_halfFloatType;
+};
+
+#endif
@@ -455,6 +455,17 @@ bool NvAppBase::writeLogFile(const std::string& path, bool append, const char* f
     return true;
 }
 
+bool NvAppBase::writeDataFile(const std::string& path, const char* extension, const std::string& contents) {
+    std::string filename = "/sdcard/" + path + extension;
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (!fp)
+        return false;
+
+    bool ok = fwrite(contents.data(), 1, contents.size(), fp) == contents.size();
+    fclose(fp);
+    return ok;
+}
+
 void NvAppBase::forceLinkHack() {
 }
 
@@ -36,9 +36,12 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
 #include <vector>
 
 #include <time.h>
+#include <dlfcn.h>
 
 #define GLEW_STATIC
 #include <GL/glew.h>
@@ -282,6 +285,311 @@ static void focus(GLFWwindow*,int32_t focused)
 }
 
 
+// Headless mode ("-headless"): renders into an EGL pbuffer with no window or X
+// display, so test mode can run on a GPU-less machine with a software rasterizer
+// (e.g. Mesa llvmpipe).  libEGL is loaded at runtime so that windowed builds do
+// not depend on it.
+typedef void* NvEGLDisplay;
+typedef void* NvEGLConfig;
+typedef void* NvEGLSurface;
+typedef void* NvEGLContext;
+typedef int32_t NvEGLint;
+typedef uint32_t NvEGLBoolean;
+
+static const NvEGLint NV_EGL_NONE = 0x3038;
+static const NvEGLint NV_EGL_ALPHA_SIZE = 0x3021;
+static const NvEGLint NV_EGL_BLUE_SIZE = 0x3022;
+static const NvEGLint NV_EGL_GREEN_SIZE = 0x3023;
+static const NvEGLint NV_EGL_RED_SIZE = 0x3024;
+static const NvEGLint NV_EGL_DEPTH_SIZE = 0x3025;
+static const NvEGLint NV_EGL_STENCIL_SIZE = 0x3026;
+static const NvEGLint NV_EGL_SURFACE_TYPE = 0x3033;
+static const NvEGLint NV_EGL_RENDERABLE_TYPE = 0x3040;
+static const NvEGLint NV_EGL_EXTENSIONS = 0x3055;
+static const NvEGLint NV_EGL_HEIGHT = 0x3056;
+static const NvEGLint NV_EGL_WIDTH = 0x3057;
+static const NvEGLint NV_EGL_PBUFFER_BIT = 0x0001;
+static const NvEGLint NV_EGL_OPENGL_BIT = 0x0008;
+static const uint32_t NV_EGL_OPENGL_API = 0x30A2;
+static const uint32_t NV_EGL_PLATFORM_SURFACELESS_MESA = 0x31DD;
+
+struct NvEGLFunctions {
+    NvEGLDisplay (*GetDisplay)(void* nativeDisplay);
+    NvEGLBoolean (*Initialize)(NvEGLDisplay dpy, NvEGLint* major, NvEGLint* minor);
+    NvEGLBoolean (*Terminate)(NvEGLDisplay dpy);
+    const char* (*QueryString)(NvEGLDisplay dpy, NvEGLint name);
+    NvEGLBoolean (*ChooseConfig)(NvEGLDisplay dpy, const NvEGLint* attribs, NvEGLConfig* configs, NvEGLint size, NvEGLint* count);
+    NvEGLBoolean (*BindAPI)(uint32_t api);
+    NvEGLSurface (*CreatePbufferSurface)(NvEGLDisplay dpy, NvEGLConfig config, const NvEGLint* attribs);
+    NvEGLContext (*CreateContext)(NvEGLDisplay dpy, NvEGLConfig config, NvEGLContext share, const NvEGLint* attribs);
+    NvEGLBoolean (*DestroySurface)(NvEGLDisplay dpy, NvEGLSurface surface);
+    NvEGLBoolean (*DestroyContext)(NvEGLDisplay dpy, NvEGLContext ctx);
+    NvEGLBoolean (*MakeCurrent)(NvEGLDisplay dpy, NvEGLSurface draw, NvEGLSurface read, NvEGLContext ctx);
+    NvEGLBoolean (*SwapBuffers)(NvEGLDisplay dpy, NvEGLSurface surface);
+    NvEGLBoolean (*SwapInterval)(NvEGLDisplay dpy, NvEGLint interval);
+    NvEGLContext (*GetCurrentContext)();
+    NvEGLDisplay (*GetCurrentDisplay)();
+    void* (*GetProcAddress)(const char* procname);
+    NvEGLDisplay (*GetPlatformDisplayEXT)(uint32_t platform, void* nativeDisplay, const NvEGLint* attribs);
+};
+
+static bool loadEGL(NvEGLFunctions& egl) {
+    void* lib = dlopen("libEGL.so.1", RTLD_NOW | RTLD_GLOBAL);
+    if (!lib)
+        lib = dlopen("libEGL.so", RTLD_NOW | RTLD_GLOBAL);
+    if (!lib) {
+        fprintf(stderr, "Headless: cannot load libEGL: %s\n", dlerror());
+        return false;
+    }
+
+    struct { void** func; const char* name; } entries[] = {
+        { (void**)&egl.GetDisplay, "eglGetDisplay" },
+        { (void**)&egl.Initialize, "eglInitialize" },
+        { (void**)&egl.Terminate, "eglTerminate" },
+        { (void**)&egl.QueryString, "eglQueryString" },
+        { (void**)&egl.ChooseConfig, "eglChooseConfig" },
+        { (void**)&egl.BindAPI, "eglBindAPI" },
+        { (void**)&egl.CreatePbufferSurface, "eglCreatePbufferSurface" },
+        { (void**)&egl.CreateContext, "eglCreateContext" },
+        { (void**)&egl.DestroySurface, "eglDestroySurface" },
+        { (void**)&egl.DestroyContext, "eglDestroyContext" },
+        { (void**)&egl.MakeCurrent, "eglMakeCurrent" },
+        { (void**)&egl.SwapBuffers, "eglSwapBuffers" },
+        { (void**)&egl.SwapInterval, "eglSwapInterval" },
+        { (void**)&egl.GetCurrentContext, "eglGetCurrentContext" },
+        { (void**)&egl.GetCurrentDisplay, "eglGetCurrentDisplay" },
+        { (void**)&egl.GetProcAddress, "eglGetProcAddress" },
+    };
+
+    for (size_t i = 0; i < sizeof(entries) / sizeof(entries[0]); i++) {
+        *entries[i].func = dlsym(lib, entries[i].name);
+        if (!*entries[i].func) {
+            fprintf(stderr, "Headless: libEGL is missing %s\n", entries[i].name);
+            return false;
+        }
+    }
+
+    egl.GetPlatformDisplayEXT = (NvEGLDisplay (*)(uint32_t, void*, const NvEGLint*))
+        egl.GetProcAddress("eglGetPlatformDisplayEXT");
+    return true;
+}
+
+class NvGLHeadlessAppContext: public NvGLAppContext {
+public:
+    NvGLHeadlessAppContext(NvEGLFunctions& egl, NvEGLConfiguration& config) :
+        NvGLAppContext(NvGLPlatformInfo(
+            NvGLPlatformCategory::PLAT_DESKTOP, 
+            NvGLPlatformOS::OS_LINUX))
+        , mEGL(egl)
+        , mDisplay(NULL)
+        , mSurface(NULL)
+        , mContext(NULL)
+        , mWidth(0)
+        , mHeight(0)
+    {
+        mConfig = config;
+    }
+
+    ~NvGLHeadlessAppContext() {
+        if (mDisplay) {
+            mEGL.MakeCurrent(mDisplay, NULL, NULL, NULL);
+            if (mContext)
+                mEGL.DestroyContext(mDisplay, mContext);
+            if (mSurface)
+                mEGL.DestroySurface(mDisplay, mSurface);
+            mEGL.Terminate(mDisplay);
+        }
+    }
+
+    bool create(int32_t width, int32_t height) {
+        // Prefer Mesa's surfaceless platform, which needs no X server or DRM device
+        const char* clientExts = mEGL.QueryString(NULL, NV_EGL_EXTENSIONS);
+        if (mEGL.GetPlatformDisplayEXT && clientExts && strstr(clientExts, "EGL_MESA_platform_surfaceless"))
+            mDisplay = mEGL.GetPlatformDisplayEXT(NV_EGL_PLATFORM_SURFACELESS_MESA, NULL, NULL);
+
+        NvEGLint major, minor;
+        if (!mDisplay || !mEGL.Initialize(mDisplay, &major, &minor)) {
+            mDisplay = mEGL.GetDisplay(NULL);
+            if (!mDisplay || !mEGL.Initialize(mDisplay, &major, &minor)) {
+                fprintf(stderr, "Headless: cannot initialize an EGL display\n");
+                mDisplay = NULL;
+                return false;
+            }
+        }
+
+        if (!mEGL.BindAPI(NV_EGL_OPENGL_API)) {
+            fprintf(stderr, "Headless: EGL does not support desktop OpenGL\n");
+            return false;
+        }
+
+        const NvEGLint configAttribs[] = {
+            NV_EGL_SURFACE_TYPE, NV_EGL_PBUFFER_BIT,
+            NV_EGL_RENDERABLE_TYPE, NV_EGL_OPENGL_BIT,
+            NV_EGL_RED_SIZE, (NvEGLint)mConfig.redBits,
+            NV_EGL_GREEN_SIZE, (NvEGLint)mConfig.greenBits,
+            NV_EGL_BLUE_SIZE, (NvEGLint)mConfig.blueBits,
+            NV_EGL_ALPHA_SIZE, (NvEGLint)mConfig.alphaBits,
+            NV_EGL_DEPTH_SIZE, (NvEGLint)mConfig.depthBits,
+            NV_EGL_STENCIL_SIZE, (NvEGLint)mConfig.stencilBits,
+            NV_EGL_NONE
+        };
+        NvEGLConfig config;
+        NvEGLint count = 0;
+        if (!mEGL.ChooseConfig(mDisplay, configAttribs, &config, 1, &count) || count < 1) {
+            fprintf(stderr, "Headless: no EGL pbuffer config matches the requested bit depths\n");
+            return false;
+        }
+
+        const NvEGLint surfaceAttribs[] = { NV_EGL_WIDTH, width, NV_EGL_HEIGHT, height, NV_EGL_NONE };
+        mSurface = mEGL.CreatePbufferSurface(mDisplay, config, surfaceAttribs);
+        mContext = mEGL.CreateContext(mDisplay, config, NULL, NULL);
+        if (!mSurface || !mContext) {
+            fprintf(stderr, "Headless: cannot create the EGL pbuffer or context\n");
+            return false;
+        }
+
+        mWidth = width;
+        mHeight = height;
+        return true;
+    }
+
+    bool bindContext() {
+        return mEGL.MakeCurrent(mDisplay, mSurface, mSurface, mContext) != 0;
+    }
+
+    bool unbindContext() {
+        return mEGL.MakeCurrent(mDisplay, NULL, NULL, NULL) != 0;
+    }
+
+    bool swap() {
+        return mEGL.SwapBuffers(mDisplay, mSurface) != 0;
+    }
+
+    bool setSwapInterval(int32_t interval) {
+        return mEGL.SwapInterval(mDisplay, interval) != 0;
+    }
+
+    int32_t width() { return mWidth; }
+
+    int32_t height() { return mHeight; }
+
+    GLproc getGLProcAddress(const char* procname) {
+        return (GLproc)mEGL.GetProcAddress(procname);
+    }
+
+    bool isExtensionSupported(const char* ext) {
+        const char* exts = (const char*)glGetString(GL_EXTENSIONS);
+        if (!exts)
+            return false;
+
+        // match whole names only, so "GL_EXT_foo" does not match "GL_EXT_foo_bar"
+        const size_t len = strlen(ext);
+        for (const char* s = strstr(exts, ext); s; s = strstr(s + len, ext)) {
+            if ((s == exts || s[-1] == ' ') && (s[len] == ' ' || s[len] == '\0'))
+                return true;
+        }
+        return false;
+    }
+
+    void setConfiguration(const NvEGLConfiguration& config) { mConfig = config; }
+
+    virtual void* getCurrentPlatformContext() { 
+        return (void*)mEGL.GetCurrentContext(); 
+    }
+
+    virtual void* getCurrentPlatformDisplay() { 
+        return (void*)mEGL.GetCurrentDisplay(); 
+    }
+
+protected:
+    NvEGLFunctions& mEGL;
+    NvEGLDisplay mDisplay;
+    NvEGLSurface mSurface;
+    NvEGLContext mContext;
+    int32_t mWidth;
+    int32_t mHeight;
+};
+
+class NvHeadlessPlatformContext : public NvPlatformContext {
+public:
+    NvHeadlessPlatformContext() : mExitRequested(false), mResized(true) { }
+    virtual ~NvHeadlessPlatformContext() { }
+
+    virtual bool isAppRunning() { return !mExitRequested; }
+    virtual void requestExit() { mExitRequested = true; }
+    virtual bool pollEvents(NvInputCallbacks* callbacks) { return true; }
+    virtual bool isContextLost() { return false; }
+    virtual bool isContextBound() { return true; }
+    virtual bool shouldRender() { return true; }
+    virtual bool hasWindowResized() {
+        bool resized = mResized;
+        mResized = false;
+        return resized;
+    }
+    virtual NvGamepad* getGamepad() { return NULL; }
+    virtual void setAppTitle(const char* title) { }
+    virtual const std::vector<std::string>& getCommandLine() { return m_commandLine; }
+
+    std::vector<std::string> m_commandLine;
+protected:
+    bool mExitRequested;
+    bool mResized;
+};
+
+static int32_t runHeadless(int32_t argc, char *argv[])
+{
+    NvEGLFunctions egl;
+    if (!loadEGL(egl))
+        return EXIT_FAILURE;
+
+    NvHeadlessPlatformContext* platform = new NvHeadlessPlatformContext;
+    for (int i = 1; i < argc; i++) {
+        platform->m_commandLine.push_back(argv[i]);
+    }
+
+    sApp = NvAppFactory(platform);
+
+    NvEGLConfiguration config(NvGfxAPIVersionGL4(), 8, 8, 8, 8, 16, 0);
+    sApp->configurationCallback(config);
+
+    int32_t width = 1280, height = 720;
+    sApp->getRequestedWindowSize(width, height);
+
+    NvGLHeadlessAppContext* context = new NvGLHeadlessAppContext(egl, config);
+    if (!context->create(width, height) || !context->bindContext()) {
+        fprintf(stderr, "Headless: failed to create an offscreen GL context\n");
+        return EXIT_FAILURE;
+    }
+    sApp->setGLContext(context);
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    config.apiVer = NvGfxAPIVersion(NvGfxAPI::GL, major, minor);
+    context->setConfiguration(config);
+
+    // GLEW's GLX extension query fails without an X display; the GL entry
+    // points themselves are still loaded, which is all the samples need
+    GLenum err = glewInit();
+    if (GLEW_OK != err && !GLEW_VERSION_1_1) {
+        fprintf(stderr, "Error: %s\n", glewGetErrorString(err));
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stdout, "Headless %dx%d: %s / %s\n", width, height,
+        (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+
+    sApp->mainLoop();
+
+    delete sApp;
+    delete context;
+    delete platform;
+
+    NvAssetLoaderShutdown();
+
+    return EXIT_SUCCESS;
+}
+
 // program initialization
 static void initGL(int32_t argc, char *argv[])
 {
@@ -300,6 +608,11 @@ int32_t main(int32_t argc, char *argv[])
 
     NvAssetLoaderInit(NULL);
 
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-headless"))
+            return runHeadless(argc, argv);
+    }
+
     sWindowIsFocused = true;
     sForcedRenderCount = 0;
 
@@ -334,7 +647,11 @@ int32_t main(int32_t argc, char *argv[])
 
     NvGLLinuxAppContext* context = new NvGLLinuxAppContext(config);
 
-    window = glfwCreateWindow( 1280, 720, "Linux SDK Application", NULL, NULL );
+    width = 1280;
+    height = 720;
+    sApp->getRequestedWindowSize(width, height);
+
+    window = glfwCreateWindow( width, height, "Linux SDK Application", NULL, NULL );
     if (!window)
     {
         fprintf( stderr, "Failed to open GLFW window\n" );
@@ -414,8 +731,32 @@ bool NvAppBase::writeScreenShot(int32_t, int32_t, const uint8_t*, const std::str
     return false;
 }
 
-bool NvAppBase::writeLogFile(const std::string&, bool, const char*, ...) {
-    return false;
+bool NvAppBase::writeLogFile(const std::string& path, bool append, const char* fmt, ...) {
+    va_list ap;
+  
+    std::string filename = path + ".txt";
+    FILE* fp = fopen(filename.c_str(), append ? "a" : "w");
+    if (!fp)
+        return false;
+
+    va_start(ap, fmt); 
+    vfprintf(fp, fmt, ap);
+    fprintf(fp, "\n");
+    va_end(ap);
+
+    fclose(fp);
+    return true;
+}
+
+bool NvAppBase::writeDataFile(const std::string& path, const char* extension, const std::string& contents) {
+    std::string filename = path + extension;
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (!fp)
+        return false;
+
+    bool ok = fwrite(contents.data(), 1, contents.size(), fp) == contents.size();
+    fclose(fp);
+    return ok;
 }
 
 void NvAppBase::forceLinkHack() {
@@ -36,6 +36,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <vector>
 
 #include <sys/time.h>
@@ -408,8 +409,32 @@ bool NvAppBase::writeScreenShot(int32_t, int32_t, const uint8_t*, const std::str
     return false;
 }
 
-bool NvAppBase::writeLogFile(const std::string&, bool, const char*, ...) {
-    return false;
+bool NvAppBase::writeLogFile(const std::string& path, bool append, const char* fmt, ...) {
+    va_list ap;
+  
+    std::string filename = path + ".txt";
+    FILE* fp = fopen(filename.c_str(), append ? "a" : "w");
+    if (!fp)
+        return false;
+
+    va_start(ap, fmt); 
+    vfprintf(fp, fmt, ap);
+    fprintf(fp, "\n");
+    va_end(ap);
+
+    fclose(fp);
+    return true;
+}
+
+bool NvAppBase::writeDataFile(const std::string& path, const char* extension, const std::string& contents) {
+    std::string filename = path + extension;
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (!fp)
+        return false;
+
+    bool ok = fwrite(contents.data(), 1, contents.size(), fp) == contents.size();
+    fclose(fp);
+    return ok;
 }
 
 void NvAppBase::forceLinkHack() {
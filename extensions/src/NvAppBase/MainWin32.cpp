@@ -566,6 +566,18 @@ bool NvAppBase::writeLogFile(const std::string& path, bool append, const char* f
     return true;
 }
 
+bool NvAppBase::writeDataFile(const std::string& path, const char* extension, const std::string& contents) {
+    std::string filename = path + extension;
+    FILE* fp = NULL;
+    errno_t errnum = fopen_s(&fp, filename.c_str(), "wb");
+    if (!fp || errnum)
+        return false;
+
+    bool ok = fwrite(contents.data(), 1, contents.size(), fp) == contents.size();
+    fclose(fp);
+    return ok;
+}
+
 
 void NvAppBase::forceLinkHack() {
 }
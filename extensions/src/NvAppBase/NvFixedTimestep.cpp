@@ -0,0 +1,143 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvFixedTimestep.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvAppBase/NvFixedTimestep.h"
+#include "NvGLUtils/NvProfiler.h"
+
+uint32_t NvFixedTimestep::ms_totalSteps = 0;
+uint32_t NvFixedTimestep::ms_totalDroppedSteps = 0;
+float NvFixedTimestep::ms_totalStepMs = 0.0f;
+
+NvFixedTimestep::NvFixedTimestep(float stepSeconds, int32_t maxSteps)
+    : m_func(NULL)
+    , m_data(NULL)
+    , m_name("NvFixedTimestep steps")
+    , m_stepSeconds(stepSeconds)
+    , m_maxSteps(maxSteps)
+    , m_accumulator(0.0)
+    , m_batchSteps(0)
+    , m_batchStarted(false)
+    , m_batchMs(0.0f)
+    , m_stepCount(0)
+    , m_droppedSteps(0)
+    , m_stepMs(0.0f)
+{
+}
+
+NvFixedTimestep::~NvFixedTimestep()
+{
+    wait();
+}
+
+void NvFixedTimestep::setStepFunction(NvFixedStepFunction func, void* data, const char* name)
+{
+    wait();
+    m_func = func;
+    m_data = data;
+    if (name)
+        m_name = name;
+}
+
+int32_t NvFixedTimestep::begin(float frameSeconds, bool overlap)
+{
+    const int32_t steps = advance(frameSeconds);
+    start(overlap);
+    return steps;
+}
+
+int32_t NvFixedTimestep::advance(float frameSeconds)
+{
+    wait();
+
+    // the accumulator is a double so that long runs do not drift
+    m_accumulator += frameSeconds;
+    int32_t steps = (int32_t)(m_accumulator / m_stepSeconds);
+    m_accumulator -= steps * (double)m_stepSeconds;
+    if (m_accumulator < 0.0)
+        m_accumulator = 0.0;
+
+    // a frame that took too long drops whole steps rather than running ever more of them
+    if (steps > m_maxSteps) {
+        m_droppedSteps += steps - m_maxSteps;
+        ms_totalDroppedSteps += steps - m_maxSteps;
+        steps = m_maxSteps;
+    }
+    if (!m_func)
+        steps = 0;
+
+    m_batchSteps = steps;
+    return steps;
+}
+
+void NvFixedTimestep::start(bool overlap)
+{
+    if (m_batchSteps <= 0 || m_batchStarted)
+        return;
+
+    m_batchStarted = true;
+    if (overlap && NvJobSystem::getWorkerCount() > 0) {
+        NvJobSystem::run(batchJob, this, m_name, &m_counter);
+    } else {
+        runBatch();
+        wait();
+    }
+}
+
+void NvFixedTimestep::wait()
+{
+    if (!m_counter.isDone())
+        NvJobSystem::wait(&m_counter);
+
+    // the totals are kept on the calling thread, so schedulers running at once do not race
+    if (m_batchStarted) {
+        m_stepCount += m_batchSteps;
+        m_stepMs += m_batchMs;
+        ms_totalSteps += m_batchSteps;
+        ms_totalStepMs += m_batchMs;
+        m_batchStarted = false;
+    }
+    m_batchSteps = 0;
+}
+
+void NvFixedTimestep::batchJob(void* data)
+{
+    ((NvFixedTimestep*)data)->runBatch();
+}
+
+void NvFixedTimestep::runBatch()
+{
+    const uint64_t start = NvProfiler::getTimeNs();
+    for (int32_t i = 0; i < m_batchSteps; i++)
+        m_func(m_data, m_stepSeconds, i, m_batchSteps);
+    m_batchMs = (float)((NvProfiler::getTimeNs() - start) * 1.0e-6);
+}
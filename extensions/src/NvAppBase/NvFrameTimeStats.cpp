@@ -0,0 +1,438 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvFrameTimeStats.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvAppBase/NvFrameTimeStats.h"
+#include "NV/NvLogs.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Upper edges of the histogram buckets in ms; the last bucket is open-ended
+static const float HISTOGRAM_EDGES[] = { 4.0f, 8.0f, 12.0f, 16.7f, 20.0f, 25.0f, 33.3f, 50.0f, 100.0f };
+static const int32_t HISTOGRAM_BUCKETS = sizeof(HISTOGRAM_EDGES) / sizeof(HISTOGRAM_EDGES[0]) + 1;
+
+NvFrameTimeStats::NvFrameTimeStats(int32_t capacity)
+    : m_cpuCount(0)
+    , m_gpuCount(0)
+    , m_frames(0)
+{
+    m_cpuMs.resize(capacity);
+    m_gpuMs.resize(capacity);
+    m_gpuFrames.resize(capacity);
+
+    m_stutterThresholds.push_back(33.3f);
+    m_stutterThresholds.push_back(50.0f);
+    m_stutterThresholds.push_back(100.0f);
+}
+
+bool NvFrameTimeStats::setStutterThresholds(const char* list) {
+    std::vector<float> thresholds;
+    const char* s = list;
+    while (*s) {
+        char* end;
+        float value = (float)strtod(s, &end);
+        if (end == s)
+            break;
+        thresholds.push_back(value);
+        s = (*end == ',') ? end + 1 : end;
+    }
+
+    if (thresholds.empty())
+        return false;
+
+    std::sort(thresholds.begin(), thresholds.end());
+    m_stutterThresholds = thresholds;
+    return true;
+}
+
+void NvFrameTimeStats::addFrame(float cpuMs) {
+    if (m_cpuCount < (int32_t)m_cpuMs.size())
+        m_cpuMs[m_cpuCount++] = cpuMs;
+    m_frames++;
+}
+
+void NvFrameTimeStats::addGPUFrame(int32_t frame, float gpuMs) {
+    if (m_gpuCount < (int32_t)m_gpuMs.size()) {
+        m_gpuFrames[m_gpuCount] = frame;
+        m_gpuMs[m_gpuCount++] = gpuMs;
+    }
+}
+
+void NvFrameTimeStats::addCounter(const std::string& name, float value) {
+    for (size_t i = 0; i < m_counterNames.size(); i++) {
+        if (m_counterNames[i] == name) {
+            m_counterValues[i] += value;
+            return;
+        }
+    }
+    m_counterNames.push_back(name);
+    m_counterValues.push_back(value);
+}
+
+static void appendJSONString(const std::string& str, std::string& text) {
+    text += '"';
+    for (size_t i = 0; i < str.size(); i++) {
+        if (str[i] == '"' || str[i] == '\\')
+            text += '\\';
+        text += str[i];
+    }
+    text += '"';
+}
+
+static float percentile(const std::vector<float>& sorted, float p) {
+    // nearest-rank percentile
+    int32_t rank = (int32_t)ceilf(p * sorted.size()) - 1;
+    rank = std::max(0, std::min(rank, (int32_t)sorted.size() - 1));
+    return sorted[rank];
+}
+
+bool NvFrameTimeStats::summarize(const std::vector<float>& samples, int32_t count, Summary& summary) {
+    memset(&summary, 0, sizeof(summary));
+    if (count <= 0)
+        return false;
+
+    std::vector<float> sorted(samples.begin(), samples.begin() + count);
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (int32_t i = 0; i < count; i++)
+        sum += sorted[i];
+
+    summary.count = count;
+    summary.mean = (float)(sum / count);
+    summary.min = sorted.front();
+    summary.median = percentile(sorted, 0.5f);
+    summary.p90 = percentile(sorted, 0.9f);
+    summary.p99 = percentile(sorted, 0.99f);
+    summary.p999 = percentile(sorted, 0.999f);
+    summary.max = sorted.back();
+    return true;
+}
+
+int32_t NvFrameTimeStats::countStutters(float thresholdMs) const {
+    int32_t stutters = 0;
+    for (int32_t i = 0; i < m_cpuCount; i++) {
+        if (m_cpuMs[i] > thresholdMs)
+            stutters++;
+    }
+    return stutters;
+}
+
+static void histogram(const std::vector<float>& samples, int32_t count, int32_t* buckets) {
+    for (int32_t b = 0; b < HISTOGRAM_BUCKETS; b++)
+        buckets[b] = 0;
+    for (int32_t i = 0; i < count; i++) {
+        int32_t b = 0;
+        while (b < HISTOGRAM_BUCKETS - 1 && samples[i] > HISTOGRAM_EDGES[b])
+            b++;
+        buckets[b]++;
+    }
+}
+
+void NvFrameTimeStats::formatReport(std::string& text) const {
+    char line[256];
+    Summary s;
+    text.clear();
+
+    if (getCPUSummary(s)) {
+        sprintf(line, "CPU frame ms: min %.2f median %.2f p90 %.2f p99 %.2f p99.9 %.2f max %.2f (mean %.2f, %d frames)\n",
+            s.min, s.median, s.p90, s.p99, s.p999, s.max, s.mean, s.count);
+        text += line;
+    }
+    if (getGPUSummary(s)) {
+        sprintf(line, "GPU frame ms: min %.2f median %.2f p90 %.2f p99 %.2f p99.9 %.2f max %.2f (mean %.2f, %d frames)\n",
+            s.min, s.median, s.p90, s.p99, s.p999, s.max, s.mean, s.count);
+        text += line;
+    }
+    if (m_frames > m_cpuCount) {
+        sprintf(line, "(%d frames did not fit in the frame buffer and are not included)\n", m_frames - m_cpuCount);
+        text += line;
+    }
+
+    int32_t buckets[HISTOGRAM_BUCKETS];
+    histogram(m_cpuMs, m_cpuCount, buckets);
+    text += "CPU frame time histogram:\n";
+    for (int32_t b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        float lo = b ? HISTOGRAM_EDGES[b - 1] : 0.0f;
+        if (b < HISTOGRAM_BUCKETS - 1)
+            sprintf(line, "  %6.1f - %6.1f ms: %d\n", lo, HISTOGRAM_EDGES[b], buckets[b]);
+        else
+            sprintf(line, "  %6.1f +        ms: %d\n", lo, buckets[b]);
+        text += line;
+    }
+
+    for (size_t i = 0; i < m_stutterThresholds.size(); i++) {
+        sprintf(line, "Stutters > %.1f ms: %d\n", m_stutterThresholds[i], countStutters(m_stutterThresholds[i]));
+        text += line;
+    }
+
+    for (size_t i = 0; i < m_counterNames.size(); i++) {
+        sprintf(line, "%.3f\n", m_counterValues[i]);
+        text += m_counterNames[i] + ": " + line;
+    }
+}
+
+void NvFrameTimeStats::appendSummaryJSON(const char* key, const Summary& s, std::string& text) {
+    char buffer[384];
+    sprintf(buffer, "  \"%s\": { \"count\": %d, \"mean\": %.4f, \"min\": %.4f, \"median\": %.4f, "
+        "\"p90\": %.4f, \"p99\": %.4f, \"p99.9\": %.4f, \"max\": %.4f },\n",
+        key, s.count, s.mean, s.min, s.median, s.p90, s.p99, s.p999, s.max);
+    text += buffer;
+}
+
+void NvFrameTimeStats::formatJSON(const std::string& name, std::string& text) const {
+    char buffer[128];
+    Summary s;
+
+    text = "{\n  \"test\": ";
+    appendJSONString(name, text);
+    text += ",\n";
+
+    sprintf(buffer, "  \"frames\": %d,\n", m_frames);
+    text += buffer;
+
+    if (getCPUSummary(s))
+        appendSummaryJSON("cpu", s, text);
+    if (getGPUSummary(s))
+        appendSummaryJSON("gpu", s, text);
+
+    int32_t buckets[HISTOGRAM_BUCKETS];
+    histogram(m_cpuMs, m_cpuCount, buckets);
+    text += "  \"histogram\": [";
+    for (int32_t b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        if (b < HISTOGRAM_BUCKETS - 1)
+            sprintf(buffer, "%s{ \"max\": %.1f, \"frames\": %d }", b ? ", " : " ", HISTOGRAM_EDGES[b], buckets[b]);
+        else
+            sprintf(buffer, ", { \"max\": null, \"frames\": %d } ],\n", buckets[b]);
+        text += buffer;
+    }
+
+    text += "  \"stutters\": [";
+    for (size_t i = 0; i < m_stutterThresholds.size(); i++) {
+        sprintf(buffer, "%s{ \"threshold\": %.1f, \"frames\": %d }", i ? ", " : " ",
+            m_stutterThresholds[i], countStutters(m_stutterThresholds[i]));
+        text += buffer;
+    }
+    text += " ],\n";
+
+    text += "  \"counters\": {";
+    for (size_t i = 0; i < m_counterNames.size(); i++) {
+        text += i ? ", " : " ";
+        appendJSONString(m_counterNames[i], text);
+        sprintf(buffer, ": %.4f", m_counterValues[i]);
+        text += buffer;
+    }
+    text += " }\n}\n";
+}
+
+void NvFrameTimeStats::formatCSV(std::string& text) const {
+    char line[64];
+    text = "frame,cpu_ms,gpu_ms\n";
+    int32_t g = 0;
+    for (int32_t i = 0; i < m_cpuCount; i++) {
+        // both series are in frame order; skip GPU times of frames that were not stored
+        while (g < m_gpuCount && m_gpuFrames[g] < i)
+            g++;
+        if (g < m_gpuCount && m_gpuFrames[g] == i)
+            sprintf(line, "%d,%.4f,%.4f\n", i, m_cpuMs[i], m_gpuMs[g]);
+        else
+            sprintf(line, "%d,%.4f,\n", i, m_cpuMs[i]);
+        text += line;
+    }
+}
+
+// Just enough JSON to read back the files written by formatJSON: objects are
+// walked member by member, so a key only matches at the level it is looked up
+static const char* skipSpace(const char* p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+        p++;
+    return p;
+}
+
+static const char* parseJSONString(const char* p, std::string& str) {
+    if (*p != '"')
+        return NULL;
+    str.clear();
+    for (p++; *p && *p != '"'; p++) {
+        if (*p == '\\' && p[1])
+            p++;
+        str += *p;
+    }
+    return (*p == '"') ? p + 1 : NULL;
+}
+
+static const char* skipJSONValue(const char* p) {
+    std::string ignored;
+    if (*p == '"')
+        return parseJSONString(p, ignored);
+
+    if (*p == '{' || *p == '[') {
+        int32_t depth = 0;
+        while (*p) {
+            if (*p == '"') {
+                p = parseJSONString(p, ignored);
+                if (!p)
+                    return NULL;
+                continue;
+            }
+            if (*p == '{' || *p == '[')
+                depth++;
+            else if ((*p == '}' || *p == ']') && --depth == 0)
+                return p + 1;
+            p++;
+        }
+        return NULL;
+    }
+
+    // number, true, false or null
+    while (*p && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n')
+        p++;
+    return p;
+}
+
+static const char* findJSONMember(const char* obj, const char* key) {
+    const char* p = skipSpace(obj);
+    if (*p != '{')
+        return NULL;
+    p = skipSpace(p + 1);
+
+    std::string name;
+    while (*p == '"') {
+        p = parseJSONString(p, name);
+        if (!p)
+            return NULL;
+        p = skipSpace(p);
+        if (*p != ':')
+            return NULL;
+        p = skipSpace(p + 1);
+        if (name == key)
+            return p;
+
+        p = skipJSONValue(p);
+        if (!p)
+            return NULL;
+        p = skipSpace(p);
+        if (*p != ',')
+            return NULL;
+        p = skipSpace(p + 1);
+    }
+    return NULL;
+}
+
+static bool readSummaryJSON(const char* json, const char* key, NvFrameTimeStats::Summary& s) {
+    memset(&s, 0, sizeof(s));
+
+    const char* obj = findJSONMember(json, key);
+    if (!obj || *obj != '{')
+        return false;
+
+    struct Field { const char* name; float* value; };
+    float count = 0.0f;
+    Field fields[] = {
+        { "count", &count }, { "mean", &s.mean }, { "min", &s.min },
+        { "median", &s.median }, { "p90", &s.p90 }, { "p99", &s.p99 },
+        { "p99.9", &s.p999 }, { "max", &s.max }
+    };
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        const char* f = findJSONMember(obj, fields[i].name);
+        if (!f)
+            return false;
+        *fields[i].value = (float)atof(f);
+    }
+    s.count = (int32_t)count;
+    return true;
+}
+
+bool NvFrameTimeStats::readBaseline(const char* filename, Summary& cpu, Summary& gpu) {
+    FILE* fp = fopen(filename, "rb");
+    if (!fp) {
+        LOGE("Cannot open baseline %s", filename);
+        return false;
+    }
+
+    std::string json;
+    char buffer[1024];
+    size_t len;
+    while ((len = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        json.append(buffer, len);
+    fclose(fp);
+
+    readSummaryJSON(json.c_str(), "gpu", gpu);
+    if (!readSummaryJSON(json.c_str(), "cpu", cpu)) {
+        LOGE("Baseline %s has no CPU frame time summary", filename);
+        return false;
+    }
+    return true;
+}
+
+bool NvFrameTimeStats::compareSeries(const char* series, const Summary& current, const Summary& baseline,
+    float tolerance, std::string& report) {
+    const char* names[] = { "median", "p90", "p99" };
+    const float cur[] = { current.median, current.p90, current.p99 };
+    const float base[] = { baseline.median, baseline.p90, baseline.p99 };
+
+    bool passed = true;
+    char line[192];
+    for (int32_t i = 0; i < 3; i++) {
+        float limit = base[i] * (1.0f + tolerance);
+        bool ok = cur[i] <= limit;
+        sprintf(line, "%s %s: %.3f ms vs baseline %.3f ms (%+.1f%%) %s\n", series, names[i], cur[i], base[i],
+            (base[i] > 0.0f) ? (cur[i] / base[i] - 1.0f) * 100.0f : 0.0f, ok ? "ok" : "REGRESSION");
+        report += line;
+        passed = passed && ok;
+    }
+    return passed;
+}
+
+bool NvFrameTimeStats::compareToBaseline(const Summary& cpu, const Summary& gpu, float tolerance, std::string& report) const {
+    report.clear();
+
+    Summary s;
+    if (!getCPUSummary(s)) {
+        report = "No frames recorded\n";
+        return false;
+    }
+    bool passed = compareSeries("CPU", s, cpu, tolerance, report);
+
+    if (gpu.count > 0) {
+        if (getGPUSummary(s))
+            passed = compareSeries("GPU", s, gpu, tolerance, report) && passed;
+        else
+            report += "GPU: no GPU times recorded in this run; not compared\n";
+    }
+
+    return passed;
+}
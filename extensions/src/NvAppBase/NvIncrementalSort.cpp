@@ -0,0 +1,293 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvIncrementalSort.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "NvAppBase/NvIncrementalSort.h"
+
+#include <string.h>
+
+uint32_t NvIncrementalSort::ms_totalSorts[PATH_COUNT] = { 0, 0, 0, 0 };
+uint64_t NvIncrementalSort::ms_totalMoved = 0;
+uint64_t NvIncrementalSort::ms_totalShifted = 0;
+
+// Fewer keys taken out of order than this are insertion sorted rather than radix sorted
+static const int32_t INSERTION_SORT_MAX = 32;
+
+// A key that fell behind by at most this many places is inserted into the sorted run
+static const int32_t INSERTION_WINDOW = 32;
+
+// Keys shifted by the insertions, per key sorted, before a radix sort is cheaper
+static const int32_t MAX_SHIFTS_PER_KEY = 1;
+
+// Most sorts skipped after the keys were found too disordered
+static const int32_t MAX_BACKOFF = 16;
+
+NvIncrementalSort::NvIncrementalSort(float maxDisorder)
+    : m_maxDisorder(maxDisorder)
+    , m_current(0)
+    , m_count(0)
+    , m_keys(NULL)
+    , m_movedKeys(NULL)
+    , m_movedValues(NULL)
+    , m_movedOrder(NULL)
+    , m_capacity(0)
+    , m_skip(0)
+    , m_backoff(0)
+    , m_lastPath(PATH_NONE)
+    , m_lastMoved(0)
+    , m_lastShifted(0)
+{
+    m_order[0] = m_order[1] = NULL;
+}
+
+NvIncrementalSort::~NvIncrementalSort()
+{
+    delete[] m_order[0];
+    delete[] m_order[1];
+    delete[] m_keys;
+    delete[] m_movedKeys;
+    delete[] m_movedValues;
+    delete[] m_movedOrder;
+}
+
+const char* NvIncrementalSort::getPathName(Path path)
+{
+    switch (path) {
+        case PATH_RADIX: return "radix";
+        case PATH_SORTED: return "sorted";
+        case PATH_MERGE: return "merge";
+        default: return "none";
+    }
+}
+
+void NvIncrementalSort::reserve(int32_t count)
+{
+    if (count <= m_capacity)
+        return;
+
+    // the previous order is lost with the old buffers
+    delete[] m_order[0];
+    delete[] m_order[1];
+    delete[] m_keys;
+    delete[] m_movedKeys;
+    delete[] m_movedValues;
+    delete[] m_movedOrder;
+    m_order[0] = new uint32_t[count];
+    m_order[1] = new uint32_t[count];
+    m_keys = new uint32_t[count];
+    m_movedKeys = new uint32_t[count];
+    m_movedValues = new uint32_t[count];
+    m_movedOrder = new uint32_t[count];
+    m_capacity = count;
+    m_count = 0;
+}
+
+// Sorts into m_order[1 - m_current] from the previous order; returns false, having
+// changed nothing that matters, if too many keys are out of order
+bool NvIncrementalSort::mergeSort(const uint32_t* keys, int32_t count)
+{
+    const uint32_t* prev = m_order[m_current];
+    uint32_t* next = m_order[1 - m_current];
+    const int32_t maxMoved = (int32_t)(count * m_maxDisorder);
+    const int64_t maxShifted = (int64_t)count * MAX_SHIFTS_PER_KEY;
+
+    for (int32_t i = 0; i < count; i++)
+        m_keys[i] = keys[prev[i]];
+
+    // Keep the keys that continue the sorted run, compacting them in place.  A key
+    // greater than the next one and than the key a window ahead is the one out of
+    // place (it jumped forward), rather than everything after it.  A key that fell
+    // a few places behind is inserted into the run; the others are taken out.
+    int32_t kept = 0, moved = 0, inserted = 0;
+    int64_t shifted = 0;
+    uint32_t last = 0;
+    for (int32_t i = 0; i < count; i++) {
+        const uint32_t key = m_keys[i];
+        const int32_t ahead = (i + INSERTION_WINDOW < count) ? i + INSERTION_WINDOW : count - 1;
+        const bool jumped = (i + 1 < count) && (key > m_keys[i + 1]) && (key > m_keys[ahead]);
+        if (key >= last && !jumped) {
+            m_keys[kept] = key;
+            next[kept] = prev[i];
+            kept++;
+            last = key;
+            continue;
+        }
+
+        if (key < last) {
+            // the end of the run may be the key that jumped forward, when it is greater
+            // than this key and the next one, and this key fits before it
+            while (kept > 0 && m_keys[kept - 1] > key && (i + 1 == count || m_keys[kept - 1] > m_keys[i + 1])
+                && (kept == 1 || m_keys[kept - 2] <= key)) {
+                if (moved == maxMoved)
+                    return false;
+                kept--;
+                m_movedKeys[moved] = m_keys[kept];
+                m_movedValues[moved] = next[kept];
+                moved++;
+            }
+            last = (kept > 0) ? m_keys[kept - 1] : 0;
+            if (key >= last) {
+                m_keys[kept] = key;
+                next[kept] = prev[i];
+                kept++;
+                last = key;
+                continue;
+            }
+
+            // after the equal keys already in the run, which came first last time
+            const int32_t stop = (kept > INSERTION_WINDOW) ? kept - INSERTION_WINDOW : 0;
+            int32_t p = kept - 1;
+            while (p > stop && m_keys[p - 1] > key)
+                p--;
+            if (p == 0 || m_keys[p - 1] <= key) {
+                const int32_t n = kept - p;
+                shifted += n;
+                if (shifted > maxShifted)
+                    return false;
+                memmove(m_keys + p + 1, m_keys + p, n * sizeof(uint32_t));
+                memmove(next + p + 1, next + p, n * sizeof(uint32_t));
+                m_keys[p] = key;
+                next[p] = prev[i];
+                kept++;
+                inserted++;
+                continue;
+            }
+        }
+
+        if (moved == maxMoved)
+            return false;
+        m_movedKeys[moved] = key;
+        m_movedValues[moved] = prev[i];
+        moved++;
+    }
+
+    m_lastMoved = moved + inserted;
+    m_lastShifted = (int32_t)shifted;
+    if (moved == 0)
+        return true;
+
+    // sort the keys taken out, keeping equal ones in their previous order
+    const uint32_t* sortedKeys = m_movedKeys;
+    const uint32_t* sortedValues = m_movedValues;
+    if (moved <= INSERTION_SORT_MAX) {
+        for (int32_t j = 1; j < moved; j++) {
+            const uint32_t key = m_movedKeys[j];
+            const uint32_t value = m_movedValues[j];
+            int32_t k = j - 1;
+            for (; k >= 0 && m_movedKeys[k] > key; k--) {
+                m_movedKeys[k + 1] = m_movedKeys[k];
+                m_movedValues[k + 1] = m_movedValues[k];
+            }
+            m_movedKeys[k + 1] = key;
+            m_movedValues[k + 1] = value;
+        }
+    } else {
+        // the tail of m_keys past the kept keys is free for the sorted ones
+        m_radix.sort(m_movedKeys, moved, m_movedOrder);
+        uint32_t* keysOut = m_keys + kept;
+        for (int32_t j = 0; j < moved; j++) {
+            const uint32_t o = m_movedOrder[j];
+            keysOut[j] = m_movedKeys[o];
+            m_movedOrder[j] = m_movedValues[o];
+        }
+        sortedKeys = keysOut;
+        sortedValues = m_movedOrder;
+    }
+
+    // merge from the back, in place in next; on equal keys the kept ones go first
+    int32_t i = kept - 1, j = moved - 1, w = count - 1;
+    while (j >= 0) {
+        if (i >= 0 && m_keys[i] > sortedKeys[j])
+            next[w--] = next[i--];
+        else
+            next[w--] = sortedValues[j--];
+    }
+    return true;
+}
+
+template <class IndexT>
+void NvIncrementalSort::sortKeys(const uint32_t* keys, int32_t count, IndexT* indices)
+{
+    if (count <= 0) {
+        m_count = 0;
+        return;
+    }
+
+    if (count != m_count)
+        reserve(count);
+
+    // After the keys were found too disordered to merge, the next few sorts go
+    // straight to the radix sort, more of them each time it happens again
+    bool merged = false;
+    m_lastMoved = 0;
+    m_lastShifted = 0;
+    if (count == m_count && m_skip == 0) {
+        merged = mergeSort(keys, count);
+        if (merged) {
+            m_backoff = 0;
+        } else {
+            m_backoff = (m_backoff == 0) ? 1 : ((2 * m_backoff < MAX_BACKOFF) ? 2 * m_backoff : MAX_BACKOFF);
+            m_skip = m_backoff;
+        }
+    } else if (m_skip > 0) {
+        m_skip--;
+    }
+
+    if (merged) {
+        m_lastPath = (m_lastMoved == 0) ? PATH_SORTED : PATH_MERGE;
+        m_current = 1 - m_current;
+    } else {
+        m_radix.sort(keys, count, m_order[m_current]);
+        m_lastPath = PATH_RADIX;
+        m_lastMoved = 0;
+        m_lastShifted = 0;
+        m_count = count;
+    }
+    ms_totalSorts[m_lastPath]++;
+    ms_totalMoved += m_lastMoved;
+    ms_totalShifted += m_lastShifted;
+
+    const uint32_t* order = m_order[m_current];
+    for (int32_t i = 0; i < count; i++)
+        indices[i] = (IndexT)order[i];
+}
+
+void NvIncrementalSort::sort(const uint32_t* keys, int32_t count, uint32_t* indices)
+{
+    sortKeys(keys, count, indices);
+}
+
+void NvIncrementalSort::sort(const uint32_t* keys, int32_t count, uint16_t* indices)
+{
+    sortKeys(keys, count, indices);
+}
@@ -0,0 +1,614 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvJobSystem.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvAppBase/NvJobSystem.h"
+#include "NvGLUtils/NvProfiler.h"
+#include "NV/NvLogs.h"
+#include "R3/thread.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define NV_JOB_TLS __declspec(thread)
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#define NV_JOB_TLS __thread
+#endif
+
+int32_t NvJobSystem::ms_workerCount = 0;
+
+// returns the new value; a full memory barrier
+static inline int32_t atomicAdd(volatile int32_t* value, int32_t delta) {
+#ifdef _WIN32
+    return (int32_t)InterlockedExchangeAdd((volatile LONG*)value, delta) + delta;
+#else
+    return __sync_add_and_fetch(value, delta);
+#endif
+}
+
+// R3's Mutex and Condition are header-only, but r3::getNumCPUCores is built into the R3
+// library, which only some samples link
+static int32_t getCPUCoreCount() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const int32_t cores = (int32_t)info.dwNumberOfProcessors;
+#else
+    const int32_t cores = (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return (cores > 0) ? cores : 1;
+}
+
+// a waiter yields this many times before blocking, so short waits stay off the lock
+static const int32_t WAIT_SPIN_COUNT = 64;
+
+static inline void yieldThread() {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+struct Job {
+    NvJobFunction func;
+    void* data;
+    const char* name;
+    NvJobCounter* counter;
+};
+
+// A ring of jobs.  The owning thread pushes and pops at the back; other threads
+// take from the front, so a thief gets the oldest (usually largest) work.  Jobs
+// are small and short-lived, so a lock per operation is cheaper than contention
+// on a lock-free deque's fences would suggest, and it keeps the code obviously correct.
+struct JobQueue {
+    r3::Mutex mutex;
+    Job jobs[NvJobSystem::QUEUE_CAPACITY];
+    volatile int32_t head;
+    volatile int32_t tail;
+
+    JobQueue() : head(0), tail(0) { }
+
+    bool push(const Job& job) {
+        r3::ScopedMutex lock(mutex);
+        if (tail - head >= NvJobSystem::QUEUE_CAPACITY)
+            return false;
+        jobs[tail++ & (NvJobSystem::QUEUE_CAPACITY - 1)] = job;
+        return true;
+    }
+
+    bool popBack(Job& job) {
+        if (tail == head)
+            return false;
+        r3::ScopedMutex lock(mutex);
+        if (tail == head)
+            return false;
+        job = jobs[--tail & (NvJobSystem::QUEUE_CAPACITY - 1)];
+        return true;
+    }
+
+    bool popFront(Job& job) {
+        if (tail == head)
+            return false;
+        r3::ScopedMutex lock(mutex);
+        if (tail == head)
+            return false;
+        job = jobs[head++ & (NvJobSystem::QUEUE_CAPACITY - 1)];
+        if (head == tail)
+            head = tail = 0;
+        return true;
+    }
+};
+
+// queue 0 is shared by every thread that is not a worker
+static JobQueue* s_queues = NULL;
+static volatile int32_t s_queuedJobs = 0;
+static volatile int32_t s_sleepingWorkers = 0;
+static volatile int32_t s_sleepingWaiters = 0;
+static volatile bool s_quit = false;
+// signalled when a job is queued, and broadcast when a counter that a waiter is
+// blocked on reaches zero
+static r3::Condition s_wakeCondition;
+static NV_JOB_TLS int32_t s_threadIndex = 0;
+
+#ifdef _WIN32
+static HANDLE s_threads[NvJobSystem::MAX_WORKERS];
+#else
+static pthread_t s_threads[NvJobSystem::MAX_WORKERS];
+#endif
+
+static void releaseCounter(NvJobCounter* counter) {
+    // as with the queued count, the waiter registers before checking the counter
+    // and we check for waiters after releasing it, so one side always sees the other
+    if (atomicAdd(&counter->m_count, -1) == 0 && s_sleepingWaiters > 0) {
+        s_wakeCondition.Acquire();
+        s_wakeCondition.Broadcast();
+        s_wakeCondition.Release();
+    }
+}
+
+static void execute(const Job& job) {
+    {
+        NvProfilerCPUScope scope(job.name ? job.name : "job");
+        job.func(job.data);
+    }
+    if (job.counter)
+        releaseCounter(job.counter);
+}
+
+static bool takeJob(int32_t index, Job& job) {
+    const int32_t queues = NvJobSystem::getWorkerCount() + 1;
+    bool found = s_queues[index].popBack(job);
+    for (int32_t i = 1; !found && i < queues; i++)
+        found = s_queues[(index + i) % queues].popFront(job);
+
+    if (found)
+        atomicAdd(&s_queuedJobs, -1);
+    return found;
+}
+
+#ifdef _WIN32
+static unsigned __stdcall workerMain(void* arg)
+#else
+static void* workerMain(void* arg)
+#endif
+{
+    s_threadIndex = (int32_t)(size_t)arg;
+
+    char name[32];
+    sprintf(name, "job worker %d", s_threadIndex);
+    NvProfiler::setThreadName(name);
+
+    Job job;
+    while (true) {
+        if (takeJob(s_threadIndex, job)) {
+            execute(job);
+            continue;
+        }
+
+        // Sleep until a job is queued.  Submitters bump the queued count before
+        // checking for sleepers, and we register as a sleeper before checking the
+        // count, so one side always sees the other
+        s_wakeCondition.Acquire();
+        atomicAdd(&s_sleepingWorkers, 1);
+        while (s_queuedJobs <= 0 && !s_quit)
+            s_wakeCondition.Wait();
+        atomicAdd(&s_sleepingWorkers, -1);
+        const bool quit = s_quit && s_queuedJobs <= 0;
+        s_wakeCondition.Release();
+
+        if (quit)
+            break;
+    }
+    return 0;
+}
+
+bool NvJobSystem::globalInit(int32_t workers) {
+    if (s_queues)
+        return true;
+
+    if (workers < 0)
+        workers = getCPUCoreCount() - 1;
+    if (workers > MAX_WORKERS)
+        workers = MAX_WORKERS;
+    if (workers <= 0) {
+        LOGI("Job system: no worker threads, jobs run inline");
+        return true;
+    }
+
+    s_queues = new JobQueue[workers + 1];
+    s_queuedJobs = 0;
+    s_quit = false;
+    ms_workerCount = workers;
+
+    for (int32_t i = 0; i < workers; i++) {
+        void* arg = (void*)(size_t)(i + 1);
+#ifdef _WIN32
+        s_threads[i] = (HANDLE)_beginthreadex(NULL, 0, workerMain, arg, 0, NULL);
+#else
+        pthread_create(&s_threads[i], NULL, workerMain, arg);
+#endif
+    }
+
+    LOGI("Job system: %d worker threads", workers);
+    return true;
+}
+
+void NvJobSystem::globalShutdown() {
+    if (!s_queues)
+        return;
+
+    // drain the shared queue here; workers finish their own queues before exiting
+    Job job;
+    while (takeJob(0, job))
+        execute(job);
+
+    s_wakeCondition.Acquire();
+    s_quit = true;
+    s_wakeCondition.Broadcast();
+    s_wakeCondition.Release();
+
+    for (int32_t i = 0; i < ms_workerCount; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(s_threads[i], INFINITE);
+        CloseHandle(s_threads[i]);
+#else
+        pthread_join(s_threads[i], NULL);
+#endif
+    }
+
+    ms_workerCount = 0;
+    delete [] s_queues;
+    s_queues = NULL;
+}
+
+bool NvJobSystem::restart(int32_t workers) {
+    globalShutdown();
+    return globalInit(workers);
+}
+
+int32_t NvJobSystem::getThreadIndex() {
+    return s_threadIndex;
+}
+
+void NvJobSystem::run(NvJobFunction func, void* data, const char* name, NvJobCounter* counter) {
+    Job job = { func, data, name, counter };
+    if (counter)
+        atomicAdd(&counter->m_count, 1);
+
+    if (!s_queues || !s_queues[s_threadIndex].push(job)) {
+        execute(job);
+        return;
+    }
+
+    atomicAdd(&s_queuedJobs, 1);
+    if (s_sleepingWorkers + s_sleepingWaiters > 0) {
+        s_wakeCondition.Acquire();
+        s_wakeCondition.Signal();
+        s_wakeCondition.Release();
+    }
+}
+
+void NvJobSystem::wait(NvJobCounter* counter) {
+    Job job;
+    int32_t spins = 0;
+    while (counter->m_count > 0) {
+        if (s_queues && takeJob(s_threadIndex, job)) {
+            execute(job);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < WAIT_SPIN_COUNT) {
+            yieldThread();
+            continue;
+        }
+
+        // the remaining jobs are running on other threads; sleep until one of
+        // them finishes the counter or more work is queued
+        s_wakeCondition.Acquire();
+        atomicAdd(&s_sleepingWaiters, 1);
+        while (counter->m_count > 0 && s_queuedJobs <= 0)
+            s_wakeCondition.Wait();
+        atomicAdd(&s_sleepingWaiters, -1);
+        s_wakeCondition.Release();
+        spins = 0;
+    }
+}
+
+struct RangeJob {
+    NvJobRangeFunction func;
+    void* data;
+    int32_t count;
+    int32_t grain;
+    int32_t chunks;
+    volatile int32_t nextChunk;
+};
+
+static void runRangeChunks(void* data) {
+    RangeJob* range = (RangeJob*)data;
+    while (true) {
+        const int32_t chunk = atomicAdd(&range->nextChunk, 1) - 1;
+        if (chunk >= range->chunks)
+            break;
+        const int32_t begin = chunk * range->grain;
+        const int32_t end = (begin + range->grain < range->count) ? (begin + range->grain) : range->count;
+        range->func(range->data, begin, end);
+    }
+}
+
+void NvJobSystem::parallelFor(NvJobRangeFunction func, void* data, int32_t count, int32_t grain, const char* name) {
+    if (count <= 0)
+        return;
+    if (grain < 1)
+        grain = 1;
+
+    RangeJob range;
+    range.func = func;
+    range.data = data;
+    range.count = count;
+    range.grain = grain;
+    range.chunks = (count + grain - 1) / grain;
+    range.nextChunk = 0;
+
+    // one helper per worker at most; each helper keeps claiming chunks until none are left
+    const int32_t helpers = (range.chunks - 1 < ms_workerCount) ? (range.chunks - 1) : ms_workerCount;
+    NvJobCounter counter;
+    for (int32_t i = 0; i < helpers; i++)
+        run(runRangeChunks, &range, name, &counter);
+
+    {
+        NvProfilerCPUScope scope(name ? name : "parallelFor");
+        runRangeChunks(&range);
+    }
+    wait(&counter);
+}
+
+int32_t NvJobGraph::addTask(NvJobFunction func, void* data, const char* name) {
+    Task task;
+    task.func = func;
+    task.data = data;
+    task.name = name;
+    task.graph = this;
+    task.predecessors = 0;
+    task.pending = 0;
+    m_tasks.push_back(task);
+    return (int32_t)m_tasks.size() - 1;
+}
+
+void NvJobGraph::addDependency(int32_t before, int32_t after) {
+    m_tasks[before].successors.push_back(after);
+    m_tasks[after].predecessors++;
+}
+
+static void runGraphTask(void* data) {
+    NvJobGraph::Task* task = (NvJobGraph::Task*)data;
+    task->func(task->data);
+
+    NvJobGraph* graph = task->graph;
+    for (size_t i = 0; i < task->successors.size(); i++) {
+        NvJobGraph::Task& next = graph->m_tasks[task->successors[i]];
+        if (atomicAdd(&next.pending, -1) == 0)
+            NvJobSystem::run(runGraphTask, &next, next.name, NULL);
+    }
+
+    // counted down last, so the graph stays alive until every successor is queued
+    releaseCounter(&graph->m_counter);
+}
+
+void NvJobGraph::submit() {
+    const int32_t count = (int32_t)m_tasks.size();
+    for (int32_t i = 0; i < count; i++)
+        m_tasks[i].pending = m_tasks[i].predecessors;
+    atomicAdd(&m_counter.m_count, count);
+
+    for (int32_t i = 0; i < count; i++) {
+        if (m_tasks[i].predecessors == 0)
+            NvJobSystem::run(runGraphTask, &m_tasks[i], m_tasks[i].name, NULL);
+    }
+}
+
+void NvJobGraph::wait() {
+    NvJobSystem::wait(&m_counter);
+}
+
+// -----------------------------------------------------------------------------
+// Stress test and dispatch benchmark
+
+struct StressCounts {
+    volatile int32_t executed;
+    volatile int32_t spawned;
+};
+
+static void stressIncrement(void* data) {
+    atomicAdd(&((StressCounts*)data)->executed, 1);
+}
+
+struct StressTree {
+    StressCounts* counts;
+    int32_t depth;
+};
+
+// each node spawns two children and waits for them, from whichever thread it runs on
+static void stressSpawn(void* data) {
+    StressTree* node = (StressTree*)data;
+    atomicAdd(&node->counts->executed, 1);
+    if (node->depth == 0)
+        return;
+
+    StressTree children[2] = { { node->counts, node->depth - 1 }, { node->counts, node->depth - 1 } };
+    NvJobCounter counter;
+    atomicAdd(&node->counts->spawned, 2);
+    NvJobSystem::run(stressSpawn, &children[0], "stress spawn", &counter);
+    NvJobSystem::run(stressSpawn, &children[1], "stress spawn", &counter);
+    NvJobSystem::wait(&counter);
+}
+
+struct StressRange {
+    int32_t* values;
+    volatile int32_t visits;
+};
+
+static void stressRange(void* data, int32_t begin, int32_t end) {
+    StressRange* range = (StressRange*)data;
+    for (int32_t i = begin; i < end; i++)
+        range->values[i] += i;
+    atomicAdd(&range->visits, end - begin);
+}
+
+struct StressGraphTask {
+    volatile int32_t* clock;
+    int32_t stamp;
+    std::vector<StressGraphTask*> predecessors;
+    volatile int32_t* failures;
+};
+
+static void stressGraphTask(void* data) {
+    StressGraphTask* task = (StressGraphTask*)data;
+    for (size_t i = 0; i < task->predecessors.size(); i++) {
+        if (task->predecessors[i]->stamp <= 0)
+            atomicAdd(task->failures, 1);
+    }
+    task->stamp = atomicAdd(task->clock, 1);
+}
+
+bool NvJobSystem::runStressTest(int32_t iterations) {
+    bool passed = true;
+
+    for (int32_t iter = 0; iter < iterations && passed; iter++) {
+        // a burst of tiny jobs, larger than one queue so some overflow and run inline
+        StressCounts counts = { 0, 0 };
+        NvJobCounter counter;
+        const int32_t jobs = QUEUE_CAPACITY * 2 + 17;
+        for (int32_t i = 0; i < jobs; i++)
+            run(stressIncrement, &counts, "stress increment", &counter);
+        wait(&counter);
+        if (counts.executed != jobs) {
+            LOGE("Job system stress: %d of %d jobs ran", counts.executed, jobs);
+            passed = false;
+        }
+
+        // recursive spawning and waiting from inside jobs
+        StressCounts treeCounts = { 0, 1 };
+        StressTree root = { &treeCounts, 10 };
+        run(stressSpawn, &root, "stress spawn", &counter);
+        wait(&counter);
+        if (treeCounts.executed != treeCounts.spawned || treeCounts.executed != (1 << 11) - 1) {
+            LOGE("Job system stress: %d of %d spawned jobs ran", treeCounts.executed, (1 << 11) - 1);
+            passed = false;
+        }
+
+        // parallel-for over a range that does not divide evenly, with varied grains
+        const int32_t count = 100003;
+        std::vector<int32_t> values(count, 0);
+        StressRange range;
+        range.values = &values[0];
+        range.visits = 0;
+        const int32_t grain = 1 + (iter * 997) % 4096;
+        parallelFor(stressRange, &range, count, grain, "stress parallelFor");
+        bool rangeOk = (range.visits == count);
+        for (int32_t i = 0; i < count && rangeOk; i++)
+            rangeOk = (values[i] == i);
+        if (!rangeOk) {
+            LOGE("Job system stress: parallelFor with grain %d visited %d of %d indices", grain, range.visits, count);
+            passed = false;
+        }
+
+        // a layered graph where each task depends on up to three tasks of the previous layer
+        const int32_t layers = 8;
+        const int32_t width = 16;
+        std::vector<StressGraphTask> tasks(layers * width);
+        volatile int32_t clock = 1;
+        volatile int32_t failures = 0;
+        NvJobGraph graph;
+        for (int32_t i = 0; i < layers * width; i++) {
+            tasks[i].clock = &clock;
+            tasks[i].stamp = 0;
+            tasks[i].failures = &failures;
+            graph.addTask(stressGraphTask, &tasks[i], "stress graph");
+        }
+        for (int32_t l = 1; l < layers; l++) {
+            for (int32_t x = 0; x < width; x++) {
+                for (int32_t d = -1; d <= 1; d++) {
+                    const int32_t px = x + d;
+                    if (px < 0 || px >= width)
+                        continue;
+                    graph.addDependency((l - 1) * width + px, l * width + x);
+                    tasks[l * width + x].predecessors.push_back(&tasks[(l - 1) * width + px]);
+                }
+            }
+        }
+        // submitted twice to check that graphs can be reused
+        for (int32_t round = 0; round < 2; round++) {
+            for (int32_t i = 0; i < layers * width; i++)
+                tasks[i].stamp = 0;
+            graph.submit();
+            graph.wait();
+        }
+        bool graphOk = (failures == 0);
+        for (int32_t i = 0; i < layers * width && graphOk; i++)
+            graphOk = (tasks[i].stamp > 0);
+        if (!graphOk) {
+            LOGE("Job system stress: task graph ran %d tasks before their dependencies", failures);
+            passed = false;
+        }
+    }
+
+    LOGI("Job system stress test (%d workers, %d iterations): %s", ms_workerCount, iterations, passed ? "passed" : "FAILED");
+    return passed;
+}
+
+static void emptyJob(void* data) {
+}
+
+static void emptyRange(void* data, int32_t begin, int32_t end) {
+}
+
+void NvJobSystem::runDispatchBenchmark() {
+    const int32_t jobs = 100000;
+    NvJobCounter counter;
+
+    // throughput: submit in batches that fit the queue, wait for each batch
+    uint64_t start = NvProfiler::getTimeNs();
+    for (int32_t submitted = 0; submitted < jobs; ) {
+        const int32_t batch = (jobs - submitted < QUEUE_CAPACITY / 2) ? (jobs - submitted) : (QUEUE_CAPACITY / 2);
+        for (int32_t i = 0; i < batch; i++)
+            run(emptyJob, NULL, "empty", &counter);
+        wait(&counter);
+        submitted += batch;
+    }
+    const double throughputNs = (double)(NvProfiler::getTimeNs() - start) / jobs;
+
+    // latency: one job at a time, so every job may have to wake a worker
+    const int32_t roundTrips = 10000;
+    start = NvProfiler::getTimeNs();
+    for (int32_t i = 0; i < roundTrips; i++) {
+        run(emptyJob, NULL, "empty", &counter);
+        wait(&counter);
+    }
+    const double latencyNs = (double)(NvProfiler::getTimeNs() - start) / roundTrips;
+
+    // parallel-for overhead: one chunk per thread, no work
+    const int32_t loops = 10000;
+    start = NvProfiler::getTimeNs();
+    for (int32_t i = 0; i < loops; i++)
+        parallelFor(emptyRange, NULL, ms_workerCount + 1, 1, "empty parallelFor");
+    const double parallelForNs = (double)(NvProfiler::getTimeNs() - start) / loops;
+
+    LOGI("Job system dispatch (%d workers): %.0f ns/job batched, %.0f ns/job round trip, %.0f ns/parallelFor",
+        ms_workerCount, throughputNs, latencyNs, parallelForNs);
+}
@@ -0,0 +1,336 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvNoiseVolume.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "NvAppBase/NvNoiseVolume.h"
+#include "NvAppBase/NvJobSystem.h"
+#include "NvGLUtils/NvProfiler.h"
+#include "NvGLUtils/NvVertexPacking.h"
+#include "NV/NvLogs.h"
+#include "Perlin/ImprovedNoise.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+std::string NvNoiseVolume::ms_cacheDirectory;
+
+// Bumped whenever the generated values change, so stale cache files are ignored
+static const uint32_t CACHE_VERSION = 1;
+static const char CACHE_MAGIC[4] = { 'N', 'V', 'N', 'V' };
+
+// Offsets of the channels' Perlin fields, following ImprovedNoise::noise3f
+static const float CHANNEL_OFFSETS[4][3] = {
+    { 0.0f, 0.0f, 0.0f },
+    { 32.0f, 78.0f, 7.0f },
+    { 123.0f, 11.0f, 96.0f },
+    { 57.0f, 201.0f, 33.0f }
+};
+
+struct NvNoiseVolumeCacheHeader {
+    char magic[4];
+    uint32_t version;
+    NvNoiseVolume::Desc desc;
+    uint32_t dataSize;
+};
+
+// A well mixed 32 bit integer hash, cheap enough to vectorize
+static inline uint32_t hashUint(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+NvNoiseVolume::Desc::Desc()
+    : type(TYPE_VALUE)
+    , format(FORMAT_HALF)
+    , width(32)
+    , height(32)
+    , depth(32)
+    , channels(4)
+    , seed(0)
+    , frequency(4.0f)
+    , octaves(4)
+    , lacunarity(2.0f)
+    , gain(0.5f)
+    , amplitude(1.0f)
+{
+}
+
+NvNoiseVolume::NvNoiseVolume()
+    : m_data(NULL)
+    , m_dataSize(0)
+    , m_fromCache(false)
+    , m_buildMs(0.0f)
+    , m_noise(NULL)
+{
+}
+
+NvNoiseVolume::~NvNoiseVolume()
+{
+    release();
+}
+
+void NvNoiseVolume::release()
+{
+    delete[] (uint8_t*)m_data;
+    m_data = NULL;
+    m_dataSize = 0;
+}
+
+void NvNoiseVolume::setCacheDirectory(const char* dir)
+{
+    ms_cacheDirectory = dir ? dir : "";
+}
+
+GLint NvNoiseVolume::getInternalFormat(Format format, int32_t channels)
+{
+    static const GLint halfFormats[4] = { GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F };
+    static const GLint snormFormats[4] = { GL_R8_SNORM, GL_RG8_SNORM, GL_RGB8_SNORM, GL_RGBA8_SNORM };
+    if (channels < 1 || channels > 4)
+        return 0;
+    return (format == FORMAT_HALF) ? halfFormats[channels - 1] : snormFormats[channels - 1];
+}
+
+bool NvNoiseVolume::generate(const Desc& desc)
+{
+    if (desc.width <= 0 || desc.height <= 0 || desc.depth <= 0 ||
+        desc.channels < 1 || desc.channels > 4 ||
+        desc.type < TYPE_VALUE || desc.type > TYPE_FBM ||
+        desc.format < FORMAT_HALF || desc.format > FORMAT_SNORM8 ||
+        (desc.type == TYPE_FBM && desc.octaves < 1)) {
+        LOGE("NvNoiseVolume: invalid description");
+        return false;
+    }
+
+    NV_PROFILE_SCOPE("Noise volume");
+    const uint64_t startNs = NvProfiler::getTimeNs();
+
+    release();
+    m_desc = desc;
+    m_dataSize = (size_t)desc.width * desc.height * desc.depth * desc.channels *
+        (desc.format == FORMAT_HALF ? sizeof(uint16_t) : sizeof(int8_t));
+    m_data = new uint8_t[m_dataSize];
+
+    m_fromCache = loadCache();
+    if (!m_fromCache) {
+        ImprovedNoise noise(desc.seed);
+        m_noise = &noise;
+        NvJobSystem::parallelFor(generateSlices, this, desc.depth, 1, "Noise volume");
+        m_noise = NULL;
+        saveCache();
+    }
+
+    m_buildMs = (NvProfiler::getTimeNs() - startNs) / 1.0e6f;
+    LOGI("NvNoiseVolume: %dx%dx%d, %d channels, %s in %.1f ms", desc.width, desc.height, desc.depth,
+        desc.channels, m_fromCache ? "loaded from the cache" : "generated", m_buildMs);
+    return true;
+}
+
+// Generates whole z slices, a row of one channel at a time, then converts the row to the storage format
+void NvNoiseVolume::generateSlices(void* data, int32_t begin, int32_t end)
+{
+    NvNoiseVolume* self = (NvNoiseVolume*)data;
+    const Desc& desc = self->m_desc;
+    const int32_t w = desc.width;
+    const int32_t channels = desc.channels;
+
+    std::vector<float> rowX(w), rowY(w), rowZ(w), values(w);
+    const float scaleX = desc.frequency / desc.width;
+    const float scaleY = desc.frequency / desc.height;
+    const float scaleZ = desc.frequency / desc.depth;
+    const uint32_t seedHash = hashUint(desc.seed ^ 0x9e3779b9U);
+
+    for (int32_t k = begin; k < end; k++) {
+        for (int32_t j = 0; j < desc.height; j++) {
+            const size_t rowTexel = ((size_t)k * desc.height + j) * w;
+
+            for (int32_t c = 0; c < channels; c++) {
+                if (desc.type == TYPE_VALUE) {
+                    const uint32_t base = (uint32_t)rowTexel * 4 + c;
+                    for (int32_t i = 0; i < w; i++) {
+                        // 24 random bits to [-1, 1)
+                        const uint32_t h = hashUint((base + (uint32_t)i * 4) ^ seedHash);
+                        values[i] = (float)(int32_t)(h >> 8) * (2.0f / 16777216.0f) - 1.0f;
+                    }
+                } else {
+                    // texel centers, in lattice cells
+                    const float* offset = CHANNEL_OFFSETS[c];
+                    const float y = (j + 0.5f) * scaleY + offset[1];
+                    const float z = (k + 0.5f) * scaleZ + offset[2];
+                    for (int32_t i = 0; i < w; i++) {
+                        rowX[i] = (i + 0.5f) * scaleX + offset[0];
+                        rowY[i] = y;
+                        rowZ[i] = z;
+                    }
+                    if (desc.type == TYPE_PERLIN)
+                        self->m_noise->noise(&rowX[0], &rowY[0], &rowZ[0], &values[0], w);
+                    else
+                        self->m_noise->fBm(&rowX[0], &rowY[0], &rowZ[0], &values[0], w,
+                            desc.octaves, desc.lacunarity, desc.gain);
+                }
+
+                const float amplitude = desc.amplitude;
+                if (desc.format == FORMAT_HALF) {
+                    uint16_t* out = (uint16_t*)self->m_data + rowTexel * channels + c;
+                    for (int32_t i = 0; i < w; i++)
+                        out[i * channels] = NvVertexPacking::floatToHalf(values[i] * amplitude);
+                } else {
+                    int8_t* out = (int8_t*)self->m_data + rowTexel * channels + c;
+                    for (int32_t i = 0; i < w; i++) {
+                        float v = values[i] * amplitude;
+                        v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+                        out[i * channels] = (int8_t)(v * 127.0f + (v < 0.0f ? -0.5f : 0.5f));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void NvNoiseVolume::decode(float* out) const
+{
+    const size_t count = (size_t)m_desc.width * m_desc.height * m_desc.depth * m_desc.channels;
+    if (!m_data)
+        return;
+    if (m_desc.format == FORMAT_HALF) {
+        const uint16_t* in = (const uint16_t*)m_data;
+        for (size_t i = 0; i < count; i++)
+            out[i] = NvVertexPacking::halfToFloat(in[i]);
+    } else {
+        const int8_t* in = (const int8_t*)m_data;
+        for (size_t i = 0; i < count; i++) {
+            const float v = in[i] / 127.0f;
+            out[i] = v < -1.0f ? -1.0f : v;
+        }
+    }
+}
+
+GLuint NvNoiseVolume::createTexture() const
+{
+    static const GLenum formats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+    if (!m_data)
+        return 0;
+
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_3D, tex);
+
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+
+    // rows of odd-sized half or byte texels are not 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_3D, 0, getInternalFormat(m_desc.format, m_desc.channels),
+        m_desc.width, m_desc.height, m_desc.depth, 0, formats[m_desc.channels - 1],
+        m_desc.format == FORMAT_HALF ? GL_HALF_FLOAT : GL_BYTE, m_data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    return tex;
+}
+
+GLuint NvNoiseVolume::createTexture(const Desc& desc)
+{
+    NvNoiseVolume volume;
+    if (!volume.generate(desc))
+        return 0;
+    return volume.createTexture();
+}
+
+// The cache file name is a hash of the description; the header holds the full
+// description, so a colliding file is regenerated rather than used
+std::string NvNoiseVolume::getCachePath() const
+{
+    uint32_t hash = 2166136261U; // FNV-1a
+    const uint8_t* bytes = (const uint8_t*)&m_desc;
+    for (size_t i = 0; i < sizeof(m_desc); i++)
+        hash = (hash ^ bytes[i]) * 16777619U;
+    hash = (hash ^ CACHE_VERSION) * 16777619U;
+
+    char name[32];
+    sprintf(name, "noise_%08x.nvv", hash);
+    return ms_cacheDirectory + "/" + name;
+}
+
+bool NvNoiseVolume::loadCache()
+{
+    if (ms_cacheDirectory.empty())
+        return false;
+
+    FILE* fp = fopen(getCachePath().c_str(), "rb");
+    if (!fp)
+        return false;
+
+    NvNoiseVolumeCacheHeader header;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+        memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+        header.version == CACHE_VERSION &&
+        memcmp(&header.desc, &m_desc, sizeof(m_desc)) == 0 &&
+        header.dataSize == m_dataSize &&
+        fread(m_data, m_dataSize, 1, fp) == 1;
+    fclose(fp);
+    return ok;
+}
+
+void NvNoiseVolume::saveCache() const
+{
+    if (ms_cacheDirectory.empty())
+        return;
+
+    const std::string path = getCachePath();
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (!fp) {
+        LOGE("NvNoiseVolume: cannot write the cache file %s", path.c_str());
+        return;
+    }
+
+    NvNoiseVolumeCacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.desc = m_desc;
+    header.dataSize = (uint32_t)m_dataSize;
+    const bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+        fwrite(m_data, m_dataSize, 1, fp) == 1;
+    fclose(fp);
+    if (!ok) {
+        LOGE("NvNoiseVolume: cannot write the cache file %s", path.c_str());
+        remove(path.c_str());
+    }
+}
@@ -0,0 +1,155 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvQualityTuner.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvAppBase/NvQualityTuner.h"
+#include "NV/NvLogs.h"
+
+NvQualityTuner::NvQualityTuner()
+    : m_level(0)
+    , m_window(0)
+    , m_settle(0)
+    , m_windowsAtLevel(0)
+    , m_previousLevel(-1)
+    , m_previousMs(0.0f)
+    , m_steppedUp(false)
+    , m_loggedLowest(false)
+    , m_changes(0)
+{
+}
+
+void NvQualityTuner::setLevels(const char* const* names, int32_t count, int32_t level)
+{
+    m_names.assign(names, names + count);
+    m_stepCost.assign(count, 0.0f);
+    m_hold.assign(count, 0);
+    m_heldUntil.assign(count, 0);
+    m_window = 0;
+    m_changes = 0;
+    reset(level);
+}
+
+void NvQualityTuner::reset(int32_t level)
+{
+    const int32_t count = getLevelCount();
+    m_level = (level >= count) ? count - 1 : level;
+    if (m_level < 0)
+        m_level = 0;
+    m_settle = m_params.settleWindows;
+    m_windowsAtLevel = 0;
+    m_previousLevel = -1;
+    m_previousMs = 0.0f;
+    m_steppedUp = false;
+    m_loggedLowest = false;
+}
+
+const char* NvQualityTuner::getLevelName(int32_t level) const
+{
+    return (level >= 0 && level < getLevelCount()) ? m_names[level].c_str() : "";
+}
+
+void NvQualityTuner::change(int32_t level, float frameMs)
+{
+    m_steppedUp = (level > m_level);
+    m_previousLevel = m_level;
+    m_previousMs = frameMs;
+    m_level = level;
+    m_settle = m_params.settleWindows;
+    m_windowsAtLevel = 0;
+    m_changes++;
+}
+
+bool NvQualityTuner::addWindow(float gpuMs, float cpuMs)
+{
+    const int32_t count = getLevelCount();
+    if (count == 0)
+        return false;
+
+    // the CPU and the GPU overlap, so the frame takes as long as the slower of them
+    const float frameMs = (gpuMs > cpuMs) ? gpuMs : cpuMs;
+
+    // the timers lag the frames, so the windows right after a change still hold the old level
+    if (m_settle > 0) {
+        m_settle--;
+        return false;
+    }
+
+    // the first window at a new level gives the cost ratio of it and the one before
+    if (m_windowsAtLevel == 0 && m_previousLevel >= 0 && m_previousMs > 0.0f && frameMs > 0.0f) {
+        const int32_t lower = (m_level < m_previousLevel) ? m_level : m_previousLevel;
+        const float ratio = (m_level > m_previousLevel) ? (frameMs / m_previousMs) : (m_previousMs / frameMs);
+        m_stepCost[lower] = (ratio > 1.0f) ? ratio : 1.0f;
+    }
+    m_window++;
+    m_windowsAtLevel++;
+
+    const float budgetMs = m_params.budgetMs;
+    if (frameMs > budgetMs * m_params.upperFraction) {
+        if (m_level == 0) {
+            if (!m_loggedLowest)
+                LOGI("Quality: %.2f ms (GPU %.2f, CPU %.2f) is over the %.2f ms budget at the lowest level, %s\n",
+                    frameMs, gpuMs, cpuMs, budgetMs, getLevelName(0));
+            m_loggedLowest = true;
+            return false;
+        }
+
+        // a level that is over budget as soon as it is stepped up to is held off for
+        // longer each time; one that went over later (the scene got heavier) is not
+        int32_t& hold = m_hold[m_level];
+        if (m_steppedUp && m_windowsAtLevel == 1)
+            hold = (hold > 0) ? hold * 2 : m_params.holdWindows;
+        else
+            hold = m_params.holdWindows;
+        if (hold > m_params.maxHoldWindows)
+            hold = m_params.maxHoldWindows;
+        m_heldUntil[m_level] = m_window + hold;
+
+        LOGI("Quality: %.2f ms (GPU %.2f, CPU %.2f) is over the %.2f ms budget, %s -> %s (%s held off for %d windows)\n",
+            frameMs, gpuMs, cpuMs, budgetMs, getLevelName(m_level), getLevelName(m_level - 1), getLevelName(m_level), hold);
+        change(m_level - 1, frameMs);
+        return true;
+    }
+    m_loggedLowest = false;
+
+    if (m_level + 1 < count && m_window >= m_heldUntil[m_level + 1]) {
+        const float ratio = (m_stepCost[m_level] > 0.0f) ? m_stepCost[m_level] : m_params.assumedStepCost;
+        const float expectedMs = frameMs * ratio;
+        if (expectedMs < budgetMs * m_params.lowerFraction) {
+            LOGI("Quality: %.2f ms (GPU %.2f, CPU %.2f), %s expected at %.2f ms of the %.2f ms budget, %s -> %s\n",
+                frameMs, gpuMs, cpuMs, getLevelName(m_level + 1), expectedMs, budgetMs,
+                getLevelName(m_level), getLevelName(m_level + 1));
+            change(m_level + 1, frameMs);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,408 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvRadixSort.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "NvAppBase/NvRadixSort.h"
+#include "NvAppBase/NvJobSystem.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define RADIX_SORT_SSE 1
+#elif defined(NV_ARM_NEON) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RADIX_SORT_NEON 1
+#endif
+
+bool NvRadixSort::ms_simd = true;
+
+static const uint32_t DIGIT_MASK = NvRadixSort::BUCKETS - 1;
+
+// Points per job when computing depth keys
+static const int32_t DEPTH_KEYS_GRAIN = 16384;
+
+NvRadixSort::NvRadixSort()
+    : m_capacity(0)
+    , m_histograms(NULL)
+    , m_histogramChunks(0)
+    , m_count(0)
+    , m_chunkCount(0)
+    , m_pass(0)
+    , m_allPasses(false)
+    , m_srcKeys(NULL)
+    , m_srcValues(NULL)
+    , m_dstKeys(NULL)
+    , m_dstValues(NULL)
+    , m_dstIndices(NULL)
+    , m_passCount(0)
+{
+    m_keys[0] = m_keys[1] = NULL;
+    m_values[0] = m_values[1] = NULL;
+}
+
+NvRadixSort::~NvRadixSort()
+{
+    for (int32_t i = 0; i < 2; i++) {
+        delete[] m_keys[i];
+        delete[] m_values[i];
+    }
+    delete[] m_histograms;
+}
+
+uint32_t NvRadixSort::floatToKey(float f)
+{
+    // flip the sign bit of positive floats and every bit of negative ones
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u ^ ((uint32_t)(-(int32_t)(u >> 31)) | 0x80000000u);
+}
+
+float NvRadixSort::keyToFloat(uint32_t key)
+{
+    const uint32_t u = key ^ (((key >> 31) - 1) | 0x80000000u);
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+const char* NvRadixSort::getSIMDName()
+{
+#if defined(RADIX_SORT_SSE)
+    return ms_simd ? "SSE2" : "scalar";
+#elif defined(RADIX_SORT_NEON)
+    return ms_simd ? "NEON" : "scalar";
+#else
+    return "scalar";
+#endif
+}
+
+struct NvDepthKeysJob {
+    const float* points;
+    int32_t stride;
+    const float* x;
+    const float* y;
+    const float* z;
+    float axis[3];
+    uint32_t* keys;
+};
+
+// The products are summed in the order of the scalar path (no fused multiply-add),
+// so every path computes the same keys.
+void NvRadixSort::depthKeysRange(void* data, int32_t begin, int32_t end)
+{
+    const NvDepthKeysJob* job = (const NvDepthKeysJob*)data;
+    const float ax = job->axis[0], ay = job->axis[1], az = job->axis[2];
+    const int32_t stride = job->stride;
+    int32_t i = begin;
+
+#if defined(RADIX_SORT_SSE)
+    if (ms_simd && stride == 4) {
+        const __m128 vax = _mm_set1_ps(ax), vay = _mm_set1_ps(ay), vaz = _mm_set1_ps(az);
+        const __m128i signBit = _mm_set1_epi32((int32_t)0x80000000u);
+        for (; i + 4 <= end; i += 4) {
+            const float* p = job->points + i * 4;
+            __m128 p0 = _mm_loadu_ps(p), p1 = _mm_loadu_ps(p + 4), p2 = _mm_loadu_ps(p + 8), p3 = _mm_loadu_ps(p + 12);
+            _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+            const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vax, p0), _mm_mul_ps(vay, p1)), _mm_mul_ps(vaz, p2));
+            const __m128i u = _mm_castps_si128(d);
+            const __m128i mask = _mm_or_si128(_mm_srai_epi32(u, 31), signBit);
+            _mm_storeu_si128((__m128i*)(job->keys + i), _mm_xor_si128(u, mask));
+        }
+    }
+#elif defined(RADIX_SORT_NEON)
+    if (ms_simd && stride == 4) {
+        const float32x4_t vax = vdupq_n_f32(ax), vay = vdupq_n_f32(ay), vaz = vdupq_n_f32(az);
+        const uint32x4_t signBit = vdupq_n_u32(0x80000000u);
+        for (; i + 4 <= end; i += 4) {
+            const float32x4x4_t p = vld4q_f32(job->points + i * 4);
+            const float32x4_t d = vaddq_f32(vaddq_f32(vmulq_f32(vax, p.val[0]), vmulq_f32(vay, p.val[1])), vmulq_f32(vaz, p.val[2]));
+            const uint32x4_t u = vreinterpretq_u32_f32(d);
+            const uint32x4_t mask = vorrq_u32(vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(u), 31)), signBit);
+            vst1q_u32(job->keys + i, veorq_u32(u, mask));
+        }
+    }
+#endif
+
+    for (; i < end; i++) {
+        const float* p = job->points + i * stride;
+        job->keys[i] = floatToKey(ax * p[0] + ay * p[1] + az * p[2]);
+    }
+}
+
+void NvRadixSort::depthKeysSoARange(void* data, int32_t begin, int32_t end)
+{
+    const NvDepthKeysJob* job = (const NvDepthKeysJob*)data;
+    const float ax = job->axis[0], ay = job->axis[1], az = job->axis[2];
+    const float* x = job->x;
+    const float* y = job->y;
+    const float* z = job->z;
+    int32_t i = begin;
+
+#if defined(RADIX_SORT_SSE)
+    if (ms_simd) {
+        const __m128 vax = _mm_set1_ps(ax), vay = _mm_set1_ps(ay), vaz = _mm_set1_ps(az);
+        const __m128i signBit = _mm_set1_epi32((int32_t)0x80000000u);
+        for (; i + 4 <= end; i += 4) {
+            const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vax, _mm_loadu_ps(x + i)), _mm_mul_ps(vay, _mm_loadu_ps(y + i))),
+                _mm_mul_ps(vaz, _mm_loadu_ps(z + i)));
+            const __m128i u = _mm_castps_si128(d);
+            const __m128i mask = _mm_or_si128(_mm_srai_epi32(u, 31), signBit);
+            _mm_storeu_si128((__m128i*)(job->keys + i), _mm_xor_si128(u, mask));
+        }
+    }
+#elif defined(RADIX_SORT_NEON)
+    if (ms_simd) {
+        const float32x4_t vax = vdupq_n_f32(ax), vay = vdupq_n_f32(ay), vaz = vdupq_n_f32(az);
+        const uint32x4_t signBit = vdupq_n_u32(0x80000000u);
+        for (; i + 4 <= end; i += 4) {
+            const float32x4_t d = vaddq_f32(vaddq_f32(vmulq_f32(vax, vld1q_f32(x + i)), vmulq_f32(vay, vld1q_f32(y + i))),
+                vmulq_f32(vaz, vld1q_f32(z + i)));
+            const uint32x4_t u = vreinterpretq_u32_f32(d);
+            const uint32x4_t mask = vorrq_u32(vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(u), 31)), signBit);
+            vst1q_u32(job->keys + i, veorq_u32(u, mask));
+        }
+    }
+#endif
+
+    for (; i < end; i++)
+        job->keys[i] = floatToKey(ax * x[i] + ay * y[i] + az * z[i]);
+}
+
+void NvRadixSort::computeDepthKeys(const float* points, int32_t stride, int32_t count, const float* axis, uint32_t* keys)
+{
+    NvDepthKeysJob job;
+    job.points = points;
+    job.stride = stride;
+    job.x = job.y = job.z = NULL;
+    job.axis[0] = axis[0];
+    job.axis[1] = axis[1];
+    job.axis[2] = axis[2];
+    job.keys = keys;
+    NvJobSystem::parallelFor(depthKeysRange, &job, count, DEPTH_KEYS_GRAIN, "Depth keys");
+}
+
+void NvRadixSort::computeDepthKeys(const float* x, const float* y, const float* z, int32_t count, const float* axis, uint32_t* keys)
+{
+    NvDepthKeysJob job;
+    job.points = NULL;
+    job.stride = 0;
+    job.x = x;
+    job.y = y;
+    job.z = z;
+    job.axis[0] = axis[0];
+    job.axis[1] = axis[1];
+    job.axis[2] = axis[2];
+    job.keys = keys;
+    NvJobSystem::parallelFor(depthKeysSoARange, &job, count, DEPTH_KEYS_GRAIN, "Depth keys");
+}
+
+void NvRadixSort::reserve(int32_t count, int32_t chunks)
+{
+    if (count > m_capacity) {
+        for (int32_t i = 0; i < 2; i++) {
+            delete[] m_keys[i];
+            delete[] m_values[i];
+            m_keys[i] = new uint32_t[count];
+            m_values[i] = new uint32_t[count];
+        }
+        m_capacity = count;
+    }
+    if (chunks > m_histogramChunks) {
+        delete[] m_histograms;
+        m_histograms = new uint32_t[chunks * PASSES * BUCKETS];
+        m_histogramChunks = chunks;
+    }
+}
+
+int32_t NvRadixSort::getChunkBegin(int32_t chunk) const
+{
+    return (int32_t)((int64_t)m_count * chunk / m_chunkCount);
+}
+
+// Counts the digits of the keys of one chunk: of every pass for the first, of the
+// current pass for the later ones (whose keys have been moved by the passes before)
+void NvRadixSort::histogramChunk(void* data, int32_t begin, int32_t end)
+{
+    NvRadixSort* sorter = (NvRadixSort*)data;
+    for (int32_t c = begin; c < end; c++) {
+        const uint32_t* keys = sorter->m_srcKeys;
+        const int32_t i0 = sorter->getChunkBegin(c), i1 = sorter->getChunkBegin(c + 1);
+        uint32_t* hist = sorter->m_histograms + c * PASSES * BUCKETS;
+
+        if (sorter->m_allPasses) {
+            memset(hist, 0, sizeof(uint32_t) * PASSES * BUCKETS);
+            uint32_t* h0 = hist;
+            uint32_t* h1 = hist + BUCKETS;
+            uint32_t* h2 = hist + 2 * BUCKETS;
+            for (int32_t i = i0; i < i1; i++) {
+                const uint32_t key = keys[i];
+                h0[key & DIGIT_MASK]++;
+                h1[(key >> DIGIT_BITS) & DIGIT_MASK]++;
+                h2[key >> (2 * DIGIT_BITS)]++;
+            }
+        } else {
+            uint32_t* h = hist + sorter->m_pass * BUCKETS;
+            const int32_t shift = sorter->m_pass * DIGIT_BITS;
+            memset(h, 0, sizeof(uint32_t) * BUCKETS);
+            for (int32_t i = i0; i < i1; i++)
+                h[(keys[i] >> shift) & DIGIT_MASK]++;
+        }
+    }
+}
+
+// Moves the keys of one chunk to their offsets for the current pass; the last pass
+// writes only the values, as the final index type
+template <class IndexT>
+void NvRadixSort::scatterChunk(void* data, int32_t begin, int32_t end)
+{
+    NvRadixSort* sorter = (NvRadixSort*)data;
+    const int32_t shift = sorter->m_pass * DIGIT_BITS;
+    const uint32_t* keys = sorter->m_srcKeys;
+    const uint32_t* values = sorter->m_srcValues;
+
+    for (int32_t c = begin; c < end; c++) {
+        uint32_t* offsets = sorter->m_histograms + (c * PASSES + sorter->m_pass) * BUCKETS;
+        const int32_t i0 = sorter->getChunkBegin(c), i1 = sorter->getChunkBegin(c + 1);
+
+        if (sorter->m_dstIndices) {
+            IndexT* out = (IndexT*)sorter->m_dstIndices;
+            if (values) {
+                for (int32_t i = i0; i < i1; i++)
+                    out[offsets[(keys[i] >> shift) & DIGIT_MASK]++] = (IndexT)values[i];
+            } else {
+                for (int32_t i = i0; i < i1; i++)
+                    out[offsets[(keys[i] >> shift) & DIGIT_MASK]++] = (IndexT)i;
+            }
+        } else {
+            uint32_t* dstKeys = sorter->m_dstKeys;
+            uint32_t* dstValues = sorter->m_dstValues;
+            for (int32_t i = i0; i < i1; i++) {
+                const uint32_t key = keys[i];
+                const uint32_t pos = offsets[(key >> shift) & DIGIT_MASK]++;
+                dstKeys[pos] = key;
+                dstValues[pos] = values ? values[i] : (uint32_t)i;
+            }
+        }
+    }
+}
+
+template <class IndexT>
+void NvRadixSort::sortKeys(const uint32_t* keys, int32_t count, IndexT* indices)
+{
+    m_passCount = 0;
+    m_chunkCount = 0;
+    if (count <= 0)
+        return;
+
+    int32_t chunks = count / PARALLEL_MIN_KEYS;
+    if (chunks > NvJobSystem::getWorkerCount() + 1)
+        chunks = NvJobSystem::getWorkerCount() + 1;
+    if (chunks < 1)
+        chunks = 1;
+    reserve(count, chunks);
+    m_count = count;
+    m_chunkCount = chunks;
+
+    // one read of the keys counts the digits of every pass
+    m_srcKeys = keys;
+    m_srcValues = NULL;
+    m_allPasses = true;
+    NvJobSystem::parallelFor(histogramChunk, this, chunks, 1, "Radix sort histograms");
+    m_allPasses = false;
+
+    // passes where every key has the same digit do not move anything
+    int32_t passes[PASSES];
+    int32_t passCount = 0;
+    for (int32_t p = 0; p < PASSES; p++) {
+        bool trivial = false;
+        for (int32_t d = 0; d < BUCKETS && !trivial; d++) {
+            uint32_t total = 0;
+            for (int32_t c = 0; c < chunks; c++)
+                total += m_histograms[(c * PASSES + p) * BUCKETS + d];
+            trivial = (total == (uint32_t)count);
+        }
+        if (!trivial)
+            passes[passCount++] = p;
+    }
+    m_passCount = passCount;
+
+    if (passCount == 0) {
+        for (int32_t i = 0; i < count; i++)
+            indices[i] = (IndexT)i;
+        return;
+    }
+
+    for (int32_t k = 0; k < passCount; k++) {
+        m_pass = passes[k];
+
+        // the first pass was counted in the input order; the others count their chunks of the moved keys
+        if (k > 0 && chunks > 1)
+            NvJobSystem::parallelFor(histogramChunk, this, chunks, 1, "Radix sort histograms");
+
+        // each chunk's keys of a digit go after those of the smaller digits and of the earlier chunks
+        uint32_t offset = 0;
+        for (int32_t d = 0; d < BUCKETS; d++) {
+            for (int32_t c = 0; c < chunks; c++) {
+                uint32_t& h = m_histograms[(c * PASSES + m_pass) * BUCKETS + d];
+                const uint32_t n = h;
+                h = offset;
+                offset += n;
+            }
+        }
+
+        const int32_t dst = k & 1;
+        if (k == passCount - 1) {
+            m_dstIndices = indices;
+        } else {
+            m_dstIndices = NULL;
+            m_dstKeys = m_keys[dst];
+            m_dstValues = m_values[dst];
+        }
+        NvJobSystem::parallelFor(scatterChunk<IndexT>, this, chunks, 1, "Radix sort scatter");
+
+        m_srcKeys = m_keys[dst];
+        m_srcValues = m_values[dst];
+    }
+    m_dstIndices = NULL;
+}
+
+void NvRadixSort::sort(const uint32_t* keys, int32_t count, uint32_t* indices)
+{
+    sortKeys(keys, count, indices);
+}
+
+void NvRadixSort::sort(const uint32_t* keys, int32_t count, uint16_t* indices)
+{
+    sortKeys(keys, count, indices);
+}
@@ -34,11 +34,23 @@
 #include "NvAppBase/NvSampleApp.h"
 #include "NV/NvLogs.h"
 #include "NV/NvPlatformGL.h"
+#include "NvAppBase/NvFixedTimestep.h"
 #include "NvAppBase/NvFramerateCounter.h"
+#include "NvAppBase/NvFrameTimeStats.h"
+#include "NvAppBase/NvIncrementalSort.h"
 #include "NvAppBase/NvInputTransformer.h"
+#include "NvAppBase/NvJobSystem.h"
+#include "NvAppBase/NvNoiseVolume.h"
+#include "NvGLUtils/NvGLSLProgram.h"
+#include "NvGLUtils/NvGPUSort.h"
+#include "NvGLUtils/NvGridIndexBuffer.h"
 #include "NvGLUtils/NvImage.h"
+#include "NvGLUtils/NvMultiDraw.h"
+#include "NvGLUtils/NvProfiler.h"
 #include "NvGLUtils/NvSimpleFBO.h"
+#include "NvGLUtils/NvStreamingBuffer.h"
 #include "NvGLUtils/NvTimers.h"
+#include "NvGLUtils/NvVertexPacking.h"
 #include "NvUI/NvTweakBar.h"
 #include "NV/NvString.h"
 #include "NV/NvTokenizer.h"
@@ -54,6 +66,7 @@ NvSampleApp::NvSampleApp(NvPlatformContext* platform, const char* appTitle) :
     , mFPSText(0L)
     , mTweakBar(0L)
     , mTweakTab(0L)
+    , mProfilerText(0L)
     , mMainFBO(0)
     , mUseFBOPair(false)
     , mCurrentFBOIndex(0)
@@ -66,6 +79,19 @@ NvSampleApp::NvSampleApp(NvPlatformContext* platform, const char* appTitle) :
     , mTestMode(false)
     , mTestDuration(0.0f)
     , mTestRepeatFrames(1)
+    , mTestFrameLimit(0)
+    , mTestTolerance(5.0f)
+    , mTestFrameStats(NULL)
+    , mTestGPUQueries(NULL)
+    , mTestGPUHead(0)
+    , mTestGPUTail(0)
+    , mProfileCaptureFrames(0)
+    , mProfileNullGPU(false)
+    , mJobWorkers(-1)
+    , mJobSystemTest(false)
+    , mBenchmarkFunction(NULL)
+    , mStreamingMethod(-1)
+    , mMultiDrawMethod(-1)
     , m_testModeIssues(TEST_MODE_ISSUE_NONE)
 {
     m_transformer = new NvInputTransformer;
@@ -98,12 +124,59 @@ NvSampleApp::NvSampleApp(NvPlatformContext* platform, const char* appTitle) :
         } else if (0==(*iter).compare("-repeat")) {
             iter++;
             std::stringstream(*iter) >> mTestRepeatFrames;
+        } else if (0==(*iter).compare("-testframes")) {
+            // end the test after a fixed number of timed frames rather than a duration
+            iter++;
+            std::stringstream(*iter) >> mTestFrameLimit;
+        } else if (0==(*iter).compare("-baseline")) {
+            // -baseline <file.json> fails the test if frame times regress beyond -tolerance
+            iter++;
+            mTestBaseline = (*iter);
+        } else if (0==(*iter).compare("-tolerance")) {
+            iter++;
+            std::stringstream(*iter) >> mTestTolerance; // percent
+        } else if (0==(*iter).compare("-stutter")) {
+            iter++;
+            mTestStutterThresholds = (*iter); // comma-separated ms thresholds
         } else if (0==(*iter).compare("-fbo")) {
             mUseFBOPair = true;
             iter++;
             std::stringstream(*iter) >> m_fboWidth;
             iter++;
             std::stringstream(*iter) >> m_fboHeight;
+        } else if (0==(*iter).compare("-profile")) {
+            // -profile <frames> <trace.json> captures a Chrome trace of the first frames
+            iter++;
+            std::stringstream(*iter) >> mProfileCaptureFrames;
+            iter++;
+            mProfileTraceFile = (*iter);
+        } else if (0==(*iter).compare("-profilenullgpu")) {
+            mProfileNullGPU = true;
+        } else if (0==(*iter).compare("-jobworkers")) {
+            // -jobworkers <n> overrides the job system's worker count (default: cores - 1)
+            iter++;
+            std::stringstream(*iter) >> mJobWorkers;
+        } else if (0==(*iter).compare("-jobtest")) {
+            // -jobtest runs the job system stress test and dispatch benchmark, then exits
+            mJobSystemTest = true;
+        } else if (0==(*iter).compare("-noisecache")) {
+            // -noisecache <dir> keeps generated noise volumes in <dir> for later runs
+            iter++;
+            NvNoiseVolume::setCacheDirectory((*iter).c_str());
+        } else if (0==(*iter).compare("-multidraw")) {
+            // -multidraw <indirect|multi|loop> caps the NvMultiDraw method
+            iter++;
+            for (int32_t m = NvMultiDraw::METHOD_INDIRECT; m <= NvMultiDraw::METHOD_LOOP; m++) {
+                if (0==(*iter).compare(NvMultiDraw::getMethodName((NvMultiDraw::Method)m)))
+                    mMultiDrawMethod = m;
+            }
+        } else if (0==(*iter).compare("-streaming")) {
+            // -streaming <persistent|unsynchronized|orphan> caps the NvStreamingBuffer method
+            iter++;
+            for (int32_t m = NvStreamingBuffer::METHOD_PERSISTENT; m <= NvStreamingBuffer::METHOD_ORPHAN; m++) {
+                if (0==(*iter).compare(NvStreamingBuffer::getMethodName((NvStreamingBuffer::Method)m)))
+                    mStreamingMethod = m;
+            }
         }
         iter++;
     }
@@ -113,6 +186,7 @@ NvSampleApp::NvSampleApp(NvPlatformContext* platform, const char* appTitle) :
 NvSampleApp::~NvSampleApp() 
 { 
     // clean up internal allocs
+    delete mTestFrameStats;
     delete mFrameTimer;
     delete m_transformer;
 }
@@ -123,6 +197,23 @@ void NvSampleApp::baseInitRendering(void) {
     LOGI("GL_VENDOR     = %s", (char *) glGetString(GL_VENDOR));
 
     NvGPUTimer::globalInit(*getGLContext());
+    NvGLSLProgram::globalInit(*getGLContext());
+    NvStreamingBuffer::globalInit(*getGLContext());
+    if (mStreamingMethod >= 0)
+        NvStreamingBuffer::limitMethod((NvStreamingBuffer::Method)mStreamingMethod);
+    NvGridIndexBuffer::globalInit(*getGLContext());
+    NvMultiDraw::globalInit(*getGLContext());
+    if (mMultiDrawMethod >= 0)
+        NvMultiDraw::limitMethod((NvMultiDraw::Method)mMultiDrawMethod);
+    NvVertexPacking::globalInit(*getGLContext());
+    NvGPUSort::globalInit(*getGLContext());
+
+    NvProfiler::globalInit(mProfileNullGPU ? NULL : NvProfiler::createGLBackend(*getGLContext()));
+    NvProfiler::setThreadName("main");
+    if (mProfileCaptureFrames > 0) {
+        NvProfiler::beginCapture(mProfileCaptureFrames);
+        mProfileCaptureFrames = 0;
+    }
 
     if (mUseFBOPair) {
         // clear the main framebuffer to black for later testing
@@ -187,6 +278,10 @@ void NvSampleApp::baseInitRendering(void) {
         NvImage::setDXTExpansion(true);
     }
 
+    // a benchmark mode runs from mainLoop instead of the sample
+    if (mBenchmarkFunction)
+        return;
+
     initRendering();
     baseInitUI();
 }
@@ -205,6 +300,13 @@ void NvSampleApp::baseInitUI(void) {
         mFPSText->SetShadow();
         mUIWindow->Add(mFPSText, (float)w-8, 0);
 
+        // per-scope profiler summary, toggled with F2
+        mProfilerText = new NvUIText("", NvUIFontFamily::SANS, w/64.0f, NvUITextAlign::LEFT);
+        mProfilerText->SetColor(NV_PACKED_COLOR(0xFF,0xFF,0x80,0xD0));
+        mProfilerText->SetShadow();
+        mProfilerText->SetVisibility(false);
+        mUIWindow->Add(mProfilerText, w/4.0f, h/16.0f);
+
         if (mTweakBar==NULL) {
             mTweakBar = NvTweakBar::CreateTweakBar(mUIWindow); // adds to window internally.
             mTweakBar->SetVisibility(false);
@@ -270,6 +372,11 @@ void NvSampleApp::baseDrawUI(void) {
         if (mFPSText) {
             mFPSText->SetValue(mFramerate->getMeanFramerate());
         }
+        if (mProfilerText && mProfilerText->GetVisibility()) {
+            std::string summary;
+            NvProfiler::formatSummary(summary);
+            mProfilerText->SetString(summary.c_str());
+        }
         NvUST time = 0;
         NvUIDrawState ds(time, getGLContext()->width(), getGLContext()->height());
         mUIWindow->Draw(ds);
@@ -278,6 +385,13 @@ void NvSampleApp::baseDrawUI(void) {
     drawUI();
 }
 
+void NvSampleApp::baseEndFrame(void) {
+    NvProfiler::endFrame();
+
+    if (NvProfiler::hasCapture() && !mProfileTraceFile.empty())
+        NvProfiler::writeChromeTrace(mProfileTraceFile.c_str());
+}
+
 void NvSampleApp::baseFocusChanged(bool focused) {
     focusChanged(focused);
 }
@@ -402,6 +516,11 @@ bool NvSampleApp::keyInput(uint32_t code, NvKeyActionType::Enum action) {
         NvUIEventResponse r = nvuiEventNotHandled;
         switch(code)
         {
+            case NvKey::K_F2: {
+                if (NvKeyActionType::DOWN!=action || !mProfilerText) break;
+                mProfilerText->SetVisibility(!mProfilerText->GetVisibility());
+                return true;
+            }
             case NvKey::K_TAB: {
                 if (NvKeyActionType::DOWN!=action) break; // we don't want autorepeat...
                 NvUIReaction &react = mUIWindow->GetReactionEdit(true);
@@ -603,12 +722,28 @@ bool NvSampleApp::gamepadChanged(uint32_t changedPadFlags) {
 void NvSampleApp::mainLoop() {
     bool hasInitializedGL = false;
 
+    NvJobSystem::globalInit(mJobWorkers);
+    if (mJobSystemTest) {
+        const bool passed = NvJobSystem::runStressTest(100);
+        NvJobSystem::runDispatchBenchmark();
+        NvJobSystem::globalShutdown();
+        exit(passed ? 0 : 1);
+    }
+
     NvStopWatch* testModeTimer = createStopWatch();
     int32_t testModeFrames = -TESTMODE_WARMUP_FRAMES;
+    float testModeFrameEnd = 0.0f;
     float totalTime = -1e6f; // don't exit during startup
 
     if (mTestMode) {
         writeLogFile(mTestName, false, "*** Starting Test\n");
+        mTestCounters.read();
+
+        // preallocate room for every frame (up to 1000fps) so recording never allocates
+        const float seconds = (mTestDuration > 1.0f) ? mTestDuration : 1.0f;
+        mTestFrameStats = new NvFrameTimeStats((mTestFrameLimit > 0) ? mTestFrameLimit : (int32_t)(seconds * 1000.0f));
+        if (!mTestStutterThresholds.empty())
+            mTestFrameStats->setStutterThresholds(mTestStutterThresholds.c_str());
     }
 
     mFramerate = new NvFramerateCounter(this);
@@ -622,7 +757,10 @@ void NvSampleApp::mainLoop() {
 
         NvPlatformContext* ctx = getPlatformContext();
 
-        baseUpdate();
+        {
+            NV_PROFILE_SCOPE("update");
+            baseUpdate();
+        }
 
         // If the context has been lost and graphics resources are still around,
         // signal for them to be deleted
@@ -643,6 +781,25 @@ void NvSampleApp::mainLoop() {
                 hasInitializedGL = true;
                 needsReshape = true;
 
+                if (mBenchmarkFunction) {
+                    NvStopWatch* stopWatch = createStopWatch();
+                    const bool passed = mBenchmarkFunction(stopWatch);
+                    delete stopWatch;
+                    LOGI("%s: %s\n", mBenchmarkFlag.c_str(), passed ? "passed" : "FAILED");
+                    // join the job workers before exit() destroys the statics they wait on
+                    NvJobSystem::globalShutdown();
+                    exit(passed ? 0 : 1);
+                }
+
+                if (mTestMode) {
+                    // a pair of timestamps per frame, deep enough that results are
+                    // read back without waiting; NULL if the context has no timer queries
+                    mTestGPUQueries = NvProfiler::createGLBackend(*getGLContext());
+                    if (mTestGPUQueries)
+                        mTestGPUQueries->init(TESTMODE_GPU_QUERY_FRAMES * 2);
+                    mTestGPUHead = mTestGPUTail = 0;
+                }
+
                 // In test mode, disable VSYNC if possible
                 if (mTestMode)
                     getGLContext()->setSwapInterval(0);
@@ -688,9 +845,17 @@ void NvSampleApp::mainLoop() {
                     }
                 }
 
-                baseDraw();
+                beginTestGPUFrame(testModeFrames);
+
+                {
+                    NV_PROFILE_SCOPE("draw");
+                    NV_PROFILE_GPU_SCOPE("draw");
+                    baseDraw();
+                }
                 CHECK_GL_ERROR(); // sanity catch errors
                 if (!mTestMode) {
+                    NV_PROFILE_SCOPE("drawUI");
+                    NV_PROFILE_GPU_SCOPE("drawUI");
                     baseDrawUI();
                     CHECK_GL_ERROR(); // sanity catch errors
                 }
@@ -704,6 +869,8 @@ void NvSampleApp::mainLoop() {
                     }
                 }
 
+                endTestGPUFrame();
+
                 if (mTestMode && mUseFBOPair) {
                     // Check if the app bound FBO 0 in FBO mode
                     GLuint currFBO = 0;
@@ -715,7 +882,11 @@ void NvSampleApp::mainLoop() {
                         m_testModeIssues |= TEST_MODE_FBO_ISSUE;
                 }
 
-                SwapBuffers();
+                {
+                    NV_PROFILE_SCOPE("swap");
+                    SwapBuffers();
+                }
+                baseEndFrame();
 
                 if (mFramerate->nextFrame()) {
                     // for now, disabling console output of fps as we have on-screen.
@@ -730,13 +901,27 @@ void NvSampleApp::mainLoop() {
                 if (testModeFrames == 0) {
                     totalTime = 0.0f;
                     testModeTimer->start();
+                    testModeFrameEnd = 0.0f;
+                    NvProfiler::resetTotals();
+                    mTestCounters.read();
+                } else if (testModeFrames > 0) {
+                    // a timed frame was just drawn; its time runs from the end of the one before,
+                    // so the recorded times add up to the timed total
+                    const float frameEnd = testModeTimer->getTime();
+                    mTestFrameStats->addFrame((frameEnd - testModeFrameEnd) * 1000.0f);
+                    testModeFrameEnd = frameEnd;
                 }
 
-                if (totalTime > mTestDuration) {
+                const bool testDone = (mTestFrameLimit > 0) ?
+                    (testModeFrames >= mTestFrameLimit) : (totalTime > mTestDuration);
+                if (testDone) {
                     testModeTimer->stop();
+                    collectTestGPUFrames(0);
                     double frameRate = testModeFrames / testModeTimer->getTime();
-                    logTestResults((float)frameRate, testModeFrames);
-                    exit(0);
+                    bool passed = logTestResults((float)frameRate, testModeFrames);
+                    // join the job workers before exit() destroys the statics they wait on
+                    NvJobSystem::globalShutdown();
+                    exit(passed ? 0 : 1);
 //                    appRequestExit();
                 }
             }
@@ -751,6 +936,22 @@ void NvSampleApp::mainLoop() {
     // mainloop exiting, clean up things created in mainloop lifespan.
     delete mFramerate;
     mFramerate = NULL;
+
+    NvJobSystem::globalShutdown();
+}
+
+void NvSampleApp::addBenchmarkMode(const char* flag, NvBenchmarkFunction func) {
+    if (mBenchmarkFunction)
+        return;
+
+    const std::vector<std::string>& cmd = getPlatformContext()->getCommandLine();
+    for (std::vector<std::string>::const_iterator it = cmd.begin(); it != cmd.end(); ++it) {
+        if (0 == (*it).compare(flag)) {
+            mBenchmarkFlag = flag;
+            mBenchmarkFunction = func;
+            return;
+        }
+    }
 }
 
 bool NvSampleApp::requireExtension(const char* ext, bool exitOnFailure) {
@@ -841,11 +1042,75 @@ void NvSampleApp::baseShutdownRendering(void) {
     mFPSText = NULL;
     mTweakBar = NULL;
     mTweakTab = NULL;
+    mProfilerText = NULL;
 
     shutdownRendering();
+
+    // pending GPU frame times are lost along with the context
+    delete mTestGPUQueries;
+    mTestGPUQueries = NULL;
+    mTestGPUHead = mTestGPUTail = 0;
+
+    NvProfiler::globalShutdown();
+}
+
+void NvSampleApp::beginTestGPUFrame(int32_t frame) {
+    if (!mTestGPUQueries)
+        return;
+
+    // make room in the query ring, waiting for the oldest frame only if the GPU
+    // has fallen a whole ring behind
+    collectTestGPUFrames(TESTMODE_GPU_QUERY_FRAMES - 1);
+
+    const int32_t index = mTestGPUHead % TESTMODE_GPU_QUERY_FRAMES;
+    mTestGPUFrames[index] = frame;
+    mTestGPUQueries->timestamp(index * 2);
+}
+
+void NvSampleApp::endTestGPUFrame() {
+    if (!mTestGPUQueries)
+        return;
+
+    mTestGPUQueries->timestamp((mTestGPUHead % TESTMODE_GPU_QUERY_FRAMES) * 2 + 1);
+    mTestGPUHead++;
+
+    collectTestGPUFrames(TESTMODE_GPU_QUERY_FRAMES);
+}
+
+void NvSampleApp::collectTestGPUFrames(uint32_t maxPending) {
+    if (!mTestGPUQueries)
+        return;
+
+    // frames complete in order, so stop at the first one still in flight
+    while (mTestGPUTail != mTestGPUHead) {
+        const int32_t index = mTestGPUTail % TESTMODE_GPU_QUERY_FRAMES;
+        if ((mTestGPUHead - mTestGPUTail <= maxPending) && !mTestGPUQueries->isAvailable(index * 2 + 1))
+            break;
+
+        const uint64_t begin = mTestGPUQueries->getTimestamp(index * 2);
+        const uint64_t end = mTestGPUQueries->getTimestamp(index * 2 + 1);
+        if (mTestGPUFrames[index] >= 0)
+            mTestFrameStats->addGPUFrame(mTestGPUFrames[index], (end - begin) * 1.0e-6f);
+        mTestGPUTail++;
+    }
 }
 
-void NvSampleApp::logTestResults(float frameRate, int32_t frames) {
+void NvSampleApp::TestCounters::read() {
+    streamWrites = NvStreamingBuffer::getTotalWriteCount();
+    streamStalls = NvStreamingBuffer::getTotalStallCount();
+    streamStallMs = NvStreamingBuffer::getTotalStallMs();
+    streamBytes = NvStreamingBuffer::getTotalWriteBytes();
+    simSteps = NvFixedTimestep::getTotalStepCount();
+    simDroppedSteps = NvFixedTimestep::getTotalDroppedStepCount();
+    simStepMs = NvFixedTimestep::getTotalStepMs();
+    sortRadix = NvIncrementalSort::getTotalSortCount(NvIncrementalSort::PATH_RADIX);
+    sortSorted = NvIncrementalSort::getTotalSortCount(NvIncrementalSort::PATH_SORTED);
+    sortMerge = NvIncrementalSort::getTotalSortCount(NvIncrementalSort::PATH_MERGE);
+    sortMoved = NvIncrementalSort::getTotalMovedCount();
+    sortShifted = NvIncrementalSort::getTotalShiftedCount();
+}
+
+bool NvSampleApp::logTestResults(float frameRate, int32_t frames) {
     LOGI("Test Frame Rate = %lf (frames = %d)\n", frameRate, frames);
     writeLogFile(mTestName, true, "\n%s %lf fps (%d frames)\n", mTestName.c_str(), frameRate, frames);
     if (mUseFBOPair) {
@@ -899,8 +1164,84 @@ void NvSampleApp::logTestResults(float frameRate, int32_t frames) {
     glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)data);
 
     writeScreenShot(m_width, m_height, data, mTestName);
-    writeLogFile(mTestName, true, "Test Complete!");
 
     delete[] data;
+
+    bool passed = true;
+    if (mTestFrameStats) {
+        // the profiler's per-scope means (update, draw submission, app scopes) over
+        // the timed frames, as counters
+        std::vector<NvProfiler::ScopeSummary> scopes;
+        int32_t scopeFrames = 0;
+        NvProfiler::getTotals(scopes, scopeFrames);
+        if (!scopes.empty())
+            mTestFrameStats->addCounter("profiled_frames", (float)scopeFrames);
+        for (size_t i = 0; i < scopes.size(); i++) {
+            std::string name = (scopes[i].gpu ? "gpu_ms:" : "cpu_ms:") + scopes[i].name;
+            mTestFrameStats->addCounter(name, scopes[i].meanMs);
+        }
+
+        // the counters below cover the timed frames only
+        TestCounters now;
+        now.read();
+
+        // GPU waits taken by streamed buffer updates
+        if (now.streamWrites > mTestCounters.streamWrites) {
+            mTestFrameStats->addCounter("stream_writes", (float)(now.streamWrites - mTestCounters.streamWrites));
+            mTestFrameStats->addCounter("stream_stalls", (float)(now.streamStalls - mTestCounters.streamStalls));
+            mTestFrameStats->addCounter("stream_stall_ms", now.streamStallMs - mTestCounters.streamStallMs);
+            if (frames > 0) {
+                const uint64_t bytes = now.streamBytes - mTestCounters.streamBytes;
+                mTestFrameStats->addCounter("stream_kb_per_frame", (float)(bytes / 1024.0 / frames));
+            }
+        }
+
+        // fixed simulation steps, including the ones dropped to catch up after slow frames
+        if (now.simSteps > mTestCounters.simSteps) {
+            mTestFrameStats->addCounter("sim_steps", (float)(now.simSteps - mTestCounters.simSteps));
+            mTestFrameStats->addCounter("sim_dropped_steps", (float)(now.simDroppedSteps - mTestCounters.simDroppedSteps));
+            mTestFrameStats->addCounter("sim_step_ms", now.simStepMs - mTestCounters.simStepMs);
+        }
+
+        // depth sorts that reused the last frame's order, and the keys they had to move and shift
+        const uint32_t radix = now.sortRadix - mTestCounters.sortRadix;
+        const uint32_t sorted = now.sortSorted - mTestCounters.sortSorted;
+        const uint32_t merge = now.sortMerge - mTestCounters.sortMerge;
+        const uint32_t sorts = radix + sorted + merge;
+        if (sorts > 0) {
+            mTestFrameStats->addCounter("sort_radix", (float)radix);
+            mTestFrameStats->addCounter("sort_sorted", (float)sorted);
+            mTestFrameStats->addCounter("sort_merge", (float)merge);
+            mTestFrameStats->addCounter("sort_moved_per_sort", (float)((double)(now.sortMoved - mTestCounters.sortMoved) / sorts));
+            mTestFrameStats->addCounter("sort_shifted_per_sort", (float)((double)(now.sortShifted - mTestCounters.sortShifted) / sorts));
+        }
+
+        std::string text;
+        mTestFrameStats->formatReport(text);
+        LOGI("%s", text.c_str());
+        writeLogFile(mTestName, true, "\n%s", text.c_str());
+
+        // machine-readable copies alongside the log
+        mTestFrameStats->formatJSON(mTestName, text);
+        writeDataFile(mTestName, ".json", text);
+        mTestFrameStats->formatCSV(text);
+        writeDataFile(mTestName, ".csv", text);
+
+        if (!mTestBaseline.empty()) {
+            NvFrameTimeStats::Summary cpu, gpu;
+            if (NvFrameTimeStats::readBaseline(mTestBaseline.c_str(), cpu, gpu)) {
+                passed = mTestFrameStats->compareToBaseline(cpu, gpu, mTestTolerance / 100.0f, text);
+                LOGI("Baseline comparison (tolerance %.1f%%):\n%s", mTestTolerance, text.c_str());
+                writeLogFile(mTestName, true, "\nBaseline %s (tolerance %.1f%%):\n%s%s\n", mTestBaseline.c_str(),
+                    mTestTolerance, text.c_str(), passed ? "PASSED" : "FAILED: frame times regressed");
+            } else {
+                passed = false;
+                writeLogFile(mTestName, true, "\nFAILED: cannot read baseline %s\n", mTestBaseline.c_str());
+            }
+        }
+    }
+
+    writeLogFile(mTestName, true, "Test Complete!");
+    return passed;
 }
 
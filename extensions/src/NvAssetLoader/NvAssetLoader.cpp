@@ -94,6 +94,12 @@ char *NvAssetLoaderRead(const char *filePath, int32_t &length)
     return buff;
 }
 
+bool NvAssetLoaderFindFile(const char *, char *, int32_t)
+{
+    // assets live inside the APK
+    return false;
+}
+
 bool NvAssetLoaderFree(char* asset)
 {
     delete[] asset;
@@ -103,6 +109,7 @@ bool NvAssetLoaderFree(char* asset)
 #elif defined(WIN32)
 
 #include <stdio.h>
+#include <string.h>
 #include <vector>
 
 static std::vector<std::string> s_searchPath;
@@ -146,12 +153,11 @@ bool NvAssetLoaderRemoveSearchPath(const char *path)
     return true;
 }
 
-char *NvAssetLoaderRead(const char *filePath, int32_t &length)
+static FILE* openAsset(const char *filePath, std::string& fullPath)
 {
     FILE *fp = NULL;
     // loop N times up the hierarchy, testing at each level
     std::string upPath;
-    std::string fullPath;
     for (int32_t i = 0; i < 10; i++) {
         std::vector<std::string>::iterator src = s_searchPath.begin();
         bool looping = true;
@@ -184,6 +190,14 @@ char *NvAssetLoaderRead(const char *filePath, int32_t &length)
         upPath.append("../");
     }
 
+    return fp;
+}
+
+char *NvAssetLoaderRead(const char *filePath, int32_t &length)
+{
+    std::string fullPath;
+    FILE *fp = openAsset(filePath, fullPath);
+
     if (!fp) {
         fprintf(stderr, "Error opening file '%s'\n", filePath);
         return NULL;
@@ -205,6 +219,21 @@ char *NvAssetLoaderRead(const char *filePath, int32_t &length)
     return data;
 }
 
+bool NvAssetLoaderFindFile(const char *filePath, char *fullPath, int32_t maxLength)
+{
+    std::string path;
+    FILE *fp = openAsset(filePath, path);
+    if (!fp)
+        return false;
+    fclose(fp);
+
+    if ((int32_t)path.length() >= maxLength)
+        return false;
+
+    strcpy(fullPath, path.c_str());
+    return true;
+}
+
 bool NvAssetLoaderFree(char* asset)
 {
     delete[] asset;
@@ -214,6 +243,7 @@ bool NvAssetLoaderFree(char* asset)
 #elif defined(LINUX) || defined(MACOSX) // have mac and linux share ftm.
 
 #include <stdio.h>
+#include <string.h>
 #include <vector>
 
 static std::vector<std::string> s_searchPath;
@@ -257,12 +287,11 @@ bool NvAssetLoaderRemoveSearchPath(const char *path)
     return true;
 }
 
-char *NvAssetLoaderRead(const char *filePath, int32_t &length)
+static FILE* openAsset(const char *filePath, std::string& fullPath)
 {
     FILE *fp = NULL;
     // loop N times up the hierarchy, testing at each level
     std::string upPath;
-    std::string fullPath;
     for (int32_t i = 0; i < 10; i++) {
         std::vector<std::string>::iterator src = s_searchPath.begin();
         bool looping = true;
@@ -294,6 +323,14 @@ char *NvAssetLoaderRead(const char *filePath, int32_t &length)
         upPath.append("../");
     }
 
+    return fp;
+}
+
+char *NvAssetLoaderRead(const char *filePath, int32_t &length)
+{
+    std::string fullPath;
+    FILE *fp = openAsset(filePath, fullPath);
+
     if (!fp) {
         fprintf(stderr, "Error opening file '%s'\n", filePath);
         return NULL;
@@ -315,6 +352,21 @@ char *NvAssetLoaderRead(const char *filePath, int32_t &length)
     return data;
 }
 
+bool NvAssetLoaderFindFile(const char *filePath, char *fullPath, int32_t maxLength)
+{
+    std::string path;
+    FILE *fp = openAsset(filePath, path);
+    if (!fp)
+        return false;
+    fclose(fp);
+
+    if ((int32_t)path.length() >= maxLength)
+        return false;
+
+    strcpy(fullPath, path.c_str());
+    return true;
+}
+
 bool NvAssetLoaderFree(char* asset)
 {
     delete[] asset;
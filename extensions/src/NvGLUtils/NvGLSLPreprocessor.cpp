@@ -0,0 +1,436 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGLSLPreprocessor.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvGLUtils/NvGLSLPreprocessor.h"
+#include "NvAssetLoader/NvAssetLoader.h"
+#include "NV/NvLogs.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+NvGLSLPreprocessor::NvGLSLPreprocessor()
+    : m_dependencyGeneration(0)
+    , m_cacheHits(0)
+    , m_cacheMisses(0)
+{
+}
+
+NvGLSLPreprocessor::~NvGLSLPreprocessor()
+{
+    std::vector<Entry*>::iterator it;
+    for (it = m_entries.begin(); it != m_entries.end(); ++it) {
+        delete (*it)->program;
+        delete *it;
+    }
+}
+
+void NvGLSLPreprocessor::setDefine(const char* name, const char* value)
+{
+    std::vector<std::pair<std::string, std::string> >::iterator it;
+    for (it = m_defines.begin(); it != m_defines.end(); ++it) {
+        if (it->first == name) {
+            it->second = value;
+            return;
+        }
+    }
+    m_defines.push_back(std::make_pair(std::string(name), std::string(value)));
+}
+
+void NvGLSLPreprocessor::clearDefines()
+{
+    m_defines.clear();
+}
+
+uint64_t NvGLSLPreprocessor::hash(const void* data, size_t size, uint64_t seed)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+uint64_t NvGLSLPreprocessor::hashSources(const std::vector<std::string>& sources, const GLint* types, bool strict)
+{
+    uint64_t h = hash(&strict, sizeof(strict));
+    for (size_t i = 0; i < sources.size(); i++) {
+        h = hash(&types[i], sizeof(GLint), h);
+        h = hash(sources[i].c_str(), sources[i].length(), h);
+    }
+    return h;
+}
+
+static void appendLineDirective(std::string& result, int32_t line, size_t sourceString, const std::string& filename)
+{
+    // GLSL numbers source strings rather than naming files, so the name goes in a comment
+    char buf[64];
+    sprintf(buf, "#line %d %d // ", line, (int32_t)sourceString);
+    result += buf;
+    result += filename;
+    result += "\n";
+}
+
+bool NvGLSLPreprocessor::expand(const std::string& filename, std::string& result, std::vector<std::string>& included)
+{
+    // every file is included at most once, which also breaks include cycles.
+    // A file's position in the list is its #line source string number
+    size_t sourceString = included.size();
+    included.push_back(filename);
+
+    int32_t len;
+    char* src = NvAssetLoaderRead(filename.c_str(), len);
+    if (!src) {
+        LOGE("Could not read shader source \"%s\"", filename.c_str());
+        return false;
+    }
+
+    std::string dir;
+    size_t slash = filename.find_last_of('/');
+    if (slash != std::string::npos)
+        dir = filename.substr(0, slash + 1);
+
+    bool success = true;
+    int32_t lineNumber = 1;
+    const char* line = src;
+    while (*line) {
+        const char* end = strchr(line, '\n');
+        size_t lineLen = end ? (size_t)(end - line) : strlen(line);
+
+        const char* p = line;
+        while ((*p == ' ') || (*p == '\t'))
+            p++;
+
+        bool isInclude = false;
+        if (*p == '#') {
+            p++;
+            while ((*p == ' ') || (*p == '\t'))
+                p++;
+            if (!strncmp(p, "include", 7)) {
+                const char* open = p + 7;
+                while ((*open == ' ') || (*open == '\t'))
+                    open++;
+                char closeChar = (*open == '<') ? '>' : '"';
+                if ((*open == '"') || (*open == '<')) {
+                    const char* close = strchr(open + 1, closeChar);
+                    if (close && (close < line + lineLen)) {
+                        std::string name = dir + std::string(open + 1, close - open - 1);
+                        isInclude = true;
+                        if (std::find(included.begin(), included.end(), name) == included.end()) {
+                            appendLineDirective(result, 1, included.size(), name);
+                            if (!expand(name, result, included))
+                                success = false;
+                            appendLineDirective(result, lineNumber + 1, sourceString, filename);
+                        }
+                    }
+                }
+            }
+        }
+
+        if (!isInclude) {
+            result.append(line, lineLen);
+            result += "\n";
+        }
+
+        if (!end)
+            break;
+        line = end + 1;
+        lineNumber++;
+    }
+
+    NvAssetLoaderFree(src);
+    return success;
+}
+
+bool NvGLSLPreprocessor::preprocess(const char* filename, const char* defines, std::string& result,
+    std::set<std::string>* dependencies)
+{
+    std::vector<std::string> included;
+    std::string body;
+    bool success = expand(filename, body, included);
+
+    if (dependencies)
+        dependencies->insert(included.begin(), included.end());
+
+    if (!success)
+        return false;
+
+    std::string defineBlock;
+    std::vector<std::pair<std::string, std::string> >::const_iterator it;
+    for (it = m_defines.begin(); it != m_defines.end(); ++it)
+        defineBlock += "#define " + it->first + " " + it->second + "\n";
+
+    if (defines) {
+        const char* d = defines;
+        while (*d) {
+            const char* end = strchr(d, ';');
+            std::string def = end ? std::string(d, end - d) : std::string(d);
+            if (!def.empty()) {
+                size_t eq = def.find('=');
+                if (eq == std::string::npos)
+                    defineBlock += "#define " + def + "\n";
+                else
+                    defineBlock += "#define " + def.substr(0, eq) + " " + def.substr(eq + 1) + "\n";
+            }
+            if (!end)
+                break;
+            d = end + 1;
+        }
+    }
+
+    // #version must stay the first directive, so the defines go right after it
+    size_t insertAt = 0;
+    size_t version = body.find("#version");
+    if (version != std::string::npos) {
+        size_t eol = body.find('\n', version);
+        insertAt = (eol == std::string::npos) ? body.length() : eol + 1;
+    }
+
+    result = body.substr(0, insertAt);
+    if (!defineBlock.empty()) {
+        result += defineBlock;
+        // restore the root file's numbering after the injected lines
+        int32_t nextLine = 1 + (int32_t)std::count(body.begin(), body.begin() + insertAt, '\n');
+        appendLineDirective(result, nextLine, 0, filename);
+    }
+    result += body.substr(insertAt);
+
+    return true;
+}
+
+bool NvGLSLPreprocessor::buildSources(Entry& entry, std::vector<std::string>& sources)
+{
+    std::set<std::string> dependencies;
+    sources.resize(entry.filenames.size());
+    for (size_t i = 0; i < entry.filenames.size(); i++) {
+        if (!preprocess(entry.filenames[i].c_str(), entry.defines.c_str(), sources[i], &dependencies))
+            return false;
+    }
+
+    if (dependencies != entry.dependencies) {
+        entry.dependencies.swap(dependencies);
+        m_dependencyGeneration++;
+    }
+    return true;
+}
+
+NvGLSLProgram* NvGLSLPreprocessor::createProgram(const ShaderFile* files, int32_t count, const char* defines, bool strict)
+{
+    Entry* entry = new Entry;
+    for (int32_t i = 0; i < count; i++) {
+        entry->filenames.push_back(files[i].filename);
+        entry->types.push_back(files[i].type);
+    }
+    entry->defines = defines ? defines : "";
+    entry->strict = strict;
+    entry->program = NULL;
+
+    std::vector<std::string> sources;
+    if (!buildSources(*entry, sources)) {
+        delete entry;
+        return NULL;
+    }
+
+    entry->key = hashSources(sources, &entry->types[0], strict);
+    std::map<uint64_t, Entry*>::iterator cached = m_cache.find(entry->key);
+    if (cached != m_cache.end()) {
+        m_cacheHits++;
+        delete entry;
+        return cached->second->program;
+    }
+    m_cacheMisses++;
+
+    std::vector<NvGLSLProgram::ShaderSourceItem> items(count);
+    for (int32_t i = 0; i < count; i++) {
+        items[i].src = sources[i].c_str();
+        items[i].type = entry->types[i];
+    }
+
+    entry->program = new NvGLSLProgram;
+    if (!entry->program->setSourceFromStrings(&items[0], count, strict)) {
+        delete entry->program;
+        delete entry;
+        return NULL;
+    }
+
+    m_entries.push_back(entry);
+    m_cache[entry->key] = entry;
+    return entry->program;
+}
+
+NvGLSLProgram* NvGLSLPreprocessor::createProgramFromStrings(NvGLSLProgram::ShaderSourceItem* src, int32_t count, bool strict)
+{
+    std::vector<std::string> sources(count);
+    std::vector<GLint> types(count);
+    for (int32_t i = 0; i < count; i++) {
+        sources[i] = src[i].src;
+        types[i] = src[i].type;
+    }
+
+    uint64_t key = hashSources(sources, &types[0], strict);
+    std::map<uint64_t, Entry*>::iterator cached = m_cache.find(key);
+    if (cached != m_cache.end()) {
+        m_cacheHits++;
+        return cached->second->program;
+    }
+    m_cacheMisses++;
+
+    NvGLSLProgram* program = new NvGLSLProgram;
+    if (!program->setSourceFromStrings(src, count, strict)) {
+        delete program;
+        return NULL;
+    }
+
+    Entry* entry = new Entry;
+    entry->types = types;
+    entry->strict = strict;
+    entry->key = key;
+    entry->program = program;
+    m_entries.push_back(entry);
+    m_cache[key] = entry;
+    return program;
+}
+
+bool NvGLSLPreprocessor::watchSource(const char* filename, const char* defines, NvGLSLSourceFunction callback, void* userData)
+{
+    Watch watch;
+    watch.filename = filename;
+    watch.defines = defines ? defines : "";
+    watch.callback = callback;
+    watch.userData = userData;
+
+    // register even if the file cannot be read yet, so fixing it triggers a build
+    std::string source;
+    bool success = preprocess(filename, defines, source, &watch.dependencies);
+    watch.key = hash(source.c_str(), source.length());
+    m_watches.push_back(watch);
+    m_dependencyGeneration++;
+
+    return success && callback(source.c_str(), userData);
+}
+
+void NvGLSLPreprocessor::unwatchSource(void* userData)
+{
+    std::vector<Watch>::iterator it = m_watches.begin();
+    while (it != m_watches.end()) {
+        if (it->userData == userData)
+            it = m_watches.erase(it);
+        else
+            ++it;
+    }
+}
+
+int32_t NvGLSLPreprocessor::fileChanged(const char* filename)
+{
+    int32_t rebuilt = 0;
+
+    for (size_t i = 0; i < m_watches.size(); i++) {
+        Watch& watch = m_watches[i];
+        if (watch.dependencies.find(filename) == watch.dependencies.end())
+            continue;
+
+        std::set<std::string> dependencies;
+        std::string source;
+        bool success = preprocess(watch.filename.c_str(), watch.defines.c_str(), source, &dependencies);
+        if (dependencies != watch.dependencies) {
+            watch.dependencies.swap(dependencies);
+            m_dependencyGeneration++;
+        }
+        if (!success)
+            continue;
+
+        uint64_t key = hash(source.c_str(), source.length());
+        if (key == watch.key)
+            continue;
+
+        if (!watch.callback(source.c_str(), watch.userData)) {
+            LOGE("Reloading \"%s\" failed; keeping the previous build", watch.filename.c_str());
+            continue;
+        }
+
+        watch.key = key;
+        LOGI("Reloaded \"%s\" after a change to \"%s\"", watch.filename.c_str(), filename);
+        rebuilt++;
+    }
+
+    std::vector<Entry*>::iterator it;
+    for (it = m_entries.begin(); it != m_entries.end(); ++it) {
+        Entry& entry = **it;
+        if (entry.dependencies.find(filename) == entry.dependencies.end())
+            continue;
+
+        std::vector<std::string> sources;
+        if (!buildSources(entry, sources))
+            continue;
+
+        // saving a file without changing the expanded source is not worth a relink
+        uint64_t key = hashSources(sources, &entry.types[0], entry.strict);
+        if (key == entry.key)
+            continue;
+
+        std::vector<NvGLSLProgram::ShaderSourceItem> items(sources.size());
+        for (size_t i = 0; i < sources.size(); i++) {
+            items[i].src = sources[i].c_str();
+            items[i].type = entry.types[i];
+        }
+
+        if (!entry.program->relink(&items[0], (int32_t)items.size())) {
+            LOGE("Reloading \"%s\" failed; keeping the previous program", entry.filenames[0].c_str());
+            continue;
+        }
+
+        std::map<uint64_t, Entry*>::iterator cached = m_cache.find(entry.key);
+        if ((cached != m_cache.end()) && (cached->second == &entry))
+            m_cache.erase(cached);
+        entry.key = key;
+        if (m_cache.find(key) == m_cache.end())
+            m_cache[key] = &entry;
+
+        LOGI("Reloaded program \"%s\" after a change to \"%s\"", entry.filenames[0].c_str(), filename);
+        rebuilt++;
+    }
+
+    return rebuilt;
+}
+
+void NvGLSLPreprocessor::getDependencies(std::set<std::string>& files) const
+{
+    std::vector<Entry*>::const_iterator it;
+    for (it = m_entries.begin(); it != m_entries.end(); ++it)
+        files.insert((*it)->dependencies.begin(), (*it)->dependencies.end());
+
+    std::vector<Watch>::const_iterator watch;
+    for (watch = m_watches.begin(); watch != m_watches.end(); ++watch)
+        files.insert(watch->dependencies.begin(), watch->dependencies.end());
+}
@@ -38,13 +38,16 @@
 
 bool NvGLSLProgram::ms_logAllMissing = false;
 
+NvGLSLProgram::NV_PFNGLMAXSHADERCOMPILERTHREADSPROC NvGLSLProgram::ms_glMaxShaderCompilerThreads = NULL;
+
 NvGLSLProgram::NvGLSLProgram()
-    : m_program(0), m_strict(false)
+    : m_program(0), m_strict(false), m_pendingShaderCount(0)
 {
 }
 
 NvGLSLProgram::~NvGLSLProgram()
 {
+    releasePendingShaders();
     //LOGI("glDeleteProgram(%d)", m_program);
     glDeleteProgram(m_program);
     //CHECK_GL_ERROR();
@@ -94,6 +97,8 @@ bool NvGLSLProgram::setSourceFromFiles(const char* vertFilename, const char* fra
 
 bool NvGLSLProgram::setSourceFromStrings(const char* vertSrc, const char* fragSrc, bool strict)
 {
+    releasePendingShaders();
+
     if (m_program) {
         glDeleteProgram(m_program);
         m_program = 0;
@@ -108,6 +113,8 @@ bool NvGLSLProgram::setSourceFromStrings(const char* vertSrc, const char* fragSr
 
 bool NvGLSLProgram::setSourceFromStrings(ShaderSourceItem* src, int32_t count, bool strict)
 {
+    releasePendingShaders();
+
     if (m_program) {
         glDeleteProgram(m_program);
         m_program = 0;
@@ -120,6 +127,160 @@ bool NvGLSLProgram::setSourceFromStrings(ShaderSourceItem* src, int32_t count, b
     return m_program != 0;
 }
 
+void NvGLSLProgram::globalInit(NvGLExtensionsAPI& api)
+{
+    ms_glMaxShaderCompilerThreads = NULL;
+
+    if (api.isExtensionSupported("GL_KHR_parallel_shader_compile"))
+        ms_glMaxShaderCompilerThreads = (NV_PFNGLMAXSHADERCOMPILERTHREADSPROC)api.getGLProcAddress("glMaxShaderCompilerThreadsKHR");
+
+    if (!ms_glMaxShaderCompilerThreads && api.isExtensionSupported("GL_ARB_parallel_shader_compile"))
+        ms_glMaxShaderCompilerThreads = (NV_PFNGLMAXSHADERCOMPILERTHREADSPROC)api.getGLProcAddress("glMaxShaderCompilerThreadsARB");
+
+    // let the driver pick the number of compiler threads
+    if (ms_glMaxShaderCompilerThreads)
+        ms_glMaxShaderCompilerThreads(0xFFFFFFFF);
+}
+
+bool NvGLSLProgram::beginSourceFromFiles(const char* vertFilename, const char* fragFilename, bool strict)
+{
+    int32_t len;
+    char* vertSrc = NvAssetLoaderRead(vertFilename, len);
+    char* fragSrc = NvAssetLoaderRead(fragFilename, len);
+    if (!vertSrc || !fragSrc) {
+        NvAssetLoaderFree(vertSrc);
+        NvAssetLoaderFree(fragSrc);
+        return false;
+    }
+
+    ShaderSourceItem src[2];
+    src[0].src = vertSrc;
+    src[0].type = GL_VERTEX_SHADER;
+    src[1].src = fragSrc;
+    src[1].type = GL_FRAGMENT_SHADER;
+
+    // the driver copies the source in glShaderSource, so it can be freed right away
+    bool success = beginSourceFromStrings(src, 2, strict);
+
+    NvAssetLoaderFree(vertSrc);
+    NvAssetLoaderFree(fragSrc);
+
+    return success;
+}
+
+bool NvGLSLProgram::beginSourceFromStrings(ShaderSourceItem* src, int32_t count, bool strict)
+{
+    releasePendingShaders();
+
+    if (m_program) {
+        glDeleteProgram(m_program);
+        m_program = 0;
+    }
+
+    if (count > MAX_SHADER_STAGES) {
+        LOGE("Too many shader stages (%d) for a single program", count);
+        return false;
+    }
+
+    m_strict = strict;
+
+    m_program = glCreateProgram();
+
+    // Issue every compile before touching any status; querying
+    // GL_COMPILE_STATUS here would serialize the driver's compiler
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        GLuint shader = glCreateShader(src[i].type);
+        glShaderSource(shader, 1, &(src[i].src), 0);
+        glCompileShader(shader);
+        glAttachShader(m_program, shader);
+        m_pendingShaders[i] = shader;
+        m_pendingTypes[i] = src[i].type;
+    }
+    m_pendingShaderCount = count;
+
+    glLinkProgram(m_program);
+
+    return true;
+}
+
+bool NvGLSLProgram::isBuildComplete()
+{
+    if (!isBuildPending() || !ms_glMaxShaderCompilerThreads)
+        return true;
+
+    GLint complete = 0;
+    glGetProgramiv(m_program, NV_COMPLETION_STATUS, &complete);
+    return complete != 0;
+}
+
+bool NvGLSLProgram::finishBuild()
+{
+    if (!isBuildPending())
+        return m_program != 0;
+
+    // check if program linked
+    GLint success = 0;
+    glGetProgramiv(m_program, GL_LINK_STATUS, &success);
+
+    if (success) {
+        // strict programs still want to see the compiler warnings
+        if (m_strict) {
+            for (int32_t i = 0; i < m_pendingShaderCount; i++)
+                checkCompileError(m_pendingShaders[i], m_pendingTypes[i]);
+        }
+    } else {
+        // the link error alone rarely points at the culprit, so report the compiles first
+        bool compiled = true;
+        for (int32_t i = 0; i < m_pendingShaderCount; i++) {
+            GLint status = 0;
+            glGetShaderiv(m_pendingShaders[i], GL_COMPILE_STATUS, &status);
+            if (!status) {
+                LOGI("Error compiling shader");
+                GLint infoLen = 0;
+                glGetShaderiv(m_pendingShaders[i], GL_INFO_LOG_LENGTH, &infoLen);
+                if (infoLen) {
+                    char* buf = new char[infoLen];
+                    glGetShaderInfoLog(m_pendingShaders[i], infoLen, NULL, buf);
+                    LOGI("Shader log:\n%s\n", buf);
+                    delete[] buf;
+                }
+                compiled = false;
+            }
+        }
+
+        if (compiled) {
+            GLint bufLength = 0;
+            glGetProgramiv(m_program, GL_INFO_LOG_LENGTH, &bufLength);
+            if (bufLength) {
+                char* buf = new char[bufLength];
+                glGetProgramInfoLog(m_program, bufLength, NULL, buf);
+                LOGI("Could not link program:\n%s\n", buf);
+                delete [] buf;
+            }
+        }
+    }
+
+    releasePendingShaders();
+
+    if (!success) {
+        glDeleteProgram(m_program);
+        m_program = 0;
+    }
+
+    return m_program != 0;
+}
+
+void NvGLSLProgram::releasePendingShaders()
+{
+    for (int32_t i = 0; i < m_pendingShaderCount; i++) {
+        if (m_program)
+            glDetachShader(m_program, m_pendingShaders[i]);
+        glDeleteShader(m_pendingShaders[i]);
+    }
+    m_pendingShaderCount = 0;
+}
+
 void NvGLSLProgram::enable()
 {
     glUseProgram(m_program);
@@ -278,6 +439,55 @@ bool NvGLSLProgram::relink()
     return true;
 }
 
+bool NvGLSLProgram::relink(ShaderSourceItem* src, int32_t count)
+{
+    if (!m_program || (count > MAX_SHADER_STAGES))
+        return false;
+
+    // compile everything first so that a broken edit keeps the old program running
+    GLuint shaders[MAX_SHADER_STAGES];
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        shaders[i] = glCreateShader(src[i].type);
+        glShaderSource(shaders[i], 1, &(src[i].src), 0);
+        glCompileShader(shaders[i]);
+    }
+
+    bool compiled = true;
+    for (i = 0; i < count; i++) {
+        // checkCompileError deletes the shaders that failed
+        if (!checkCompileError(shaders[i], src[i].type)) {
+            shaders[i] = 0;
+            compiled = false;
+        }
+    }
+
+    if (!compiled) {
+        for (i = 0; i < count; i++) {
+            if (shaders[i])
+                glDeleteShader(shaders[i]);
+        }
+        return false;
+    }
+
+    releasePendingShaders();
+
+    GLuint attached[MAX_SHADER_STAGES];
+    GLsizei attachedCount = 0;
+    glGetAttachedShaders(m_program, MAX_SHADER_STAGES, &attachedCount, attached);
+    for (i = 0; i < attachedCount; i++)
+        glDetachShader(m_program, attached[i]);
+
+    for (i = 0; i < count; i++) {
+        glAttachShader(m_program, shaders[i]);
+
+        // can be deleted since the program will keep a reference
+        glDeleteShader(shaders[i]);
+    }
+
+    return relink();
+}
+
 GLint NvGLSLProgram::getAttribLocation(const char* attribute, bool isOptional)
 {
     GLint result = glGetAttribLocation(m_program, attribute);
@@ -0,0 +1,201 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGLSLProgramRegistry.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvGLUtils/NvGLSLProgramRegistry.h"
+#include "NV/NvStopWatch.h"
+#include "NV/NvLogs.h"
+
+NvGLSLProgramRegistry::NvGLSLProgramRegistry(NvStopWatchFactory* factory)
+    : m_batchTime(0.0f)
+{
+    m_submitWatch = factory->createStopWatch();
+    m_batchWatch = factory->createStopWatch();
+}
+
+NvGLSLProgramRegistry::~NvGLSLProgramRegistry()
+{
+    std::vector<Entry>::iterator it;
+    for (it = m_entries.begin(); it != m_entries.end(); ++it)
+        delete it->program;
+
+    delete m_submitWatch;
+    delete m_batchWatch;
+}
+
+NvGLSLProgram* NvGLSLProgramRegistry::addFromFiles(const char* name, const char* vertFilename, const char* fragFilename, bool strict)
+{
+    Entry entry;
+    entry.name = name;
+    entry.vertFilename = vertFilename;
+    entry.fragFilename = fragFilename;
+    entry.strict = strict;
+    entry.built = false;
+    entry.succeeded = false;
+    entry.program = new NvGLSLProgram;
+    entry.submitTime = 0.0f;
+    entry.readyTime = 0.0f;
+    m_entries.push_back(entry);
+
+    return entry.program;
+}
+
+NvGLSLProgram* NvGLSLProgramRegistry::addFromStrings(const char* name, NvGLSLProgram::ShaderSourceItem* src, int32_t count, bool strict)
+{
+    Entry entry;
+    entry.name = name;
+    for (int32_t i = 0; i < count; i++) {
+        entry.sources.push_back(src[i].src);
+        entry.types.push_back(src[i].type);
+    }
+    entry.strict = strict;
+    entry.built = false;
+    entry.succeeded = false;
+    entry.program = new NvGLSLProgram;
+    entry.submitTime = 0.0f;
+    entry.readyTime = 0.0f;
+    m_entries.push_back(entry);
+
+    return entry.program;
+}
+
+bool NvGLSLProgramRegistry::submit(Entry& entry)
+{
+    if (!entry.vertFilename.empty())
+        return entry.program->beginSourceFromFiles(entry.vertFilename.c_str(), entry.fragFilename.c_str(), entry.strict);
+
+    NvGLSLProgram::ShaderSourceItem src[NvGLSLProgram::MAX_SHADER_STAGES];
+    int32_t count = (int32_t)entry.sources.size();
+    if (count > NvGLSLProgram::MAX_SHADER_STAGES)
+        count = NvGLSLProgram::MAX_SHADER_STAGES;
+    for (int32_t i = 0; i < count; i++) {
+        src[i].src = entry.sources[i].c_str();
+        src[i].type = entry.types[i];
+    }
+
+    return entry.program->beginSourceFromStrings(src, count, entry.strict);
+}
+
+bool NvGLSLProgramRegistry::warmUp()
+{
+    m_batchWatch->stop();
+    m_batchWatch->reset();
+    m_batchWatch->start();
+
+    // Pass 1: issue every compile and link, touching no status
+    bool allSucceeded = true;
+    std::vector<Entry*> pending;
+    std::vector<Entry>::iterator it;
+    for (it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->built)
+            continue;
+
+        m_submitWatch->stop();
+        m_submitWatch->reset();
+        m_submitWatch->start();
+        bool issued = submit(*it);
+        m_submitWatch->stop();
+
+        it->submitTime = m_submitWatch->getTime() * 1000.0f;
+        it->built = true;
+        if (issued) {
+            pending.push_back(&(*it));
+        } else {
+            LOGE("Program \"%s\" could not be loaded", it->name.c_str());
+            it->succeeded = false;
+            allSucceeded = false;
+        }
+    }
+
+    // Pass 2: collect the programs as they become ready.  If the driver
+    // cannot report completion, or nothing finished in a pass, block on
+    // the oldest pending program rather than spinning
+    while (!pending.empty()) {
+        bool progress = false;
+        std::vector<Entry*>::iterator p = pending.begin();
+        while (p != pending.end()) {
+            if ((*p)->program->isBuildComplete()) {
+                Entry& entry = **p;
+                entry.succeeded = entry.program->finishBuild();
+                entry.readyTime = m_batchWatch->getTime() * 1000.0f;
+                if (!entry.succeeded) {
+                    LOGE("Program \"%s\" failed to build", entry.name.c_str());
+                    allSucceeded = false;
+                }
+                p = pending.erase(p);
+                progress = true;
+            } else {
+                ++p;
+            }
+        }
+
+        if (!progress) {
+            Entry& entry = *pending.front();
+            entry.succeeded = entry.program->finishBuild();
+            entry.readyTime = m_batchWatch->getTime() * 1000.0f;
+            if (!entry.succeeded) {
+                LOGE("Program \"%s\" failed to build", entry.name.c_str());
+                allSucceeded = false;
+            }
+            pending.erase(pending.begin());
+        }
+    }
+
+    m_batchWatch->stop();
+    m_batchTime = m_batchWatch->getTime() * 1000.0f;
+
+    logReport();
+
+    return allSucceeded;
+}
+
+NvGLSLProgram* NvGLSLProgramRegistry::get(const char* name)
+{
+    std::vector<Entry>::iterator it;
+    for (it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->name == name)
+            return it->succeeded ? it->program : NULL;
+    }
+    return NULL;
+}
+
+void NvGLSLProgramRegistry::logReport()
+{
+    LOGI("Shader warm-up: %d programs in %.2f ms (%s)", (int32_t)m_entries.size(), m_batchTime,
+        NvGLSLProgram::isParallelCompileSupported() ? "parallel compile" : "serial compile");
+
+    std::vector<Entry>::const_iterator it;
+    for (it = m_entries.begin(); it != m_entries.end(); ++it) {
+        LOGI("  %-24s submit %7.2f ms  ready %7.2f ms  %s", it->name.c_str(),
+            it->submitTime, it->readyTime, it->succeeded ? "ok" : "FAILED");
+    }
+}
@@ -0,0 +1,137 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGLSLShaderWatcher.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvGLUtils/NvGLSLShaderWatcher.h"
+#include "NvGLUtils/NvGLSLPreprocessor.h"
+#include "NvAssetLoader/NvAssetLoader.h"
+#include "NV/NvLogs.h"
+#include <set>
+
+#if defined(LINUX) && !defined(ANDROID)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#define NV_HAS_INOTIFY 1
+#endif
+
+NvGLSLShaderWatcher::NvGLSLShaderWatcher(NvGLSLPreprocessor* preprocessor)
+    : m_preprocessor(preprocessor)
+    , m_fd(-1)
+    , m_generation(0xFFFFFFFF)
+{
+#ifdef NV_HAS_INOTIFY
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0)
+        LOGE("Shader watcher: inotify_init1 failed (%d)", errno);
+#endif
+}
+
+NvGLSLShaderWatcher::~NvGLSLShaderWatcher()
+{
+#ifdef NV_HAS_INOTIFY
+    if (m_fd >= 0)
+        close(m_fd);
+#endif
+}
+
+void NvGLSLShaderWatcher::updateWatches()
+{
+#ifdef NV_HAS_INOTIFY
+    std::set<std::string> files;
+    m_preprocessor->getDependencies(files);
+
+    std::set<std::string>::const_iterator it;
+    for (it = files.begin(); it != files.end(); ++it) {
+        char path[1024];
+        if (!NvAssetLoaderFindFile(it->c_str(), path, sizeof(path)))
+            continue;
+
+        std::string fullPath(path);
+        if (m_assets.find(fullPath) != m_assets.end())
+            continue;
+        m_assets[fullPath] = *it;
+
+        size_t slash = fullPath.find_last_of('/');
+        std::string dir = (slash == std::string::npos) ? std::string(".") : fullPath.substr(0, slash);
+
+        // editors often save by writing a new file and renaming it over the old one,
+        // so watch the directory rather than the file
+        int32_t wd = inotify_add_watch(m_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0)
+            m_dirs[wd] = dir;
+    }
+#endif
+}
+
+int32_t NvGLSLShaderWatcher::poll()
+{
+    if (m_fd < 0)
+        return 0;
+
+    if (m_generation != m_preprocessor->getDependencyGeneration()) {
+        m_generation = m_preprocessor->getDependencyGeneration();
+        updateWatches();
+    }
+
+    int32_t rebuilt = 0;
+#ifdef NV_HAS_INOTIFY
+    std::set<std::string> changed;
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t len = read(m_fd, buf, sizeof(buf));
+        if (len <= 0)
+            break;
+
+        for (char* ptr = buf; ptr < buf + len; ) {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            std::map<int32_t, std::string>::const_iterator dir = m_dirs.find(event->wd);
+            if ((dir == m_dirs.end()) || !event->len)
+                continue;
+
+            std::map<std::string, std::string>::const_iterator asset =
+                m_assets.find(dir->second + "/" + event->name);
+            if (asset != m_assets.end())
+                changed.insert(asset->second);
+        }
+    }
+
+    // one save can generate several events; rebuild once per file
+    std::set<std::string>::const_iterator it;
+    for (it = changed.begin(); it != changed.end(); ++it)
+        rebuilt += m_preprocessor->fileChanged(it->c_str());
+#endif
+
+    return rebuilt;
+}
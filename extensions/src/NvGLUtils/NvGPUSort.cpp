@@ -0,0 +1,619 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGPUSort.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "NvGLUtils/NvGPUSort.h"
+#include "NvGLUtils/NvGLSLProgram.h"
+#include "NvGLUtils/NvProfiler.h"
+#include "NV/NvLogs.h"
+#include "NV/NvStopWatch.h"
+#include "KHR/khrplatform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+bool NvGPUSort::ms_supported = false;
+bool NvGPUSort::ms_es = false;
+
+// The tokens are not in the ES 2.0 headers
+static const GLenum NV_COMPUTE_SHADER = 0x91B9;
+static const GLenum NV_SHADER_STORAGE_BUFFER = 0x90D2;
+static const GLbitfield NV_ELEMENT_ARRAY_BARRIER_BIT = 0x00000002;
+static const GLbitfield NV_VERTEX_ATTRIB_ARRAY_BARRIER_BIT = 0x00000001;
+static const GLbitfield NV_BUFFER_UPDATE_BARRIER_BIT = 0x00000200;
+static const GLbitfield NV_SHADER_STORAGE_BARRIER_BIT = 0x00002000;
+static const GLbitfield NV_MAP_READ_BIT = 0x0001;
+static const GLenum NV_DYNAMIC_COPY = 0x88EA;
+
+typedef void (KHRONOS_APIENTRY* NV_PFNGLDISPATCHCOMPUTEPROC) (GLuint x, GLuint y, GLuint z);
+typedef void (KHRONOS_APIENTRY* NV_PFNGLMEMORYBARRIERPROC) (GLbitfield barriers);
+typedef void (KHRONOS_APIENTRY* NV_PFNGLBINDBUFFERBASEPROC) (GLenum target, GLuint index, GLuint buffer);
+typedef void (KHRONOS_APIENTRY* NV_PFNGLBINDBUFFERRANGEPROC) (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+typedef void* (KHRONOS_APIENTRY* NV_PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (KHRONOS_APIENTRY* NV_PFNGLUNMAPBUFFERPROC) (GLenum target);
+
+static NV_PFNGLDISPATCHCOMPUTEPROC s_glDispatchCompute = NULL;
+static NV_PFNGLMEMORYBARRIERPROC s_glMemoryBarrier = NULL;
+static NV_PFNGLBINDBUFFERBASEPROC s_glBindBufferBase = NULL;
+static NV_PFNGLBINDBUFFERRANGEPROC s_glBindBufferRange = NULL;
+static NV_PFNGLMAPBUFFERRANGEPROC s_glMapBufferRange = NULL;
+static NV_PFNGLUNMAPBUFFERPROC s_glUnmapBuffer = NULL;
+
+// Storage buffer bindings shared by the kernels
+enum {
+    BINDING_KEYS_IN = 0,
+    BINDING_VALUES_IN,
+    BINDING_KEYS_OUT,
+    BINDING_VALUES_OUT,
+    BINDING_COUNTS,
+    BINDING_POINTS
+};
+
+// Declarations shared by the kernels; BLOCK_SIZE and BUCKETS are prepended
+static const char* s_commonSrc =
+    "layout(local_size_x = BLOCK_SIZE) in;\n"
+    "layout(std430, binding = 0) buffer KeysIn { uint keysIn[]; };\n"
+    "layout(std430, binding = 1) buffer ValuesIn { uint valuesIn[]; };\n"
+    "layout(std430, binding = 2) buffer KeysOut { uint keysOut[]; };\n"
+    "layout(std430, binding = 3) buffer ValuesOut { uint valuesOut[]; };\n"
+    "layout(std430, binding = 4) buffer Counts { uint counts[]; };\n"
+    "uniform int count;\n"
+    "uniform int blocks;\n"
+    "uniform int shift;\n"
+    // shared memory writes are made visible before the work group moves on
+    "#define SYNC() memoryBarrierShared(); barrier()\n"
+    "uint digitOf(uint key) { return (key >> uint(shift)) & uint(BUCKETS - 1); }\n";
+
+// Depth keys of points along an axis, floatToKey(dot(axis, p)), and their indices
+static const char* s_keysSrc =
+    "layout(std430, binding = 5) readonly buffer Points { float points[]; };\n"
+    "uniform vec3 axis;\n"
+    "uniform int stride;\n"
+    "void main() {\n"
+    "    int i = int(gl_GlobalInvocationID.x);\n"
+    "    if (i >= count) return;\n"
+    "    int p = i * stride;\n"
+    "    uint u = floatBitsToUint(axis.x * points[p] + axis.y * points[p + 1] + axis.z * points[p + 2]);\n"
+    "    keysIn[i] = u ^ ((0u - (u >> 31)) | 0x80000000u);\n"
+    "    valuesIn[i] = uint(i);\n"
+    "}\n";
+
+// Per block histogram of the digit, stored digit by digit: counts[digit * blocks + block]
+static const char* s_countSrc =
+    "shared uint s_counts[BUCKETS];\n"
+    "void main() {\n"
+    "    uint t = gl_LocalInvocationID.x;\n"
+    "    int block = int(gl_WorkGroupID.x);\n"
+    "    int i = block * BLOCK_SIZE + int(t);\n"
+    "    if (t < uint(BUCKETS)) s_counts[t] = 0u;\n"
+    "    SYNC();\n"
+    "    if (i < count) atomicAdd(s_counts[digitOf(keysIn[i])], 1u);\n"
+    "    SYNC();\n"
+    "    if (t < uint(BUCKETS)) counts[int(t) * blocks + block] = s_counts[t];\n"
+    "}\n";
+
+// Exclusive scan of all the counts in one work group: each thread sums a run of
+// them, the run totals are scanned in shared memory, then each run is written out
+static const char* s_scanSrc =
+    "shared uint s_sums[BLOCK_SIZE];\n"
+    "void main() {\n"
+    "    int t = int(gl_LocalInvocationID.x);\n"
+    "    int n = BUCKETS * blocks;\n"
+    "    int run = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;\n"
+    "    int begin = min(t * run, n);\n"
+    "    int end = min(begin + run, n);\n"
+    "    uint sum = 0u;\n"
+    "    for (int j = begin; j < end; j++) sum += counts[j];\n"
+    "    s_sums[t] = sum;\n"
+    "    SYNC();\n"
+    "    for (int d = 1; d < BLOCK_SIZE; d <<= 1) {\n"
+    "        uint v = (t >= d) ? s_sums[t - d] : 0u;\n"
+    "        SYNC();\n"
+    "        s_sums[t] += v;\n"
+    "        SYNC();\n"
+    "    }\n"
+    "    uint offset = s_sums[t] - sum;\n"
+    "    for (int j = begin; j < end; j++) {\n"
+    "        uint c = counts[j];\n"
+    "        counts[j] = offset;\n"
+    "        offset += c;\n"
+    "    }\n"
+    "}\n";
+
+// Sorts the block by the digit with a stable split per digit bit, then writes each key
+// to its digit's offset plus its rank among the block's keys of that digit.  The padding
+// past the last key has every digit bit set, so it stays at the end of the block
+static const char* s_scatterSrc =
+    "shared uint s_keys[BLOCK_SIZE];\n"
+    "shared uint s_values[BLOCK_SIZE];\n"
+    "shared uint s_scan[BLOCK_SIZE];\n"
+    "shared uint s_start[BUCKETS];\n"
+    "void main() {\n"
+    "    int t = int(gl_LocalInvocationID.x);\n"
+    "    int block = int(gl_WorkGroupID.x);\n"
+    "    int i = block * BLOCK_SIZE + t;\n"
+    "    int valid = min(count - block * BLOCK_SIZE, BLOCK_SIZE);\n"
+    "    uint key = (i < count) ? keysIn[i] : 0xFFFFFFFFu;\n"
+    "    uint value = (i < count) ? valuesIn[i] : 0u;\n"
+    "    for (int bit = 0; bit < DIGIT_BITS; bit++) {\n"
+    "        uint b = (digitOf(key) >> uint(bit)) & 1u;\n"
+    "        s_scan[t] = b;\n"
+    "        SYNC();\n"
+    "        for (int d = 1; d < BLOCK_SIZE; d <<= 1) {\n"
+    "            uint v = (t >= d) ? s_scan[t - d] : 0u;\n"
+    "            SYNC();\n"
+    "            s_scan[t] += v;\n"
+    "            SYNC();\n"
+    "        }\n"
+    "        uint onesBefore = s_scan[t] - b;\n"
+    "        uint zeros = uint(BLOCK_SIZE) - s_scan[BLOCK_SIZE - 1];\n"
+    "        uint dst = (b == 0u) ? (uint(t) - onesBefore) : (zeros + onesBefore);\n"
+    "        SYNC();\n"
+    "        s_keys[dst] = key;\n"
+    "        s_values[dst] = value;\n"
+    "        SYNC();\n"
+    "        key = s_keys[t];\n"
+    "        value = s_values[t];\n"
+    "        SYNC();\n"
+    "    }\n"
+    "    uint digit = digitOf(key);\n"
+    "    if (t == 0 || digit != digitOf(s_keys[t - 1])) s_start[digit] = uint(t);\n"
+    "    SYNC();\n"
+    "    if (t < valid) {\n"
+    "        uint dst = counts[int(digit) * blocks + block] + uint(t) - s_start[digit];\n"
+    "        keysOut[dst] = key;\n"
+    "        valuesOut[dst] = value;\n"
+    "    }\n"
+    "}\n";
+
+void NvGPUSort::globalInit(NvGLExtensionsAPI& api)
+{
+    // The extension headers differ between platforms, so the version is read
+    // from the string rather than from the GL_VERSION_x_y macros
+    const char* version = (const char*)glGetString(GL_VERSION);
+    const bool es = version && (strstr(version, "OpenGL ES") != NULL);
+    int32_t major = 0, minor = 0;
+    if (version) {
+        const char* digits = version;
+        while (*digits && (*digits < '0' || *digits > '9'))
+            digits++;
+        sscanf(digits, "%d.%d", &major, &minor);
+    }
+    const int32_t ver = major * 10 + minor;
+
+    ms_es = es;
+    ms_supported = false;
+    s_glDispatchCompute = NULL;
+    s_glMemoryBarrier = NULL;
+    s_glBindBufferBase = NULL;
+    s_glBindBufferRange = NULL;
+    s_glMapBufferRange = NULL;
+    s_glUnmapBuffer = NULL;
+
+    if (es ? (ver >= 31) : (ver >= 43)) {
+        s_glDispatchCompute = (NV_PFNGLDISPATCHCOMPUTEPROC)api.getGLProcAddress("glDispatchCompute");
+        s_glMemoryBarrier = (NV_PFNGLMEMORYBARRIERPROC)api.getGLProcAddress("glMemoryBarrier");
+        s_glBindBufferBase = (NV_PFNGLBINDBUFFERBASEPROC)api.getGLProcAddress("glBindBufferBase");
+        s_glBindBufferRange = (NV_PFNGLBINDBUFFERRANGEPROC)api.getGLProcAddress("glBindBufferRange");
+        s_glMapBufferRange = (NV_PFNGLMAPBUFFERRANGEPROC)api.getGLProcAddress("glMapBufferRange");
+        s_glUnmapBuffer = (NV_PFNGLUNMAPBUFFERPROC)api.getGLProcAddress("glUnmapBuffer");
+    }
+    ms_supported = s_glDispatchCompute && s_glMemoryBarrier && s_glBindBufferBase && s_glBindBufferRange
+        && s_glMapBufferRange && s_glUnmapBuffer;
+
+    LOGI("NvGPUSort: %s", ms_supported ? "compute shaders" : "not supported");
+}
+
+NvGPUSort::NvGPUSort()
+    : m_keysProg(NULL)
+    , m_countProg(NULL)
+    , m_scanProg(NULL)
+    , m_scatterProg(NULL)
+    , m_counts(0)
+    , m_capacity(0)
+    , m_count(0)
+{
+    m_keys[0] = m_keys[1] = 0;
+    m_values[0] = m_values[1] = 0;
+}
+
+NvGPUSort::~NvGPUSort()
+{
+    release();
+}
+
+static NvGLSLProgram* createKernel(bool es, const char* src)
+{
+    char defines[256];
+    sprintf(defines, "%s\n#define BLOCK_SIZE %d\n#define DIGIT_BITS %d\n#define BUCKETS %d\n",
+        es ? "#version 310 es\nprecision highp float;\nprecision highp int;" : "#version 430",
+        NvGPUSort::BLOCK_SIZE, NvGPUSort::DIGIT_BITS, NvGPUSort::BUCKETS);
+    std::string source = std::string(defines) + s_commonSrc + src;
+
+    NvGLSLProgram::ShaderSourceItem item;
+    item.src = source.c_str();
+    item.type = NV_COMPUTE_SHADER;
+    NvGLSLProgram* prog = new NvGLSLProgram;
+    if (!prog->setSourceFromStrings(&item, 1)) {
+        delete prog;
+        return NULL;
+    }
+    return prog;
+}
+
+bool NvGPUSort::init()
+{
+    release();
+    if (!ms_supported)
+        return false;
+
+    m_keysProg = createKernel(ms_es, s_keysSrc);
+    m_countProg = createKernel(ms_es, s_countSrc);
+    m_scanProg = createKernel(ms_es, s_scanSrc);
+    m_scatterProg = createKernel(ms_es, s_scatterSrc);
+    if (!m_keysProg || !m_countProg || !m_scanProg || !m_scatterProg) {
+        LOGE("NvGPUSort: the kernels failed to build");
+        release();
+        return false;
+    }
+
+    glGenBuffers(2, m_keys);
+    glGenBuffers(2, m_values);
+    glGenBuffers(1, &m_counts);
+    return true;
+}
+
+void NvGPUSort::release()
+{
+    delete m_keysProg;
+    delete m_countProg;
+    delete m_scanProg;
+    delete m_scatterProg;
+    m_keysProg = m_countProg = m_scanProg = m_scatterProg = NULL;
+
+    if (m_keys[0]) {
+        glDeleteBuffers(2, m_keys);
+        glDeleteBuffers(2, m_values);
+        glDeleteBuffers(1, &m_counts);
+    }
+    m_keys[0] = m_keys[1] = 0;
+    m_values[0] = m_values[1] = 0;
+    m_counts = 0;
+    m_capacity = 0;
+    m_count = 0;
+}
+
+void NvGPUSort::reserve(int32_t count)
+{
+    if (count <= m_capacity)
+        return;
+
+    m_capacity = count;
+    const int32_t blocks = (m_capacity + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    for (int32_t i = 0; i < 2; i++) {
+        glBindBuffer(NV_SHADER_STORAGE_BUFFER, m_keys[i]);
+        glBufferData(NV_SHADER_STORAGE_BUFFER, m_capacity * sizeof(uint32_t), NULL, NV_DYNAMIC_COPY);
+        glBindBuffer(NV_SHADER_STORAGE_BUFFER, m_values[i]);
+        glBufferData(NV_SHADER_STORAGE_BUFFER, m_capacity * sizeof(uint32_t), NULL, NV_DYNAMIC_COPY);
+    }
+    glBindBuffer(NV_SHADER_STORAGE_BUFFER, m_counts);
+    glBufferData(NV_SHADER_STORAGE_BUFFER, BUCKETS * blocks * sizeof(uint32_t), NULL, NV_DYNAMIC_COPY);
+    glBindBuffer(NV_SHADER_STORAGE_BUFFER, 0);
+}
+
+void NvGPUSort::computeDepthKeys(GLuint points, size_t offset, int32_t stride, int32_t count, const float* axis)
+{
+    if (!m_keysProg || count <= 0)
+        return;
+
+    NV_PROFILE_GPU_SCOPE("GPU sort keys");
+    reserve(count);
+    m_count = count;
+
+    m_keysProg->enable();
+    m_keysProg->setUniform1i("count", count);
+    m_keysProg->setUniform1i("stride", stride);
+    m_keysProg->setUniform3f("axis", axis[0], axis[1], axis[2]);
+    s_glBindBufferRange(NV_SHADER_STORAGE_BUFFER, BINDING_POINTS, points, offset,
+        ((count - 1) * stride + 3) * sizeof(float));
+    s_glBindBufferBase(NV_SHADER_STORAGE_BUFFER, BINDING_KEYS_IN, m_keys[0]);
+    s_glBindBufferBase(NV_SHADER_STORAGE_BUFFER, BINDING_VALUES_IN, m_values[0]);
+    s_glDispatchCompute((count + BLOCK_SIZE - 1) / BLOCK_SIZE, 1, 1);
+    s_glBindBufferBase(NV_SHADER_STORAGE_BUFFER, BINDING_POINTS, 0);
+    m_keysProg->disable();
+
+    s_glMemoryBarrier(NV_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void NvGPUSort::setKeys(const uint32_t* keys, const uint32_t* values, int32_t count)
+{
+    if (!m_keysProg || count <= 0)
+        return;
+
+    reserve(count);
+    m_count = count;
+
+    glBindBuffer(NV_SHADER_STORAGE_BUFFER, m_keys[0]);
+    glBufferSubData(NV_SHADER_STORAGE_BUFFER, 0, count * sizeof(uint32_t), keys);
+    glBindBuffer(NV_SHADER_STORAGE_BUFFER, m_values[0]);
+    if (values) {
+        glBufferSubData(NV_SHADER_STORAGE_BUFFER, 0, count * sizeof(uint32_t), values);
+    } else {
+        std::vector<uint32_t> indices(count);
+        for (int32_t i = 0; i < count; i++)
+            indices[i] = i;
+        glBufferSubData(NV_SHADER_STORAGE_BUFFER, 0, count * sizeof(uint32_t), &indices[0]);
+    }
+    glBindBuffer(NV_SHADER_STORAGE_BUFFER, 0);
+}
+
+void NvGPUSort::sort()
+{
+    if (!m_keysProg || m_count <= 0)
+        return;
+
+    NV_PROFILE_GPU_SCOPE("GPU sort");
+    const int32_t blocks = (m_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    s_glBindBufferBase(NV_SHADER_STORAGE_BUFFER, BINDING_COUNTS, m_counts);
+
+    for (int32_t pass = 0; pass < PASSES; pass++) {
+        // an even number of passes leaves the results where the keys started
+        const int32_t src = pass & 1;
+        s_glBindBufferBase(NV_SHADER_STORAGE_BUFFER, BINDING_KEYS_IN, m_keys[src]);
+        s_glBindBufferBase(NV_SHADER_STORAGE_BUFFER, BINDING_VALUES_IN, m_values[src]);
+        s_glBindBufferBase(NV_SHADER_STORAGE_BUFFER, BINDING_KEYS_OUT, m_keys[1 - src]);
+        s_glBindBufferBase(NV_SHADER_STORAGE_BUFFER, BINDING_VALUES_OUT, m_values[1 - src]);
+
+        m_countProg->enable();
+        m_countProg->setUniform1i("count", m_count);
+        m_countProg->setUniform1i("blocks", blocks);
+        m_countProg->setUniform1i("shift", pass * DIGIT_BITS);
+        s_glDispatchCompute(blocks, 1, 1);
+        s_glMemoryBarrier(NV_SHADER_STORAGE_BARRIER_BIT);
+
+        m_scanProg->enable();
+        m_scanProg->setUniform1i("blocks", blocks);
+        s_glDispatchCompute(1, 1, 1);
+        s_glMemoryBarrier(NV_SHADER_STORAGE_BARRIER_BIT);
+
+        m_scatterProg->enable();
+        m_scatterProg->setUniform1i("count", m_count);
+        m_scatterProg->setUniform1i("blocks", blocks);
+        m_scatterProg->setUniform1i("shift", pass * DIGIT_BITS);
+        s_glDispatchCompute(blocks, 1, 1);
+        s_glMemoryBarrier(NV_SHADER_STORAGE_BARRIER_BIT);
+    }
+    m_scatterProg->disable();
+
+    for (int32_t b = BINDING_KEYS_IN; b <= BINDING_COUNTS; b++)
+        s_glBindBufferBase(NV_SHADER_STORAGE_BUFFER, b, 0);
+
+    // the values are drawn from as indices, or read back
+    s_glMemoryBarrier(NV_ELEMENT_ARRAY_BARRIER_BIT | NV_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | NV_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+bool NvGPUSort::readResults(uint32_t* keys, uint32_t* values)
+{
+    if (!m_keysProg || m_count <= 0)
+        return false;
+
+    bool ok = true;
+    for (int32_t i = 0; i < 2; i++) {
+        uint32_t* dst = i ? values : keys;
+        if (!dst)
+            continue;
+        glBindBuffer(NV_SHADER_STORAGE_BUFFER, i ? m_values[0] : m_keys[0]);
+        const void* src = s_glMapBufferRange(NV_SHADER_STORAGE_BUFFER, 0, m_count * sizeof(uint32_t), NV_MAP_READ_BIT);
+        if (src) {
+            memcpy(dst, src, m_count * sizeof(uint32_t));
+            s_glUnmapBuffer(NV_SHADER_STORAGE_BUFFER);
+        } else {
+            ok = false;
+        }
+    }
+    glBindBuffer(NV_SHADER_STORAGE_BUFFER, 0);
+    return ok;
+}
+
+void NvGPUSort::emulate(const uint32_t* keys, const uint32_t* values, int32_t count,
+    uint32_t* sortedKeys, uint32_t* sortedValues)
+{
+    if (count <= 0)
+        return;
+
+    const int32_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<uint32_t> bufKeys[2], bufValues[2];
+    bufKeys[0].assign(keys, keys + count);
+    bufValues[0].assign(values, values + count);
+    bufKeys[1].resize(count);
+    bufValues[1].resize(count);
+    std::vector<uint32_t> counts(BUCKETS * blocks);
+
+    uint32_t blockKeys[BLOCK_SIZE], blockValues[BLOCK_SIZE];
+    uint32_t splitKeys[BLOCK_SIZE], splitValues[BLOCK_SIZE];
+    uint32_t start[BUCKETS];
+
+    for (int32_t pass = 0; pass < PASSES; pass++) {
+        const int32_t src = pass & 1;
+        const uint32_t* keysIn = &bufKeys[src][0];
+        const uint32_t* valuesIn = &bufValues[src][0];
+        uint32_t* keysOut = &bufKeys[1 - src][0];
+        uint32_t* valuesOut = &bufValues[1 - src][0];
+        const int32_t shift = pass * DIGIT_BITS;
+
+        // count
+        std::fill(counts.begin(), counts.end(), 0u);
+        for (int32_t i = 0; i < count; i++)
+            counts[((keysIn[i] >> shift) & (BUCKETS - 1)) * blocks + i / BLOCK_SIZE]++;
+
+        // scan, in the runs the scan threads take
+        const int32_t n = BUCKETS * blocks;
+        const int32_t run = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        uint32_t offset = 0;
+        for (int32_t t = 0; t < BLOCK_SIZE; t++) {
+            const int32_t begin = std::min(t * run, n);
+            const int32_t end = std::min(begin + run, n);
+            for (int32_t j = begin; j < end; j++) {
+                const uint32_t c = counts[j];
+                counts[j] = offset;
+                offset += c;
+            }
+        }
+
+        // scatter
+        for (int32_t block = 0; block < blocks; block++) {
+            const int32_t valid = std::min(count - block * BLOCK_SIZE, BLOCK_SIZE);
+            for (int32_t t = 0; t < BLOCK_SIZE; t++) {
+                const int32_t i = block * BLOCK_SIZE + t;
+                blockKeys[t] = (t < valid) ? keysIn[i] : 0xFFFFFFFFu;
+                blockValues[t] = (t < valid) ? valuesIn[i] : 0u;
+            }
+
+            // one stable split per digit bit: the keys with the bit clear, then those with it set
+            for (int32_t bit = 0; bit < DIGIT_BITS; bit++) {
+                int32_t zeros = 0;
+                for (int32_t t = 0; t < BLOCK_SIZE; t++)
+                    zeros += (((blockKeys[t] >> shift) >> bit) & 1) ? 0 : 1;
+                int32_t nextZero = 0, nextOne = zeros;
+                for (int32_t t = 0; t < BLOCK_SIZE; t++) {
+                    const int32_t dst = (((blockKeys[t] >> shift) >> bit) & 1) ? nextOne++ : nextZero++;
+                    splitKeys[dst] = blockKeys[t];
+                    splitValues[dst] = blockValues[t];
+                }
+                memcpy(blockKeys, splitKeys, sizeof(blockKeys));
+                memcpy(blockValues, splitValues, sizeof(blockValues));
+            }
+
+            for (int32_t t = 0; t < BLOCK_SIZE; t++) {
+                const uint32_t digit = (blockKeys[t] >> shift) & (BUCKETS - 1);
+                if (t == 0 || digit != ((blockKeys[t - 1] >> shift) & (BUCKETS - 1)))
+                    start[digit] = t;
+            }
+            for (int32_t t = 0; t < valid; t++) {
+                const uint32_t digit = (blockKeys[t] >> shift) & (BUCKETS - 1);
+                const uint32_t dst = counts[digit * blocks + block] + t - start[digit];
+                keysOut[dst] = blockKeys[t];
+                valuesOut[dst] = blockValues[t];
+            }
+        }
+    }
+
+    memcpy(sortedKeys, &bufKeys[0][0], count * sizeof(uint32_t));
+    memcpy(sortedValues, &bufValues[0][0], count * sizeof(uint32_t));
+}
+
+// orders indices by their keys, ties by index; the reference for the self test
+struct NvGPUSortKeyLess {
+    const uint32_t* keys;
+    bool operator()(uint32_t a, uint32_t b) const { return keys[a] < keys[b]; }
+};
+
+static uint32_t selfTestRandom(uint32_t& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state;
+}
+
+bool NvGPUSort::runSelfTest(NvStopWatch* stopWatch)
+{
+    const int32_t sizes[] = { 1, 255, 256, 257, 1000, 65543, 300000 };
+    const int32_t numSizes = sizeof(sizes) / sizeof(sizes[0]);
+    const char* distributions[] = { "random", "few distinct", "sorted", "reversed" };
+    const int32_t numDistributions = sizeof(distributions) / sizeof(distributions[0]);
+
+    NvGPUSort gpu;
+    const bool gpuTested = gpu.init();
+    LOGI("NvGPUSort self test: emulation%s", gpuTested ? " and compute shaders" : " only (no compute shaders)");
+
+    bool passed = true;
+    uint32_t state = 12345;
+    for (int32_t s = 0; s < numSizes; s++) {
+        const int32_t count = sizes[s];
+        std::vector<uint32_t> keys(count), values(count), reference(count);
+        std::vector<uint32_t> sortedKeys(count), sortedValues(count);
+
+        for (int32_t d = 0; d < numDistributions; d++) {
+            for (int32_t i = 0; i < count; i++) {
+                const uint32_t r = selfTestRandom(state);
+                switch (d) {
+                case 0: keys[i] = r; break;
+                case 1: keys[i] = (r >> 8) % 7 * 0x12345678u; break;
+                case 2: keys[i] = i * 3u; break;
+                default: keys[i] = 0xFFFFFFFFu - i * 5u; break;
+                }
+                values[i] = i;
+                reference[i] = i;
+            }
+            NvGPUSortKeyLess less;
+            less.keys = &keys[0];
+            std::stable_sort(reference.begin(), reference.end(), less);
+
+            emulate(&keys[0], &values[0], count, &sortedKeys[0], &sortedValues[0]);
+            bool ok = (sortedValues == reference);
+            for (int32_t i = 0; ok && i < count; i++)
+                ok = (sortedKeys[i] == keys[reference[i]]);
+            if (!ok) {
+                LOGE("NvGPUSort self test: emulation of %d %s keys does not match the reference", count, distributions[d]);
+                passed = false;
+            }
+
+            if (gpuTested) {
+                gpu.setKeys(&keys[0], NULL, count);
+                glFinish();
+                stopWatch->reset();
+                stopWatch->start();
+                gpu.sort();
+                glFinish();
+                stopWatch->stop();
+                const float ms = stopWatch->getTime() * 1000.0f;
+
+                std::fill(sortedValues.begin(), sortedValues.end(), 0u);
+                ok = gpu.readResults(&sortedKeys[0], &sortedValues[0]) && (sortedValues == reference);
+                for (int32_t i = 0; ok && i < count; i++)
+                    ok = (sortedKeys[i] == keys[reference[i]]);
+                if (!ok) {
+                    LOGE("NvGPUSort self test: compute sort of %d %s keys does not match the reference", count, distributions[d]);
+                    passed = false;
+                }
+                if (d == 0)
+                    LOGI("NvGPUSort self test: %7d random keys sorted in %8.3f ms", count, ms);
+            }
+        }
+    }
+
+    return passed;
+}
@@ -0,0 +1,412 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGridIndexBuffer.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "NvGLUtils/NvGridIndexBuffer.h"
+#include "NV/NvLogs.h"
+
+#include <map>
+#include <stdio.h>
+#include <string.h>
+
+bool NvGridIndexBuffer::ms_restart = false;
+bool NvGridIndexBuffer::ms_restartAlwaysOn = false;
+bool NvGridIndexBuffer::ms_uint32 = true;
+
+// The tokens are not in the ES 2.0 headers
+static const GLenum NV_PRIMITIVE_RESTART_FIXED_INDEX = 0x8D69;
+
+// Marks a restart while the indices are built; replaced by the restart index of the index type
+static const uint32_t RESTART = 0xFFFFFFFF;
+
+typedef std::map<NvGridIndexBuffer::Desc, NvGridIndexBuffer*> BufferMap;
+static BufferMap s_buffers;
+
+bool NvGridIndexBuffer::Desc::operator<(const Desc& rhs) const
+{
+    if (columns != rhs.columns)         return columns < rhs.columns;
+    if (rows != rhs.rows)               return rows < rhs.rows;
+    if (rowStride != rhs.rowStride)     return rowStride < rhs.rowStride;
+    if (firstVertex != rhs.firstVertex) return firstVertex < rhs.firstVertex;
+    if (skirts != rhs.skirts)           return skirts < rhs.skirts;
+    return layout < rhs.layout;
+}
+
+void NvGridIndexBuffer::globalInit(NvGLExtensionsAPI& api)
+{
+    // The extension headers differ between platforms, so the version is read
+    // from the string rather than from the GL_VERSION_x_y macros
+    const char* version = (const char*)glGetString(GL_VERSION);
+    const bool es = version && (strstr(version, "OpenGL ES") != NULL);
+    int32_t major = 0, minor = 0;
+    if (version) {
+        const char* digits = version;
+        while (*digits && (*digits < '0' || *digits > '9'))
+            digits++;
+        sscanf(digits, "%d.%d", &major, &minor);
+    }
+    const int32_t ver = major * 10 + minor;
+
+    // ES 3.0 always restarts at the fixed index; desktop GL has to enable it
+    if (es) {
+        ms_restart = ms_restartAlwaysOn = (ver >= 30);
+        ms_uint32 = (ver >= 30) || api.isExtensionSupported("GL_OES_element_index_uint");
+    } else {
+        ms_restart = (ver >= 43) || api.isExtensionSupported("GL_ARB_ES3_compatibility");
+        ms_restartAlwaysOn = false;
+        ms_uint32 = true;
+    }
+
+    LOGI("NvGridIndexBuffer: %s, %s indices", ms_restart ? "primitive restart" : "degenerate strip joins",
+        ms_uint32 ? "32 bit" : "16 bit");
+}
+
+NvGridIndexBuffer* NvGridIndexBuffer::acquire(const Desc& desc)
+{
+    BufferMap::iterator it = s_buffers.find(desc);
+    if (it != s_buffers.end()) {
+        it->second->m_refCount++;
+        return it->second;
+    }
+
+    NvGridIndexBuffer* buffer = new NvGridIndexBuffer(desc);
+    if (!buffer->build()) {
+        delete buffer;
+        return NULL;
+    }
+
+    buffer->m_refCount = 1;
+    s_buffers[desc] = buffer;
+    return buffer;
+}
+
+void NvGridIndexBuffer::release(NvGridIndexBuffer* buffer)
+{
+    if (!buffer || --buffer->m_refCount > 0)
+        return;
+
+    s_buffers.erase(buffer->m_desc);
+    delete buffer;
+}
+
+NvGridIndexBuffer::NvGridIndexBuffer(const Desc& desc) :
+    m_desc(desc),
+    m_buffer(0),
+    m_mode(GL_TRIANGLES),
+    m_indexType(GL_UNSIGNED_SHORT),
+    m_indexCount(0),
+    m_refCount(0),
+    m_acmr(0.0f)
+{
+}
+
+NvGridIndexBuffer::~NvGridIndexBuffer()
+{
+    if (m_buffer)
+        glDeleteBuffers(1, &m_buffer);
+}
+
+int32_t NvGridIndexBuffer::getSkirtVertex(const Desc& desc, int32_t n)
+{
+    const int32_t w = desc.columns, h = desc.rows, s = desc.rowStride;
+
+    int32_t v;
+    if (n < w)
+        v = n;
+    else if ((n -= w) < w)
+        v = (h-1)*s + n;
+    else if ((n -= w) < h)
+        v = n*s;
+    else
+        v = (n - h)*s + w-1;
+
+    return desc.firstVertex + v;
+}
+
+void NvGridIndexBuffer::buildTriangles(const Desc& desc, int32_t blockWidth, uint32_t* indices, int32_t& count)
+{
+    const int32_t w = desc.columns, h = desc.rows, s = desc.rowStride;
+
+    // Column blocks of blockWidth vertices sharing their edge columns, walked row by row, so the row above
+    // is still in the vertex cache
+    for (int32_t i = 0; i < w-1; i += blockWidth-1)
+    {
+        const int32_t end = (i + blockWidth-1 < w-1) ? (i + blockWidth-1) : (w-1);
+        for (int32_t r = 0; r < h-1; r++)
+        {
+            for (int32_t c = i; c < end; c++)
+            {
+                const uint32_t v = desc.firstVertex + r*s + c;
+                indices[count++] = v;
+                indices[count++] = v + 1;
+                indices[count++] = v + s;
+
+                indices[count++] = v + s;
+                indices[count++] = v + 1;
+                indices[count++] = v + s + 1;
+            }
+        }
+    }
+}
+
+void NvGridIndexBuffer::buildStrips(const Desc& desc, bool restart, uint32_t* indices, int32_t& count)
+{
+    const int32_t w = desc.columns, h = desc.rows, s = desc.rowStride;
+
+    // One strip down each column of quads; its triangles wind like the list's.  Each strip has an even
+    // number of indices, so joining them with two degenerate indices keeps the winding.
+    for (int32_t c = 0; c < w-1; c++)
+    {
+        const uint32_t v = desc.firstVertex + c;
+        if (c > 0) {
+            if (restart) {
+                indices[count++] = RESTART;
+            } else {
+                indices[count] = indices[count-1];
+                count++;
+                indices[count++] = v;
+            }
+        }
+
+        for (int32_t r = 0; r < h; r++)
+        {
+            indices[count++] = v + r*s;
+            indices[count++] = v + r*s + 1;
+        }
+    }
+}
+
+void NvGridIndexBuffer::buildSkirts(const Desc& desc, bool strips, bool restart, uint32_t* indices, int32_t& count)
+{
+    const uint32_t skirtBase = desc.firstVertex + desc.rows * desc.rowStride;
+    const int32_t edgeLengths[4] = { desc.columns, desc.columns, desc.rows, desc.rows };
+
+    // Each edge segment and the skirt below it form a quad, drawn from both sides so the winding
+    // doesn't matter under back-face culling
+    for (int32_t edge = 0, n = 0; edge < 4; n += edgeLengths[edge], edge++)
+    {
+        if (!strips) {
+            for (int32_t k = 0; k < edgeLengths[edge]-1; k++)
+            {
+                const uint32_t a = getSkirtVertex(desc, n+k), b = getSkirtVertex(desc, n+k+1);
+                const uint32_t sa = skirtBase + n+k, sb = skirtBase + n+k+1;
+                const uint32_t tris[12] = { a, b, sa,  b, sb, sa,  a, sa, b,  b, sa, sb };
+                for (int32_t t = 0; t < 12; t++)
+                    indices[count++] = tris[t];
+            }
+            continue;
+        }
+
+        // A strip along the edge for each side
+        for (int32_t side = 0; side < 2; side++)
+        {
+            const uint32_t first = side ? (skirtBase + n) : (uint32_t)getSkirtVertex(desc, n);
+            if (restart) {
+                indices[count++] = RESTART;
+            } else {
+                indices[count] = indices[count-1];
+                count++;
+                indices[count++] = first;
+            }
+
+            for (int32_t k = 0; k < edgeLengths[edge]; k++)
+            {
+                const uint32_t a = getSkirtVertex(desc, n+k), sa = skirtBase + n+k;
+                indices[count++] = side ? sa : a;
+                indices[count++] = side ? a : sa;
+            }
+        }
+    }
+}
+
+bool NvGridIndexBuffer::build()
+{
+    const Desc& d = m_desc;
+    const int32_t w = d.columns, h = d.rows;
+    if (w < 2 || h < 2 || d.rowStride < w || d.firstVertex < 0) {
+        LOGE("NvGridIndexBuffer: invalid %dx%d grid", w, h);
+        return false;
+    }
+
+    const int64_t skirtVertices = d.skirts ? 2 * (w + h) : 0;
+    const int64_t maxVertex = (int64_t)d.firstVertex + (int64_t)(h-1) * d.rowStride + (w-1) + skirtVertices;
+    if (maxVertex >= RESTART_INDEX_16) {
+        if (!ms_uint32) {
+            LOGE("NvGridIndexBuffer: %dx%d grid needs 32 bit indices, which the context lacks", w, h);
+            return false;
+        }
+        m_indexType = GL_UNSIGNED_INT;
+    }
+
+    // Room for either layout; strips need fewer
+    const bool strips = (d.layout == LAYOUT_STRIPS);
+    const int32_t segments = 2 * (w-1) + 2 * (h-1);
+    const int32_t capacity = 6 * (w-1) * (h-1) + (d.skirts ? 12 * segments : 0);
+    uint32_t* indices = new uint32_t[capacity];
+    int32_t count = 0;
+
+    if (strips) {
+        m_mode = GL_TRIANGLE_STRIP;
+        buildStrips(d, ms_restart, indices, count);
+    } else {
+        // The block width with the fewest simulated cache misses
+        int32_t bestWidth = w;
+        float bestACMR = 0.0f;
+        const int32_t maxWidth = (w < 2 * VERTEX_CACHE_SIZE) ? w : (2 * VERTEX_CACHE_SIZE);
+        for (int32_t blockWidth = 2; blockWidth <= maxWidth; blockWidth++) {
+            count = 0;
+            buildTriangles(d, blockWidth, indices, count);
+            const float acmr = computeACMR(indices, count, GL_TRIANGLES, VERTEX_CACHE_SIZE);
+            if (blockWidth == 2 || acmr < bestACMR) {
+                bestACMR = acmr;
+                bestWidth = blockWidth;
+            }
+        }
+
+        m_mode = GL_TRIANGLES;
+        count = 0;
+        buildTriangles(d, bestWidth, indices, count);
+    }
+
+    if (d.skirts)
+        buildSkirts(d, strips, ms_restart, indices, count);
+
+    m_indexCount = count;
+    m_acmr = computeACMR(indices, count, m_mode, VERTEX_CACHE_SIZE);
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
+    if (m_indexType == GL_UNSIGNED_INT) {
+        // RESTART is already the 32 bit restart index
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * count, indices, GL_STATIC_DRAW);
+    } else {
+        uint16_t* shortIndices = new uint16_t[count];
+        for (int32_t i = 0; i < count; i++)
+            shortIndices[i] = (indices[i] == RESTART) ? (uint16_t)RESTART_INDEX_16 : (uint16_t)indices[i];
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t) * count, shortIndices, GL_STATIC_DRAW);
+        delete [] shortIndices;
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    delete [] indices;
+
+    LOGI("NvGridIndexBuffer: %dx%d grid%s as %s, %d %d bit indices (%d bytes), ACMR %.3f",
+        w, h, d.skirts ? " with skirts" : "", strips ? "strips" : "triangles", m_indexCount,
+        (m_indexType == GL_UNSIGNED_INT) ? 32 : 16, (int32_t)getBytes(), m_acmr);
+    return true;
+}
+
+size_t NvGridIndexBuffer::getBytes() const
+{
+    return (size_t)m_indexCount * ((m_indexType == GL_UNSIGNED_INT) ? sizeof(uint32_t) : sizeof(uint16_t));
+}
+
+void NvGridIndexBuffer::draw() const
+{
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
+
+    const bool restart = (m_mode == GL_TRIANGLE_STRIP) && ms_restart && !ms_restartAlwaysOn;
+    if (restart)
+        glEnable(NV_PRIMITIVE_RESTART_FIXED_INDEX);
+
+    glDrawElements(m_mode, m_indexCount, m_indexType, 0);
+
+    if (restart)
+        glDisable(NV_PRIMITIVE_RESTART_FIXED_INDEX);
+}
+
+float NvGridIndexBuffer::computeACMR(const uint32_t* indices, int32_t count, GLenum mode, int32_t cacheSize)
+{
+    uint32_t* cache = new uint32_t[cacheSize];
+    int32_t cached = 0, next = 0;
+    int32_t misses = 0, triangles = 0;
+
+    // Vertices of the current strip, to count its non-degenerate triangles
+    uint32_t prev[2] = { 0, 0 };
+    int32_t stripLength = 0;
+
+    for (int32_t i = 0; i < count; i++)
+    {
+        const uint32_t v = indices[i];
+        if (v == RESTART) {
+            stripLength = 0;
+            continue;
+        }
+
+        bool hit = false;
+        for (int32_t c = 0; c < cached && !hit; c++)
+            hit = (cache[c] == v);
+        if (!hit) {
+            misses++;
+            if (cached < cacheSize) {
+                cache[cached++] = v;
+            } else {
+                cache[next] = v;
+                next = (next + 1) % cacheSize;
+            }
+        }
+
+        if (mode == GL_TRIANGLE_STRIP) {
+            if (stripLength >= 2 && v != prev[0] && v != prev[1] && prev[0] != prev[1])
+                triangles++;
+            prev[0] = prev[1];
+            prev[1] = v;
+            stripLength++;
+        } else if ((i % 3) == 2) {
+            triangles++;
+        }
+    }
+
+    delete [] cache;
+    return triangles ? (float)misses / (float)triangles : 0.0f;
+}
+
+int32_t NvGridIndexBuffer::getBufferCount()
+{
+    return (int32_t)s_buffers.size();
+}
+
+size_t NvGridIndexBuffer::getTotalBytes()
+{
+    size_t bytes = 0;
+    for (BufferMap::const_iterator it = s_buffers.begin(); it != s_buffers.end(); ++it)
+        bytes += it->second->getBytes();
+    return bytes;
+}
+
+size_t NvGridIndexBuffer::getUnsharedBytes()
+{
+    size_t bytes = 0;
+    for (BufferMap::const_iterator it = s_buffers.begin(); it != s_buffers.end(); ++it)
+        bytes += it->second->getBytes() * it->second->m_refCount;
+    return bytes;
+}
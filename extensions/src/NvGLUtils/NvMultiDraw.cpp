@@ -0,0 +1,358 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvMultiDraw.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "NvGLUtils/NvMultiDraw.h"
+#include "NV/NvLogs.h"
+#include "KHR/khrplatform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+NvMultiDraw::Method NvMultiDraw::ms_defaultMethod = NvMultiDraw::METHOD_LOOP;
+
+// The tokens are not in the ES 2.0 headers
+static const GLenum NV_DRAW_INDIRECT_BUFFER = 0x8F3F;
+static const GLenum NV_DYNAMIC_DRAW = 0x88E8;
+
+// Draw commands, as glMultiDrawElementsIndirect and glMultiDrawArraysIndirect read them
+static const int32_t ELEMENTS_COMMAND_WORDS = 5; // count, instanceCount, firstIndex, baseVertex, baseInstance
+static const int32_t ARRAYS_COMMAND_WORDS = 4;   // count, instanceCount, first, baseInstance
+
+typedef void (KHRONOS_APIENTRY* NV_PFNGLGENVERTEXARRAYSPROC) (GLsizei n, GLuint* arrays);
+typedef void (KHRONOS_APIENTRY* NV_PFNGLBINDVERTEXARRAYPROC) (GLuint array);
+typedef void (KHRONOS_APIENTRY* NV_PFNGLDELETEVERTEXARRAYSPROC) (GLsizei n, const GLuint* arrays);
+typedef void (KHRONOS_APIENTRY* NV_PFNGLMULTIDRAWELEMENTSPROC) (GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawcount);
+typedef void (KHRONOS_APIENTRY* NV_PFNGLMULTIDRAWARRAYSPROC) (GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawcount);
+typedef void (KHRONOS_APIENTRY* NV_PFNGLMULTIDRAWELEMENTSINDIRECTPROC) (GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+typedef void (KHRONOS_APIENTRY* NV_PFNGLMULTIDRAWARRAYSINDIRECTPROC) (GLenum mode, const void* indirect, GLsizei drawcount, GLsizei stride);
+
+static NV_PFNGLGENVERTEXARRAYSPROC s_glGenVertexArrays = NULL;
+static NV_PFNGLBINDVERTEXARRAYPROC s_glBindVertexArray = NULL;
+static NV_PFNGLDELETEVERTEXARRAYSPROC s_glDeleteVertexArrays = NULL;
+static NV_PFNGLMULTIDRAWELEMENTSPROC s_glMultiDrawElements = NULL;
+static NV_PFNGLMULTIDRAWARRAYSPROC s_glMultiDrawArrays = NULL;
+static NV_PFNGLMULTIDRAWELEMENTSINDIRECTPROC s_glMultiDrawElementsIndirect = NULL;
+static NV_PFNGLMULTIDRAWARRAYSINDIRECTPROC s_glMultiDrawArraysIndirect = NULL;
+
+// the best method the context supports, before any limitMethod()
+static NvMultiDraw::Method s_supportedMethod = NvMultiDraw::METHOD_LOOP;
+
+void NvMultiDraw::globalInit(NvGLExtensionsAPI& api)
+{
+    s_glGenVertexArrays = NULL;
+    s_glBindVertexArray = NULL;
+    s_glDeleteVertexArrays = NULL;
+    s_glMultiDrawElements = NULL;
+    s_glMultiDrawArrays = NULL;
+    s_glMultiDrawElementsIndirect = NULL;
+    s_glMultiDrawArraysIndirect = NULL;
+
+    // The extension headers differ between platforms, so the version is read
+    // from the string rather than from the GL_VERSION_x_y macros
+    const char* version = (const char*)glGetString(GL_VERSION);
+    const bool es = version && (strstr(version, "OpenGL ES") != NULL);
+    int32_t major = 0, minor = 0;
+    if (version) {
+        const char* digits = version;
+        while (*digits && (*digits < '0' || *digits > '9'))
+            digits++;
+        sscanf(digits, "%d.%d", &major, &minor);
+    }
+    const int32_t ver = major * 10 + minor;
+
+    if ((ver >= 30) || (!es && api.isExtensionSupported("GL_ARB_vertex_array_object"))) {
+        s_glGenVertexArrays = (NV_PFNGLGENVERTEXARRAYSPROC)api.getGLProcAddress("glGenVertexArrays");
+        s_glBindVertexArray = (NV_PFNGLBINDVERTEXARRAYPROC)api.getGLProcAddress("glBindVertexArray");
+        s_glDeleteVertexArrays = (NV_PFNGLDELETEVERTEXARRAYSPROC)api.getGLProcAddress("glDeleteVertexArrays");
+    } else if (es && api.isExtensionSupported("GL_OES_vertex_array_object")) {
+        s_glGenVertexArrays = (NV_PFNGLGENVERTEXARRAYSPROC)api.getGLProcAddress("glGenVertexArraysOES");
+        s_glBindVertexArray = (NV_PFNGLBINDVERTEXARRAYPROC)api.getGLProcAddress("glBindVertexArrayOES");
+        s_glDeleteVertexArrays = (NV_PFNGLDELETEVERTEXARRAYSPROC)api.getGLProcAddress("glDeleteVertexArraysOES");
+    }
+    if (!s_glGenVertexArrays || !s_glBindVertexArray || !s_glDeleteVertexArrays) {
+        s_glGenVertexArrays = NULL;
+        s_glBindVertexArray = NULL;
+        s_glDeleteVertexArrays = NULL;
+    }
+
+    if (!es) {
+        s_glMultiDrawElements = (NV_PFNGLMULTIDRAWELEMENTSPROC)api.getGLProcAddress("glMultiDrawElements");
+        s_glMultiDrawArrays = (NV_PFNGLMULTIDRAWARRAYSPROC)api.getGLProcAddress("glMultiDrawArrays");
+    } else if (api.isExtensionSupported("GL_EXT_multi_draw_arrays")) {
+        s_glMultiDrawElements = (NV_PFNGLMULTIDRAWELEMENTSPROC)api.getGLProcAddress("glMultiDrawElementsEXT");
+        s_glMultiDrawArrays = (NV_PFNGLMULTIDRAWARRAYSPROC)api.getGLProcAddress("glMultiDrawArraysEXT");
+    }
+
+    if (!es && ((ver >= 43) || api.isExtensionSupported("GL_ARB_multi_draw_indirect"))) {
+        s_glMultiDrawElementsIndirect = (NV_PFNGLMULTIDRAWELEMENTSINDIRECTPROC)api.getGLProcAddress("glMultiDrawElementsIndirect");
+        s_glMultiDrawArraysIndirect = (NV_PFNGLMULTIDRAWARRAYSINDIRECTPROC)api.getGLProcAddress("glMultiDrawArraysIndirect");
+    } else if (es && api.isExtensionSupported("GL_EXT_multi_draw_indirect")) {
+        s_glMultiDrawElementsIndirect = (NV_PFNGLMULTIDRAWELEMENTSINDIRECTPROC)api.getGLProcAddress("glMultiDrawElementsIndirectEXT");
+        s_glMultiDrawArraysIndirect = (NV_PFNGLMULTIDRAWARRAYSINDIRECTPROC)api.getGLProcAddress("glMultiDrawArraysIndirectEXT");
+    }
+
+    // ES only draws indirect from vertex array objects
+    if (s_glMultiDrawElementsIndirect && s_glMultiDrawArraysIndirect && (!es || s_glGenVertexArrays))
+        s_supportedMethod = METHOD_INDIRECT;
+    else if (s_glMultiDrawElements && s_glMultiDrawArrays)
+        s_supportedMethod = METHOD_MULTI;
+    else
+        s_supportedMethod = METHOD_LOOP;
+
+    ms_defaultMethod = s_supportedMethod;
+    LOGI("NvMultiDraw: %s draws, %s vertex array objects", getMethodName(ms_defaultMethod),
+        s_glGenVertexArrays ? "with" : "without");
+}
+
+void NvMultiDraw::limitMethod(Method method)
+{
+    ms_defaultMethod = (method > s_supportedMethod) ? method : s_supportedMethod;
+}
+
+bool NvMultiDraw::hasVertexArrays()
+{
+    return s_glGenVertexArrays != NULL;
+}
+
+const char* NvMultiDraw::getMethodName(Method method)
+{
+    switch (method) {
+    case METHOD_INDIRECT: return "indirect";
+    case METHOD_MULTI: return "multi";
+    default: return "loop";
+    }
+}
+
+NvMultiDraw::NvMultiDraw()
+    : m_method(METHOD_LOOP)
+    , m_vao(0)
+    , m_commandBuffer(0)
+    , m_dirty(true)
+    , m_vertexBuffer(0)
+    , m_offset(0)
+    , m_size(0)
+    , m_indexBuffer(0)
+    , m_attribCount(0)
+    , m_indexType(0)
+    , m_calls(0)
+    , m_drawCalls(0)
+{
+}
+
+NvMultiDraw::~NvMultiDraw()
+{
+    release();
+}
+
+void NvMultiDraw::init()
+{
+    release();
+
+    m_method = ms_defaultMethod;
+    if (s_glGenVertexArrays)
+        s_glGenVertexArrays(1, &m_vao);
+    if (m_method == METHOD_INDIRECT)
+        glGenBuffers(1, &m_commandBuffer);
+    m_dirty = true;
+}
+
+void NvMultiDraw::release()
+{
+    if (m_vao)
+        s_glDeleteVertexArrays(1, &m_vao);
+    if (m_commandBuffer)
+        glDeleteBuffers(1, &m_commandBuffer);
+
+    m_vao = 0;
+    m_commandBuffer = 0;
+    m_commands.clear();
+}
+
+void NvMultiDraw::setVertices(GLuint vertexBuffer, size_t offset, GLint size, GLuint indexBuffer,
+    const GLint* attribs, int32_t attribCount)
+{
+    GLint unique[MAX_ATTRIBS];
+    int32_t uniqueCount = 0;
+    for (int32_t i = 0; i < attribCount; i++) {
+        bool seen = (attribs[i] < 0);
+        for (int32_t j = 0; j < uniqueCount && !seen; j++)
+            seen = (unique[j] == attribs[i]);
+        if (!seen && uniqueCount < MAX_ATTRIBS)
+            unique[uniqueCount++] = attribs[i];
+    }
+
+    if (vertexBuffer == m_vertexBuffer && offset == m_offset && size == m_size &&
+        indexBuffer == m_indexBuffer && uniqueCount == m_attribCount &&
+        memcmp(unique, m_attribs, uniqueCount * sizeof(GLint)) == 0)
+        return;
+
+    m_vertexBuffer = vertexBuffer;
+    m_offset = offset;
+    m_size = size;
+    m_indexBuffer = indexBuffer;
+    memcpy(m_attribs, unique, uniqueCount * sizeof(GLint));
+    m_attribCount = uniqueCount;
+    m_dirty = true;
+}
+
+void NvMultiDraw::setRanges(const GLint* first, const GLsizei* count, int32_t rangeCount,
+    GLenum indexType, size_t indexOffset)
+{
+    const size_t indexSize = (indexType == GL_UNSIGNED_INT) ? sizeof(GLuint) : sizeof(GLushort);
+
+    m_indexType = indexType;
+    m_first.assign(first, first + rangeCount);
+    m_count.assign(count, count + rangeCount);
+    m_indices.resize(indexType ? rangeCount : 0);
+    for (int32_t i = 0; i < (int32_t)m_indices.size(); i++)
+        m_indices[i] = (const void*)(indexOffset + indexSize * first[i]);
+
+    if (m_method != METHOD_INDIRECT)
+        return;
+
+    std::vector<GLuint> commands;
+    if (indexType) {
+        commands.resize(rangeCount * ELEMENTS_COMMAND_WORDS);
+        for (int32_t i = 0; i < rangeCount; i++) {
+            GLuint* command = &commands[i * ELEMENTS_COMMAND_WORDS];
+            command[0] = (GLuint)count[i];
+            command[1] = 1;
+            command[2] = (GLuint)(indexOffset / indexSize + first[i]);
+            command[3] = 0;
+            command[4] = 0;
+        }
+    } else {
+        commands.resize(rangeCount * ARRAYS_COMMAND_WORDS);
+        for (int32_t i = 0; i < rangeCount; i++) {
+            GLuint* command = &commands[i * ARRAYS_COMMAND_WORDS];
+            command[0] = (GLuint)count[i];
+            command[1] = 1;
+            command[2] = (GLuint)first[i];
+            command[3] = 0;
+        }
+    }
+
+    if (commands != m_commands && !commands.empty()) {
+        glBindBuffer(NV_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+        glBufferData(NV_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(GLuint), &commands[0], NV_DYNAMIC_DRAW);
+        glBindBuffer(NV_DRAW_INDIRECT_BUFFER, 0);
+        m_calls += 3;
+        m_commands.swap(commands);
+    }
+}
+
+void NvMultiDraw::setupVertices()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    for (int32_t i = 0; i < m_attribCount; i++) {
+        glVertexAttribPointer(m_attribs[i], m_size, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)m_offset);
+        glEnableVertexAttribArray(m_attribs[i]);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    m_calls += 2 + 2 * m_attribCount;
+}
+
+void NvMultiDraw::bind()
+{
+    if (!m_vao) {
+        setupVertices();
+    } else {
+        s_glBindVertexArray(m_vao);
+        m_calls++;
+        if (m_dirty) {
+            // the attribute pointers keep the array buffer they were set with, so it can be unbound
+            setupVertices();
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            m_calls++;
+            m_dirty = false;
+        }
+    }
+
+    if (m_method == METHOD_INDIRECT) {
+        glBindBuffer(NV_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+        m_calls++;
+    }
+}
+
+void NvMultiDraw::unbind()
+{
+    if (m_vao) {
+        s_glBindVertexArray(0);
+        m_calls++;
+    } else {
+        for (int32_t i = 0; i < m_attribCount; i++)
+            glDisableVertexAttribArray(m_attribs[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        m_calls += 2 + m_attribCount;
+    }
+    if (m_method == METHOD_INDIRECT) {
+        glBindBuffer(NV_DRAW_INDIRECT_BUFFER, 0);
+        m_calls++;
+    }
+}
+
+void NvMultiDraw::draw(GLenum mode, int32_t begin, int32_t count)
+{
+    if (begin < 0 || count <= 0 || begin + count > (int32_t)m_first.size())
+        return;
+
+    if (m_method == METHOD_INDIRECT) {
+        if (m_indexType) {
+            const size_t stride = ELEMENTS_COMMAND_WORDS * sizeof(GLuint);
+            s_glMultiDrawElementsIndirect(mode, m_indexType, (const void*)(begin * stride), count, 0);
+        } else {
+            const size_t stride = ARRAYS_COMMAND_WORDS * sizeof(GLuint);
+            s_glMultiDrawArraysIndirect(mode, (const void*)(begin * stride), count, 0);
+        }
+        m_calls++;
+        m_drawCalls++;
+    } else if (m_method == METHOD_MULTI) {
+        if (m_indexType)
+            s_glMultiDrawElements(mode, &m_count[begin], m_indexType, &m_indices[begin], count);
+        else
+            s_glMultiDrawArrays(mode, &m_first[begin], &m_count[begin], count);
+        m_calls++;
+        m_drawCalls++;
+    } else {
+        for (int32_t i = begin; i < begin + count; i++) {
+            if (m_indexType)
+                glDrawElements(mode, m_count[i], m_indexType, m_indices[i]);
+            else
+                glDrawArrays(mode, m_first[i], m_count[i]);
+        }
+        m_calls += count;
+        m_drawCalls += count;
+    }
+}
@@ -0,0 +1,591 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvProfiler.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvGLUtils/NvProfiler.h"
+#include "NvGLUtils/NvTimers.h"
+#include "NV/NvPlatformGL.h"
+#include "NV/NvLogs.h"
+#include "R3/thread.h"
+
+#include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define NV_PROFILER_TLS __declspec(thread)
+#else
+#include <time.h>
+#define NV_PROFILER_TLS __thread
+#endif
+
+bool NvProfiler::ms_enabled = false;
+int32_t NvProfiler::ms_captureFramesLeft = 0;
+
+// Events kept for one trace capture; older events are dropped beyond this
+static const size_t MAX_CAPTURE_EVENTS = 1 << 20;
+
+// Trace "thread" id used for GPU events
+static const int32_t GPU_TRACK = 0;
+
+static inline void memoryBarrier() {
+#ifdef _WIN32
+    MemoryBarrier();
+#else
+    __sync_synchronize();
+#endif
+}
+
+struct ProfilerEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    int32_t depth;
+    int32_t track;
+};
+
+static bool eventStartsBefore(const ProfilerEvent& a, const ProfilerEvent& b) {
+    return (a.start != b.start) ? (a.start < b.start) : (a.depth < b.depth);
+}
+
+// Single-producer/single-consumer ring of completed CPU scopes.  The owning thread
+// is the only writer; endFrame is the only reader.  Buffers are never freed, as a
+// thread may still hold a pointer to its buffer after the profiler is shut down
+struct ThreadBuffer {
+    ProfilerEvent events[NvProfiler::THREAD_BUFFER_EVENTS];
+    volatile uint32_t head;
+    uint32_t tail;
+    int32_t depth;
+    int32_t track;
+    std::string name;
+};
+
+struct GPUPair {
+    const char* name;
+    uint64_t cpuIssue;
+    int32_t depth;
+    bool closed;
+};
+
+struct ScopeStats {
+    std::string name;
+    int32_t depth;
+    bool gpu;
+    uint64_t frameNs;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    uint32_t calls;
+};
+
+static NV_PROFILER_TLS ThreadBuffer* s_threadBuffer = NULL;
+static r3::Mutex s_threadsMutex;
+static std::vector<ThreadBuffer*> s_threads;
+
+static NvProfiler::GPUBackend* s_gpu = NULL;
+static GPUPair s_gpuPairs[NvProfiler::GPU_QUERY_PAIRS];
+static uint32_t s_gpuHead = 0;
+static uint32_t s_gpuTail = 0;
+static int32_t s_gpuDepth = 0;
+static int64_t s_gpuOffset = 0;
+static bool s_gpuCalibrated = false;
+
+static uint32_t s_dropped = 0;
+static std::vector<ProfilerEvent> s_frameEvents;
+static std::vector<ProfilerEvent> s_capture;
+struct ScopeStatsSet {
+    std::vector<ScopeStats> stats;
+    std::map<std::string, size_t> index;
+    int32_t frames;
+
+    ScopeStatsSet() : frames(0) { }
+
+    void clear() {
+        stats.clear();
+        index.clear();
+        frames = 0;
+    }
+};
+
+static ScopeStatsSet s_interval;
+static ScopeStatsSet s_totals;
+static std::vector<NvProfiler::ScopeSummary> s_summary;
+
+class NvProfilerNullBackend : public NvProfiler::GPUBackend {
+public:
+    NvProfilerNullBackend() { }
+
+    virtual bool init(int32_t count) {
+        m_timestamps.assign(count, 0);
+        return true;
+    }
+
+    virtual void timestamp(int32_t slot) { m_timestamps[slot] = NvProfiler::getTimeNs(); }
+    virtual bool isAvailable(int32_t slot) { return true; }
+    virtual uint64_t getTimestamp(int32_t slot) { return m_timestamps[slot]; }
+
+protected:
+    std::vector<uint64_t> m_timestamps;
+};
+
+class NvProfilerGLBackend : public NvProfiler::GPUBackend {
+public:
+    NvProfilerGLBackend() { }
+
+    // NvProfiler::globalShutdown runs before the context is destroyed
+    virtual ~NvProfilerGLBackend() {
+        if (!m_queries.empty())
+            NvGPUTimer::m_glDeleteQueries((GLsizei)m_queries.size(), &m_queries[0]);
+    }
+
+    virtual bool init(int32_t count) {
+        if (!m_queries.empty())
+            NvGPUTimer::m_glDeleteQueries((GLsizei)m_queries.size(), &m_queries[0]);
+        m_queries.assign(count, 0);
+        NvGPUTimer::m_glGenQueries(count, &m_queries[0]);
+        return true;
+    }
+
+    virtual void timestamp(int32_t slot) {
+        NvGPUTimer::m_glQueryCounter(m_queries[slot], NvGPUTimer::NV_TIMESTAMP);
+    }
+
+    virtual bool isAvailable(int32_t slot) {
+        GLuint available = 0;
+        NvGPUTimer::m_glGetQueryObjectuiv(m_queries[slot], NvGPUTimer::NV_QUERY_RESULT_AVAILABLE, &available);
+        return available != 0;
+    }
+
+    virtual uint64_t getTimestamp(int32_t slot) {
+        uint64_t time = 0;
+        NvGPUTimer::m_glGetQueryObjectui64v(m_queries[slot], NvGPUTimer::NV_QUERY_RESULT, &time);
+        return time;
+    }
+
+protected:
+    std::vector<GLuint> m_queries;
+};
+
+NvProfiler::GPUBackend* NvProfiler::createGLBackend(NvGLExtensionsAPI& api) {
+    bool supported = api.isExtensionSupported("GL_ARB_timer_query") ||
+        api.isExtensionSupported("GL_NV_timer_query");
+#ifdef GL_VERSION_3_3
+    if (!supported) {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(0x821B /* GL_MAJOR_VERSION */, &major);
+        glGetIntegerv(0x821C /* GL_MINOR_VERSION */, &minor);
+        supported = (major * 10 + minor) >= 33;
+    }
+#endif
+    if (!supported)
+        return NULL;
+
+    // The entry points are shared with NvGPUTimer
+    NvGPUTimer::globalInit(api);
+    return new NvProfilerGLBackend;
+}
+
+NvProfiler::GPUBackend* NvProfiler::createNullBackend() {
+    return new NvProfilerNullBackend;
+}
+
+void NvProfiler::globalInit(GPUBackend* gpu) {
+    if (ms_enabled)
+        globalShutdown();
+
+    if (!gpu) {
+        LOGI("NvProfiler: GPU timestamps unavailable; GPU scopes use the null backend");
+        gpu = createNullBackend();
+    }
+
+    s_gpu = gpu;
+    s_gpu->init(GPU_QUERY_PAIRS * 2);
+    s_gpuHead = s_gpuTail = 0;
+    s_gpuDepth = 0;
+    s_gpuCalibrated = false;
+
+    ms_enabled = true;
+}
+
+void NvProfiler::globalShutdown() {
+    ms_enabled = false;
+
+    delete s_gpu;
+    s_gpu = NULL;
+    s_gpuHead = s_gpuTail = 0;
+}
+
+uint64_t NvProfiler::getTimeNs() {
+#ifdef _WIN32
+    static LARGE_INTEGER freq = { 0 };
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000000ULL +
+        (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000000ULL / freq.QuadPart;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static ThreadBuffer* getThreadBuffer() {
+    if (!s_threadBuffer) {
+        ThreadBuffer* buffer = new ThreadBuffer;
+        buffer->head = 0;
+        buffer->tail = 0;
+        buffer->depth = 0;
+
+        r3::ScopedMutex lock(s_threadsMutex);
+        buffer->track = (int32_t)s_threads.size() + 1;
+        s_threads.push_back(buffer);
+        s_threadBuffer = buffer;
+    }
+    return s_threadBuffer;
+}
+
+void NvProfiler::setThreadName(const char* name) {
+    ThreadBuffer* buffer = getThreadBuffer();
+    r3::ScopedMutex lock(s_threadsMutex);
+    buffer->name = name;
+}
+
+void NvProfiler::beginCPU(int32_t& depth) {
+    depth = getThreadBuffer()->depth++;
+}
+
+void NvProfiler::endCPU(const char* name, int32_t depth, uint64_t startNs) {
+    const uint64_t endNs = getTimeNs();
+    ThreadBuffer* buffer = s_threadBuffer;
+    buffer->depth--;
+
+    const uint32_t head = buffer->head;
+    ProfilerEvent& ev = buffer->events[head & (THREAD_BUFFER_EVENTS - 1)];
+    ev.name = name;
+    ev.start = startNs;
+    ev.end = endNs;
+    ev.depth = depth;
+    ev.track = buffer->track;
+
+    // publish the event only after it has been written
+    memoryBarrier();
+    buffer->head = head + 1;
+}
+
+int32_t NvProfiler::beginGPU(const char* name) {
+    if (s_gpuHead - s_gpuTail >= (uint32_t)GPU_QUERY_PAIRS) {
+        // every pair is still in flight; drop rather than wait on the GPU
+        s_dropped++;
+        return -1;
+    }
+
+    const int32_t pair = s_gpuHead % GPU_QUERY_PAIRS;
+    s_gpuHead++;
+
+    GPUPair& p = s_gpuPairs[pair];
+    p.name = name;
+    p.cpuIssue = getTimeNs();
+    p.depth = s_gpuDepth++;
+    p.closed = false;
+    s_gpu->timestamp(pair * 2);
+    return pair;
+}
+
+void NvProfiler::endGPU(int32_t pair) {
+    if (!s_gpu)
+        return;
+    s_gpu->timestamp(pair * 2 + 1);
+    s_gpuPairs[pair].closed = true;
+    s_gpuDepth--;
+}
+
+static void drainThread(ThreadBuffer* buffer, std::vector<ProfilerEvent>& out) {
+    const uint32_t capacity = NvProfiler::THREAD_BUFFER_EVENTS;
+    const uint32_t head = buffer->head;
+    memoryBarrier();
+
+    uint32_t tail = buffer->tail;
+    if (head - tail > capacity) {
+        s_dropped += head - tail - capacity;
+        tail = head - capacity;
+    }
+
+    const size_t first = out.size();
+    for (uint32_t i = tail; i != head; i++)
+        out.push_back(buffer->events[i & (capacity - 1)]);
+
+    // The owner may have wrapped onto the oldest slots while we were copying
+    memoryBarrier();
+    const uint32_t newHead = buffer->head;
+    if (newHead - tail > capacity) {
+        uint32_t lost = std::min(newHead - tail - capacity, head - tail);
+        out.erase(out.begin() + first, out.begin() + first + lost);
+        s_dropped += lost;
+    }
+
+    buffer->tail = head;
+
+    // scopes are recorded when they close, so children precede their parents;
+    // restore start order so the summary lists parents first
+    std::stable_sort(out.begin() + first, out.end(), eventStartsBefore);
+}
+
+static void resolveGPU(std::vector<ProfilerEvent>& out) {
+    while (s_gpuTail != s_gpuHead) {
+        const int32_t pair = s_gpuTail % NvProfiler::GPU_QUERY_PAIRS;
+        GPUPair& p = s_gpuPairs[pair];
+        if (!p.closed || !s_gpu->isAvailable(pair * 2 + 1))
+            break;
+
+        const uint64_t begin = s_gpu->getTimestamp(pair * 2);
+        const uint64_t end = s_gpu->getTimestamp(pair * 2 + 1);
+
+        // Map the GPU clock onto the CPU clock.  The GPU cannot start a scope before
+        // the CPU issued it, so the offset only ever grows to keep that true
+        if (!s_gpuCalibrated || (int64_t)begin + s_gpuOffset < (int64_t)p.cpuIssue) {
+            s_gpuOffset = (int64_t)p.cpuIssue - (int64_t)begin;
+            s_gpuCalibrated = true;
+        }
+
+        ProfilerEvent ev;
+        ev.name = p.name;
+        ev.start = (uint64_t)((int64_t)begin + s_gpuOffset);
+        ev.end = ev.start + ((end > begin) ? (end - begin) : 0);
+        ev.depth = p.depth;
+        ev.track = GPU_TRACK;
+        out.push_back(ev);
+
+        s_gpuTail++;
+    }
+}
+
+static void addEvent(ScopeStatsSet& set, const std::string& key, const ProfilerEvent& ev, bool gpu) {
+    std::map<std::string, size_t>::iterator it = set.index.find(key);
+    size_t index;
+    if (it == set.index.end()) {
+        ScopeStats stats;
+        stats.name = ev.name;
+        stats.depth = ev.depth;
+        stats.gpu = gpu;
+        stats.frameNs = stats.totalNs = stats.maxNs = 0;
+        stats.calls = 0;
+        index = set.stats.size();
+        set.stats.push_back(stats);
+        set.index[key] = index;
+    } else {
+        index = it->second;
+    }
+
+    ScopeStats& stats = set.stats[index];
+    stats.frameNs += ev.end - ev.start;
+    stats.calls++;
+}
+
+static void endStatsFrame(ScopeStatsSet& set) {
+    for (size_t i = 0; i < set.stats.size(); i++) {
+        ScopeStats& stats = set.stats[i];
+        stats.totalNs += stats.frameNs;
+        stats.maxNs = std::max(stats.maxNs, stats.frameNs);
+        stats.frameNs = 0;
+    }
+    set.frames++;
+}
+
+static void summarize(const ScopeStatsSet& set, std::vector<NvProfiler::ScopeSummary>& scopes) {
+    scopes.clear();
+    for (size_t i = 0; i < set.stats.size(); i++) {
+        const ScopeStats& stats = set.stats[i];
+        if (!stats.calls)
+            continue;
+        NvProfiler::ScopeSummary summary;
+        summary.name = stats.name;
+        summary.depth = stats.depth;
+        summary.gpu = stats.gpu;
+        summary.meanMs = (float)(stats.totalNs * 1.0e-6 / set.frames);
+        summary.maxMs = (float)(stats.maxNs * 1.0e-6);
+        summary.callsPerFrame = (float)stats.calls / set.frames;
+        scopes.push_back(summary);
+    }
+}
+
+static void accumulate(const std::vector<ProfilerEvent>& events) {
+    char key[32];
+    for (size_t i = 0; i < events.size(); i++) {
+        const ProfilerEvent& ev = events[i];
+        const bool gpu = ev.track == GPU_TRACK;
+        sprintf(key, "%c%d:", gpu ? 'G' : 'C', ev.depth);
+        std::string fullKey = std::string(key) + ev.name;
+
+        addEvent(s_interval, fullKey, ev, gpu);
+        addEvent(s_totals, fullKey, ev, gpu);
+    }
+
+    endStatsFrame(s_totals);
+    endStatsFrame(s_interval);
+    if (s_interval.frames < NvProfiler::SUMMARY_FRAMES)
+        return;
+
+    summarize(s_interval, s_summary);
+
+    // start the next interval from scratch, so scopes that stop running disappear
+    s_interval.clear();
+}
+
+void NvProfiler::endFrame() {
+    if (!ms_enabled)
+        return;
+
+    s_frameEvents.clear();
+    {
+        r3::ScopedMutex lock(s_threadsMutex);
+        for (size_t i = 0; i < s_threads.size(); i++)
+            drainThread(s_threads[i], s_frameEvents);
+    }
+    resolveGPU(s_frameEvents);
+
+    accumulate(s_frameEvents);
+
+    if (ms_captureFramesLeft > 0) {
+        size_t room = MAX_CAPTURE_EVENTS - std::min(MAX_CAPTURE_EVENTS, s_capture.size());
+        size_t count = std::min(room, s_frameEvents.size());
+        s_capture.insert(s_capture.end(), s_frameEvents.begin(), s_frameEvents.begin() + count);
+        s_dropped += (uint32_t)(s_frameEvents.size() - count);
+
+        if (--ms_captureFramesLeft == 0)
+            LOGI("NvProfiler: captured %d events", (int32_t)s_capture.size());
+    }
+}
+
+void NvProfiler::beginCapture(int32_t frames) {
+    s_capture.clear();
+    ms_captureFramesLeft = frames;
+}
+
+bool NvProfiler::hasCapture() {
+    return (ms_captureFramesLeft == 0) && !s_capture.empty();
+}
+
+static void writeJSONString(FILE* fp, const char* str) {
+    fputc('"', fp);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            fputc('\\', fp);
+        if ((unsigned char)*str >= 0x20)
+            fputc(*str, fp);
+    }
+    fputc('"', fp);
+}
+
+bool NvProfiler::writeChromeTrace(const char* filename) {
+    FILE* fp = fopen(filename, "w");
+    if (!fp) {
+        LOGE("NvProfiler: cannot open trace file %s", filename);
+        return false;
+    }
+
+    uint64_t origin = 0;
+    for (size_t i = 0; i < s_capture.size(); i++) {
+        if (!i || s_capture[i].start < origin)
+            origin = s_capture[i].start;
+    }
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", GPU_TRACK);
+    {
+        r3::ScopedMutex lock(s_threadsMutex);
+        for (size_t i = 0; i < s_threads.size(); i++) {
+            char fallback[32];
+            sprintf(fallback, "thread %d", s_threads[i]->track);
+            fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                s_threads[i]->track);
+            writeJSONString(fp, s_threads[i]->name.empty() ? fallback : s_threads[i]->name.c_str());
+            fprintf(fp, "}}");
+        }
+    }
+
+    for (size_t i = 0; i < s_capture.size(); i++) {
+        const ProfilerEvent& ev = s_capture[i];
+        fprintf(fp, ",\n{\"name\":");
+        writeJSONString(fp, ev.name);
+        fprintf(fp, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+            (ev.track == GPU_TRACK) ? "gpu" : "cpu",
+            (ev.start - origin) * 1.0e-3, (ev.end - ev.start) * 1.0e-3, ev.track);
+    }
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    bool ok = !ferror(fp);
+    fclose(fp);
+
+    if (ok) {
+        LOGI("NvProfiler: wrote %d events to %s", (int32_t)s_capture.size(), filename);
+    } else {
+        LOGE("NvProfiler: failed writing trace file %s", filename);
+    }
+
+    s_capture.clear();
+    return ok;
+}
+
+void NvProfiler::getSummary(std::vector<ScopeSummary>& scopes) {
+    scopes = s_summary;
+}
+
+void NvProfiler::resetTotals() {
+    s_totals.clear();
+}
+
+void NvProfiler::getTotals(std::vector<ScopeSummary>& scopes, int32_t& frames) {
+    summarize(s_totals, scopes);
+    frames = s_totals.frames;
+}
+
+void NvProfiler::formatSummary(std::string& text) {
+    char line[256];
+    text.clear();
+    for (size_t i = 0; i < s_summary.size(); i++) {
+        const ScopeSummary& s = s_summary[i];
+        sprintf(line, "%s %*s%s  %.2f ms (max %.2f)", s.gpu ? "GPU" : "CPU",
+            s.depth * 2, "", s.name.c_str(), s.meanMs, s.maxMs);
+        text += line;
+        if (s.callsPerFrame > 1.01f) {
+            sprintf(line, " x%.0f", s.callsPerFrame);
+            text += line;
+        }
+        text += "\n";
+    }
+}
+
+uint32_t NvProfiler::getDroppedEventCount() {
+    return s_dropped;
+}
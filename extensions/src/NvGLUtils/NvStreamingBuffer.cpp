@@ -0,0 +1,367 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvStreamingBuffer.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvGLUtils/NvStreamingBuffer.h"
+#include "NvGLUtils/NvProfiler.h"
+#include "NV/NvLogs.h"
+#include "KHR/khrplatform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+NvStreamingBuffer::Method NvStreamingBuffer::ms_defaultMethod = NvStreamingBuffer::METHOD_ORPHAN;
+uint32_t NvStreamingBuffer::ms_totalWrites = 0;
+uint32_t NvStreamingBuffer::ms_totalStalls = 0;
+float NvStreamingBuffer::ms_totalStallMs = 0.0f;
+uint64_t NvStreamingBuffer::ms_totalWriteBytes = 0;
+
+// Slot offsets are kept aligned for vertex attributes and for binding a slot
+// as a shader storage or uniform buffer range
+static const size_t SLOT_ALIGNMENT = 256;
+
+// The tokens are not in the ES 2.0 headers
+static const GLbitfield NV_MAP_WRITE_BIT = 0x0002;
+static const GLbitfield NV_MAP_INVALIDATE_RANGE_BIT = 0x0004;
+static const GLbitfield NV_MAP_INVALIDATE_BUFFER_BIT = 0x0008;
+static const GLbitfield NV_MAP_UNSYNCHRONIZED_BIT = 0x0020;
+static const GLbitfield NV_MAP_PERSISTENT_BIT = 0x0040;
+static const GLbitfield NV_MAP_COHERENT_BIT = 0x0080;
+static const GLenum NV_SYNC_GPU_COMMANDS_COMPLETE = 0x9117;
+static const GLbitfield NV_SYNC_FLUSH_COMMANDS_BIT = 0x0001;
+static const GLenum NV_TIMEOUT_EXPIRED = 0x911B;
+static const GLenum NV_WAIT_FAILED = 0x911D;
+static const GLenum NV_STREAM_DRAW = 0x88E0;
+
+typedef void* (KHRONOS_APIENTRY* NV_PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (KHRONOS_APIENTRY* NV_PFNGLUNMAPBUFFERPROC) (GLenum target);
+typedef void (KHRONOS_APIENTRY* NV_PFNGLBUFFERSTORAGEPROC) (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void* (KHRONOS_APIENTRY* NV_PFNGLFENCESYNCPROC) (GLenum condition, GLbitfield flags);
+typedef GLenum (KHRONOS_APIENTRY* NV_PFNGLCLIENTWAITSYNCPROC) (void* sync, GLbitfield flags, uint64_t timeout);
+typedef void (KHRONOS_APIENTRY* NV_PFNGLDELETESYNCPROC) (void* sync);
+
+static NV_PFNGLMAPBUFFERRANGEPROC s_glMapBufferRange = NULL;
+static NV_PFNGLUNMAPBUFFERPROC s_glUnmapBuffer = NULL;
+static NV_PFNGLBUFFERSTORAGEPROC s_glBufferStorage = NULL;
+static NV_PFNGLFENCESYNCPROC s_glFenceSync = NULL;
+static NV_PFNGLCLIENTWAITSYNCPROC s_glClientWaitSync = NULL;
+static NV_PFNGLDELETESYNCPROC s_glDeleteSync = NULL;
+
+// the best method the context supports, before any limitMethod()
+static NvStreamingBuffer::Method s_supportedMethod = NvStreamingBuffer::METHOD_ORPHAN;
+
+void NvStreamingBuffer::globalInit(NvGLExtensionsAPI& api)
+{
+    s_glMapBufferRange = NULL;
+    s_glUnmapBuffer = NULL;
+    s_glBufferStorage = NULL;
+    s_glFenceSync = NULL;
+    s_glClientWaitSync = NULL;
+    s_glDeleteSync = NULL;
+
+    // The extension headers differ between platforms, so the version is read
+    // from the string rather than from the GL_VERSION_x_y macros
+    const char* version = (const char*)glGetString(GL_VERSION);
+    const bool es = version && (strstr(version, "OpenGL ES") != NULL);
+    int32_t major = 0, minor = 0;
+    if (version) {
+        const char* digits = version;
+        while (*digits && (*digits < '0' || *digits > '9'))
+            digits++;
+        sscanf(digits, "%d.%d", &major, &minor);
+    }
+    const int32_t ver = major * 10 + minor;
+
+    if (ver >= 30) {
+        s_glMapBufferRange = (NV_PFNGLMAPBUFFERRANGEPROC)api.getGLProcAddress("glMapBufferRange");
+        s_glUnmapBuffer = (NV_PFNGLUNMAPBUFFERPROC)api.getGLProcAddress("glUnmapBuffer");
+    } else if (api.isExtensionSupported("GL_ARB_map_buffer_range")) {
+        s_glMapBufferRange = (NV_PFNGLMAPBUFFERRANGEPROC)api.getGLProcAddress("glMapBufferRange");
+        s_glUnmapBuffer = (NV_PFNGLUNMAPBUFFERPROC)api.getGLProcAddress("glUnmapBuffer");
+    } else if (api.isExtensionSupported("GL_EXT_map_buffer_range")) {
+        s_glMapBufferRange = (NV_PFNGLMAPBUFFERRANGEPROC)api.getGLProcAddress("glMapBufferRangeEXT");
+        s_glUnmapBuffer = (NV_PFNGLUNMAPBUFFERPROC)api.getGLProcAddress("glUnmapBufferOES");
+    }
+    if (!s_glUnmapBuffer)
+        s_glMapBufferRange = NULL;
+
+    if ((es ? (ver >= 30) : (ver >= 32)) || api.isExtensionSupported("GL_ARB_sync")) {
+        s_glFenceSync = (NV_PFNGLFENCESYNCPROC)api.getGLProcAddress("glFenceSync");
+        s_glClientWaitSync = (NV_PFNGLCLIENTWAITSYNCPROC)api.getGLProcAddress("glClientWaitSync");
+        s_glDeleteSync = (NV_PFNGLDELETESYNCPROC)api.getGLProcAddress("glDeleteSync");
+    }
+    const bool hasSync = s_glFenceSync && s_glClientWaitSync && s_glDeleteSync;
+
+    if (!es && ((ver >= 44) || api.isExtensionSupported("GL_ARB_buffer_storage")))
+        s_glBufferStorage = (NV_PFNGLBUFFERSTORAGEPROC)api.getGLProcAddress("glBufferStorage");
+    else if (es && api.isExtensionSupported("GL_EXT_buffer_storage"))
+        s_glBufferStorage = (NV_PFNGLBUFFERSTORAGEPROC)api.getGLProcAddress("glBufferStorageEXT");
+
+    if (s_glMapBufferRange && hasSync && s_glBufferStorage)
+        s_supportedMethod = METHOD_PERSISTENT;
+    else if (s_glMapBufferRange && hasSync)
+        s_supportedMethod = METHOD_UNSYNCHRONIZED;
+    else
+        s_supportedMethod = METHOD_ORPHAN;
+
+    ms_defaultMethod = s_supportedMethod;
+    ms_totalWrites = 0;
+    ms_totalStalls = 0;
+    ms_totalStallMs = 0.0f;
+    ms_totalWriteBytes = 0;
+
+    LOGI("NvStreamingBuffer: %s", getMethodName(ms_defaultMethod));
+}
+
+void NvStreamingBuffer::limitMethod(Method method)
+{
+    ms_defaultMethod = (method > s_supportedMethod) ? method : s_supportedMethod;
+    LOGI("NvStreamingBuffer: %s", getMethodName(ms_defaultMethod));
+}
+
+const char* NvStreamingBuffer::getMethodName(Method method)
+{
+    switch (method) {
+    case METHOD_PERSISTENT:
+        return "persistent";
+    case METHOD_UNSYNCHRONIZED:
+        return "unsynchronized";
+    default:
+        return "orphan";
+    }
+}
+
+NvStreamingBuffer::NvStreamingBuffer()
+    : m_target(GL_ARRAY_BUFFER)
+    , m_buffer(0)
+    , m_method(METHOD_ORPHAN)
+    , m_slotSize(0)
+    , m_slotStride(0)
+    , m_slotCount(0)
+    , m_readSlot(0)
+    , m_writeSlot(0)
+    , m_persistent(NULL)
+    , m_staging(NULL)
+    , m_writing(false)
+    , m_mapped(false)
+    , m_stallCount(0)
+    , m_stallMs(0.0f)
+{
+    for (int32_t i = 0; i < MAX_SLOTS; i++)
+        m_fences[i] = NULL;
+}
+
+NvStreamingBuffer::~NvStreamingBuffer()
+{
+    release();
+}
+
+bool NvStreamingBuffer::init(GLenum target, size_t slotSize, int32_t slotCount, const void* initialData)
+{
+    release();
+
+    m_target = target;
+    m_slotSize = slotSize;
+    m_slotStride = (slotSize + SLOT_ALIGNMENT - 1) & ~(SLOT_ALIGNMENT - 1);
+    m_slotCount = (slotCount < 1) ? 1 : ((slotCount > MAX_SLOTS) ? MAX_SLOTS : slotCount);
+    m_stallCount = 0;
+    m_stallMs = 0.0f;
+
+    // fall back to the next method if the driver refuses this one
+    for (int32_t method = ms_defaultMethod; method <= METHOD_ORPHAN; method++) {
+        if (create((Method)method, initialData))
+            return true;
+        release();
+    }
+
+    LOGE("NvStreamingBuffer: cannot create a %d byte buffer", (int32_t)slotSize);
+    return false;
+}
+
+bool NvStreamingBuffer::create(Method method, const void* initialData)
+{
+    m_method = method;
+    if (m_method == METHOD_ORPHAN)
+        m_slotCount = 1;
+    const size_t totalSize = m_slotStride * m_slotCount;
+
+    while (glGetError() != GL_NO_ERROR) {}
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(m_target, m_buffer);
+
+    if (m_method == METHOD_PERSISTENT) {
+        const GLbitfield flags = NV_MAP_WRITE_BIT | NV_MAP_PERSISTENT_BIT | NV_MAP_COHERENT_BIT;
+        s_glBufferStorage(m_target, totalSize, NULL, flags);
+        m_persistent = (uint8_t*)s_glMapBufferRange(m_target, 0, totalSize, flags);
+        if (m_persistent && initialData) {
+            for (int32_t i = 0; i < m_slotCount; i++)
+                memcpy(m_persistent + i * m_slotStride, initialData, m_slotSize);
+        }
+    } else {
+        glBufferData(m_target, totalSize, NULL, NV_STREAM_DRAW);
+        if (initialData) {
+            for (int32_t i = 0; i < m_slotCount; i++)
+                glBufferSubData(m_target, i * m_slotStride, m_slotSize, initialData);
+        }
+        // without glMapBufferRange, writes go through system memory and glBufferSubData
+        if (!s_glMapBufferRange)
+            m_staging = new uint8_t[m_slotSize];
+    }
+
+    glBindBuffer(m_target, 0);
+
+    m_readSlot = 0;
+    m_writeSlot = 0;
+
+    return (glGetError() == GL_NO_ERROR) && ((m_method != METHOD_PERSISTENT) || m_persistent);
+}
+
+void NvStreamingBuffer::release()
+{
+    for (int32_t i = 0; i < MAX_SLOTS; i++) {
+        if (m_fences[i])
+            s_glDeleteSync(m_fences[i]);
+        m_fences[i] = NULL;
+    }
+
+    if (m_buffer) {
+        if (m_persistent || m_mapped) {
+            glBindBuffer(m_target, m_buffer);
+            s_glUnmapBuffer(m_target);
+            glBindBuffer(m_target, 0);
+        }
+        glDeleteBuffers(1, &m_buffer);
+    }
+    m_buffer = 0;
+    m_persistent = NULL;
+    m_mapped = false;
+    m_writing = false;
+
+    delete[] m_staging;
+    m_staging = NULL;
+}
+
+void NvStreamingBuffer::waitForSlot(int32_t slot)
+{
+    void* fence = m_fences[slot];
+    if (!fence)
+        return;
+    m_fences[slot] = NULL;
+
+    GLenum result = s_glClientWaitSync(fence, 0, 0);
+    if (result == NV_TIMEOUT_EXPIRED) {
+        NV_PROFILE_SCOPE("NvStreamingBuffer stall");
+        const uint64_t start = NvProfiler::getTimeNs();
+        do {
+            result = s_glClientWaitSync(fence, NV_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
+        } while (result == NV_TIMEOUT_EXPIRED);
+        const float ms = (float)((NvProfiler::getTimeNs() - start) * 1.0e-6);
+
+        m_stallCount++;
+        m_stallMs += ms;
+        ms_totalStalls++;
+        ms_totalStallMs += ms;
+    }
+    if (result == NV_WAIT_FAILED)
+        LOGE("NvStreamingBuffer: glClientWaitSync failed");
+
+    s_glDeleteSync(fence);
+}
+
+void* NvStreamingBuffer::beginWrite()
+{
+    if (!m_buffer || m_writing)
+        return NULL;
+
+    m_writeSlot = (m_readSlot + 1) % m_slotCount;
+    waitForSlot(m_writeSlot);
+    m_writing = true;
+    ms_totalWrites++;
+    ms_totalWriteBytes += m_slotSize;
+
+    if (m_method == METHOD_PERSISTENT)
+        return m_persistent + m_writeSlot * m_slotStride;
+
+    glBindBuffer(m_target, m_buffer);
+
+    void* ptr = NULL;
+    if (m_method == METHOD_UNSYNCHRONIZED) {
+        ptr = s_glMapBufferRange(m_target, m_writeSlot * m_slotStride, m_slotSize,
+            NV_MAP_WRITE_BIT | NV_MAP_INVALIDATE_RANGE_BIT | NV_MAP_UNSYNCHRONIZED_BIT);
+    } else {
+        // detach the storage the GPU may still be reading; the driver allocates a fresh copy
+        glBufferData(m_target, m_slotStride, NULL, NV_STREAM_DRAW);
+        if (s_glMapBufferRange)
+            ptr = s_glMapBufferRange(m_target, 0, m_slotSize, NV_MAP_WRITE_BIT | NV_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    glBindBuffer(m_target, 0);
+
+    m_mapped = (ptr != NULL);
+    if (!ptr) {
+        if (!m_staging)
+            m_staging = new uint8_t[m_slotSize];
+        ptr = m_staging;
+    }
+    return ptr;
+}
+
+void NvStreamingBuffer::endWrite()
+{
+    if (!m_writing)
+        return;
+    m_writing = false;
+
+    if (m_method != METHOD_PERSISTENT) {
+        glBindBuffer(m_target, m_buffer);
+        if (m_mapped)
+            s_glUnmapBuffer(m_target);
+        else
+            glBufferSubData(m_target, m_writeSlot * m_slotStride, m_slotSize, m_staging);
+        glBindBuffer(m_target, 0);
+        m_mapped = false;
+    }
+
+    m_readSlot = m_writeSlot;
+}
+
+void NvStreamingBuffer::fenceRead()
+{
+    // an orphaned buffer is renamed by the driver, so there is nothing to wait on
+    if (m_method == METHOD_ORPHAN || !m_buffer)
+        return;
+
+    if (m_fences[m_readSlot])
+        s_glDeleteSync(m_fences[m_readSlot]);
+    m_fences[m_readSlot] = s_glFenceSync(NV_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
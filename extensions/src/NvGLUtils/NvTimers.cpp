@@ -34,6 +34,7 @@
 #include <NvGLUtils/NvTimers.h>
 
 NvGPUTimer::NV_PFNGLGENQUERIESPROC          NvGPUTimer::m_glGenQueries = NULL;
+NvGPUTimer::NV_PFNGLDELETEQUERIESPROC       NvGPUTimer::m_glDeleteQueries = NULL;
 NvGPUTimer::NV_PFNGLQUERYCOUNTERPROC        NvGPUTimer::m_glQueryCounter = NULL;
 NvGPUTimer::NV_PFNGLGETQUERYOBJECTUIVPROC   NvGPUTimer::m_glGetQueryObjectuiv = NULL;
 NvGPUTimer::NV_PFNGLGETQUERYOBJECTUI64VPROC NvGPUTimer::m_glGetQueryObjectui64v = NULL;
@@ -41,23 +42,27 @@ NvGPUTimer::NV_PFNGLGETQUERYOBJECTUI64VPROC NvGPUTimer::m_glGetQueryObjectui64v
 NvStopWatchFactory* NvCPUTimer::ms_factory = NULL;
 
 static void nullGenQueries(GLsizei, GLuint *) { }
+static void nullDeleteQueries(GLsizei, const GLuint *) { }
 static void nullQueryCounter(GLuint, GLenum) { }
 static void nullGetQueryObjectuiv(GLuint, GLenum, GLuint *) { }
 static void nullGetQueryObjectui64v(GLuint, GLenum, uint64_t *) { }
 
 void NvGPUTimer::globalInit(NvGLExtensionsAPI& api) {
     m_glGenQueries = NULL;
+    m_glDeleteQueries = NULL;
     m_glQueryCounter = NULL;
     m_glGetQueryObjectuiv = NULL;
     m_glGetQueryObjectui64v = NULL;
 
 #ifdef GL_ES_VERSION_3_0
     m_glGenQueries = (NV_PFNGLGENQUERIESPROC)glGenQueries;
+    m_glDeleteQueries = (NV_PFNGLDELETEQUERIESPROC)glDeleteQueries;
     m_glGetQueryObjectuiv = (NV_PFNGLGETQUERYOBJECTUIVPROC)glGetQueryObjectuiv;
 #endif
 
 #ifdef GL_VERSION_1_5
     m_glGenQueries = (NV_PFNGLGENQUERIESPROC)glGenQueries;
+    m_glDeleteQueries = (NV_PFNGLDELETEQUERIESPROC)glDeleteQueries;
     m_glGetQueryObjectuiv = (NV_PFNGLGETQUERYOBJECTUIVPROC)glGetQueryObjectuiv;
 #endif
 
@@ -69,6 +74,8 @@ void NvGPUTimer::globalInit(NvGLExtensionsAPI& api) {
     if (api.isExtensionSupported("GL_ARB_occlusion_query")) {
         if (!m_glGenQueries)
             m_glGenQueries = (NV_PFNGLGENQUERIESPROC)api.getGLProcAddress("glGenQueriesARB");
+        if (!m_glDeleteQueries)
+            m_glDeleteQueries = (NV_PFNGLDELETEQUERIESPROC)api.getGLProcAddress("glDeleteQueriesARB");
         if (!m_glGetQueryObjectuiv)
             m_glGetQueryObjectuiv = (NV_PFNGLGETQUERYOBJECTUIVPROC)api.getGLProcAddress("glGetQueryObjectuivARB");
     }
@@ -76,6 +83,8 @@ void NvGPUTimer::globalInit(NvGLExtensionsAPI& api) {
     if (api.isExtensionSupported("GL_EXT_occlusion_query_boolean")) {
         if (!m_glGenQueries)
             m_glGenQueries = (NV_PFNGLGENQUERIESPROC)api.getGLProcAddress("glGenQueriesEXT");
+        if (!m_glDeleteQueries)
+            m_glDeleteQueries = (NV_PFNGLDELETEQUERIESPROC)api.getGLProcAddress("glDeleteQueriesEXT");
         if (!m_glGetQueryObjectuiv)
             m_glGetQueryObjectuiv = (NV_PFNGLGETQUERYOBJECTUIVPROC)api.getGLProcAddress("glGetQueryObjectuivEXT");
     }
@@ -96,6 +105,8 @@ void NvGPUTimer::globalInit(NvGLExtensionsAPI& api) {
 
     if (!m_glGenQueries)
         m_glGenQueries = (NV_PFNGLGENQUERIESPROC)nullGenQueries;
+    if (!m_glDeleteQueries)
+        m_glDeleteQueries = (NV_PFNGLDELETEQUERIESPROC)nullDeleteQueries;
 
     if (!m_glQueryCounter)
         m_glQueryCounter = (NV_PFNGLQUERYCOUNTERPROC)nullQueryCounter;
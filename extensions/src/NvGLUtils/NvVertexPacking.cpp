@@ -0,0 +1,387 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvVertexPacking.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "NvGLUtils/NvVertexPacking.h"
+#include "NV/NvLogs.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define VERTEX_PACKING_SSE 1
+#elif defined(__aarch64__)
+// AArch64 always has the half float conversions; 32 bit NEON may not
+#include <arm_neon.h>
+#define VERTEX_PACKING_NEON 1
+#endif
+
+bool NvVertexPacking::ms_simd = true;
+GLenum NvVertexPacking::ms_halfFloatType = 0;
+
+// The tokens are not in the ES 2.0 headers
+static const GLenum NV_HALF_FLOAT = 0x140B;
+static const GLenum NV_HALF_FLOAT_OES = 0x8D61;
+
+// Floats at and above this round to an infinite half
+static const uint32_t HALF_MAX_BITS = (127 + 16) << 23;
+// The smallest float whose half is normal
+static const uint32_t HALF_MIN_NORMAL_BITS = (127 - 14) << 23;
+// Adding this float rounds the mantissa of a subnormal half into place
+static const uint32_t HALF_SUBNORMAL_MAGIC_BITS = ((127 - 15) + (23 - 10) + 1) << 23;
+
+static inline uint32_t floatBits(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static inline float bitsFloat(uint32_t u)
+{
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// To snorm8, rounding halves up; v*127 + 128.5 is positive, so truncating floors it
+static inline int8_t quantize(float v)
+{
+    return (int8_t)((int32_t)(v * 127.0f + 128.5f) - 128);
+}
+
+static inline void octahedral(float nx, float ny, float nz, float& ex, float& ez)
+{
+    const float inv = 1.0f / ((fabsf(nx) + fabsf(ny)) + fabsf(nz));
+    float ox = nx * inv;
+    float oz = nz * inv;
+    if (ny < 0.0f) {
+        // fold the lower half onto the corners
+        const float fx = (ox < 0.0f) ? -(1.0f - fabsf(oz)) : (1.0f - fabsf(oz));
+        const float fz = (oz < 0.0f) ? -(1.0f - fabsf(ox)) : (1.0f - fabsf(ox));
+        ox = fx;
+        oz = fz;
+    }
+    ex = ox;
+    ez = oz;
+}
+
+static inline void encodeNormal(float nx, float ny, float nz, int8_t* e)
+{
+    float ex, ez;
+    octahedral(nx, ny, nz, ex, ez);
+    e[0] = quantize(ex);
+    e[1] = quantize(ez);
+}
+
+uint16_t NvVertexPacking::floatToHalf(float f)
+{
+    uint32_t u = floatBits(f);
+    const uint32_t sign = u & 0x80000000u;
+    u ^= sign;
+
+    uint32_t h;
+    if (u >= HALF_MAX_BITS) {
+        // infinity, or a quiet NaN
+        h = (u > 0x7F800000u) ? 0x7E00 : 0x7C00;
+    } else if (u < HALF_MIN_NORMAL_BITS) {
+        h = floatBits(bitsFloat(u) + bitsFloat(HALF_SUBNORMAL_MAGIC_BITS)) - HALF_SUBNORMAL_MAGIC_BITS;
+    } else {
+        // rebias the exponent and round the mantissa to nearest even
+        const uint32_t mantissaOdd = (u >> 13) & 1;
+        h = (u + ((uint32_t)(15 - 127) << 23) + 0xFFF + mantissaOdd) >> 13;
+    }
+    return (uint16_t)(h | (sign >> 16));
+}
+
+float NvVertexPacking::halfToFloat(uint16_t h)
+{
+    const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1F;
+    const uint32_t mantissa = h & 0x3FF;
+
+    if (exponent == 0) {
+        const float f = (float)mantissa * (1.0f / 16777216.0f);
+        return sign ? -f : f;
+    }
+    if (exponent == 31)
+        return bitsFloat(sign | 0x7F800000u | (mantissa << 13));
+    return bitsFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+NvPackedHeightVertex NvVertexPacking::pack(float height, float nx, float ny, float nz)
+{
+    NvPackedHeightVertex v;
+    v.height = floatToHalf(height);
+    encodeNormal(nx, ny, nz, v.normal);
+    return v;
+}
+
+NvFloatHeightVertex NvVertexPacking::packFloat(float height, float nx, float ny, float nz)
+{
+    NvFloatHeightVertex v;
+    v.height = height;
+    octahedral(nx, ny, nz, v.normal[0], v.normal[1]);
+    return v;
+}
+
+void NvVertexPacking::unpack(const NvPackedHeightVertex& v, float& height, float* normal)
+{
+    height = halfToFloat(v.height);
+
+    // as GL converts signed normalized bytes, then the shaders' decodeNormal
+    const float ex = (v.normal[0] < -127) ? -1.0f : v.normal[0] / 127.0f;
+    const float ez = (v.normal[1] < -127) ? -1.0f : v.normal[1] / 127.0f;
+    float n[3] = { ex, 1.0f - fabsf(ex) - fabsf(ez), ez };
+    if (n[1] < 0.0f) {
+        n[0] = (1.0f - fabsf(ez)) * (ex >= 0.0f ? 1.0f : -1.0f);
+        n[2] = (1.0f - fabsf(ex)) * (ez >= 0.0f ? 1.0f : -1.0f);
+    }
+    const float len = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+    normal[0] = n[0] / len;
+    normal[1] = n[1] / len;
+    normal[2] = n[2] / len;
+}
+
+#if defined(VERTEX_PACKING_SSE)
+
+// floatToHalf on four floats; the halves are in the low 16 bits of each lane
+static inline __m128i floatToHalf4(__m128 f)
+{
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+    const __m128 sign = _mm_and_ps(f, signMask);
+    const __m128 absf = _mm_xor_ps(f, sign);
+    const __m128i u = _mm_castps_si128(absf);
+
+    const __m128i isRegular = _mm_cmpgt_epi32(_mm_set1_epi32(HALF_MAX_BITS), u);
+    const __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absf, absf));
+    const __m128i special = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+    const __m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32(HALF_MIN_NORMAL_BITS), u);
+    const __m128i magic = _mm_set1_epi32(HALF_SUBNORMAL_MAGIC_BITS);
+    const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absf, _mm_castsi128_ps(magic))), magic);
+
+    const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(u, 13), _mm_set1_epi32(1));
+    const __m128i bias = _mm_set1_epi32((int32_t)(((uint32_t)(15 - 127) << 23) + 0xFFF));
+    const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(u, bias), mantissaOdd), 13);
+
+    const __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    const __m128i h = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, special));
+    return _mm_or_si128(h, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+
+static inline __m128i quantize4(__m128 v)
+{
+    const __m128i q = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(127.0f)), _mm_set1_ps(128.5f)));
+    return _mm_and_si128(_mm_sub_epi32(q, _mm_set1_epi32(128)), _mm_set1_epi32(0xFF));
+}
+
+static inline __m128 abs4(__m128 v)
+{
+    return _mm_andnot_ps(_mm_castsi128_ps(_mm_set1_epi32(0x80000000)), v);
+}
+
+// Four packed vertices from SoA heights and normals
+static inline void pack4(__m128 height, __m128 nx, __m128 ny, __m128 nz, NvPackedHeightVertex* out)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signBit = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+
+    const __m128 inv = _mm_div_ps(one, _mm_add_ps(_mm_add_ps(abs4(nx), abs4(ny)), abs4(nz)));
+    __m128 ox = _mm_mul_ps(nx, inv);
+    __m128 oz = _mm_mul_ps(nz, inv);
+
+    const __m128 lower = _mm_cmplt_ps(ny, zero);
+    const __m128 fx = _mm_xor_ps(_mm_sub_ps(one, abs4(oz)), _mm_and_ps(_mm_cmplt_ps(ox, zero), signBit));
+    const __m128 fz = _mm_xor_ps(_mm_sub_ps(one, abs4(ox)), _mm_and_ps(_mm_cmplt_ps(oz, zero), signBit));
+    ox = _mm_or_ps(_mm_and_ps(lower, fx), _mm_andnot_ps(lower, ox));
+    oz = _mm_or_ps(_mm_and_ps(lower, fz), _mm_andnot_ps(lower, oz));
+
+    const __m128i h = _mm_and_si128(floatToHalf4(height), _mm_set1_epi32(0xFFFF));
+    const __m128i word = _mm_or_si128(h, _mm_or_si128(_mm_slli_epi32(quantize4(ox), 16), _mm_slli_epi32(quantize4(oz), 24)));
+    _mm_storeu_si128((__m128i*)out, word);
+}
+
+#elif defined(VERTEX_PACKING_NEON)
+
+static inline void pack4(float32x4_t height, float32x4_t nx, float32x4_t ny, float32x4_t nz, NvPackedHeightVertex* out)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+
+    const float32x4_t inv = vdivq_f32(one, vaddq_f32(vaddq_f32(vabsq_f32(nx), vabsq_f32(ny)), vabsq_f32(nz)));
+    float32x4_t ox = vmulq_f32(nx, inv);
+    float32x4_t oz = vmulq_f32(nz, inv);
+
+    const uint32x4_t lower = vcltq_f32(ny, zero);
+    const float32x4_t rx = vsubq_f32(one, vabsq_f32(oz));
+    const float32x4_t rz = vsubq_f32(one, vabsq_f32(ox));
+    const float32x4_t fx = vbslq_f32(vcltq_f32(ox, zero), vnegq_f32(rx), rx);
+    const float32x4_t fz = vbslq_f32(vcltq_f32(oz, zero), vnegq_f32(rz), rz);
+    ox = vbslq_f32(lower, fx, ox);
+    oz = vbslq_f32(lower, fz, oz);
+
+    const float32x4_t scale = vdupq_n_f32(127.0f);
+    const float32x4_t offset = vdupq_n_f32(128.5f);
+    const int32x4_t qx = vsubq_s32(vcvtq_s32_f32(vaddq_f32(vmulq_f32(ox, scale), offset)), vdupq_n_s32(128));
+    const int32x4_t qz = vsubq_s32(vcvtq_s32_f32(vaddq_f32(vmulq_f32(oz, scale), offset)), vdupq_n_s32(128));
+
+    const uint32x4_t h = vmovl_u16(vreinterpret_u16_f16(vcvt_f16_f32(height)));
+    const uint32x4_t bx = vshlq_n_u32(vandq_u32(vreinterpretq_u32_s32(qx), vdupq_n_u32(0xFF)), 16);
+    const uint32x4_t bz = vshlq_n_u32(vandq_u32(vreinterpretq_u32_s32(qz), vdupq_n_u32(0xFF)), 24);
+    vst1q_u32((uint32_t*)out, vorrq_u32(h, vorrq_u32(bx, bz)));
+}
+
+#endif
+
+void NvVertexPacking::packNormals(const float* heights, const float* normals, int32_t count, NvPackedHeightVertex* out)
+{
+    int32_t i = 0;
+#if defined(VERTEX_PACKING_SSE)
+    if (ms_simd) {
+        for (; i+4 <= count; i+=4) {
+            // x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 to x, y, z
+            const __m128 a = _mm_loadu_ps(normals + 3*i);
+            const __m128 b = _mm_loadu_ps(normals + 3*i + 4);
+            const __m128 c = _mm_loadu_ps(normals + 3*i + 8);
+            const __m128 nx = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,3,0));
+            const __m128 ny = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0,0,1,1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+            const __m128 nz = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1,1,2,2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3,3,0,0)), _MM_SHUFFLE(2,0,2,0));
+            pack4(_mm_loadu_ps(heights + i), nx, ny, nz, out + i);
+        }
+    }
+#elif defined(VERTEX_PACKING_NEON)
+    if (ms_simd) {
+        for (; i+4 <= count; i+=4) {
+            const float32x4x3_t n = vld3q_f32(normals + 3*i);
+            pack4(vld1q_f32(heights + i), n.val[0], n.val[1], n.val[2], out + i);
+        }
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = pack(heights[i], normals[3*i], normals[3*i+1], normals[3*i+2]);
+}
+
+void NvVertexPacking::packNormals(const float* heights, const float* normals, int32_t count, NvFloatHeightVertex* out)
+{
+    for (int32_t i = 0; i < count; i++)
+        out[i] = packFloat(heights[i], normals[3*i], normals[3*i+1], normals[3*i+2]);
+}
+
+void NvVertexPacking::writeNormals(const float* heights, const float* normals, int32_t count, void* out)
+{
+    if (isSupported())
+        packNormals(heights, normals, count, (NvPackedHeightVertex*)out);
+    else
+        packNormals(heights, normals, count, (NvFloatHeightVertex*)out);
+}
+
+void NvVertexPacking::packGradients(const float* heights, const float* gradients, int32_t count, NvPackedHeightVertex* out)
+{
+    int32_t i = 0;
+#if defined(VERTEX_PACKING_SSE)
+    if (ms_simd) {
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (; i+4 <= count; i+=4) {
+            const __m128 a = _mm_loadu_ps(gradients + 2*i);
+            const __m128 b = _mm_loadu_ps(gradients + 2*i + 4);
+            pack4(_mm_loadu_ps(heights + i), _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)), one,
+                _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)), out + i);
+        }
+    }
+#elif defined(VERTEX_PACKING_NEON)
+    if (ms_simd) {
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        for (; i+4 <= count; i+=4) {
+            const float32x4x2_t g = vld2q_f32(gradients + 2*i);
+            pack4(vld1q_f32(heights + i), g.val[0], one, g.val[1], out + i);
+        }
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = pack(heights[i], gradients[2*i], 1.0f, gradients[2*i+1]);
+}
+
+const char* NvVertexPacking::getSIMDName()
+{
+#if defined(VERTEX_PACKING_SSE)
+    return ms_simd ? "SSE2" : "scalar";
+#elif defined(VERTEX_PACKING_NEON)
+    return ms_simd ? "NEON" : "scalar";
+#else
+    return "scalar";
+#endif
+}
+
+void NvVertexPacking::setAttribPointers(GLuint heightAttr, GLuint normalAttr, size_t offset)
+{
+    if (isSupported()) {
+        const GLsizei stride = sizeof(NvPackedHeightVertex);
+        glVertexAttribPointer(heightAttr, 1, ms_halfFloatType, GL_FALSE, stride, (const GLvoid*)offset);
+        glVertexAttribPointer(normalAttr, 2, GL_BYTE, GL_TRUE, stride, (const GLvoid*)(offset + 2));
+    } else {
+        const GLsizei stride = sizeof(NvFloatHeightVertex);
+        glVertexAttribPointer(heightAttr, 1, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)offset);
+        glVertexAttribPointer(normalAttr, 2, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)(offset + sizeof(float)));
+    }
+}
+
+void NvVertexPacking::globalInit(NvGLExtensionsAPI& api)
+{
+    // The extension headers differ between platforms, so the version is read
+    // from the string rather than from the GL_VERSION_x_y macros
+    const char* version = (const char*)glGetString(GL_VERSION);
+    const bool es = version && (strstr(version, "OpenGL ES") != NULL);
+    int32_t major = 0, minor = 0;
+    if (version) {
+        const char* digits = version;
+        while (*digits && (*digits < '0' || *digits > '9'))
+            digits++;
+        sscanf(digits, "%d.%d", &major, &minor);
+    }
+    const int32_t ver = major * 10 + minor;
+
+    if (ver >= 30)
+        ms_halfFloatType = NV_HALF_FLOAT;
+    else if (es && api.isExtensionSupported("GL_OES_vertex_half_float"))
+        ms_halfFloatType = NV_HALF_FLOAT_OES;
+    else if (!es && api.isExtensionSupported("GL_ARB_half_float_vertex"))
+        ms_halfFloatType = NV_HALF_FLOAT;
+    else
+        ms_halfFloatType = 0;
+
+    LOGI("NvVertexPacking: %s, %s", getSIMDName(), ms_halfFloatType ? "half float attributes" : "no half float attributes, streaming floats");
+}
@@ -37,6 +37,7 @@
 #include "NvAppBase/NvInputTransformer.h"
 #include "NvAssetLoader/NvAssetLoader.h"
 #include "NvGLUtils/NvGLSLProgram.h"
+#include "NvGLUtils/NvGLSLProgramRegistry.h"
 #include "NvGLUtils/NvImage.h"
 #include "NvUI/NvTweakBar.h"
 #include "NV/NvLogs.h"
@@ -76,6 +77,7 @@ Bloom::Bloom(NvPlatformContext* platform)
     mBlurWidth = 4.0f;
     mBloomIntensity = 3.0f;
     mAutoSpin = true;
+    mPrograms = NULL;
 }
 
 Bloom::~Bloom()
@@ -103,19 +105,24 @@ void Bloom::initRendering(void) {
 
     NvAssetLoaderAddSearchPath("Bloom");
 
-    mQuadProgram = NvGLSLProgram::createFromFiles("shaders/quad.vp", "shaders/quad.fp");
-    mBlurProgram = NvGLSLProgram::createFromFiles("shaders/fullscreen_quad.vp", "shaders/blur.fp");
-    mCombineProgram = NvGLSLProgram::createFromFiles("shaders/fullscreen_quad.vp", "shaders/combine.fp");
-    mDownfilterProgram = NvGLSLProgram::createFromFiles("shaders/fullscreen_quad.vp", "shaders/downfilter.fp");
+    // declare all programs up front so that their builds overlap
+    mPrograms = new NvGLSLProgramRegistry(this);
+
+    mQuadProgram = mPrograms->addFromFiles("quad", "shaders/quad.vp", "shaders/quad.fp");
+    mBlurProgram = mPrograms->addFromFiles("blur", "shaders/fullscreen_quad.vp", "shaders/blur.fp");
+    mCombineProgram = mPrograms->addFromFiles("combine", "shaders/fullscreen_quad.vp", "shaders/combine.fp");
+    mDownfilterProgram = mPrograms->addFromFiles("downfilter", "shaders/fullscreen_quad.vp", "shaders/downfilter.fp");
 
     const NvGfxAPIVersion& api = getGLContext()->getConfiguration().apiVer;
 
     if ((api.api == NvGfxAPI::GLES) && (api.majVersion == 3)) {
-        mGateProgram = NvGLSLProgram::createFromFiles("shaders/gate_es3.vp", "shaders/gate_es3.fp");
+        mGateProgram = mPrograms->addFromFiles("gate", "shaders/gate_es3.vp", "shaders/gate_es3.fp");
     } else {
-        mGateProgram = NvGLSLProgram::createFromFiles("shaders/gate.vp", "shaders/gate.fp");
+        mGateProgram = mPrograms->addFromFiles("gate", "shaders/gate.vp", "shaders/gate.fp");
     }
-    mGateShadowProgram = NvGLSLProgram::createFromFiles("shaders/gate_shadow.vp", "shaders/gate_shadow.fp");
+    mGateShadowProgram = mPrograms->addFromFiles("gate_shadow", "shaders/gate_shadow.vp", "shaders/gate_shadow.fp");
+
+    mPrograms->warmUp();
 
     createOSDVBOs();
     createGateVBOs();
@@ -144,6 +151,12 @@ void Bloom::initRendering(void) {
     CHECK_GL_ERROR();
 }
 
+void Bloom::shutdownRendering(void) {
+    // release the programs along with the rest of the GL resources
+    delete mPrograms;
+    mPrograms = NULL;
+}
+
 void Bloom::initUI(void) {
     if (mTweakBar) {
         NvTweakVarBase *var;
@@ -39,6 +39,7 @@
 
 class NvStopWatch;
 class NvGLSLProgram;
+class NvGLSLProgramRegistry;
 class NvFramerateCounter;
 
 class Bloom : public NvSampleApp
@@ -48,6 +49,7 @@ public:
     ~Bloom();
     
     void initRendering(void);
+    void shutdownRendering(void);
     void initUI(void);
     void draw(void);
     void reshape(int32_t width, int32_t height);
@@ -102,6 +104,9 @@ private:
 
     nv::vec3f mLightPosition;
 
+    // owns all of the programs below
+    NvGLSLProgramRegistry* mPrograms;
+
     // service shaders
     NvGLSLProgram* mQuadProgram;
 
@@ -36,20 +36,22 @@
 #include "NvAppBase/NvInputTransformer.h"
 #include "NvAssetLoader/NvAssetLoader.h"
 #include "NvGLUtils/NvGLSLProgram.h"
+#include "NvGLUtils/NvGLSLPreprocessor.h"
+#include "NvGLUtils/NvGLSLShaderWatcher.h"
 #include "NvUI/NvTweakBar.h"
 #include "NV/NvLogs.h"
 #include <string>
 
 #include "ParticleSystem.h"
 
-extern std::string loadShaderSourceWithUniformTag(const char* uniformsFile, const char* srcFile);
-
 ComputeParticles::ComputeParticles(NvPlatformContext* platform) 
     : NvSampleApp(platform, "Compute Particles Samples"),
     mEnableAttractor(false),
     mAnimate(true),
     mReset(false),
-    mTime(0.0f)
+    mTime(0.0f),
+    mShaders(NULL),
+    mShaderWatcher(NULL)
 {
     m_transformer->setTranslationVec(nv::vec3f(0.0f, 0.0f, -3.0f));
 
@@ -78,17 +80,15 @@ void ComputeParticles::initRendering(void) {
 
     NvAssetLoaderAddSearchPath("ComputeParticles");
 
-    std::string renderVS = loadShaderSourceWithUniformTag("shaders/uniforms.h", "shaders/renderVS.glsl");
-    mRenderProg = new NvGLSLProgram;
-    
-    int32_t len;
-    NvGLSLProgram::ShaderSourceItem sources[2];
+    mShaders = new NvGLSLPreprocessor;
+    mShaderWatcher = new NvGLSLShaderWatcher(mShaders);
+
+    NvGLSLPreprocessor::ShaderFile sources[2];
+    sources[0].filename = "shaders/renderVS.glsl";
     sources[0].type = GL_VERTEX_SHADER;
-    sources[0].src = renderVS.c_str();
+    sources[1].filename = "shaders/renderFS.glsl";
     sources[1].type = GL_FRAGMENT_SHADER;
-    sources[1].src = NvAssetLoaderRead("shaders/renderFS.glsl", len);
-    mRenderProg->setSourceFromStrings(sources, 2);
-    NvAssetLoaderFree((char*)sources[1].src);
+    mRenderProg = mShaders->createProgram(sources, 2);
 
     //create ubo and initialize it with the structure data
     glGenBuffers( 1, &mUBO);
@@ -104,7 +104,7 @@ void ComputeParticles::initRendering(void) {
     // For now, scale back the particle count on mobile.
     int32_t particleCount = isMobilePlatform() ? (mNumParticles >> 2) : mNumParticles;
 
-    mParticles = new ParticleSystem(particleCount);
+    mParticles = new ParticleSystem(particleCount, *mShaders);
 
     int cx, cy, cz;
     glGetIntegeri_v( GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &cx );
@@ -142,8 +142,23 @@ void ComputeParticles::reshape(int32_t width, int32_t height)
     CHECK_GL_ERROR();
 }
 
+void ComputeParticles::shutdownRendering(void)
+{
+    delete mParticles;
+    mParticles = NULL;
+
+    delete mShaderWatcher;
+    mShaderWatcher = NULL;
+
+    delete mShaders;
+    mShaders = NULL;
+}
+
 void ComputeParticles::draw(void)
 {
+    // pick up shader edits made while the sample is running
+    mShaderWatcher->poll();
+
     glClearColor( 0.25f, 0.25f, 0.25f, 1.0f);
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -219,46 +234,6 @@ void ComputeParticles::draw(void)
 }
 
 
-// A replacement for the ARB_shader_include extension, which is not widely supported
-// This loads a "header" file (uniformsFile) and a "source" file (srcFile).  It scans
-// the source file for "#UNIFORMS" and replaces this tag with the contents of the
-// uniforms file.  Limited, but functional for the cases used here
-std::string loadShaderSourceWithUniformTag(const char* uniformsFile, const char* srcFile) {
-    int32_t len;
-
-    char *uniformsStr = NvAssetLoaderRead(uniformsFile, len);
-    if (!uniformsStr)
-        return "";
-
-    char *srcStr = NvAssetLoaderRead(srcFile, len);
-    if (!srcStr)
-        return "";
-
-    std::string dest = "";
-
-    const char* uniformTag = "#UNIFORMS";
-
-    char* uniformTagStart = strstr(srcStr, uniformTag);
-
-    if (uniformTagStart) {
-        // NULL the start of the tag
-        *uniformTagStart = 0;
-        dest += srcStr; // source up to tag
-        dest += "\n";
-        dest += uniformsStr;
-        dest += "\n";
-        char* uniformTagEnd = uniformTagStart + strlen(uniformTag);
-        dest += uniformTagEnd;
-    } else {
-        dest += srcStr;
-    }
-
-    NvAssetLoaderFree(uniformsStr);
-    NvAssetLoaderFree(srcStr);
-
-    return dest;
-}
-
 NvAppBase* NvAppFactory(NvPlatformContext* platform) {
     return new ComputeParticles(platform);
 }
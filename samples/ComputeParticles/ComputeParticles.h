@@ -47,6 +47,8 @@
 
 class NvFramerateCounter;
 class NvGLSLProgram;
+class NvGLSLPreprocessor;
+class NvGLSLShaderWatcher;
 class ParticleSystem;
 
 class ComputeParticles : public NvSampleApp
@@ -56,6 +58,7 @@ public:
     ~ComputeParticles();
     
     void initRendering(void);
+    void shutdownRendering(void);
     void initUI(void);
     void draw(void);
     void reshape(int32_t width, int32_t height);
@@ -75,6 +78,9 @@ private:
     bool mAnimate;
     bool mReset;
     float mTime;
+
+    NvGLSLPreprocessor* mShaders;
+    NvGLSLShaderWatcher* mShaderWatcher;
 };
 
 #endif // COMPUTE_PARTICLES_H
\ No newline at end of file
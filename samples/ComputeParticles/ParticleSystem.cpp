@@ -38,12 +38,11 @@
 #define CPP 1
 #include "NV/NvLogs.h"
 #include "NvAssetLoader/NvAssetLoader.h"
+#include "NvGLUtils/NvGLSLPreprocessor.h"
 #include "NV/NvShaderMappings.h"
 #include "noise.h"
 #include "uniforms.h"
 
-extern std::string loadShaderSourceWithUniformTag(const char* uniformsFile, const char* srcFile);
-
 static float frand()
 {
     return rand() / (float) RAND_MAX;
@@ -54,10 +53,12 @@ static float sfrand()
     return frand()*2.0f-1.0f;
 }
 
-ParticleSystem::ParticleSystem(size_t size) :
+ParticleSystem::ParticleSystem(size_t size, NvGLSLPreprocessor& shaders) :
     m_size(size),
+    m_shaders(&shaders),
     m_noiseTex(0),
     m_noiseSize(16),
+    m_programPipeline(0),
     m_updateProg(0)
 {
     // Split the velocities and positions, as for now the
@@ -108,15 +109,40 @@ static inline const char *GetShaderStageName(GLenum target)
     return "";
 }
 
-GLuint ParticleSystem::createShaderPipelineProgram(GLuint target, const char* src)
+bool ParticleSystem::reloadUpdateProgram(const char* src, void* data)
+{
+    return ((ParticleSystem*)data)->createUpdateProgram(src);
+}
+
+bool ParticleSystem::createUpdateProgram(const char* src)
 {
-    GLuint object;
-    GLint status;
+    GLuint object = glCreateShaderProgramv(GL_COMPUTE_SHADER, 1, (const GLchar **)&src);
 
-    object = glCreateShaderProgramv( target, 1, (const GLchar **)&src );
+    GLint status = GL_FALSE;
+    glGetProgramiv(object, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint logLength = 0;
+        glGetProgramiv(object, GL_INFO_LOG_LENGTH, &logLength);
+        if (logLength > 1) {
+            char *log = new char [logLength];
+            glGetProgramInfoLog(object, logLength, 0, log);
+            LOGI("Could not build %s:\n%s\n", GetShaderStageName(GL_COMPUTE_SHADER), log);
+            delete [] log;
+        }
+        // keep running the previous program, if there is one
+        glDeleteProgram(object);
+        return false;
+    }
+
+    if (m_programPipeline)
+        glDeleteProgramPipelines(1, &m_programPipeline);
+    if (m_updateProg)
+        glDeleteProgram(m_updateProg);
+    m_updateProg = object;
 
+    glGenProgramPipelines( 1, &m_programPipeline);
     glBindProgramPipeline(m_programPipeline);
-    glUseProgramStages(m_programPipeline, GL_COMPUTE_SHADER_BIT, object);
+    glUseProgramStages(m_programPipeline, GL_COMPUTE_SHADER_BIT, m_updateProg);
     glValidateProgramPipeline(m_programPipeline);
     glGetProgramPipelineiv(m_programPipeline, GL_VALIDATE_STATUS, &status);
 
@@ -129,25 +155,6 @@ GLuint ParticleSystem::createShaderPipelineProgram(GLuint target, const char* sr
         delete [] log;
     }
 
-    glBindProgramPipeline(0);
-
-    return object;
-}
-
-void ParticleSystem::loadShaders()
-{
-    if (m_updateProg) {
-        glDeleteProgram(m_updateProg);
-        m_updateProg = 0;
-    }
-
-    glGenProgramPipelines( 1, &m_programPipeline);
-
-    std::string src = loadShaderSourceWithUniformTag("shaders/uniforms.h", "shaders/particlesCS.glsl");
-    m_updateProg = createShaderPipelineProgram(GL_COMPUTE_SHADER, src.c_str());
-
-    glBindProgramPipeline(m_programPipeline);
-
     GLint loc = glGetUniformLocation(m_updateProg, "invNoiseSize");
     glProgramUniform1f(m_updateProg, loc, 1.0f / m_noiseSize);
 
@@ -155,13 +162,25 @@ void ParticleSystem::loadShaders()
     glProgramUniform1i(m_updateProg, loc, 0);
 
     glBindProgramPipeline(0);
+
+    return true;
+}
+
+void ParticleSystem::loadShaders()
+{
+    // rebuilt in place whenever particlesCS.glsl or one of its includes is saved
+    m_shaders->unwatchSource(this);
+    m_shaders->watchSource("shaders/particlesCS.glsl", NULL, reloadUpdateProgram, this);
 }
 
 ParticleSystem::~ParticleSystem()
 {
+    m_shaders->unwatchSource(this);
+
     delete m_pos;
     delete m_vel;
 
+    glDeleteProgramPipelines(1, &m_programPipeline);
     glDeleteProgram(m_updateProg);
 }
 
@@ -38,13 +38,14 @@
 #include "ShaderBuffer.h"
 
 class NvGLSLProgram;
+class NvGLSLPreprocessor;
 
 using namespace nv;
 
 class ParticleSystem
 {
 public:
-    ParticleSystem(size_t size);
+    ParticleSystem(size_t size, NvGLSLPreprocessor& shaders);
     ~ParticleSystem();
 
     void loadShaders();
@@ -58,9 +59,11 @@ public:
     ShaderBuffer<uint32_t> *getIndexBuffer() { return m_indices; }
 
 private:
-    GLuint createShaderPipelineProgram(GLuint target, const char* src);
+    static bool reloadUpdateProgram(const char* src, void* data);
+    bool createUpdateProgram(const char* src);
 
     size_t m_size;
+    NvGLSLPreprocessor* m_shaders;
     ShaderBuffer<vec4f> *m_pos;
     ShaderBuffer<vec4f> *m_vel;
     ShaderBuffer<uint32_t> *m_indices;
@@ -33,7 +33,7 @@
 //----------------------------------------------------------------------------------
 #version 430
 
-#UNIFORMS
+#include "uniforms.h"
 
 layout( std140, binding=1 ) buffer Pos {
     vec4 pos[];
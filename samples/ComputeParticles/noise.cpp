@@ -32,41 +32,19 @@
 //
 //----------------------------------------------------------------------------------
 #include "NV/NvPlatformGL.h"
-#include <stdlib.h>
-
-static inline float frand()
-{
-    return rand() / (float) RAND_MAX;
-}
+#include "NvAppBase/NvNoiseVolume.h"
 
+// A volume of independent random values in [-1, 1] per channel, generated (or loaded
+// from the noise cache) by NvNoiseVolume and uploaded in one call.  GL_RGBA8_SNORM is
+// stored as bytes, any other format as half floats
 GLuint createNoiseTexture4f3D(int w, int h, int d, GLint internalFormat)
 {
-    float *data = new float [w*h*d*4];
-    float *ptr = data;
-    for(int z=0; z<d; z++) {
-        for(int y=0; y<h; y++) {
-            for(int x=0; x<w; x++) {
-              *ptr++ = frand()*2.0f-1.0f;
-              *ptr++ = frand()*2.0f-1.0f;
-              *ptr++ = frand()*2.0f-1.0f;
-              *ptr++ = frand()*2.0f-1.0f;
-            }
-        }
-    }
-
-    GLuint tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_3D, tex);
-
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
-
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexImage3D(GL_TEXTURE_3D, 0, internalFormat, w, h, d, 0, GL_RGBA, GL_FLOAT, data);
-
-    delete [] data;
-    return tex;
+    NvNoiseVolume::Desc desc;
+    desc.type = NvNoiseVolume::TYPE_VALUE;
+    desc.format = (internalFormat == GL_RGBA8_SNORM) ? NvNoiseVolume::FORMAT_SNORM8 : NvNoiseVolume::FORMAT_HALF;
+    desc.width = w;
+    desc.height = h;
+    desc.depth = d;
+    desc.channels = 4;
+    return NvNoiseVolume::createTexture(desc);
 }
@@ -36,21 +36,21 @@
 #include "NvAppBase/NvInputTransformer.h"
 #include "NvAssetLoader/NvAssetLoader.h"
 #include "NvGLUtils/NvGLSLProgram.h"
+#include "NvGLUtils/NvGLSLPreprocessor.h"
 #include "NvGLUtils/NvImage.h"
 #include "NvUI/NvTweakBar.h"
 #include "NV/NvLogs.h"
+#include "NV/NvStopWatch.h"
 
 #undef APIENTRY
 #include "Wave.h"
 #include "WaveSimRenderer.h"
+#include "WaveSimBenchmark.h"
 
 
 const uint32_t MAX_GRID_SIZE = WATER_GRID_SIZE[0].m_value;
 
 
-extern std::string loadShaderSourceWithUniformTag(const char* uniformsFile, const char* srcFile);
-
-
 ComputeWaterSimulation::ComputeWaterSimulation(NvPlatformContext* platform) 
 	: NvSampleApp(platform, "Compute Water Surface"),
 	mReset(false),
@@ -69,13 +69,19 @@ ComputeWaterSimulation::ComputeWaterSimulation(NvPlatformContext* platform)
 
 	mPrevFrameUseComputeShader = mSettings.UseComputeShader;
 
+	mWaveSteps.setStepFunction(stepWavesTask, this, "Wave steps");
+
 	mPrevNumWaves = mNumWaves = WATER_NUM_THREADS[0].m_value;
 	mPrevGridSize = mGridSize = WATER_GRID_SIZE[1].m_value;
 	mWaterShaderType = WATER_SHADER_TYPE[0].m_value;
+
+	// -wavebench times the CPU solver over grid sizes and thread counts, then exits
+	addBenchmarkMode("-wavebench", runWaveSimBenchmark);
 }
 
 ComputeWaterSimulation::~ComputeWaterSimulation()
 {
+	mWaveSteps.wait();
 	LOGI("ComputeWaterSimulation: destroyed\n");
 }
 
@@ -153,11 +159,12 @@ void ComputeWaterSimulation::initRendering(void) {
 	mWaterShader[WATER_SHADER_FRESNEL] = NvGLSLProgram::createFromFiles("shaders/water.vert", "shaders/waterFresnel.frag");
 	
 	// load compute shaders
+	NvGLSLPreprocessor preprocessor;
 	std::string src;
-	src = loadShaderSourceWithUniformTag("shaders/uniforms.h", "shaders/WaterTransformPass.glsl");
+	preprocessor.preprocess("shaders/WaterTransformPass.glsl", NULL, src);
 	createShaderPipelineProgram(GL_COMPUTE_SHADER, src.c_str(), mTransformPipeline, mTransformProgram);
 
-	src = loadShaderSourceWithUniformTag("shaders/uniforms.h", "shaders/WaterGradientsPass.glsl");
+	preprocessor.preprocess("shaders/WaterGradientsPass.glsl", NULL, src);
 	createShaderPipelineProgram(GL_COMPUTE_SHADER, src.c_str(), mGradientsPipeline, mGradientsProgram);
 
 	mSkyTexture = NvImage::UploadTextureFromDDSFile("sky/day.dds");
@@ -176,6 +183,17 @@ void ComputeWaterSimulation::initRendering(void) {
 		glBindBuffer(GL_ARRAY_BUFFER, mVelocityBuffer[i]);
 		glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		// intermediate heights between the two compute passes, and the gradients they render with
+		glGenBuffers(1, &mScratchHeightBuffer[i]);
+		glBindBuffer(GL_ARRAY_BUFFER, mScratchHeightBuffer[i]);
+		glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glGenBuffers(1, &mGradientsBuffer[i]);
+		glBindBuffer(GL_ARRAY_BUFFER, mGradientsBuffer[i]);
+		glBufferData(GL_ARRAY_BUFFER, size * 2, NULL, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
 	initWaves(mNumWaves);
@@ -241,6 +259,9 @@ void ComputeWaterSimulation::draw(void)
 	glClearColor( 0.25f, 0.25f, 0.25f, 1.0f);
 	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	// nothing below may touch the CPU surfaces while their steps are running
+	finishWaveSteps();
+
 	if (mReset) {
 		mReset = false;
         doReset();
@@ -315,7 +336,7 @@ void ComputeWaterSimulation::runWaterSimulation()
 				glBindBuffer(GL_SHADER_STORAGE_BUFFER, mHeightBuffer[i]);
 				ptr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 
                     0, mWaves[i]->getSimulation().m_heightFieldSize, GL_MAP_WRITE_BIT);
-				memcpy(ptr, mWaves[i]->getSimulation().getHeightField(), mWaves[i]->getSimulation().m_heightFieldSize);
+				mWaves[i]->getSimulation().getHeightField().copyTo((float*)ptr);
 				glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 				glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
@@ -323,7 +344,7 @@ void ComputeWaterSimulation::runWaterSimulation()
 				glBindBuffer(GL_SHADER_STORAGE_BUFFER, mVelocityBuffer[i]);
 				ptr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 
                     0, mWaves[i]->getSimulation().m_heightFieldSize, GL_MAP_WRITE_BIT);
-				memcpy(ptr, mWaves[i]->getSimulation().getVelocity(), mWaves[i]->getSimulation().m_heightFieldSize);
+				mWaves[i]->getSimulation().getVelocity().copyTo((float*)ptr);
 				glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 				glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 			}
@@ -338,7 +359,7 @@ void ComputeWaterSimulation::runWaterSimulation()
 				glBindBuffer(GL_SHADER_STORAGE_BUFFER, mHeightBuffer[i]);
 				ptr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 
                     0, mWaves[i]->getSimulation().m_heightFieldSize, GL_MAP_READ_BIT);
-				memcpy(mWaves[i]->getSimulation().getHeightField(), ptr, mWaves[i]->getSimulation().m_heightFieldSize);
+				mWaves[i]->getSimulation().getHeightField().copyFrom((const float*)ptr);
 				glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 				glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
@@ -346,16 +367,17 @@ void ComputeWaterSimulation::runWaterSimulation()
 				glBindBuffer(GL_SHADER_STORAGE_BUFFER, mVelocityBuffer[i]);
 				ptr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 
                     0, mWaves[i]->getSimulation().m_heightFieldSize, GL_MAP_READ_BIT);
-				memcpy(mWaves[i]->getSimulation().getVelocity(), ptr, mWaves[i]->getSimulation().m_heightFieldSize);
+				mWaves[i]->getSimulation().getVelocity().copyFrom((const float*)ptr);
 				glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 				glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 			}
 
-			//HACK: simulate once even if animation disabled
-			bool mCurAnimate = mSettings.Animate;
-			mSettings.Animate = true;
-			simulateWaterCPU();
-			mSettings.Animate = mCurAnimate;
+			// draw the state taken over from the GPU, even if animation is disabled
+			for(uint32_t i = 0; i < mNumWaves; i++)
+			{
+				mWaves[i]->getSimulation().calcGradients();
+				mWaves[i]->updateBufferData();
+			}
 		}
 
 		mPrevFrameUseComputeShader = mSettings.UseComputeShader;
@@ -377,39 +399,70 @@ void ComputeWaterSimulation::runWaterSimulation()
 
 void ComputeWaterSimulation::simulateWaterCPU()
 {
-	Wave::resetThreadStopWatch();
+	if (!mSettings.Animate)
+		return;
 
-	if (mSettings.Animate)
+	if (mDisturbance.w > 0.0f)
 	{
-		if (mDisturbance.w > 0.0f)
+		nv::vec3f point(mDisturbance.x, 0.0f, mDisturbance.y);
+		nv::vec2f gridPos;
+		for(uint32_t i = 0; i < mNumWaves; i++)
 		{
-			nv::vec3f point(mDisturbance.x, 0.0f, mDisturbance.y);
-			nv::vec2f gridPos;
-			for(uint32_t i = 0; i < mNumWaves; i++)
+			if (mWaves[i]->mapPointXZToGridPos(point, gridPos))
 			{
-				if (mWaves[i]->mapPointXZToGridPos(point, gridPos))
-				{
-					mWaves[i]->getSimulation().addDisturbance(gridPos.x, gridPos.y,
-						mDisturbance.z * mWaveScale, mDisturbance.w * mWaveScale);
-				}
+				mWaves[i]->getSimulation().addDisturbance(gridPos.x, gridPos.y,
+					mDisturbance.z * mWaveScale, mDisturbance.w * mWaveScale);
 			}
 		}
+	}
+
+	for(uint32_t i = 0; i < mNumWaves; i++)
+	{
+		mWaves[i]->getSimulation().setDamping(mSettings.Damping);
+	}
 
+	// the steps due run as one job while this frame draws; their results are drawn from the next frame
+	if (mWaveSteps.advance(getFrameDeltaTime()) > 0)
+	{
 		for(uint32_t i = 0; i < mNumWaves; i++)
 		{
-			mWaves[i]->getSimulation().setDamping(mSettings.Damping);
-			mWaves[i]->startSimulationThread();
+			mWaves[i]->getRenderer().beginUpdate();
 		}
+		mWaveSteps.start();
 	}
 	else
 	{
-		Wave::pauseAllSimulationThreads();
+		// no step is due; draw the last one further along
+		for(uint32_t i = 0; i < mNumWaves; i++)
+		{
+			mWaves[i]->getRenderer().updateBufferData(mWaveSteps.getAlpha());
+		}
 	}
+}
 
-	Wave::syncAllSimulationThreads();
-	for(uint32_t i = 0; i < mNumWaves; i++)
+void ComputeWaterSimulation::finishWaveSteps()
+{
+	mWaveSteps.wait();
+	for(uint32_t i = 0; mWaves && i < mNumWaves; i++)
 	{
-		mWaves[i]->updateBufferData();
+		mWaves[i]->getRenderer().endUpdate();
+	}
+}
+
+void ComputeWaterSimulation::stepWavesTask(void* data, float dt, int32_t step, int32_t steps)
+{
+	ComputeWaterSimulation* app = (ComputeWaterSimulation*)data;
+
+	// the surfaces step concurrently; only the last step of a batch is streamed to the renderers,
+	// interpolated to where the frames that draw it fall between steps
+	const bool output = (step == steps-1);
+	for(uint32_t i = 0; i < app->mNumWaves; i++)
+	{
+		app->mWaves[i]->startSimulation(output, app->mWaveSteps.getAlpha());
+	}
+	for(uint32_t i = 0; i < app->mNumWaves; i++)
+	{
+		app->mWaves[i]->waitForSimulation();
 	}
 }
 
@@ -446,10 +499,8 @@ void ComputeWaterSimulation::simulateWaterGPU()
 			loc = glGetUniformLocation(mTransformProgram, "Disturbance");
 			glProgramUniform4fv(mTransformProgram, loc, 1, disturbance[i]._array);
 
-			GLuint heightBuffer = mWaves[i]->getRenderer().m_waterYVBO[mWaves[i]->getRenderer().m_renderCurrent];
-
 			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mHeightBuffer[i]);
-			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, heightBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, mScratchHeightBuffer[i]);
 			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, mVelocityBuffer[i]);
 			
 			glDispatchCompute((mGridSize / WORK_GROUP_SIZE) + 1, (mGridSize / WORK_GROUP_SIZE) + 1, 1);
@@ -478,11 +529,8 @@ void ComputeWaterSimulation::simulateWaterGPU()
 
 	for(uint32_t i = 0; i < mNumWaves; i++)
 	{
-		GLuint heightBuffer = mWaves[i]->getRenderer().m_waterYVBO[mWaves[i]->getRenderer().m_renderCurrent];
-		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, heightBuffer);
-
-		GLuint gradientsBuffer = mWaves[i]->getRenderer().m_waterGVBO[mWaves[i]->getRenderer().m_renderCurrent];
-		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, gradientsBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mScratchHeightBuffer[i]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, mGradientsBuffer[i]);
 
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, mHeightBuffer[i]);
 
@@ -516,42 +564,6 @@ bool ComputeWaterSimulation::handleGamepadChanged(uint32_t changedPadFlags) {
 	return false;
 }
 
-std::string loadShaderSourceWithUniformTag(const char* uniformsFile, const char* srcFile) {
-	int32_t len;
-
-	char *uniformsStr = NvAssetLoaderRead(uniformsFile, len);
-	if (!uniformsStr)
-		return "";
-
-	char *srcStr = NvAssetLoaderRead(srcFile, len);
-	if (!srcStr)
-		return "";
-
-	std::string dest = "";
-
-	const char* uniformTag = "#UNIFORMS";
-
-	char* uniformTagStart = strstr(srcStr, uniformTag);
-
-	if (uniformTagStart) {
-		// NULL the start of the tag
-		*uniformTagStart = 0;
-		dest += srcStr; // source up to tag
-		dest += "\n";
-		dest += uniformsStr;
-		dest += "\n";
-		char* uniformTagEnd = uniformTagStart + strlen(uniformTag);
-		dest += uniformTagEnd;
-	} else {
-		dest += srcStr;
-	}
-
-	NvAssetLoaderFree(uniformsStr);
-	NvAssetLoaderFree(srcStr);
-
-	return dest;
-}
-
 NvAppBase* NvAppFactory(NvPlatformContext* platform) {
 	return new ComputeWaterSimulation(platform);
 }
@@ -582,13 +594,11 @@ void ComputeWaterSimulation::drawWater()
 
 	for(uint32_t i = 0; i < mNumWaves; i++)
 	{
-		//HACK: swap height buffers
-		uint currentBuffer = mWaves[i]->getRenderer().m_renderCurrent;
-		GLuint tmp = mWaves[i]->getRenderer().m_waterYVBO[currentBuffer];
+		//the compute shader path renders straight from its own buffers
 		if (mSettings.UseComputeShader)
-		{
-			mWaves[i]->getRenderer().m_waterYVBO[currentBuffer] = mHeightBuffer[i];
-		}
+			mWaves[i]->getRenderer().setSourceBuffers(mHeightBuffer[i], mGradientsBuffer[i]);
+		else
+			mWaves[i]->getRenderer().setSourceBuffers(0, 0);
 
 		mWaves[i]->getRenderer().setViewMatrix(m_transformer->getModelViewMat());
 		mWaves[i]->getRenderer().setColor(1.0f, 1.0f, 1.0f, 1.0f);
@@ -599,12 +609,8 @@ void ComputeWaterSimulation::drawWater()
 			mWaterShader[mWaterShaderType]->getUniformLocation("NormalMatrix"),
 			mWaterShader[mWaterShaderType]->getAttribLocation("vPositionXZ"),
 			mWaterShader[mWaterShaderType]->getAttribLocation("vPositionY"),
-			mWaterShader[mWaterShaderType]->getAttribLocation("vGradient"));
-
-		if (mSettings.UseComputeShader)
-		{
-			mWaves[i]->getRenderer().m_waterYVBO[currentBuffer] = tmp;
-		}
+			mWaterShader[mWaterShaderType]->getAttribLocation("vGradient"),
+			mWaterShader[mWaterShaderType]->getUniformLocation("packedNormals"));
 	}
 
 	mWaterShader[mWaterShaderType]->disable();
@@ -621,7 +627,6 @@ void ComputeWaterSimulation::initWaves(int numWaves)
 	//WaveSimRenderer::m_renderersCount = 0;
 	if (mWaves)
 	{
-		Wave::syncAllSimulationThreads();
 		for(uint32_t i = 0; i < mPrevNumWaves; i++)
 		{
 			delete mWaves[i];
@@ -635,8 +640,7 @@ void ComputeWaterSimulation::initWaves(int numWaves)
 	for(int i=0; i<numWaves; i++)
 	{
 		mWaves[i] = new Wave(mGridSize, mGridSize, mSettings.Damping,
-			nv::vec4f(0.8f*rand()/(float)RAND_MAX, 0.8f*rand()/(float)RAND_MAX, 0.7f + 0.3f* rand()/(float)RAND_MAX, 0.5f),
-			createStopWatch());
+			nv::vec4f(0.8f*rand()/(float)RAND_MAX, 0.8f*rand()/(float)RAND_MAX, 0.7f + 0.3f* rand()/(float)RAND_MAX, 0.5f));
 
 		//mWaves[i]->addRandomDisturbance((int)mSettings.Size, mSettings.Strength);
 		//for(int j=0; j<WaveSimRenderer::NUM_BUFFERS; j++)
@@ -670,8 +674,7 @@ void ComputeWaterSimulation::doReset()
             0, sizeof(float) * size, GL_MAP_WRITE_BIT);
 		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 
-		memset(mWaves[i]->getSimulation().getHeightField(), 0, size);
-		memset(mWaves[i]->getSimulation().getVelocity(), 0, size);
+		mWaves[i]->getSimulation().reset();
 		mWaves[i]->updateBufferData();
 	}
 
@@ -32,6 +32,7 @@
 //
 //----------------------------------------------------------------------------------
 #include "NvAppBase/NvSampleApp.h"
+#include "NvAppBase/NvFixedTimestep.h"
 
 #include "KHR/khrplatform.h"
 #include "NvGamepad/NvGamepad.h"
@@ -132,11 +133,15 @@ public:
 private:
 	void runWaterSimulation();
 	void simulateWaterCPU();
+	void finishWaveSteps();
 	void simulateWaterGPU();
 	void drawWater();
 	void initWaves(int numWaves);
 	void doReset();
 
+	// one fixed step of every CPU surface, as run by mWaveSteps
+	static void stepWavesTask(void* data, float dt, int32_t step, int32_t steps);
+
 	GLint createShaderPipelineProgram(GLuint target, const char* src, GLuint &pipeline, GLuint &program);
 
 	// unproject point in screen space to view space
@@ -166,6 +171,8 @@ private:
 
 	GLuint mHeightBuffer[NUM_WAVES];
 	GLuint mVelocityBuffer[NUM_WAVES];
+	GLuint mScratchHeightBuffer[NUM_WAVES];
+	GLuint mGradientsBuffer[NUM_WAVES];
 
 	nv::matrix4f mProjectionMatrix;
 
@@ -185,6 +192,9 @@ private:
 	uint32_t mGridSize, mPrevGridSize;
 	float mWaveScale;
 
+	// steps the CPU surfaces at a fixed rate, overlapped with drawing
+	NvFixedTimestep mWaveSteps;
+
 	NvGLSLProgram* mWaterShader[WATER_SHADER_COUNT];
 	uint32_t mWaterShaderType;
 };
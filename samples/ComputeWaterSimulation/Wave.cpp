@@ -33,20 +33,46 @@
 //----------------------------------------------------------------------------------
 #include "Wave.h"
 
-Wave::Wave(int width, int height, float damping, nv::vec4f color, NvStopWatch* stopWatch)
-:m_simulation(width+2, height+2, damping), m_renderer(&m_simulation), m_thread(&m_simulation, stopWatch)
+Wave::Wave(int width, int height, float damping, nv::vec4f color)
+:m_simulation(width+2, height+2, damping), m_renderer(&m_simulation)
 {
 	//set the color
 	m_renderer.setColor(color.x, color.y, color.z, color.w);
 
 	//init the vbo's for rendering
 	m_renderer.initBuffers();
-	
-	//start the thread
-	m_thread.Start();
 
-	//wait until the current thread has completed
-	WaveSimThread::waitForAllThreads();
+	//one band per thread, but no band thinner than 32 rows
+	int bands = mini(mini(NvJobSystem::getWorkerCount() + 1, MAX_BANDS), maxi(height / 32, 1));
+	m_simulation.setBandCount(bands);
+	bands = m_simulation.getBandCount();
+
+	const int swapTask = bands;
+	for(int i=0; i<bands; i++)
+	{
+		m_bandTasks[i].simulation = &m_simulation;
+		m_bandTasks[i].band = i;
+		m_simulationGraph.addTask(simulateBandTask, &m_bandTasks[i], "WaveSim band");
+	}
+	m_simulationGraph.addTask(swapBuffersTask, &m_simulation, "WaveSim swap");
+	for(int i=0; i<bands; i++)
+		m_simulationGraph.addDependency(i, swapTask);
+}
+
+Wave::~Wave()
+{
+	waitForSimulation();
+}
+
+void Wave::simulateBandTask(void* data)
+{
+	BandTask* task = (BandTask*)data;
+	task->simulation->simulateBand(WAVESIM_STEP, task->band);
+}
+
+void Wave::swapBuffersTask(void* data)
+{
+	((WaveSim*)data)->swapBuffers();
 }
 
 WaveSim& Wave::getSimulation()
@@ -59,19 +85,14 @@ WaveSimRenderer& Wave::getRenderer()
 	return m_renderer;
 }
 
-WaveSimThread& Wave::getThread()
-{
-	return m_thread;
-}
-
 void Wave::updateBufferData()
 {
 	m_renderer.updateBufferData();
 }
 
-void Wave::render(GLuint colorHandle, GLuint modelViewMatrixHandle, GLuint modelMatrixHandle, GLuint normalMatrixHandle, GLuint posXYHandle, GLuint posYHandle, GLuint normalHandle)
+void Wave::render(GLuint colorHandle, GLuint modelViewMatrixHandle, GLuint modelMatrixHandle, GLuint normalMatrixHandle, GLuint posXYHandle, GLuint posYHandle, GLuint normalHandle, GLuint packedNormalsHandle)
 {
-	m_renderer.render(colorHandle, modelViewMatrixHandle, modelMatrixHandle, normalMatrixHandle, posXYHandle, posYHandle, normalHandle);
+	m_renderer.render(colorHandle, modelViewMatrixHandle, modelMatrixHandle, normalMatrixHandle, posXYHandle, posYHandle, normalHandle, packedNormalsHandle);
 }
 
 int randBetween(int min, int max)
@@ -93,32 +114,18 @@ void Wave::addRandomDisturbance(int radius, float height)
 void Wave::simulateAndCalcNormals(float timestep)
 {
 	m_simulation.simulate(timestep);
-	m_simulation.calcGradients();
-}
-
-void Wave::resetThreadStopWatch()
-{
-//	WaveSimThread::m_threadStopWatch->reset();
-}
-
-void Wave::startThreadStopWatch()
-{
-//	WaveSimThread::m_threadStopWatch->start();
-}
-
-void Wave::startSimulationThread()
-{
-	m_thread.runSimulation();
 }
 
-void Wave::pauseAllSimulationThreads()
+void Wave::startSimulation(bool output, float alpha)
 {
-	WaveSimThread::pauseAllThreads();
+	//the step writes its results straight into the next slot of the renderer's buffers
+	m_simulation.setOutput(output ? m_renderer.getOutput() : NULL, alpha);
+	m_simulationGraph.submit();
 }
 
-void Wave::syncAllSimulationThreads()
+void Wave::waitForSimulation()
 {
-	WaveSimThread::waitForAllThreads();
+	m_simulationGraph.wait();
 }
 
 bool Wave::mapPointXZToGridPos(nv::vec3f point, nv::vec2f &gridPos)
@@ -35,10 +35,10 @@
 #define _WAVE_
 
 #include "WaveSim.h"
-#include "WaveSimThread.h"
 #include "WaveSimRenderer.h"
+#include "NvAppBase/NvJobSystem.h"
 
-//A wrapper for the fluid surface simulation, thread handling and rendering
+//A wrapper for the fluid surface simulation, its simulation jobs and rendering
 class Wave{
 private:
 
@@ -48,14 +48,29 @@ private:
 	//rendering
 	WaveSimRenderer m_renderer;
 
-	//thread handling
-	WaveSimThread m_thread;
+	//the most row bands a step is split into
+	static const int MAX_BANDS = 8;
+
+	//a band of the simulation, as passed to simulateBandTask
+	struct BandTask
+	{
+		WaveSim* simulation;
+		int band;
+	};
+	BandTask m_bandTasks[MAX_BANDS];
+
+	//one step: a task per band, then a task that swaps the simulation buffers once every band is done
+	NvJobGraph m_simulationGraph;
+
+	static void simulateBandTask(void* data);
+	static void swapBuffersTask(void* data);
 
 public:
 	//ctor
-	Wave(int width, int height, float damping, nv::vec4f color, NvStopWatch* stopWatch);
+	Wave(int width, int height, float damping, nv::vec4f color);
 
-	//no dtor as no pointers are used
+	//dtor (waits for a simulation step still running)
+	~Wave();
 
 	//returs a reference to the simulation variable
 	WaveSim& getSimulation();
@@ -63,36 +78,26 @@ public:
 	//return a reference to the renderer variable
 	WaveSimRenderer& getRenderer();
 
-	//returns a reference to the thread handling variable
-	WaveSimThread& getThread();
-	
 	//updates the VBO data
 	void updateBufferData();
 
 	//renders the current surface
-	void render(GLuint colorHandle, GLuint modelViewMatrixHandle, GLuint modelMatrixHandle, GLuint normalMatrixHandle, GLuint posXYHandle, GLuint posYHandle, GLuint normalHandle);
+	void render(GLuint colorHandle, GLuint modelViewMatrixHandle, GLuint modelMatrixHandle, GLuint normalMatrixHandle, GLuint posXYHandle, GLuint posYHandle, GLuint normalHandle, GLuint packedNormalsHandle);
 
-	//simulates and calculates the normals
+	//simulates and calculates the normals on the calling thread
 	void simulateAndCalcNormals(float timestep);
 
-	//starts the underlying simulation thread for 1 loop and the thread goes to wait for the next call to this function
-	void startSimulationThread();
+	//starts one simulation step on the job system; the simulation must not be touched until
+	//waitForSimulation().  If output is set the step writes its results, alpha of the way from
+	//the current ones, into the slot mapped by the renderer's beginUpdate()
+	void startSimulation(bool output, float alpha);
+
+	//waits for the step started by startSimulation(), helping with its jobs meanwhile
+	void waitForSimulation();
 
 	//adds a random disturbance
 	void addRandomDisturbance(int radius, float height);
 
-	//pauses all the simulation threads
-	static void pauseAllSimulationThreads();
-	
-	//synchronizes all simulation threads (waits until all threads have completed simulation and reached wait.
-	static void syncAllSimulationThreads();
-
-	//starts the thread stopwatch for recording the time
-	static void startThreadStopWatch();
-
-	//resets the thread stopwatch
-	static void resetThreadStopWatch();
-
 	//maps a world-space 3D point on XZ plane to a grid position in the current surface grid (does nothing if the point lies outside the surface)
 	bool mapPointXZToGridPos(nv::vec3f point, nv::vec2f &gridPos);
 };
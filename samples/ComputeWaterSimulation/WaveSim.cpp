@@ -32,19 +32,78 @@
 //
 //----------------------------------------------------------------------------------
 #include "WaveSim.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define WAVESIM_SSE 1
+#elif defined(NV_ARM_NEON) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WAVESIM_NEON 1
+#endif
+
+// One row of the solver: new velocities and heights from the current heights
+// of the row and its neighbours. Operations are kept in the order of the
+// scalar reference (no fused multiply-add), so all paths produce the same bits.
+static void stepRow(float dt, float damping, const float *u, const float *up, const float *down,
+	const float *v, float *dstU, float *dstV, int w)
+{
+	dstU[0] = u[0];
+	dstV[0] = v[0];
+	dstU[w-1] = u[w-1];
+	dstV[w-1] = v[w-1];
+
+	int i = 1;
+#if defined(WAVESIM_SSE)
+	const __m128 vdt = _mm_set1_ps(dt);
+	const __m128 vquarter = _mm_set1_ps(0.25f);
+	const __m128 vdamping = _mm_set1_ps(damping);
+	for(; i+4 <= w-1; i+=4) {
+		__m128 c = _mm_loadu_ps(u+i);
+		__m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_loadu_ps(u+i-1), _mm_loadu_ps(u+i+1)), _mm_loadu_ps(up+i)), _mm_loadu_ps(down+i));
+		__m128 vel = _mm_add_ps(_mm_loadu_ps(v+i), _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(vdt, sum), vquarter), c));
+		vel = _mm_mul_ps(vel, vdamping);
+		_mm_storeu_ps(dstV+i, vel);
+		_mm_storeu_ps(dstU+i, _mm_add_ps(c, _mm_mul_ps(vdt, vel)));
+	}
+#elif defined(WAVESIM_NEON)
+	const float32x4_t vdt = vdupq_n_f32(dt);
+	const float32x4_t vquarter = vdupq_n_f32(0.25f);
+	const float32x4_t vdamping = vdupq_n_f32(damping);
+	for(; i+4 <= w-1; i+=4) {
+		float32x4_t c = vld1q_f32(u+i);
+		float32x4_t sum = vaddq_f32(vaddq_f32(vaddq_f32(vld1q_f32(u+i-1), vld1q_f32(u+i+1)), vld1q_f32(up+i)), vld1q_f32(down+i));
+		float32x4_t vel = vaddq_f32(vld1q_f32(v+i), vsubq_f32(vmulq_f32(vmulq_f32(vdt, sum), vquarter), c));
+		vel = vmulq_f32(vel, vdamping);
+		vst1q_f32(dstV+i, vel);
+		vst1q_f32(dstU+i, vaddq_f32(c, vmulq_f32(vdt, vel)));
+	}
+#endif
+	for(; i<w-1; i++) {
+		float vel = v[i] + (dt * (((u[i-1] + u[i+1]) + up[i]) + down[i])*0.25f - u[i]);
+		vel *= damping;
+		dstV[i] = vel;
+		dstU[i] = u[i] + dt*vel;
+	}
+}
 
 WaveSim::WaveSim(int w, int h, float damping) :
 	m_width(w),
 	m_height(h),
-    m_v(w, h),
     m_current(0),
     //m_c2(0.5f),
     //m_h2(1.0f),
-    m_damping(damping)
+    m_damping(damping),
+    m_output(NULL),
+    m_outputAlpha(1.0f),
+    m_bandCount(0)
 {
 	m_u[0].init(m_width,m_height);
 	m_u[1].init(m_width,m_height);
+	m_v[0].init(m_width,m_height);
+	m_v[1].init(m_width,m_height);
 	m_gradients = new float[m_width*m_height*2];
+	setBandCount(1);
     reset();
 }
 
@@ -55,12 +114,11 @@ WaveSim::~WaveSim()
 
 void WaveSim::reset()
 {
-    int size = m_width * m_height;
-    for(int i=0; i<size; i++) {
-        m_u[0].data[i] = 0.0f;
-        m_u[1].data[i] = 0.0f;
-        m_v.data[i] = 0.0f;
+    for(int k=0; k<2; k++) {
+        m_u[k].fill(0.0f);
+        m_v[k].fill(0.0f);
     }
+    memset(m_gradients, 0, sizeof(float)*m_width*m_height*2);
 }
 
 void WaveSim::setDamping(float _damping)
@@ -68,6 +126,45 @@ void WaveSim::setDamping(float _damping)
 	m_damping = _damping;
 }
 
+void WaveSim::setBandCount(int bands)
+{
+	bands = clamp(bands, 1, maxi(1, m_height-2));
+	if (bands == m_bandCount)
+		return;
+
+	m_haloRows.init(m_width, bands*4);
+	m_bandCount = bands;
+}
+
+void WaveSim::setOutput(NvPackedHeightVertex *vertices, float alpha)
+{
+	m_output = vertices;
+	m_outputAlpha = alpha;
+}
+
+void WaveSim::packOutput(NvPackedHeightVertex *vertices, float alpha)
+{
+	//the back arrays still hold the heights from before the last step
+	const Array2D<float> &oldU = m_u[1-m_current];
+	const Array2D<float> &newU = m_u[m_current];
+	//no band is running, so borrow band 0's interpolation row
+	for(int j=0; j<m_height; j++)
+		packRow(j, oldU, newU, m_haloRows.getRow(3), vertices, alpha);
+}
+
+void WaveSim::packRow(int j, const Array2D<float> &oldU, const Array2D<float> &newU, float *scratch, NvPackedHeightVertex *dst, float alpha)
+{
+	const int w = m_width;
+	const float *heights = newU.getRow(j);
+	if (alpha < 1.0f) {
+		const float *old = oldU.getRow(j);
+		for(int i=0; i<w; i++)
+			scratch[i] = old[i] + alpha*(heights[i] - old[i]);
+		heights = scratch;
+	}
+	NvVertexPacking::packGradients(heights, m_gradients + j*w*2, w, dst + j*w);
+}
+
 void WaveSim::addDisturbance(float x, float y, float r, float s)
 {
     int ix = (int) floorf(x);
@@ -92,26 +189,154 @@ void WaveSim::addDisturbance(float x, float y, float r, float s)
 
 // http://www.matthiasmueller.info/talks/GDC2008.pdf
 void WaveSim::simulate(float dt)
+{
+	for(int band=0; band<m_bandCount; band++)
+		simulateBand(dt, band);
+	swapBuffers();
+}
+
+void WaveSim::updateRow(float dt, int j)
+{
+	const Array2D<float> &u = m_u[m_current];
+	stepRow(dt, m_damping, u.getRow(j), u.getRow(j-1), u.getRow(j+1), m_v[m_current].getRow(j),
+		m_u[1-m_current].getRow(j), m_v[1-m_current].getRow(j), m_width);
+}
+
+void WaveSim::integrateRow(float dt, int j, float *dstU, float *scratchV)
+{
+	const Array2D<float> &u = m_u[m_current];
+	// the velocities are discarded; the band that owns the row writes them
+	stepRow(dt, m_damping, u.getRow(j), u.getRow(j-1), u.getRow(j+1), m_v[m_current].getRow(j), dstU, scratchV, m_width);
+}
+
+void WaveSim::gradientsRow(const float *up, const float *center, const float *down, float *dst)
+{
+	const int w = m_width;
+	int i = 1;
+#if defined(WAVESIM_SSE)
+	for(; i+4 <= w-1; i+=4) {
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(center+i+1), _mm_loadu_ps(center+i-1));
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(down+i), _mm_loadu_ps(up+i));
+		_mm_storeu_ps(dst + 2*i, _mm_unpacklo_ps(dx, dz));
+		_mm_storeu_ps(dst + 2*i + 4, _mm_unpackhi_ps(dx, dz));
+	}
+#elif defined(WAVESIM_NEON)
+	for(; i+4 <= w-1; i+=4) {
+		float32x4x2_t g;
+		g.val[0] = vsubq_f32(vld1q_f32(center+i+1), vld1q_f32(center+i-1));
+		g.val[1] = vsubq_f32(vld1q_f32(down+i), vld1q_f32(up+i));
+		vst2q_f32(dst + 2*i, g);
+	}
+#endif
+	for(; i<w-1; i++) {
+		dst[2*i] = center[i+1] - center[i-1];		//dy/dx
+		dst[2*i+1] = down[i] - up[i];				//dy/dz
+	}
+
+	//the border columns are flat; written so that an external output is complete
+	dst[0] = dst[1] = 0.0f;
+	dst[2*w-2] = dst[2*w-1] = 0.0f;
+}
+
+// Rows are streamed top to bottom; the gradients of a row are computed as soon
+// as the new heights of the row below exist, so every row is read from memory
+// once per step and the three-row window stays in cache.
+void WaveSim::simulateBand(float dt, int band)
+{
+	const int w = m_width;
+	const int h = m_height;
+	const int rows = h - 2;
+	if (rows <= 0 || band < 0 || band >= m_bandCount)
+		return;
+
+	const int j0 = 1 + rows*band/m_bandCount;
+	const int j1 = 1 + rows*(band+1)/m_bandCount;
+
+	const Array2D<float> &srcU = m_u[m_current];
+	Array2D<float> &dstU = m_u[1-m_current];
+	float *gradients = m_gradients;
+
+	// this band's rows in m_haloRows; see the layout in WaveSim.h
+	float *haloAbove = m_haloRows.getRow(band*4);
+	float *haloBelow = m_haloRows.getRow(band*4 + 1);
+	float *scratchV = m_haloRows.getRow(band*4 + 2);
+	float *scratch = m_haloRows.getRow(band*4 + 3);
+
+	// the border rows are never simulated; carry them over to the back arrays (their gradients stay 0)
+	if (band == 0) {
+		memcpy(dstU.getRow(0), srcU.getRow(0), sizeof(float)*w);
+		memcpy(m_v[1-m_current].getRow(0), m_v[m_current].getRow(0), sizeof(float)*w);
+		if (m_output)
+			packRow(0, srcU, dstU, scratch, m_output, m_outputAlpha);
+	}
+	if (band == m_bandCount-1) {
+		memcpy(dstU.getRow(h-1), srcU.getRow(h-1), sizeof(float)*w);
+		memcpy(m_v[1-m_current].getRow(h-1), m_v[m_current].getRow(h-1), sizeof(float)*w);
+		if (m_output)
+			packRow(h-1, srcU, dstU, scratch, m_output, m_outputAlpha);
+	}
+
+	// halo rows: new heights of the rows just outside the band, recomputed locally
+	const float *above = srcU.getRow(j0-1);
+	const float *below = srcU.getRow(j1);
+	if (j0-1 > 0) {
+		integrateRow(dt, j0-1, haloAbove, scratchV);
+		above = haloAbove;
+	}
+	if (j1 < h-1) {
+		integrateRow(dt, j1, haloBelow, scratchV);
+		below = haloBelow;
+	}
+
+	for(int j=j0; j<j1; j++) {
+		updateRow(dt, j);
+		if (j > j0) {
+			const float *up = (j-2 < j0) ? above : dstU.getRow(j-2);
+			gradientsRow(up, dstU.getRow(j-1), dstU.getRow(j), gradients + (j-1)*w*2);
+			// pack the finished row out while it is still in cache
+			if (m_output)
+				packRow(j-1, srcU, dstU, scratch, m_output, m_outputAlpha);
+		}
+	}
+	const float *up = (j1-2 < j0) ? above : dstU.getRow(j1-2);
+	gradientsRow(up, dstU.getRow(j1-1), below, gradients + (j1-1)*w*2);
+	if (m_output)
+		packRow(j1-1, srcU, dstU, scratch, m_output, m_outputAlpha);
+}
+
+void WaveSim::swapBuffers()
+{
+	m_current = 1 - m_current;
+}
+
+void WaveSim::calcGradients()
+{
+	const Array2D<float> &u = m_u[m_current];
+	for(int j=1; j<m_height-1; j++)
+		gradientsRow(u.getRow(j-1), u.getRow(j), u.getRow(j+1), m_gradients + j*m_width*2);
+}
+
+void WaveSim::simulateReference(float dt)
 {
     for(int j=1; j<m_height-1; j++) {
         for(int i=1; i<m_width-1; i++) {
             //m_v.get(i, j) += dt*m_c2*( m_u.getClamp(i-1, j) + m_u.getClamp(i+1, j) + m_u.getClamp(i, j-1) + m_u.getClamp(i, j+1) - 4.0f*m_u.get(i, j) ) / m_h2;
             //m_v.get(i, j) += dt* (m_u.getClamp(i-1, j) + m_u.getClamp(i+1, j) + m_u.getClamp(i, j-1) + m_u.getClamp(i, j+1))*0.25f - m_u.get(i, j);
-            m_v.get(i, j) += dt * (m_u[m_current].get(i-1, j) + m_u[m_current].get(i+1, j) + m_u[m_current].get(i, j-1) + m_u[m_current].get(i, j+1))*0.25f - m_u[m_current].get(i, j);
+            m_v[m_current].get(i, j) += dt * (m_u[m_current].get(i-1, j) + m_u[m_current].get(i+1, j) + m_u[m_current].get(i, j-1) + m_u[m_current].get(i, j+1))*0.25f - m_u[m_current].get(i, j);
         }
     }
 
     //float damping = powf(m_damping, dt);
     for(int j=1; j<m_height-1; j++) {
         for(int i=1; i<m_width-1; i++) {
-            float &v = m_v.get(i, j);
+            float &v = m_v[m_current].get(i, j);
             v *= m_damping;
             m_u[m_current].get(i, j) += dt*v;
         }
     }
 }
 
-void WaveSim::calcGradients()
+void WaveSim::calcGradientsReference()
 {
 	float *ptr;
 	for(int j=1; j<m_height-1; j++)
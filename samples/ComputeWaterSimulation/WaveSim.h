@@ -37,8 +37,28 @@
 #include <NvFoundation.h>
 #include "Array2D.h"
 #include "NV/NvMath.h"
+#include "NvGLUtils/NvVertexPacking.h"
+
+// the length of one solver step, in simulation time units.  The wave speed,
+// damping and disturbances are tuned for unit steps; how many steps run per
+// second of real time is set by the caller (ComputeWaterSimulation steps at a
+// fixed 60 Hz)
+static const float WAVESIM_STEP = 1.0f;
 
 // simple heightfield fluid surface
+//
+// Each step is one fused pass over the grid: the velocity update, damping,
+// height integration and gradients are computed row by row, reading the front
+// height/velocity arrays and writing the back ones, which are then swapped.
+// The pass can be split into horizontal row bands that run concurrently; each
+// band recomputes the new heights of the row just above and below it (its
+// halo) instead of waiting for its neighbours, so bands never share writes.
+//
+// m_haloRows holds four rows per band, at band*4 + :
+//   0  new heights of the halo row above the band
+//   1  new heights of the halo row below the band
+//   2  velocities computed for the halo rows, which are discarded
+//   3  heights interpolated between steps for the packed output
 class WaveSim
 {
 public:
@@ -55,12 +75,42 @@ public:
     //set the damping
     void setDamping(float _damping);
 
-    //simulate using math for indexing
+    //simulate one step and calculate the gradients (all bands on the calling thread)
     void simulate(float dt);
 
-    //calculate the gradients
+    //set the number of row bands a step is split into (clamped to the interior row count)
+    void setBandCount(int bands);
+
+    //get the number of row bands
+    int getBandCount() { return m_bandCount; }
+
+    //simulate one band of a step; bands may run concurrently, and swapBuffers()
+    //must be called once all bands of the step have completed
+    void simulateBand(float dt, int band);
+
+    //make the results of the last step current
+    void swapBuffers();
+
+    //also write the new heights and normals of every following step to this array, one
+    //packed vertex per grid point (row after row, unpadded), e.g. a mapped vertex
+    //buffer; the array is write-only.  The heights are alpha of the way from the ones
+    //before the step to the new ones, for drawing between steps.  Pass NULL to stop
+    void setOutput(NvPackedHeightVertex *vertices, float alpha = 1.0f);
+
+    //write the current heights and normals as setOutput() does, the heights alpha of the
+    //way from the ones before the last step (must not run during a step)
+    void packOutput(NvPackedHeightVertex *vertices, float alpha);
+
+    //recalculate the gradients of the current heights (simulate() already does this)
 	void calcGradients();
 
+    //the original two-pass scalar solver, kept to validate the fused pass; updates the
+    //current arrays in place and must be followed by calcGradientsReference()
+    void simulateReference(float dt);
+
+    //the original scalar gradients pass
+    void calcGradientsReference();
+
 	//get the width of the surface
     int getWidth() { return m_width; }
 
@@ -68,16 +118,16 @@ public:
     int getHeight() { return m_height; }
 
     //get the height at a specific grid point
-    float getHeight(int i, int j) { return m_v.get(i, j); }
+    float getHeight(int i, int j) { return m_v[m_current].get(i, j); }
 
-    //get the pointer to the current heights array
-    float *getHeightField() { return m_u[m_current].data; }
+    //get the current heights (rows are padded; see Array2D)
+    Array2D<float> &getHeightField() { return m_u[m_current]; }
 
     //get the pointer to the current gradients array
 	float *getGradients() { return m_gradients; }
 
-	// get the pointer to the current velocity array
-	float* getVelocity() { return m_v.data; }
+	// get the current velocities
+	Array2D<float> &getVelocity() { return m_v[m_current]; }
 
 	//get the normal at a grid point (x,y)
 	nv::vec3f getNormal(int x, int y)
@@ -90,9 +140,20 @@ public:
 	int m_heightFieldSize, m_gradientsSize;
 
 private:
+	//the new heights of one row, without writing the back velocity array (used for halo rows)
+	void integrateRow(float dt, int j, float *dstU, float *scratchV);
+
+	//the new velocities and heights of one row
+	void updateRow(float dt, int j);
+
+	//the gradients of one row from three rows of new heights
+	void gradientsRow(const float *up, const float *center, const float *down, float *dst);
+
+	//pack row j of the new heights (alpha of the way from the old ones) and its gradients
+	void packRow(int j, const Array2D<float> &oldU, const Array2D<float> &newU, float *scratch, NvPackedHeightVertex *dst, float alpha);
 
     Array2D<float> m_u[2];    // height
-    Array2D<float> m_v;    // velocity
+    Array2D<float> m_v[2];    // velocity
 	
 	//float m_scaleY; //used to hold the relative height (y) * 2.0f wrt world coords
 	float *m_gradients;
@@ -106,8 +167,16 @@ private:
     //width/height of the grid
     int m_width, m_height;
 
-    //and index to the current(front) height array
+    //and index to the current(front) height and velocity arrays
     int m_current;
+
+    //the external copy written by each step (see setOutput), or NULL
+    NvPackedHeightVertex *m_output;
+    float m_outputAlpha;
+
+    //the number of row bands, and each band's halo, scratch and interpolation rows (see above)
+    int m_bandCount;
+    Array2D<float> m_haloRows;
 };
 
 #endif
@@ -0,0 +1,226 @@
+//----------------------------------------------------------------------------------
+// File:        ComputeWaterSimulation/WaveSimBenchmark.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "WaveSimBenchmark.h"
+#include "WaveSim.h"
+#include "NvAppBase/NvJobSystem.h"
+#include "NV/NvStopWatch.h"
+#include "R3/thread.h"
+#include "NV/NvLogs.h"
+#include <math.h>
+#include <string.h>
+
+struct BandStep
+{
+	WaveSim* sim;
+	float timestep;
+};
+
+static void simulateBands(void* data, int32_t begin, int32_t end)
+{
+	BandStep* step = (BandStep*)data;
+	for(int32_t band=begin; band<end; band++)
+		step->sim->simulateBand(step->timestep, band);
+}
+
+// the same deterministic set of disturbances for every configuration
+static void seedWaves(WaveSim& sim)
+{
+	sim.reset();
+	const int w = sim.getWidth() - 2;
+	const int h = sim.getHeight() - 2;
+	const float radius = (float)mini(8, maxi(w/16, 2));
+	for(int k=0; k<16; k++)
+	{
+		float x = 1.0f + (float)((k*7919 + 13) % w);
+		float y = 1.0f + (float)((k*104729 + 7) % h);
+		sim.addDisturbance(x, y, radius, (k & 1) ? 1.0f : -0.5f);
+	}
+}
+
+static float maxDifference(const float* a, const float* b, int count)
+{
+	float diff = 0.0f;
+	for(int i=0; i<count; i++)
+	{
+		float d = fabsf(a[i] - b[i]);
+		if (d > diff)
+			diff = d;
+	}
+	return diff;
+}
+
+static float maxDifference(const Array2D<float>& a, const Array2D<float>& b)
+{
+	float diff = 0.0f;
+	for(int j=0; j<a.getHeight(); j++)
+	{
+		float d = maxDifference(a.getRow(j), b.getRow(j), a.getWidth());
+		if (d > diff)
+			diff = d;
+	}
+	return diff;
+}
+
+bool runWaveSimBenchmark(NvStopWatch* stopWatch)
+{
+#ifdef ANDROID
+	const int maxGridSize = 2048;
+#else
+	const int maxGridSize = 4096;
+#endif
+	// the reordering-free kernels should match exactly; allow for compilers that contract to FMA
+	const float epsilon = 1e-5f;
+	const float timestep = WAVESIM_STEP;
+
+	const int cores = r3::getNumCPUCores();
+	int threadCounts[4] = { 1, 2, 4, cores };
+	int numThreadCounts = (cores > 4) ? 4 : 3;
+
+	bool passed = true;
+	LOGI("WaveSim benchmark: %d cores\n", cores);
+
+	for(int size=256; size<=maxGridSize; size*=2)
+	{
+		const int w = size + 2;
+		const int cells = w*w;
+		// roughly the same amount of work per configuration
+		const int steps = mini(maxi((1<<24) / (size*size), 4), 256);
+
+		WaveSim reference(w, w, 0.99f);
+		seedWaves(reference);
+		stopWatch->reset();
+		stopWatch->start();
+		for(int i=0; i<steps; i++)
+		{
+			reference.simulateReference(timestep);
+			reference.calcGradientsReference();
+		}
+		stopWatch->stop();
+		const float referenceMs = stopWatch->getTime() * 1000.0f / steps;
+		LOGI("WaveSim %4d^2 reference:  %8.3f ms/step\n", size, referenceMs);
+
+		for(int t=0; t<numThreadCounts; t++)
+		{
+			NvJobSystem::restart(threadCounts[t] - 1);
+
+			WaveSim sim(w, w, 0.99f);
+			sim.setBandCount(threadCounts[t]);
+			seedWaves(sim);
+			BandStep step = { &sim, timestep };
+
+			stopWatch->reset();
+			stopWatch->start();
+			for(int i=0; i<steps; i++)
+			{
+				NvJobSystem::parallelFor(simulateBands, &step, sim.getBandCount(), 1, "WaveSim bands");
+				sim.swapBuffers();
+			}
+			stopWatch->stop();
+			const float ms = stopWatch->getTime() * 1000.0f / steps;
+
+			float error = maxDifference(sim.getHeightField(), reference.getHeightField());
+			float velocityError = maxDifference(sim.getVelocity(), reference.getVelocity());
+			float gradientError = maxDifference(sim.getGradients(), reference.getGradients(), cells*2);
+			if (velocityError > error)
+				error = velocityError;
+			if (gradientError > error)
+				error = gradientError;
+
+			// one more step packed into an external array, as WaveSimRenderer streams it; the
+			// bands pack row by row, and must match packing the finished arrays bit for bit
+			NvPackedHeightVertex* streamed = new NvPackedHeightVertex[cells];
+			NvPackedHeightVertex* expected = new NvPackedHeightVertex[cells];
+			sim.setOutput(streamed);
+			NvJobSystem::parallelFor(simulateBands, &step, sim.getBandCount(), 1, "WaveSim bands");
+			sim.swapBuffers();
+			sim.setOutput(NULL);
+			for(int j=0; j<w; j++)
+				NvVertexPacking::packGradients(sim.getHeightField().getRow(j), sim.getGradients() + j*w*2, w, expected + j*w);
+			const bool outputOk = memcmp(streamed, expected, sizeof(NvPackedHeightVertex)*cells) == 0;
+			delete [] streamed;
+			delete [] expected;
+
+			const bool ok = (error <= epsilon) && outputOk;
+			passed = passed && ok;
+
+			if (ok)
+			{
+				LOGI("WaveSim %4d^2 %2d threads: %8.3f ms/step (%5.2fx), max error %g\n",
+					size, threadCounts[t], ms, referenceMs / ms, error);
+			}
+			else if (!outputOk)
+			{
+				LOGE("WaveSim %4d^2 %2d threads: the streamed vertices differ from the packed results\n", size, threadCounts[t]);
+			}
+			else
+			{
+				LOGE("WaveSim %4d^2 %2d threads: max error %g exceeds %g\n", size, threadCounts[t], error, epsilon);
+			}
+		}
+
+		// the CPU cost of streaming a step: copying the float heights and gradients, or packing them
+		float* floats = new float[cells*3];
+		NvPackedHeightVertex* vertices = new NvPackedHeightVertex[cells];
+		stopWatch->reset();
+		stopWatch->start();
+		for(int i=0; i<steps; i++)
+		{
+			reference.getHeightField().copyTo(floats);
+			memcpy(floats + cells, reference.getGradients(), sizeof(float)*cells*2);
+		}
+		stopWatch->stop();
+		const float copyMs = stopWatch->getTime() * 1000.0f / steps;
+
+		float packMs[2];
+		for(int simd=1; simd>=0; simd--)
+		{
+			NvVertexPacking::setSIMDEnabled(simd != 0);
+			stopWatch->reset();
+			stopWatch->start();
+			for(int i=0; i<steps; i++)
+				reference.packOutput(vertices, 1.0f);
+			stopWatch->stop();
+			packMs[simd] = stopWatch->getTime() * 1000.0f / steps;
+		}
+		NvVertexPacking::setSIMDEnabled(true);
+
+		LOGI("WaveSim %4d^2 upload: floats %6d KB %8.3f ms/step, packed %6d KB %8.3f ms/step (%s), %8.3f ms/step scalar\n",
+			size, (int)(sizeof(float)*3*cells/1024), copyMs, (int)(sizeof(NvPackedHeightVertex)*cells/1024),
+			packMs[1], NvVertexPacking::getSIMDName(), packMs[0]);
+		delete [] floats;
+		delete [] vertices;
+	}
+
+	return passed;
+}
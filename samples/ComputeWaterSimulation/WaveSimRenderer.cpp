@@ -32,13 +32,14 @@
 //
 //----------------------------------------------------------------------------------
 #include "WaveSimRenderer.h"
+#include <string.h>
 
 //extern nv::matrix4f viewMatrix;
 
 int WaveSimRenderer::m_renderersCount = 0;
 
 WaveSimRenderer::WaveSimRenderer(WaveSim *sim)
-:m_simulation(sim), m_rendererId(m_renderersCount++), m_current(0), m_previous(0), m_renderCurrent(1)
+:m_simulation(sim), m_rendererId(m_renderersCount++), m_sourceHeights(0), m_sourceGradients(0), m_updating(false), m_mapped(NULL), m_staging(NULL), m_output(NULL), m_waterXZVBO(0), m_waterIndices(NULL)
 {
 	if(m_rendererId%2 != 0)
 		m_gridRenderPos = nv::vec2f(-2.1f + (m_rendererId/2)*2.2f, -2.1f);
@@ -53,6 +54,10 @@ WaveSimRenderer::WaveSimRenderer(WaveSim *sim)
 
 WaveSimRenderer::~WaveSimRenderer()
 {
+	if (m_waterXZVBO)
+		glDeleteBuffers(1, &m_waterXZVBO);
+	NvGridIndexBuffer::release(m_waterIndices);
+	delete [] m_staging;
 	m_renderersCount--;
 }
 
@@ -92,151 +97,82 @@ void WaveSimRenderer::initBuffers()
 
 	delete [] surfacexz;
 
-	//no of quads for a grid of wxh = (w-1)*(h-1);
-	//no of triangles = no of quads * 2;
-	//no of vertices = no of triangles * 3;
-	//no of components per vertex = 2 [x,z];
+	//the interior (w-2)x(h-2) vertices, rows of h vertices starting at (1,1); the indices depend only on
+	//the grid size, so every surface of this size shares one buffer
+	NvGridIndexBuffer::Desc desc(h-2, w-2);
+	desc.rowStride = h;
+	desc.firstVertex = h+1;
+	m_waterIndices = NvGridIndexBuffer::acquire(desc);
+	
+	m_simulation->m_heightFieldSize = sizeof(float)*w*h;
+	m_simulation->m_gradientsSize = sizeof(float)*w*h*2;
 
-	m_vertCount = (w-3)*(h-3) * 2 * 3;
+	//a third of the float heights and gradients it replaces
+	NvPackedHeightVertex *vertices = new NvPackedHeightVertex[w*h];
+	m_simulation->packOutput(vertices, 1.0f);
+	m_waterVBO.init(GL_ARRAY_BUFFER, sizeof(NvPackedHeightVertex)*w*h, NvStreamingBuffer::DEFAULT_SLOT_COUNT, vertices);
+	delete [] vertices;
+}
 
-#if 1
-	unsigned short *indices = new unsigned short[m_vertCount];
-	for(int i=0; i<w-3; i++)
-	{
-		for(int j=0; j<h-3; j++)
-		{
-			int k,l;
-			if(i%2==0)
-			{
-				k = i+1;
-				l = j+1;
-				//for each quad on even row
-				//triangle 1
-				//vertex 1
-				indices[i*(h-3)*6 + j*6 + 0] = (unsigned short) ((k)*h + (l));
-				//vertex 2
-				indices[i*(h-3)*6 + j*6 + 1] = (unsigned short) ((k)*h + (l+1));
-				//vertex 3
-				indices[i*(h-3)*6 + j*6 + 2] = (unsigned short) ((k+1)*h + (l));
+void WaveSimRenderer::updateBufferData(float alpha)
+{
+	endUpdate();
 
-				//triangle 2
-				//vertex 1
-				indices[i*(h-3)*6 + j*6 + 3] = (unsigned short) ((k+1)*h + (l));
-				//vertex 2
-				indices[i*(h-3)*6 + j*6 + 4] = (unsigned short) ((k)*h + (l+1));
-				//vertex 3
-				indices[i*(h-3)*6 + j*6 + 5] = (unsigned short) ((k+1)*h + (l+1));
-			}
-			else
-			{
-				k = 1 + (w - 4) - i;
-				l = 1 + (h - 4) - j;
-				//for each quad on odd row
-				//triangle 1
-				//vertex 1
-				indices[i*(h-3)*6 + j*6 + 0] = (unsigned short) ((k)*h + (l));
-				//vertex 2
-				indices[i*(h-3)*6 + j*6 + 1] = (unsigned short) ((k)*h + (l+1));
-				//vertex 3
-				indices[i*(h-3)*6 + j*6 + 2] = (unsigned short) ((k+1)*h + (l));
+	NvPackedHeightVertex *vertices = (NvPackedHeightVertex*)m_waterVBO.beginWrite();
+	if (vertices)
+		m_simulation->packOutput(vertices, alpha);
+	m_waterVBO.endWrite();
+}
 
-				//triangle 2
-				//vertex 1
-				indices[i*(h-3)*6 + j*6 + 3] = (unsigned short) ((k+1)*h + (l));
-				//vertex 2
-				indices[i*(h-3)*6 + j*6 + 4] = (unsigned short) ((k)*h + (l+1));
-				//vertex 3
-				indices[i*(h-3)*6 + j*6 + 5] = (unsigned short) ((k+1)*h + (l+1));
-			}
-		}
-	}
-#else
-	unsigned short *indices = new unsigned short[m_vertCount];
-	unsigned short* ptr = indices;
-	for(int i=0; i<w-3; i++)
+void WaveSimRenderer::beginUpdate()
+{
+	endUpdate();
+
+	//the step job runs while this frame draws the water.  A persistently mapped slot may stay mapped
+	//meanwhile; with the other methods the buffer cannot be drawn from while mapped, so write to memory first.
+	if (m_waterVBO.getMethod() == NvStreamingBuffer::METHOD_PERSISTENT)
 	{
-		for(int j=0; j<h-3; j++)
-		{
-			*ptr++ = (unsigned short)(i * w + j);
-			*ptr++ = (unsigned short)(i * w + 1 + j);
-			*ptr++ = (unsigned short)(i * w + h + j);
-			
-			*ptr++ = (unsigned short)(i * w + h + j);
-			*ptr++ = (unsigned short)(i * w + 1 + j);
-			*ptr++ = (unsigned short)(i * w + h + j + 1);
-		}
+		m_mapped = (NvPackedHeightVertex*)m_waterVBO.beginWrite();
+		m_output = m_mapped;
 	}
-#endif
-	
-	glGenBuffers(1, &m_waterIBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_waterIBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short)*m_vertCount, indices, GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-	
-	m_simulation->m_heightFieldSize = sizeof(float)*w*h;
-	for(int i=0; i<NUM_BUFFERS; i++)
+	else
 	{
-		glGenBuffers(1, &m_waterYVBO[i]);
-		glBindBuffer(GL_ARRAY_BUFFER, m_waterYVBO[i]);
-		glBufferData(GL_ARRAY_BUFFER, m_simulation->m_heightFieldSize, m_simulation->getHeightField(), GL_DYNAMIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		if (!m_staging)
+			m_staging = new NvPackedHeightVertex[m_simulation->getWidth()*m_simulation->getHeight()];
+		m_output = m_staging;
 	}
+	m_updating = true;
+}
 
-	m_simulation->m_gradientsSize = sizeof(float)*w*h*2;
-	
-	for(int i=0; i<NUM_BUFFERS; i++)
+void WaveSimRenderer::endUpdate()
+{
+	if (!m_updating)
+		return;
+
+	m_simulation->setOutput(NULL);
+	if (m_waterVBO.getMethod() == NvStreamingBuffer::METHOD_PERSISTENT)
 	{
-		glGenBuffers(1, &m_waterGVBO[i]);
-		glBindBuffer(GL_ARRAY_BUFFER, m_waterGVBO[i]);
-		glBufferData(GL_ARRAY_BUFFER, m_simulation->m_gradientsSize, m_simulation->getGradients(), GL_DYNAMIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_waterVBO.endWrite();
 	}
-
-	delete [] indices;
+	else
+	{
+		void *ptr = m_waterVBO.beginWrite();
+		if (ptr)
+			memcpy(ptr, m_staging, sizeof(NvPackedHeightVertex)*m_simulation->getWidth()*m_simulation->getHeight());
+		m_waterVBO.endWrite();
+	}
+	m_mapped = NULL;
+	m_output = NULL;
+	m_updating = false;
 }
 
-void WaveSimRenderer::updateBufferData()
+void WaveSimRenderer::setSourceBuffers(GLuint heights, GLuint gradients)
 {
-#ifdef USE_GL_BUFFER_SUB_DATA
-	//update the new vertex y positions
-	glBindBuffer(GL_ARRAY_BUFFER, m_waterYVBO[m_current]);
-	glBufferSubData(GL_ARRAY_BUFFER, GLintptr(0), m_simulation->m_heightFieldSize, m_simulation->getHeightField());
-
-	//update the new normals
-	glBindBuffer(GL_ARRAY_BUFFER, m_waterGVBO[m_current]);
-	glBufferSubData(GL_ARRAY_BUFFER, GLintptr(0), m_simulation->m_gradientsSize, m_simulation->getGradients());
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-#else
-	glBindBuffer(GL_ARRAY_BUFFER, m_waterYVBO[m_current]);
-	//glBufferData(GL_ARRAY_BUFFER, m_simulation->m_heightFieldSize, NULL, GL_DYNAMIC_DRAW);
-	//GL_OES_mapbuffer
-	void *ptr1 = glMapBufferRange(GL_ARRAY_BUFFER, 
-        0, m_simulation->m_heightFieldSize, GL_MAP_WRITE_BIT);
-	memcpy(ptr1, m_simulation->getHeightField(), m_simulation->m_heightFieldSize);
-	//for(int i = 0; i < 100; i++)
-	//{
-	//	((float*)ptr1)[0] = rand() * 10000.0f / RAND_MAX;
-	//}
-	//((float*)ptr1)[0] = 1.125f;
-	//((float*)ptr1)[1] = 5.225f;
-	//((float*)ptr1)[2] = 100.525f;
-	glUnmapBuffer(GL_ARRAY_BUFFER);
-
-	glBindBuffer(GL_ARRAY_BUFFER, m_waterGVBO[m_current]);
-	//glBufferData(GL_ARRAY_BUFFER, m_simulation->m_gradientsSize, NULL, GL_DYNAMIC_DRAW);
-	//GL_OES_mapbuffer
-	void *ptr2 = glMapBufferRange(GL_ARRAY_BUFFER, 
-        0, m_simulation->m_gradientsSize, GL_MAP_WRITE_BIT);
-	memcpy(ptr2, m_simulation->getGradients(), m_simulation->m_gradientsSize);
-	glUnmapBuffer(GL_ARRAY_BUFFER);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-#endif
-
-	//swap the vbo's
-	m_current = ++m_current % NUM_BUFFERS;
+	m_sourceHeights = heights;
+	m_sourceGradients = gradients;
 }
 
-void WaveSimRenderer::render(GLuint colorHandle, GLuint modelViewMatrixHandle, GLuint modelMatrixHandle, GLuint normalMatrixHandle, GLuint posXYHandle, GLuint posYHandle, GLuint gradientHandle)
+void WaveSimRenderer::render(GLuint colorHandle, GLuint modelViewMatrixHandle, GLuint modelMatrixHandle, GLuint normalMatrixHandle, GLuint posXYHandle, GLuint posYHandle, GLuint gradientHandle, GLuint packedNormalsHandle)
 {
 	m_modelViewMatrix = m_viewMatrix * m_modelMatrix;
 
@@ -251,24 +187,35 @@ void WaveSimRenderer::render(GLuint colorHandle, GLuint modelViewMatrixHandle, G
 
 	glBindBuffer(GL_ARRAY_BUFFER, m_waterXZVBO);
 	glVertexAttribPointer(posXYHandle, 2, GL_FLOAT, GL_FALSE, 0, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, m_waterYVBO[m_renderCurrent]);
-	glVertexAttribPointer(posYHandle, 1, GL_FLOAT, GL_FALSE, 0, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, m_waterGVBO[m_renderCurrent]);
-	glVertexAttribPointer(gradientHandle, 2, GL_FLOAT, GL_FALSE, 0, 0);
+	const bool packed = !m_sourceHeights || !m_sourceGradients;
+	if (packed)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_waterVBO.getBuffer());
+		NvVertexPacking::setAttribPointers(posYHandle, gradientHandle, m_waterVBO.getReadOffset());
+	}
+	else
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_sourceHeights);
+		glVertexAttribPointer(posYHandle, 1, GL_FLOAT, GL_FALSE, 0, 0);
+		glBindBuffer(GL_ARRAY_BUFFER, m_sourceGradients);
+		glVertexAttribPointer(gradientHandle, 2, GL_FLOAT, GL_FALSE, 0, 0);
+	}
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glUniform1i(packedNormalsHandle, packed ? 1 : 0);
 
 	glEnableVertexAttribArray(posXYHandle);
 	glEnableVertexAttribArray(posYHandle);
 	glEnableVertexAttribArray(gradientHandle);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_waterIBO);
-	glDrawElements(GL_TRIANGLES, m_vertCount, GL_UNSIGNED_SHORT, 0);
-	//glDrawElements(GL_LINE_LOOP, m_vertCount, GL_UNSIGNED_SHORT, 0);
+	if (m_waterIndices)
+		m_waterIndices->draw();
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 	glDisableVertexAttribArray(posXYHandle);
 	glDisableVertexAttribArray(posYHandle);
 	glDisableVertexAttribArray(gradientHandle);
 
-	m_renderCurrent = ++m_renderCurrent % NUM_BUFFERS;
+	//the slot drawn from may not be rewritten until the GPU is done with it
+	if (packed)
+		m_waterVBO.fenceRead();
 }
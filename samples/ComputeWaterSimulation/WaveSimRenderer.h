@@ -34,11 +34,10 @@
 #ifndef _WAVE_SIM_RENDERER_
 #define _WAVE_SIM_RENDERER_
 
-//#define USE_GL_BUFFER_SUB_DATA 1
-//else use glmap/memcpy/glunmap
-
 #include "NV/NvPlatformGL.h"
 #include "NV/NvMath.h"
+#include "NvGLUtils/NvGridIndexBuffer.h"
+#include "NvGLUtils/NvStreamingBuffer.h"
 
 #include "WaveSim.h"
 
@@ -54,9 +53,6 @@ public:
 	//stores the number of renderers
 	static int m_renderersCount;
 
-	//number of buffers for round-robin VBO's
-	static const int NUM_BUFFERS = 4;
-
 	//matrices for the surface
 	nv::matrix4f m_modelMatrix, m_modelViewMatrix, m_normalMatrix;
 
@@ -83,26 +79,53 @@ public:
 	//init the Vertex Buffers
 	void initBuffers();
 
-	//update the buffer data using round-robin VBO's
-	void updateBufferData();
+	//pack the current simulation results into the next slot of the streamed VBO, the heights
+	//alpha of the way from the ones before the last step
+	void updateBufferData(float alpha = 1.0f);
+
+	//prepare the memory a simulation step writes (see getOutput()): the next slot of the streamed VBO
+	//when it is persistently mapped, system memory otherwise; endUpdate() must follow once the step has completed
+	void beginUpdate();
+
+	//the memory prepared by beginUpdate(), for WaveSim::setOutput(), or NULL
+	NvPackedHeightVertex* getOutput() { return m_output; }
+
+	//unmap or upload the slot filled since beginUpdate() and make it the one rendered
+	void endUpdate();
 
-	//render the surface
-	void render(GLuint colorHandle, GLuint modelViewMatrixHandle, GLuint modelMatrixHandle, GLuint normalMatrixHandle, GLuint posXYHandle, GLuint posYHandle, GLuint gradientHandle);
+	//render float heights and gradients from these buffers instead of the streamed VBO (0 to stop)
+	void setSourceBuffers(GLuint heights, GLuint gradients);
+
+	//render the surface; packedNormalsHandle is the uniform telling the shader whether gradientHandle
+	//receives a gradient or a packed normal
+	void render(GLuint colorHandle, GLuint modelViewMatrixHandle, GLuint modelMatrixHandle, GLuint normalMatrixHandle, GLuint posXYHandle, GLuint posYHandle, GLuint gradientHandle, GLuint packedNormalsHandle);
 
 	//pointer to the simulation object
 	WaveSim *m_simulation;
 
-	//handles to the water's XZ VBO and Index Buffers (static and donot change)
-	GLuint m_waterXZVBO, m_waterIBO;
+	//handle to the water's XZ VBO (static and donot change)
+	GLuint m_waterXZVBO;
+
+	//the grid's indices, shared with every surface of the same size
+	NvGridIndexBuffer* m_waterIndices;
+
+	//the water heights and normals, packed into 32 bits per vertex and streamed from the CPU simulation
+	NvStreamingBuffer m_waterVBO;
+
+	//buffers rendered instead of the streamed ones (e.g. written by the compute shader), or 0
+	GLuint m_sourceHeights, m_sourceGradients;
+
+	//true between beginUpdate() and endUpdate()
+	bool m_updating;
 
-	//handles to the water Y VBO(heights) and the waver G VBO(gradients)
-	GLuint m_waterYVBO[NUM_BUFFERS], m_waterGVBO[NUM_BUFFERS];
+	//the slot mapped by beginUpdate(), with a persistently mapped VBO
+	NvPackedHeightVertex* m_mapped;
 
-	//index variables to point at the current, previous vbo's for update buffers and a renderCurrent for the current rendering VBO.
-	int m_current, m_previous, m_renderCurrent;
+	//the step's output when the VBO is not persistently mapped, uploaded by endUpdate()
+	NvPackedHeightVertex* m_staging;
 
-	// variable to store the number of vertices for glDrawElements();
-	int m_vertCount;
+	//m_mapped or m_staging, while updating
+	NvPackedHeightVertex* m_output;
 };
 
 
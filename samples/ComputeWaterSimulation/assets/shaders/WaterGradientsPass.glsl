@@ -35,7 +35,7 @@
 #extension GL_ARB_compute_shader : enable
 #extension GL_ARB_shader_storage_buffer_object : enable
 
-#UNIFORMS
+#include "uniforms.h"
 
 uniform uint GridSize;
 
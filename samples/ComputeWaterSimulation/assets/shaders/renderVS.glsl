@@ -33,7 +33,7 @@
 //----------------------------------------------------------------------------------
 #version 430
 
-#UNIFORMS
+#include "uniforms.h"
 
 layout(location=0) in vec4 position;
 layout(location=1) in vec4 color;
@@ -43,7 +43,9 @@ uniform vec4 eyePositionWorld;
 
 attribute vec2 vPositionXZ;
 attribute float vPositionY;
-attribute vec2 vGradient;
+attribute vec2 vGradient;	//the gradient, or the octahedral normal when packedNormals is set
+
+uniform int packedNormals;
 
 varying vec3 reflectedCubeMapCoord;
 varying vec3 refractedCubeMapCoord;
@@ -56,9 +58,18 @@ float pow2(float x)
 	return x*x;
 }
 
+//inverse of the octahedral mapping in NvVertexPacking, y up
+vec3 decodeNormal(vec2 e)
+{
+	vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+	if (n.y < 0.0)
+		n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
 void main()
 {
-	vec3 vNormal = normalize(vec3(vGradient.x, 1.0, vGradient.y));
+	vec3 vNormal = (packedNormals != 0) ? decodeNormal(vGradient) : normalize(vec3(vGradient.x, 1.0, vGradient.y));
 	
 	vec3 normal = normalize(mat3(NormalMatrix) * vNormal);
 
@@ -0,0 +1,451 @@
+//----------------------------------------------------------------------------------
+// File:        FeedbackParticlesApp/CPUParticles.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "CPUParticles.h"
+#include <NvAppBase/NvJobSystem.h>
+#include <NvAppBase/NvNoiseVolume.h>
+#include <NvGLUtils/NvProfiler.h>
+#include <NV/NvLogs.h>
+#include <math.h>
+#include <string.h>
+
+
+//------------------------------------------------------------------------------
+// The functions below follow feedback.vert line by line
+//
+static inline float fract(float x)
+{
+    return x - floorf(x);
+}
+
+static inline float mixf(float a,float b,float t)
+{
+    return a + (b - a)*t;
+}
+
+static inline float clampf(float x,float lo,float hi)
+{
+    return x < lo ? lo : (x > hi ? hi : x);
+}
+
+static inline float sphereDistance(float x,float y,float z,const nv::vec3f& c,float r)
+{
+    const float dx = x - c.x, dy = y - c.y, dz = z - c.z;
+    return sqrtf(dx*dx + dy*dy + dz*dz) - r;
+}
+
+static inline float smin(float a,float b,float k)
+{
+    const float h = clampf(0.5f + 0.5f*(b - a)/k,0.0f,1.0f);
+    return mixf(b,a,h) - k*h*(1.0f - h);
+}
+
+static inline float sampleDistance(float x,float y,float z,const nv::vec3f* c)
+{
+    const float s1 = sphereDistance(x,y,z,c[0],0.3f);
+    const float s2 = sphereDistance(x,y,z,c[1],0.2f);
+    const float s3 = sphereDistance(x,y,z,c[2],0.3f);
+
+    return smin(smin(s1,s2,0.1f),s3,0.1f);
+}
+
+// smoothStep((r + 1)/2)*2 - 1, clamped rather than branched
+static inline float ramp(float r)
+{
+    r = clampf((r + 1.0f)*0.5f,0.0f,1.0f);
+    return r*r*r*(10.0f + r*(-15.0f + r*6.0f))*2.0f - 1.0f;
+}
+
+
+//------------------------------------------------------------------------------
+//
+CPUParticles::CPUParticles()
+    : m_x(NULL),
+      m_y(NULL),
+      m_z(NULL),
+      m_vx(NULL),
+      m_vy(NULL),
+      m_vz(NULL),
+      m_age(NULL),
+      m_color(NULL),
+      m_count(0),
+      m_capacity(0),
+      m_random(NULL),
+      m_randomExtent(0),
+      m_fbm(NULL),
+      m_fbmSize(0)
+{
+    memset(&m_frame,0,sizeof(m_frame));
+}
+
+
+//------------------------------------------------------------------------------
+//
+CPUParticles::~CPUParticles()
+{
+    release();
+}
+
+
+//------------------------------------------------------------------------------
+//
+bool CPUParticles::init(uint32_t capacity,const float* randomValues,uint32_t randomExtent,
+                        const NvNoiseVolume& fbm)
+{
+    const NvNoiseVolume::Desc& fbmDesc = fbm.getDesc();
+    if (!fbm.getData() || fbmDesc.channels != 3 ||
+        fbmDesc.width != fbmDesc.height || fbmDesc.width != fbmDesc.depth)
+    {
+        LOGE("CPUParticles: the FBM volume must be a cube of 3 channels\n");
+        return false;
+    }
+
+    release();
+
+    m_capacity  = capacity;
+    m_x         = new float[m_capacity];
+    m_y         = new float[m_capacity];
+    m_z         = new float[m_capacity];
+    m_vx        = new float[m_capacity];
+    m_vy        = new float[m_capacity];
+    m_vz        = new float[m_capacity];
+    m_age       = new float[m_capacity];
+    m_color     = new uint32_t[m_capacity];
+
+    m_randomExtent = randomExtent;
+    m_random    = new float[randomExtent*4];
+    memcpy(m_random,randomValues,randomExtent*4*sizeof(float));
+
+    m_fbmSize   = fbmDesc.width;
+    m_fbm       = new float[m_fbmSize*m_fbmSize*m_fbmSize*3];
+    fbm.decode(m_fbm);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+//
+void CPUParticles::release()
+{
+    delete [] m_x;
+    delete [] m_y;
+    delete [] m_z;
+    delete [] m_vx;
+    delete [] m_vy;
+    delete [] m_vz;
+    delete [] m_age;
+    delete [] m_color;
+    delete [] m_random;
+    delete [] m_fbm;
+
+    m_x = m_y = m_z = m_vx = m_vy = m_vz = m_age = m_random = m_fbm = NULL;
+    m_color     = NULL;
+    m_fbmSize   = 0;
+    m_count     = 0;
+    m_capacity  = 0;
+}
+
+
+//------------------------------------------------------------------------------
+// texture(u_RandomTexture,vec2(a,0.5)): linear filtering, repeating
+//
+float CPUParticles::getRandom(float a) const
+{
+    return getRandomVector(a).x + 0.5f;
+}
+
+nv::vec3f CPUParticles::getRandomVector(float a) const
+{
+    const float u  = fract(a)*m_randomExtent - 0.5f;
+    const float fl = floorf(u);
+    const float f  = u - fl;
+    const uint32_t i0 = ((int32_t)fl + m_randomExtent)%m_randomExtent;
+    const uint32_t i1 = (i0 + 1)%m_randomExtent;
+    const float* t0 = m_random + i0*4;
+    const float* t1 = m_random + i1*4;
+
+    return nv::vec3f(mixf(t0[0],t1[0],f) - 0.5f,
+                     mixf(t0[1],t1[1],f) - 0.5f,
+                     mixf(t0[2],t1[2],f) - 0.5f);
+}
+
+
+//------------------------------------------------------------------------------
+// texture(u_FBMTexture,(p + 2)*0.25): trilinear, repeating
+//
+void CPUParticles::sampleFbm(const float* x,const float* y,const float* z,uint32_t n,
+                             float* fx,float* fy,float* fz) const
+{
+    const int32_t N = m_fbmSize;
+    for (uint32_t i = 0;i < n;i++)
+    {
+        const float u = fract((x[i] + 2.0f)*0.25f)*N - 0.5f;
+        const float v = fract((y[i] + 2.0f)*0.25f)*N - 0.5f;
+        const float w = fract((z[i] + 2.0f)*0.25f)*N - 0.5f;
+        const float u0 = floorf(u), v0 = floorf(v), w0 = floorf(w);
+        const float a = u - u0, b = v - v0, c = w - w0;
+        const int32_t i0 = ((int32_t)u0 + N)%N, i1 = (i0 + 1)%N;
+        const int32_t j0 = ((int32_t)v0 + N)%N, j1 = (j0 + 1)%N;
+        const int32_t k0 = ((int32_t)w0 + N)%N, k1 = (k0 + 1)%N;
+
+        const float* t000 = m_fbm + ((k0*N + j0)*N + i0)*3;
+        const float* t100 = m_fbm + ((k0*N + j0)*N + i1)*3;
+        const float* t010 = m_fbm + ((k0*N + j1)*N + i0)*3;
+        const float* t110 = m_fbm + ((k0*N + j1)*N + i1)*3;
+        const float* t001 = m_fbm + ((k1*N + j0)*N + i0)*3;
+        const float* t101 = m_fbm + ((k1*N + j0)*N + i1)*3;
+        const float* t011 = m_fbm + ((k1*N + j1)*N + i0)*3;
+        const float* t111 = m_fbm + ((k1*N + j1)*N + i1)*3;
+
+        float out[3];
+        for (int32_t e = 0;e < 3;e++)
+        {
+            out[e] = mixf(mixf(mixf(t000[e],t100[e],a),mixf(t010[e],t110[e],a),b),
+                          mixf(mixf(t001[e],t101[e],a),mixf(t011[e],t111[e],a),b),c);
+        }
+        fx[i] = out[0];
+        fy[i] = out[1];
+        fz[i] = out[2];
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// feedback.vert's samplePotential over a block of points
+//
+void CPUParticles::samplePotential(const float* x,const float* y,const float* z,uint32_t n,
+                                   float* px,float* py,float* pz) const
+{
+    const float e = 0.01f;
+    const nv::vec3f* c = m_colliders;
+
+    float fx[BLOCK_SIZE],fy[BLOCK_SIZE],fz[BLOCK_SIZE];
+    if (m_frame.removeNoise)
+    {
+        // the feedback path samples no texture, which reads as zero
+        memset(fx,0,n*sizeof(float));
+        memset(fy,0,n*sizeof(float));
+        memset(fz,0,n*sizeof(float));
+    }
+    else
+    {
+        sampleFbm(x,y,z,n,fx,fy,fz);
+    }
+
+    for (uint32_t i = 0;i < n;i++)
+    {
+        // computeGradient
+        const float d    = sampleDistance(x[i],y[i],z[i],c);
+        const float dfdx = sampleDistance(x[i] + e,y[i],z[i],c) - d;
+        const float dfdy = sampleDistance(x[i],y[i] + e,z[i],c) - d;
+        const float dfdz = sampleDistance(x[i],y[i],z[i] + e,c) - d;
+        const float inv  = 1.0f/sqrtf(dfdx*dfdx + dfdy*dfdy + dfdz*dfdz);
+        const float gx = dfdx*inv, gy = dfdy*inv, gz = dfdz*inv;
+
+        const float alpha = ramp(fabsf(d));
+
+        // blendVectors(getFbm(p)*2,alpha,gradient) + blendVectors(vec3(p.z,0,-p.x)*3,alpha,gradient)
+        const float ax = fx[i]*2.0f, ay = fy[i]*2.0f, az = fz[i]*2.0f;
+        const float bx = z[i]*3.0f,  by = 0.0f,       bz = -x[i]*3.0f;
+        const float da = (ax*gx + ay*gy + az*gz)*(1.0f - alpha);
+        const float db = (bx*gx + by*gy + bz*gz)*(1.0f - alpha);
+
+        px[i] = (alpha*(ax + bx) + (da + db)*gx)/25.0f;
+        py[i] = (alpha*(ay + by) + (da + db)*gy)/25.0f;
+        pz[i] = (alpha*(az + bz) + (da + db)*gz)/25.0f;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// feedback.vert's curlOperator over a block of points: central differences of the
+// potential at the six neighbours
+//
+void CPUParticles::curl(const float* x,const float* y,const float* z,uint32_t n,
+                        float* cx,float* cy,float* cz) const
+{
+    const float e = 0.0001f;
+
+    // [axis][sign] potentials at pos +- e along the axis
+    float px[3][2][BLOCK_SIZE],py[3][2][BLOCK_SIZE],pz[3][2][BLOCK_SIZE];
+    float ox[BLOCK_SIZE],oy[BLOCK_SIZE],oz[BLOCK_SIZE];
+    for (uint32_t axis = 0;axis < 3;axis++)
+    {
+        for (uint32_t s = 0;s < 2;s++)
+        {
+            const float d = s ? -e : e;
+            const float dx = (axis == 0) ? d : 0.0f;
+            const float dy = (axis == 1) ? d : 0.0f;
+            const float dz = (axis == 2) ? d : 0.0f;
+            for (uint32_t i = 0;i < n;i++)
+            {
+                ox[i] = x[i] + dx;
+                oy[i] = y[i] + dy;
+                oz[i] = z[i] + dz;
+            }
+            samplePotential(ox,oy,oz,n,px[axis][s],py[axis][s],pz[axis][s]);
+        }
+    }
+
+    const float scale = 1.0f/(2.0f*e);
+    for (uint32_t i = 0;i < n;i++)
+    {
+        cx[i] = (pz[1][0][i] - pz[1][1][i] - py[2][0][i] + py[2][1][i])*scale;
+        cy[i] = (px[2][0][i] - px[2][1][i] - pz[0][0][i] + pz[0][1][i])*scale;
+        cz[i] = (py[0][0][i] - py[0][1][i] - px[1][0][i] + px[1][1][i])*scale;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// feedback.vert's main: age, then a midpoint step along the curl
+//
+void CPUParticles::integrate(uint32_t begin,uint32_t end)
+{
+    const float dt = m_frame.deltaTime;
+    float vx[BLOCK_SIZE],vy[BLOCK_SIZE],vz[BLOCK_SIZE];
+    float mx[BLOCK_SIZE],my[BLOCK_SIZE],mz[BLOCK_SIZE];
+    float wx[BLOCK_SIZE],wy[BLOCK_SIZE],wz[BLOCK_SIZE];
+
+    for (uint32_t b = begin;b < end;b += BLOCK_SIZE)
+    {
+        const uint32_t n = (end - b < (uint32_t)BLOCK_SIZE) ? end - b : (uint32_t)BLOCK_SIZE;
+        float* x = m_x + b;
+        float* y = m_y + b;
+        float* z = m_z + b;
+
+        curl(x,y,z,n,vx,vy,vz);
+        for (uint32_t i = 0;i < n;i++)
+        {
+            mx[i] = x[i] + 0.5f*dt*vx[i];
+            my[i] = y[i] + 0.5f*dt*vy[i];
+            mz[i] = z[i] + 0.5f*dt*vz[i];
+        }
+        curl(mx,my,mz,n,wx,wy,wz);
+
+        float* age = m_age + b;
+        for (uint32_t i = 0;i < n;i++)
+        {
+            x[i]   += dt*wx[i];
+            y[i]   += dt*wy[i];
+            z[i]   += dt*wz[i];
+            age[i] += dt;
+        }
+        memcpy(m_vx + b,vx,n*sizeof(float));
+        memcpy(m_vy + b,vy,n*sizeof(float));
+        memcpy(m_vz + b,vz,n*sizeof(float));
+    }
+}
+
+
+//------------------------------------------------------------------------------
+//
+void CPUParticles::integrateRange(void* data,int32_t begin,int32_t end)
+{
+    ((CPUParticles*)data)->integrate(begin,end);
+}
+
+
+//------------------------------------------------------------------------------
+//
+void CPUParticles::emit(uint32_t emitterIndex,const nv::vec3f& position,const uint8_t* color,
+                        uint32_t count,float time)
+{
+    const uint32_t packedColor = color[0]|(color[1]<<8)|(color[2]<<16);
+
+    float seed = (time*123525.0f + emitterIndex*1111.0f)/1234.0f;
+    for (uint32_t n = 0;n < count && m_count < m_capacity;n++)
+    {
+        const nv::vec3f dir = nv::normalize(getRandomVector(seed));
+        const nv::vec3f vel = dir/(10.0f + getRandom(seed)*20.0f)*0.3f;
+        const nv::vec3f pos = position + vel*2.77f;
+
+        m_x[m_count]     = pos.x;
+        m_y[m_count]     = pos.y;
+        m_z[m_count]     = pos.z;
+        m_vx[m_count]    = vel.x;
+        m_vy[m_count]    = vel.y;
+        m_vz[m_count]    = vel.z;
+        m_age[m_count]   = 0.0f;
+        m_color[m_count] = packedColor;
+        m_count++;
+
+        seed += 4207.56f;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+//
+void CPUParticles::process(const Frame& frame,bool parallel)
+{
+    m_frame = frame;
+
+    const float t = frame.collidersTime;
+    m_colliders[0] = nv::vec3f(sinf(t)*0.3f,0.0f,cosf(t)*0.3f);
+    m_colliders[1] = nv::vec3f(sinf(t/2.0f)*0.2f,-0.5f,cosf(t/2.0f)*0.2f);
+    m_colliders[2] = nv::vec3f(sinf(t/2.5f)*0.4f,0.6f,cosf(t/2.5f)*0.4f);
+
+    {
+        NV_PROFILE_SCOPE("CPU particles integrate");
+        if (parallel)
+            NvJobSystem::parallelFor(integrateRange,this,m_count,JOB_GRAIN,"CPU particles integrate");
+        else
+            integrate(0,m_count);
+    }
+
+    // feedback.geom keeps the particles younger than their lifetime; the dead ones
+    // are replaced by the last live one
+    NV_PROFILE_SCOPE("CPU particles remove");
+    const float lifetime = frame.particleLifetime;
+    uint32_t i = 0;
+    while (i < m_count)
+    {
+        if (m_age[i] < lifetime)
+        {
+            i++;
+            continue;
+        }
+
+        const uint32_t last = --m_count;
+        m_x[i]      = m_x[last];
+        m_y[i]      = m_y[last];
+        m_z[i]      = m_z[last];
+        m_vx[i]     = m_vx[last];
+        m_vy[i]     = m_vy[last];
+        m_vz[i]     = m_vz[last];
+        m_age[i]    = m_age[last];
+        m_color[i]  = m_color[last];
+    }
+}
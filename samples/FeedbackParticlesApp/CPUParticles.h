@@ -0,0 +1,139 @@
+//----------------------------------------------------------------------------------
+// File:        FeedbackParticlesApp/CPUParticles.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef _CPU_PARTICLES_H
+#define _CPU_PARTICLES_H
+
+#include <NvFoundation.h>
+#include <NV/NvMath.h>
+
+class NvNoiseVolume;
+
+
+//------------------------------------------------------------------------------
+// CPU version of the transform feedback particle update: the same emission,
+// lifetimes and curl-of-FBM motion as emitter_feedback.geom and feedback.vert/geom,
+// for contexts or runs (e.g. headless tests) that cannot use the feedback path, and
+// as a reference for it.
+//
+// The particles live in a structure-of-arrays pool.  Dead particles are removed by
+// moving the last one into their slot, so the pool stays dense but not in order.
+// The integration runs over blocks of particles in branch-free loops, so the
+// compiler can vectorize them, and the blocks are spread over the job system.
+class CPUParticles
+{
+public:
+    enum
+    {
+        BLOCK_SIZE      = 64,   // particles integrated together
+        JOB_GRAIN       = 1024, // particles per parallelFor job
+    };
+
+    struct Frame
+    {
+        float   time;
+        float   deltaTime;
+        float   collidersTime;
+        float   particleLifetime;
+        bool    removeNoise;
+    };
+
+    CPUParticles();
+    ~CPUParticles();
+
+    // randomValues: the randomExtent RGBA values of the feedback path's random texture;
+    // fbm: the 3 channel cube the feedback path's FBM texture is made from
+    bool            init(uint32_t capacity,const float* randomValues,uint32_t randomExtent,
+                         const NvNoiseVolume& fbm);
+    void            release();
+    void            clear() { m_count = 0; };
+
+    // emits count particles from an emitter, as emitter_feedback.geom does;
+    // emitterIndex stands in for gl_PrimitiveIDIn
+    void            emit(uint32_t emitterIndex,const nv::vec3f& position,const uint8_t* color,
+                         uint32_t count,float time);
+
+    // ages and moves every particle, and removes those past their lifetime;
+    // parallel spreads the blocks over the job system workers
+    void            process(const Frame& frame,bool parallel=true);
+
+    uint32_t        getCount() const { return m_count; };
+    uint32_t        getCapacity() const { return m_capacity; };
+
+    // the pool, getCount() particles long
+    const float*    getX() const { return m_x; };
+    const float*    getY() const { return m_y; };
+    const float*    getZ() const { return m_z; };
+    const float*    getVelocityX() const { return m_vx; };
+    const float*    getVelocityY() const { return m_vy; };
+    const float*    getVelocityZ() const { return m_vz; };
+    const float*    getAge() const { return m_age; };
+    // rgb in the low three bytes
+    const uint32_t* getColor() const { return m_color; };
+
+private:
+    float           getRandom(float a) const;
+    nv::vec3f       getRandomVector(float a) const;
+    void            sampleFbm(const float* x,const float* y,const float* z,uint32_t n,
+                              float* fx,float* fy,float* fz) const;
+    void            samplePotential(const float* x,const float* y,const float* z,uint32_t n,
+                                    float* px,float* py,float* pz) const;
+    void            curl(const float* x,const float* y,const float* z,uint32_t n,
+                         float* cx,float* cy,float* cz) const;
+    void            integrate(uint32_t begin,uint32_t end);
+
+    static void     integrateRange(void* data,int32_t begin,int32_t end);
+
+    float*          m_x;
+    float*          m_y;
+    float*          m_z;
+    float*          m_vx;
+    float*          m_vy;
+    float*          m_vz;
+    float*          m_age;
+    uint32_t*       m_color;
+    uint32_t        m_count;
+    uint32_t        m_capacity;
+
+    float*          m_random;
+    uint32_t        m_randomExtent;
+    // xyz per texel of the FBM volume, m_fbmSize^3 texels
+    float*          m_fbm;
+    int32_t         m_fbmSize;
+
+    // per-frame state read by the range jobs
+    Frame           m_frame;
+    nv::vec3f       m_colliders[3];
+};
+
+#endif
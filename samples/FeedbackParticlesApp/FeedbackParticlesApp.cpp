@@ -44,16 +44,28 @@
 #include <NvUI/NvTweakBar.h>
 #include <NV/NvLogs.h>
 #include "FeedbackParticlesApp.h"
+#include "ParticleBenchmark.h"
 #include "Utils.h"
 
 
 //------------------------------------------------------------------------------
 //
 FeedbackParticlesApp::FeedbackParticlesApp(NvPlatformContext* platform) 
-    : NvSampleApp(platform, "Feedback Particles Sample")
+    : NvSampleApp(platform, "Feedback Particles Sample"),
+      m_cpuParticles(false)
 {
     // Required in all subclasses to avoid silent link issues
     forceLinkHack();
+
+    // -cpuparticles emits and moves the particles on the CPU even when transform feedback is available
+    // -particlebench times the CPU particle update, then exits
+    const std::vector<std::string>& cmd = platform->getCommandLine();
+    for (std::vector<std::string>::const_iterator it = cmd.begin(); it != cmd.end(); ++it)
+    {
+        if (0 == (*it).compare("-cpuparticles"))
+            m_cpuParticles = true;
+    }
+    addBenchmarkMode("-particlebench", runParticleBenchmark);
 }
 
 
@@ -79,13 +91,16 @@ void FeedbackParticlesApp::configurationCallback(NvEGLConfiguration& config)
 //
 void FeedbackParticlesApp::initRendering(void) 
 {
-    if (!requireMinAPIVersion(NvGfxAPIVersionGL4())) 
+    // the CPU backend only needs GL 3 (mapped buffers and point sprites); transform feedback
+    // drawing and the billboard geometry shader need GL 4, so lesser contexts fall back to it
+    if (!requireMinAPIVersion(NvGfxAPIVersion(NvGfxAPI::GL, 3))) 
         return;
 
     m_transformer->setTranslationVec(nv::vec3f(0.0f,0.0f,-3.0f));
 
     NvAssetLoaderAddSearchPath("FeedbackParticlesApp");
-    m_scene.init();
+    const bool hasFeedback = (getGLContext()->getConfiguration().apiVer >= NvGfxAPIVersionGL4());
+    m_scene.init((m_cpuParticles || !hasFeedback) ? ParticleSystem::BACKEND_CPU : ParticleSystem::BACKEND_FEEDBACK);
 }
 
 
@@ -58,6 +58,7 @@ protected:
 private:
     FeedbackParticlesScene  m_scene;
     NvUIValueText*          m_countText;
+    bool                    m_cpuParticles;
 };
 
 #endif
\ No newline at end of file
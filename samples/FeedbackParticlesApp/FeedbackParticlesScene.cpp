@@ -36,10 +36,11 @@
 
 //-----------------------------------------------------------------------------
 //
-bool FeedbackParticlesScene::init()
+bool FeedbackParticlesScene::init(ParticleSystem::Backend backend)
 {
     m_isSimulationStopped = false;
     m_reset = false;
+    m_particleSystem.setBackend(backend);
     m_particleSystem.init();
 
     return true;
@@ -46,7 +46,7 @@ class FeedbackParticlesScene
 {
     friend class FeedbackParticlesApp;
 public:
-    bool            init();
+    bool            init(ParticleSystem::Backend backend);
     void            release();
     void            update(float deltaTime);
     void            draw();
@@ -0,0 +1,131 @@
+//----------------------------------------------------------------------------------
+// File:        FeedbackParticlesApp/ParticleBenchmark.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "ParticleBenchmark.h"
+#include "CPUParticles.h"
+#include "TextureUtils.h"
+#include "Utils.h"
+#include <NvAppBase/NvJobSystem.h>
+#include <NV/NvLogs.h>
+#include <NV/NvStopWatch.h>
+#include <math.h>
+#include <stdlib.h>
+
+
+//------------------------------------------------------------------------------
+//
+bool runParticleBenchmark(NvStopWatch* stopWatch)
+{
+    const uint32_t counts[]     = { 16384, 65536, 262144 };
+    const uint32_t frames       = 10;
+    const float    frameSeconds = 1.0f/60.0f;
+    const uint32_t randomExtent = 2048;
+    const uint32_t threads      = NvJobSystem::getWorkerCount() + 1;
+
+    float* randomValues = new float[randomExtent*4];
+    for (uint32_t n = 0;n < randomExtent*4;n++)
+        randomValues[n] = rand()/(float)RAND_MAX;
+
+    CPUParticles particles;
+    NvNoiseVolume fbm;
+    stopWatch->reset();
+    stopWatch->start();
+    fbm.generate(TexturesUtils::FBMVolumeDesc());
+    particles.init(counts[countof(counts) - 1],randomValues,randomExtent,fbm);
+    stopWatch->stop();
+    delete [] randomValues;
+
+    LOGI("Particle benchmark: %u threads, FBM volume ready in %.1f ms\n",threads,stopWatch->getTime()*1000.0f);
+
+    bool passed = true;
+    for (uint32_t c = 0;c < countof(counts);c++)
+    {
+        // as many emitters as the sample's UI allows, around the emitter ring, with
+        // lifetimes long enough that every particle lives through the run
+        particles.clear();
+        const uint8_t color[3] = { 255,255,255 };
+        float time = 0.0f;
+        for (uint32_t n = 0;particles.getCount() < counts[c];n++)
+        {
+            const float a = n*0.7f;
+            particles.emit(n%32,nv::vec3f(sinf(a)*0.2f,-1.5f,cosf(a)*0.2f),color,100,time);
+            time += 0.005f;
+        }
+        const uint32_t emitted = particles.getCount();
+
+        float ms[2];
+        for (uint32_t parallel = 0;parallel < 2;parallel++)
+        {
+            CPUParticles::Frame frame;
+            frame.time              = time;
+            frame.deltaTime         = frameSeconds;
+            frame.collidersTime     = time;
+            frame.particleLifetime  = 1.0e9f;
+            frame.removeNoise       = false;
+
+            stopWatch->reset();
+            stopWatch->start();
+            for (uint32_t f = 0;f < frames;f++)
+            {
+                particles.process(frame,parallel != 0);
+                frame.time          += frameSeconds;
+                frame.collidersTime += frameSeconds;
+            }
+            stopWatch->stop();
+            ms[parallel] = stopWatch->getTime()*1000.0f/frames;
+        }
+
+        const double oneThread  = counts[c]/(ms[0]/1000.0);
+        const double allThreads = counts[c]/(ms[1]/1000.0);
+        LOGI("Particles %7u: 1 thread %8.2f ms/frame (%5.2f M particles/s per core), "
+             "%u threads %8.2f ms/frame (%5.2f M particles/s, %5.2f M per core)\n",
+             counts[c],ms[0],oneThread/1.0e6,threads,ms[1],allThreads/1.0e6,allThreads/threads/1.0e6);
+
+        // nothing may die or blow up on either path
+        uint32_t broken = 0;
+        for (uint32_t n = 0;n < particles.getCount();n++)
+        {
+            const float sum = particles.getX()[n] + particles.getY()[n] + particles.getZ()[n];
+            if (!(sum - sum == 0.0f))
+                broken++;
+        }
+        if (particles.getCount() != emitted || broken != 0)
+        {
+            LOGE("Particles %7u: %u of %u alive after the run, %u with non-finite positions\n",
+                 counts[c],particles.getCount(),emitted,broken);
+            passed = false;
+        }
+    }
+
+    return passed;
+}
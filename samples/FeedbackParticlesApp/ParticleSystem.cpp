@@ -36,9 +36,19 @@
 #include <NvGLUtils/NvGLSLProgram.h>
 #include <NvModel/NvShapes.h>
 #include <NV/NvLogs.h>
+#include <NvAppBase/NvJobSystem.h>
+#include <NvGLUtils/NvProfiler.h>
 #include "TextureUtils.h"
 #include "Utils.h"
 
+#ifndef GL_POINT_SPRITE
+#define GL_POINT_SPRITE                   0x8861
+#endif
+
+#ifndef GL_PROGRAM_POINT_SIZE
+#define GL_PROGRAM_POINT_SIZE             0x8642
+#endif
+
 
 //------------------------------------------------------------------------------
 //
@@ -63,7 +73,10 @@ ParticleSystem::ParticleSystem()
       m_emittersBuffer(0),
       m_particleTexture(0),
       m_randomTexture(0),
-      m_FBMTexture(0)
+      m_FBMTexture(0),
+      m_backend(BACKEND_FEEDBACK),
+      m_cpuBuffer(0),
+      m_cpuTarget(NULL)
 {
     memset(&m_emitters,0,sizeof(m_emitters));
 }
@@ -148,6 +161,21 @@ bool ParticleSystem::initEmitterProgram()
 //
 bool ParticleSystem::initBillboardProgram()
 {
+    if (BACKEND_CPU == m_backend)
+    {
+        //point sprites need no geometry shader, so the CPU backend runs on any GL 3 context
+        NvAsset vertShader("billboard_point.vert");
+        NvAsset fragShader("billboard_point.frag");
+
+        m_billboardProgram = new NvGLSLProgram();
+        m_billboardProgram->setSourceFromStrings(vertShader,fragShader);
+
+        m_billboardProgram->enable();
+        m_billboardProgram->setUniform1i("u_Texture",PARTICLE_TEX_UNIT);
+
+        return true;
+    }
+
     NvAsset vertShader("billboard.vert");
     NvAsset fragShader("billboard.frag");
     NvAsset geomShader("billboard.geom");
@@ -197,14 +225,37 @@ void ParticleSystem::initParticleBuffers()
 //
 bool ParticleSystem::init()
 {
-    initFeedbackProgram();
+    //both backends draw from the same random values
+    float* randomValues = new float[RANDOM_TEX_SIZE*4];
+    for (uint32_t n = 0;n < RANDOM_TEX_SIZE*4;n++)
+        randomValues[n] = rand()/(float)RAND_MAX;
+
+    //and the same FBM volume, generated on the job system workers (or loaded from the noise cache)
+    NvNoiseVolume fbm;
+    fbm.generate(TexturesUtils::FBMVolumeDesc());
+
     initBillboardProgram();
-    initEmitterProgram();
-    initParticleBuffers();
+    if (BACKEND_CPU == m_backend)
+    {
+        //the CPU backend samples the volume itself and needs no feedback objects
+        m_cpuParticles.init(MAX_PARTICLES,randomValues,RANDOM_TEX_SIZE,fbm);
+        glGenBuffers(1,&m_cpuBuffer);
+        m_randomTexture = 0;
+        m_FBMTexture    = 0;
+    }
+    else
+    {
+        initFeedbackProgram();
+        initEmitterProgram();
+        initParticleBuffers();
+
+        m_randomTexture = TexturesUtils::random1DTexture(RANDOM_TEX_SIZE,randomValues);
+        m_FBMTexture    = fbm.createTexture();
+    }
+    LOGI("Particles: %s backend\n",(BACKEND_CPU == m_backend) ? "CPU" : "transform feedback");
+    delete [] randomValues;
 
     m_particleTexture   = TexturesUtils::spotTexture(PARTICLE_TEX_SIZE,PARTICLE_TEX_SIZE);
-    m_randomTexture     = TexturesUtils::random1DTexture(RANDOM_TEX_SIZE);
-    m_FBMTexture        = TexturesUtils::FBM3DTexture(FBM_TEX_SIZE);
 
     m_time              = 0.0f;
     m_isStopped         = false;
@@ -229,9 +280,18 @@ void ParticleSystem::release()
     glDeleteTextures(1,&m_particleTexture);
     glDeleteTextures(1,&m_FBMTexture);
 
+    if (BACKEND_CPU == m_backend)
+    {
+        m_cpuParticles.release();
+        glDeleteBuffers(1,&m_cpuBuffer);
+        m_cpuBuffer = 0;
+        return;
+    }
+
     glDeleteTransformFeedbacks(countof(m_transformFeedback),m_transformFeedback);
     glDeleteBuffers(countof(m_particlesBuffers),m_particlesBuffers);
     glDeleteBuffers(1,&m_emittersBuffer);
+    m_emittersBuffer = 0;
 
     glDeleteQueries(countof(m_countQuery),m_countQuery);
 }
@@ -390,23 +450,114 @@ void ParticleSystem::advanceFeedback()
 }
 
 
+//------------------------------------------------------------------------------
+// emitParticles and processParticles on the CPU: the emitters due this frame emit,
+// then every particle moves, new ones included
+//
+void ParticleSystem::advanceCPU()
+{
+    const Particle* p = m_emitters;
+    for (uint32_t n = 0;n < m_emittersCount;n++)
+    {
+        if (p->age >= m_params.emitPeriod)
+            m_cpuParticles.emit(n,p->position,p->color,m_params.emitCount,m_time);
+        ++p;
+    }
+
+    CPUParticles::Frame frame;
+    frame.time              = m_time;
+    frame.deltaTime         = m_deltaTime;
+    frame.collidersTime     = m_collidersTime;
+    frame.particleLifetime  = m_params.particleLifetime;
+    frame.removeNoise       = m_params.removeNoise;
+    m_cpuParticles.process(frame);
+
+    m_particleCount = m_cpuParticles.getCount();
+    uploadCPUParticles();
+}
+
+
+//------------------------------------------------------------------------------
+//
+void ParticleSystem::packCPURange(void* data,int32_t begin,int32_t end)
+{
+    ParticleSystem* self = (ParticleSystem*)data;
+    const CPUParticles& cpu = self->m_cpuParticles;
+    const float* x   = cpu.getX();
+    const float* y   = cpu.getY();
+    const float* z   = cpu.getZ();
+    const float* vx  = cpu.getVelocityX();
+    const float* vy  = cpu.getVelocityY();
+    const float* vz  = cpu.getVelocityZ();
+    const float* age = cpu.getAge();
+    const uint32_t* color = cpu.getColor();
+
+    Particle* p = self->m_cpuTarget + begin;
+    for (int32_t n = begin;n < end;n++)
+    {
+        p->type     = Particle::NORMAL;
+        p->color[0] = color[n]&255;
+        p->color[1] = (color[n]>>8)&255;
+        p->color[2] = (color[n]>>16)&255;
+        p->age      = age[n];
+        p->position = nv::vec3f(x[n],y[n],z[n]);
+        p->velocity = nv::vec3f(vx[n],vy[n],vz[n]);
+        ++p;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+//
+void ParticleSystem::uploadCPUParticles()
+{
+    NV_PROFILE_SCOPE("CPU particles upload");
+
+    const GLsizeiptr size = m_particleCount*sizeof(Particle);
+    glBindBuffer(GL_ARRAY_BUFFER,m_cpuBuffer);
+    glBufferData(GL_ARRAY_BUFFER,size,NULL,GL_STREAM_DRAW);          //orphan old data
+    if (0 != size)
+    {
+        m_cpuTarget = (Particle*)glMapBufferRange(GL_ARRAY_BUFFER,0,size,
+                                                  GL_MAP_WRITE_BIT|GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (NULL != m_cpuTarget)
+        {
+            NvJobSystem::parallelFor(packCPURange,this,m_particleCount,CPUParticles::JOB_GRAIN,"CPU particles pack");
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            m_cpuTarget = NULL;
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER,0);
+}
+
+
 //------------------------------------------------------------------------------
 //
 void ParticleSystem::drawParticles(const nv::matrix4f& mMV, const nv::matrix4f& mProj)
 {
     nv::matrix4f MVP = mProj*mMV;
-    nv::vec4f right  = mMV.get_row(0);
-    nv::vec4f up     = mMV.get_row(1);
 
     m_billboardProgram->enable();
     m_billboardProgram->setUniformMatrix4fv("u_MVP",(GLfloat*)MVP.get_value(),1);
-    m_billboardProgram->setUniformMatrix4fv("u_MV",(GLfloat*)mMV.get_value(),1);
-    m_billboardProgram->setUniform3f("u_Right",right.x,right.y,right.z);
-    m_billboardProgram->setUniform3f("u_Up",up.x,up.y,up.z);
-    m_billboardProgram->setUniform1f("u_BillboardSize",m_params.billboardSize);
-    m_billboardProgram->setUniform1f("u_VelocityScale",m_params.velocityScale);
     m_billboardProgram->setUniform1f("u_ParticleLifetime",m_params.particleLifetime);
     m_billboardProgram->setUniform1f("u_UseColors",m_params.useColors ? 1.f : 0.f);
+    if (BACKEND_CPU == m_backend)
+    {
+        //a sprite covers the same 2*billboardSize extent as the billboard quad
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT,viewport);
+        m_billboardProgram->setUniform1f("u_PointScale",m_params.billboardSize*mProj.element(1,1)*viewport[3]);
+    }
+    else
+    {
+        nv::vec4f right = mMV.get_row(0);
+        nv::vec4f up    = mMV.get_row(1);
+        m_billboardProgram->setUniformMatrix4fv("u_MV",(GLfloat*)mMV.get_value(),1);
+        m_billboardProgram->setUniform3f("u_Right",right.x,right.y,right.z);
+        m_billboardProgram->setUniform3f("u_Up",up.x,up.y,up.z);
+        m_billboardProgram->setUniform1f("u_BillboardSize",m_params.billboardSize);
+        m_billboardProgram->setUniform1f("u_VelocityScale",m_params.velocityScale);
+    }
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D,m_particleTexture);
@@ -417,9 +568,22 @@ void ParticleSystem::drawParticles(const nv::matrix4f& mMV, const nv::matrix4f&
     else
         glBlendFuncSeparate(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA,GL_ZERO,GL_ONE_MINUS_SRC_ALPHA);
 
-    glBindBuffer(GL_ARRAY_BUFFER,m_particlesBuffers[m_ring.end()]);
-    ms_attributes->apply(m_billboardProgram);
-    glDrawTransformFeedback(GL_POINTS,m_transformFeedback[m_ring.end()]);
+    if (BACKEND_CPU == m_backend)
+    {
+        glEnable(GL_POINT_SPRITE);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glBindBuffer(GL_ARRAY_BUFFER,m_cpuBuffer);
+        ms_attributes->apply(m_billboardProgram);
+        glDrawArrays(GL_POINTS,0,m_particleCount);
+        glDisable(GL_PROGRAM_POINT_SIZE);
+        glDisable(GL_POINT_SPRITE);
+    }
+    else
+    {
+        glBindBuffer(GL_ARRAY_BUFFER,m_particlesBuffers[m_ring.end()]);
+        ms_attributes->apply(m_billboardProgram);
+        glDrawTransformFeedback(GL_POINTS,m_transformFeedback[m_ring.end()]);
+    }
     ms_attributes->reset(m_billboardProgram);
     glBindBuffer(GL_ARRAY_BUFFER,0);
 
@@ -434,6 +598,15 @@ void ParticleSystem::draw(const nv::matrix4f& mMV, const nv::matrix4f& mProj)
     if (m_emittersCount != m_params.emittersCount)
         seedEmitters(m_params.emittersCount);
 
+    if (BACKEND_CPU == m_backend)
+    {
+        if (!m_isStopped)
+            advanceCPU();
+
+        drawParticles(mMV, mProj);
+        return;
+    }
+
     if (!m_isStopped)
         advanceFeedback();
 
@@ -37,6 +37,7 @@
 #include <NvFoundation.h>
 #include <NV/NvMath.h>
 #include "Utils.h"
+#include "CPUParticles.h"
 
 
 //------------------------------------------------------------------------------
@@ -70,7 +71,6 @@ class ParticleSystem
         PARTICLE_TEX_UNIT   = 0,
 
         RANDOM_TEX_SIZE     = 2048,
-        FBM_TEX_SIZE        = 256,
         PARTICLE_TEX_SIZE   = 256,
         MAX_PARTICLES       = (1024*1024),
 
@@ -82,6 +82,13 @@ class ParticleSystem
     typedef Ring<FEEDBACK_QUEUE_LEN> RingCycle;
 
 public:
+    // where the particles are emitted and moved, and how they are drawn
+    enum Backend
+    {
+        BACKEND_FEEDBACK,   // transform feedback, drawn as geometry shader billboards
+        BACKEND_CPU,        // CPUParticles, uploaded each frame and drawn as point sprites
+    };
+
     struct Parameters
     {
         Parameters()
@@ -112,6 +119,10 @@ public:
 
     ParticleSystem();
 
+    // takes effect on the next init()
+    void            setBackend(Backend backend) { m_backend = backend; };
+    Backend         getBackend() const { return m_backend; };
+
     bool            init();
     void            release();
     void            update(float deltaTime);
@@ -134,6 +145,10 @@ private:
     void            processParticles();
     void            moveEmitters();
     void            seedEmitters(uint32_t num);
+    void            advanceCPU();
+    void            uploadCPUParticles();
+
+    static void     packCPURange(void* data,int32_t begin,int32_t end);
 
     NvGLSLProgram*  m_feedbackProgram;
     NvGLSLProgram*  m_billboardProgram;
@@ -161,6 +176,11 @@ private:
     uint32_t        m_emittersCount;
     uint32_t        m_particleCount;
 
+    Backend         m_backend;
+    CPUParticles    m_cpuParticles;
+    uint32_t        m_cpuBuffer;
+    Particle*       m_cpuTarget;
+
     static NvVertexAttribute ms_attributes[];
 };
 
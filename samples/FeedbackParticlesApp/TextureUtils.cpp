@@ -33,72 +33,36 @@
 //----------------------------------------------------------------------------------
 #include "TextureUtils.h"
 #include <NV/NvPlatformGL.h>
-#include <NvGLUtils/NvGLSLProgram.h>
-#include <NvModel/NvShapes.h>
 #include <NV/NvLogs.h>
 
 
 //------------------------------------------------------------------------------
 //
-uint32_t TexturesUtils::FBM3DTexture(uint32_t extent)
+NvNoiseVolume::Desc TexturesUtils::FBMVolumeDesc()
 {
-    NvGLSLProgram* FBMProgram = NvGLSLProgram::createFromFiles("fbm.vert","fbm.frag");
-
-    GLuint prevFBO = 0;
-    // Enum has MANY names based on extension/version
-    // but they all map to 0x8CA6
-    glGetIntegerv(0x8CA6, (GLint*)&prevFBO);
-
-    uint32_t out;
-    glActiveTexture(GL_TEXTURE0);
-    glEnable(GL_TEXTURE_3D);
-    glGenTextures(1,&out);
-    glBindTexture(GL_TEXTURE_3D,out);
-    glTexImage3D(GL_TEXTURE_3D,0,GL_RGBA16F,extent,extent,extent,0,GL_RGBA,GL_FLOAT,NULL);
-    glTexParameteri(GL_TEXTURE_3D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_3D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-    glBindTexture(GL_TEXTURE_3D,0);
-
-    uint32_t framebuffer;
-    glGenFramebuffers(1,&framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER,framebuffer);
-
-    GLenum buffers[] = { GL_COLOR_ATTACHMENT0 };
-    glDrawBuffers(1,buffers);
-    
-    glPushAttrib(GL_VIEWPORT_BIT);
-    glViewport(0,0,extent,extent);
-    for(uint32_t n = 0; n < extent; n++)
-    {
-        const float layer = n/(float)extent;
-
-        glFramebufferTexture3D( GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_3D,
-                                out,0,n);
-
-        FBMProgram->enable();
-        FBMProgram->setUniform1f("u_Layer",layer);
-
-        NvDrawQuad(0);
-    }
-    glPopAttrib();
-    glBindFramebuffer(GL_FRAMEBUFFER, prevFBO);
-    glDeleteFramebuffers(1,&framebuffer);
-
-    delete FBMProgram;
-
-    return out;
+    // 16 lattice cells across the volume, the scale of the fbm(8*p) over p in [-1,1]
+    // it used to be rendered from; 128^3 texels resolve the finest of the 4 octaves
+    NvNoiseVolume::Desc desc;
+    desc.type       = NvNoiseVolume::TYPE_FBM;
+    desc.format     = NvNoiseVolume::FORMAT_HALF;
+    desc.width      = 128;
+    desc.height     = 128;
+    desc.depth      = 128;
+    desc.channels   = 3;
+    desc.seed       = 1;
+    desc.frequency  = 16.0f;
+    desc.octaves    = 4;
+    desc.lacunarity = 2.0f;
+    desc.gain       = 0.5f;
+    desc.amplitude  = 1.0f;
+    return desc;
 }
 
 
 //------------------------------------------------------------------------------
 //
-uint32_t TexturesUtils::random1DTexture(uint32_t extent)
+uint32_t TexturesUtils::random1DTexture(uint32_t extent,const float* values)
 {
-    float* pRaw = new float[extent*4];
-
-    for (uint32_t n = 0;n < extent*4;n++)
-        pRaw[n] = rand()/(float)RAND_MAX;
-
     uint32_t out;
     glGenTextures(1,&out);
     glActiveTexture(GL_TEXTURE0);
@@ -107,9 +71,7 @@ uint32_t TexturesUtils::random1DTexture(uint32_t extent)
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
-    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,extent,1,0,GL_RGBA,GL_FLOAT,pRaw);
-
-    delete [] pRaw;
+    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,extent,1,0,GL_RGBA,GL_FLOAT,values);
 
     return out;
 }
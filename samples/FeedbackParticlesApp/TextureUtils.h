@@ -34,11 +34,15 @@
 #ifndef _TEXTURE_UTILS_H
 #define _TEXTURE_UTILS_H
 #include <NvFoundation.h>
+#include <NvAppBase/NvNoiseVolume.h>
 
 namespace TexturesUtils
 {
-    uint32_t random1DTexture(uint32_t extent);
-    uint32_t FBM3DTexture(uint32_t extent);
+    // values: extent RGBA values in [0,1]
+    uint32_t random1DTexture(uint32_t extent,const float* values);
+    // the curl noise potential: a cube of 3 channel fBm, shared by the feedback
+    // path's FBM texture and the CPU particles
+    NvNoiseVolume::Desc FBMVolumeDesc();
     uint32_t spotTexture(uint32_t width,uint32_t height);
 };
 
@@ -1,5 +1,5 @@
 //----------------------------------------------------------------------------------
-// File:        FeedbackParticlesApp/assets/fbm.vert
+// File:        FeedbackParticlesApp/assets/billboard_point.frag
 // SDK Version: v1.2 
 // Email:       gameworks@nvidia.com
 // Site:        http://developer.nvidia.com/
@@ -31,17 +31,16 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
 //----------------------------------------------------------------------------------
-#version 430
+#version 130
 
-uniform float u_Layer;
+uniform sampler2D u_Texture;
+uniform float u_UseColors;
 
-in vec3 attr_position;
-out vec3 vs_Pos;
+in vec4 vs_Tint;
+out vec4 out_FragColor;
 
 void main()
 {
-    gl_Position = vec4(2.0*attr_position - vec3(1.0,1.0,0.0),1.0);
-    vs_Pos = vec3(gl_Position.xy,u_Layer*2.0 - 1.0);
+    out_FragColor.rgb = u_UseColors > 0.0 ? vs_Tint.rgb : vec3(1.0);
+    out_FragColor.a   = texture(u_Texture,gl_PointCoord).a*vs_Tint.a;
 }
-
-
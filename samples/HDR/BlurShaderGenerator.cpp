@@ -95,7 +95,7 @@ float* generateTriangleWeights(int width)
   as long as 0 <= b/(a+b) <= 1
 */
 
-unsigned int generate1DConvolutionFP_filter(const char* vs, float *weights, int width, bool vertical, bool tex2D, int img_width, int img_height)
+unsigned int generate1DConvolutionFP_filter(NvGLSLPreprocessor& shaders, const char* vs, float *weights, int width, bool vertical, bool tex2D, int img_width, int img_height)
 {
     // calculate new set of weights and offsets
     int nsamples = 2*width+1;
@@ -153,7 +153,13 @@ unsigned int generate1DConvolutionFP_filter(const char* vs, float *weights, int
 
     delete [] weights2;
     delete [] offsets;
-	NvGLSLProgram* program = NvGLSLProgram::createFromStrings(vs, (char*)ost.str().c_str());
-	int id = program->getProgram();
-	return id;
+	// identical kernels (same weights and image size) share one cached program
+	std::string fs = ost.str();
+	NvGLSLProgram::ShaderSourceItem sources[2];
+	sources[0].type = GL_VERTEX_SHADER;
+	sources[0].src = vs;
+	sources[1].type = GL_FRAGMENT_SHADER;
+	sources[1].src = fs.c_str();
+	NvGLSLProgram* program = shaders.createProgramFromStrings(sources, 2);
+	return program ? program->getProgram() : 0;
 }
@@ -35,9 +35,10 @@
 #define _BLUR_SHADER_GENERATOR_H_
 
 #include "NvGLUtils/NvGLSLProgram.h"
+#include "NvGLUtils/NvGLSLPreprocessor.h"
 
 float *generateGaussianWeights(float s, int &n);
 float *generateTriangleWeights(int width);
-unsigned int  generate1DConvolutionFP_filter(const char* vs, float *weights, int width, bool vertical, bool tex2D, int img_width, int img_height);
+unsigned int  generate1DConvolutionFP_filter(NvGLSLPreprocessor& shaders, const char* vs, float *weights, int width, bool vertical, bool tex2D, int img_width, int img_height);
 
 #endif //_BLUR_SHADER_GENERATOR_H_
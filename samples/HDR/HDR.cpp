@@ -132,6 +132,7 @@ HDR::HDR(NvPlatformContext* platform)
 	m_materialIndex = 5;
 	m_glareType = CAMERA_GLARE;
 	m_bInitialized = 0;
+	m_blurShaders = NULL;
 	m_gamma = 1.0 / 1.8;  
 	m_blendAmount = 0.33;
 	m_lumThreshold = 1.0;
@@ -226,6 +227,12 @@ HDR::~HDR()
     LOGI("HDR: destroyed\n");
 }
 
+void HDR::shutdownRendering(void)
+{
+	delete m_blurShaders;
+	m_blurShaders = NULL;
+}
+
 void HDR::configurationCallback(NvEGLConfiguration& config)
 { 
     config.depthBits = 24; 
@@ -305,12 +312,15 @@ void HDR::initBlurCode()
 	w = (int)(m_postProcessingWidth/4*m_aspectRatio);
 	h = (int)(m_postProcessingHeight/4);
 
+	if (!m_blurShaders)
+		m_blurShaders = new NvGLSLPreprocessor;
+
 	//gen blur code at each level
 	for (i=0; i<4; i++) {
 		id = BLURH4+i*2;
 		weights = generateGaussianWeights(s[i], width);
-		m_shaders[id].pid = generate1DConvolutionFP_filter(vtx_blur, weights, width, false, true, w, h);
-		m_shaders[id+1].pid = generate1DConvolutionFP_filter(vtx_blur, weights, width, true, true, w, h);
+		m_shaders[id].pid = generate1DConvolutionFP_filter(*m_blurShaders, vtx_blur, weights, width, false, true, w, h);
+		m_shaders[id+1].pid = generate1DConvolutionFP_filter(*m_blurShaders, vtx_blur, weights, width, true, true, w, h);
 		m_shaders[id].GenLocation(LOC_PARAMETER(blur));
 		m_shaders[id+1].GenLocation(LOC_PARAMETER(blur));
 		delete [] weights;
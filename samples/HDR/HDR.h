@@ -51,6 +51,7 @@ public:
     ~HDR();
     
     void initRendering(void);
+    void shutdownRendering(void);
     void initUI(void);
     void draw(void);
     void reshape(int32_t width, int32_t height);
@@ -154,6 +155,7 @@ private:
 	RenderTexture*	exp_buffer[2];		//exposure info buffer
 	BUFFER_PYRAMID	m_starGenLevel;
 	CShaderObject   m_shaders[PROGSIZE];
+	NvGLSLPreprocessor* m_blurShaders;
 
 	bool m_bInitialized;
 	float m_aspectRatio;
@@ -0,0 +1,138 @@
+//----------------------------------------------------------------------------------
+// File:        OptimizationApp/AutoQualityTest.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "AutoQualityTest.h"
+#include "NvAppBase/NvQualityTuner.h"
+#include "NV/NvLogs.h"
+
+static const int32_t LEVEL_COUNT = 5;
+static const char* const LEVEL_NAMES[LEVEL_COUNT] = { "level 0", "level 1", "level 2", "level 3", "level 4" };
+
+// a stretch of windows at a steady scene load
+struct Phase
+{
+    float load;
+    int32_t windows;
+};
+
+struct Trace
+{
+    const char* name;
+    float gpuMs[LEVEL_COUNT];   // the GPU frame time of each level at load 1
+    float cpuMs;                // the CPU frame time that does not depend on the level
+    float noise;                // the relative jitter of each window's times
+    int32_t startLevel;
+    int32_t phaseCount;
+    Phase phases[3];
+};
+
+static const Trace TRACES[] =
+{
+    { "steady",              { 5.0f, 7.0f, 10.0f, 13.0f, 19.0f },  2.0f, 0.03f, 4, 1, { { 1.0f,  60 } } },
+    { "load changes",        { 5.0f, 7.0f, 10.0f, 13.0f, 19.0f },  2.0f, 0.03f, 3, 3, { { 1.0f,  40 }, { 1.5f, 40 }, { 0.6f, 40 } } },
+    { "noise at the budget", { 6.0f, 9.0f, 12.3f, 16.0f, 23.4f },  2.0f, 0.08f, 3, 1, { { 1.0f, 100 } } },
+    { "expensive top level", { 5.0f, 6.0f,  7.0f,  8.0f, 30.0f },  2.0f, 0.03f, 0, 1, { { 1.0f, 100 } } },
+    { "CPU bound",           { 5.0f, 7.0f, 10.0f, 13.0f, 19.0f }, 17.5f, 0.03f, 2, 1, { { 1.0f,  40 } } },
+};
+
+// the CPU also spends a little time per unit of GPU work (draw calls, state)
+static float frameMs(const Trace& trace, int32_t level, float load)
+{
+    const float gpuMs = trace.gpuMs[level] * load;
+    const float cpuMs = trace.cpuMs + 0.3f * gpuMs;
+    return (gpuMs > cpuMs) ? gpuMs : cpuMs;
+}
+
+static float jitter(uint32_t& seed, float noise)
+{
+    seed = seed * 1664525 + 1013904223;
+    return 1.0f + noise * ((seed >> 8) / (float)(1 << 24) * 2.0f - 1.0f);
+}
+
+bool runAutoQualityTest(NvStopWatch*)
+{
+    bool passed = true;
+    const NvQualityTuner::Params params;
+    const float upperMs = params.budgetMs * params.upperFraction;
+    const float lowerMs = params.budgetMs * params.lowerFraction;
+
+    for (int32_t t = 0; t < (int32_t)(sizeof(TRACES) / sizeof(TRACES[0])); t++)
+    {
+        const Trace& trace = TRACES[t];
+        LOGI("Auto quality test: %s, %.2f ms budget\n", trace.name, params.budgetMs);
+
+        NvQualityTuner tuner;
+        tuner.setParams(params);
+        tuner.setLevels(LEVEL_NAMES, LEVEL_COUNT, trace.startLevel);
+
+        uint32_t seed = 12345;
+        for (int32_t p = 0; p < trace.phaseCount; p++)
+        {
+            const Phase& phase = trace.phases[p];
+            uint32_t changesAtHalf = 0;
+            for (int32_t w = 0; w < phase.windows; w++)
+            {
+                if (w == phase.windows / 2)
+                    changesAtHalf = tuner.getChangeCount();
+
+                const float gpuMs = trace.gpuMs[tuner.getLevel()] * phase.load * jitter(seed, trace.noise);
+                const float cpuMs = trace.cpuMs * jitter(seed, trace.noise) + 0.3f * gpuMs;
+                tuner.addWindow(gpuMs, cpuMs);
+            }
+
+            // the level must fit the budget, and the next one must not be expected to
+            // fit with room to spare, or the tuner left quality unused
+            const int32_t level = tuner.getLevel();
+            const float levelMs = frameMs(trace, level, phase.load);
+            const bool fits = (level == 0) || (levelMs <= upperMs);
+            const bool full = (level == LEVEL_COUNT - 1) || (frameMs(trace, level + 1, phase.load) > lowerMs);
+            const uint32_t lateChanges = tuner.getChangeCount() - changesAtHalf;
+
+            if (!fits || !full || lateChanges > 0)
+            {
+                LOGE("Auto quality test %s, load %.2f: ended at %s (%.2f ms)%s%s, %u changes in the second half\n",
+                    trace.name, phase.load, tuner.getLevelName(level), levelMs,
+                    fits ? "" : " over budget", full ? "" : " with a level to spare", lateChanges);
+                passed = false;
+            }
+            else
+            {
+                LOGI("Auto quality test %s, load %.2f: settled at %s (%.2f ms) after %u changes\n",
+                    trace.name, phase.load, tuner.getLevelName(level), levelMs, tuner.getChangeCount());
+            }
+        }
+    }
+
+    return passed;
+}
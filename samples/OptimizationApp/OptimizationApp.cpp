@@ -35,13 +35,20 @@
 #include "NvAppBase/NvFramerateCounter.h"
 #include "NV/NvStopWatch.h"
 #include "NvAssetLoader/NvAssetLoader.h"
+#include "NvGLUtils/NvGPUSort.h"
 #include "NvGLUtils/NvImage.h"
 #include "NV/NvLogs.h"
 #include "NvUI/NvTweakBar.h"
 
 #include "SceneRenderer.h"
+#include "AutoQualityTest.h"
+#include "ParticleBenchmark.h"
+#include "ParticleSystem.h"
+#include "SortBenchmark.h"
 #include "AppExtensions.h"
 
+#include <sstream>
+
 void (KHRONOS_APIENTRY *glBlitFramebufferFunc) (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter);
 
 uint32_t gFloatTypeEnum;
@@ -53,7 +60,10 @@ OptimizationApp::OptimizationApp(NvPlatformContext* platform) :
     NvSampleApp(platform, "Optimization Sample"),
     m_lightDirection(0.0f),
     m_center(0.0f),
-    m_pausedByPerfHUD(false)
+    m_pausedByPerfHUD(false),
+    m_particleCount(DEFAULT_PARTICLE_COUNT),
+    m_gpuSort(false),
+    m_autoQualityMs(0.0f)
 {
     // Required in all subclasses to avoid silent link issues
     forceLinkHack();
@@ -62,6 +72,37 @@ OptimizationApp::OptimizationApp(NvPlatformContext* platform) :
     m_transformer->setTranslationVec(nv::vec3f(0.0f, -50.0f, 100.0f));
     m_transformer->setMaxTranslationVel(100.0f);
     m_transformer->setMotionMode(NvCameraMotionType::FIRST_PERSON);
+
+    // -sortbench times the particle depth sort from 10k to 10M particles, then exits
+    // -particlebench times the CPU particle update from the default count to 4M particles, then exits
+    // -autoqualitytest runs the quality tuner against synthetic frame time traces, then exits
+    // -gpusorttest checks the compute shader sort and its CPU emulation, then exits
+    addBenchmarkMode("-sortbench", runSortBenchmark);
+    addBenchmarkMode("-particlebench", runParticleBenchmark);
+    addBenchmarkMode("-autoqualitytest", runAutoQualityTest);
+    addBenchmarkMode("-gpusorttest", NvGPUSort::runSelfTest);
+
+    // -particles <n> sets the particle count
+    // -gpusort sorts the particles in compute shaders instead of on the CPU, where the context has them
+    // -autoquality <ms> picks the resolutions and upsampling filter to fit a frame time budget
+    const std::vector<std::string>& cmd = platform->getCommandLine();
+    for (std::vector<std::string>::const_iterator it = cmd.begin(); it != cmd.end(); ++it)
+    {
+        if (0 == (*it).compare("-gpusort"))
+            m_gpuSort = true;
+        else if (0 == (*it).compare("-autoquality") && (it + 1) != cmd.end())
+        {
+            ++it;
+            std::stringstream(*it) >> m_autoQualityMs;
+        }
+        else if (0 == (*it).compare("-particles") && (it + 1) != cmd.end())
+        {
+            ++it;
+            std::stringstream(*it) >> m_particleCount;
+            if (m_particleCount < 1)
+                m_particleCount = DEFAULT_PARTICLE_COUNT;
+        }
+    }
 }
 
 OptimizationApp::~OptimizationApp()
@@ -90,6 +131,7 @@ void OptimizationApp::initUI(void) {
         mTweakBar->addValue("Render low res scene:", m_sceneRenderer->getSceneParams()->renderLowResolution);
         mTweakBar->addValue("Render low res particles:", m_sceneRenderer->getParticleParams()->renderLowResolution);
         mTweakBar->addValue("Use cross-bilateral upsampling:", m_sceneRenderer->getUpsamplingParams()->useCrossBilateral);
+        mTweakBar->addValue("Auto quality:", m_sceneRenderer->getSceneParams()->autoQuality);
     }
 
     // UI elements for displaying triangle statistics
@@ -130,8 +172,15 @@ void OptimizationApp::initRendering(void) {
         gLumaTypeEnum = 0x1903; // GL_RED, not declared in ES
     }
 
-    m_sceneRenderer = new SceneRenderer(
-        getGLContext()->getConfiguration().apiVer == NvGfxAPIVersionES2());
+    // ES2 draws 32 bit indices only with GL_OES_element_index_uint
+    const bool isES2 = (getGLContext()->getConfiguration().apiVer == NvGfxAPIVersionES2());
+    const bool hasIndexUint = !isES2 || requireExtension("GL_OES_element_index_uint", false);
+    m_sceneRenderer = new SceneRenderer(isES2, m_particleCount, hasIndexUint, m_gpuSort);
+    if (m_autoQualityMs > 0.0f)
+    {
+        m_sceneRenderer->getSceneParams()->autoQuality = true;
+        m_sceneRenderer->getSceneParams()->frameBudgetMs = m_autoQualityMs;
+    }
     CHECK_GL_ERROR();
 
     glEnable(GL_DEPTH_TEST);
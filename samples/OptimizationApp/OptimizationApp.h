@@ -76,4 +76,8 @@ private:
     nv::vec3f m_center;
 
     NvUIText* m_timingStats;
+
+    int32_t m_particleCount;
+    bool m_gpuSort;
+    float m_autoQualityMs;
 };
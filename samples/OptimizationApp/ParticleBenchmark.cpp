@@ -0,0 +1,149 @@
+//----------------------------------------------------------------------------------
+// File:        OptimizationApp/ParticleBenchmark.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "ParticleBenchmark.h"
+#include "ParticleSystem.h"
+#include "NvAppBase/NvIncrementalSort.h"
+#include "NvAppBase/NvJobSystem.h"
+#include "NV/NvLogs.h"
+#include "NV/NvStopWatch.h"
+#include <math.h>
+
+// one way of running the particles: how they are drawn, and how fast the view turns
+struct ParticleBenchmarkRun
+{
+    ParticleIndexMode mode;
+    float turnDegrees;
+    const char* name;
+};
+
+// true if the particles are drawn in decreasing dot(halfVector, position), the order the depth
+// sort gives them; the keys are computed in SIMD, so equal depths may differ by a rounding step
+static bool drawnBackToFront(ParticleSystem& particles, const nv::vec3f& halfVector)
+{
+    const nv::vec4f* positions = particles.getPositions();
+    const GLuint* indices = (const GLuint*)particles.getSortedIndices();
+    float last = 0.0f;
+    for (int32_t i = 0; i < particles.getNumActive(); i++)
+    {
+        const nv::vec4f& p = positions[indices ? indices[i] : i];
+        const float depth = halfVector.x * p.x + halfVector.y * p.y + halfVector.z * p.z;
+        if (i > 0 && depth > last + 1e-5f * (1.0f + fabsf(last)))
+            return false;
+        last = depth;
+    }
+    return true;
+}
+
+bool runParticleBenchmark(NvStopWatch* stopWatch)
+{
+    const int32_t counts[] = { DEFAULT_PARTICLE_COUNT, 65536, 262144, 1048576, 4194304 };
+    const int32_t numCounts = sizeof(counts) / sizeof(counts[0]);
+    const ParticleBenchmarkRun runs[] = {
+        { PARTICLE_INDEX_32,   0.0f, "32 bit indices,  steady view " },
+        { PARTICLE_INDEX_NONE, 0.0f, "sorted vertices, steady view " },
+        { PARTICLE_INDEX_32,   0.1f, "32 bit indices,  turning view" },
+    };
+    const int32_t numRuns = sizeof(runs) / sizeof(runs[0]);
+    const int32_t frames = 30;
+    const float frameSeconds = 1.0f / 60.0f;
+
+    // the largest count that fits each frame budget, by run
+    int32_t fits60[numRuns] = { 0 }, fits30[numRuns] = { 0 };
+
+    bool passed = true;
+    LOGI("Particle benchmark: %d threads\n", NvJobSystem::getWorkerCount() + 1);
+
+    for (int32_t c = 0; c < numCounts; c++)
+    {
+        for (int32_t r = 0; r < numRuns; r++)
+        {
+            ParticleSystem particles(counts[c], runs[r].mode);
+
+            uint32_t merges = NvIncrementalSort::getTotalSortCount(NvIncrementalSort::PATH_MERGE)
+                + NvIncrementalSort::getTotalSortCount(NvIncrementalSort::PATH_SORTED);
+            float totalMs = 0.0f, maxMs = 0.0f;
+            nv::vec3f halfVector;
+            for (int32_t f = 0; f <= frames; f++)
+            {
+                // looking down at the particles, turning by turnDegrees a frame
+                const float a = 0.5f + f * runs[r].turnDegrees * 3.14159265f / 180.0f;
+                halfVector = nv::vec3f(cosf(a) * 0.8f, -0.6f, sinf(a) * 0.8f);
+
+                stopWatch->reset();
+                stopWatch->start();
+                // the update runs as a job behind the frame; waiting for it times the whole of it
+                particles.simulate(frameSeconds, halfVector, nv::vec4f(0.0f, 0.0f, 0.0f, 1.0f));
+                particles.finish();
+                stopWatch->stop();
+
+                // the first frame radix sorts from scratch, so it is left out
+                if (f > 0)
+                {
+                    const float ms = stopWatch->getTime() * 1000.0f;
+                    totalMs += ms;
+                    if (ms > maxMs)
+                        maxMs = ms;
+                }
+            }
+            merges = NvIncrementalSort::getTotalSortCount(NvIncrementalSort::PATH_MERGE)
+                + NvIncrementalSort::getTotalSortCount(NvIncrementalSort::PATH_SORTED) - merges;
+
+            if (!drawnBackToFront(particles, halfVector))
+            {
+                LOGE("Particles %8d, %s: the last frame is not drawn back to front\n", counts[c], runs[r].name);
+                passed = false;
+            }
+
+            const float meanMs = totalMs / frames;
+            const int32_t indexBytes = (runs[r].mode == PARTICLE_INDEX_NONE) ? 0 : sizeof(GLuint);
+            const double uploadMB = (double)counts[c] * (sizeof(nv::vec4f) + indexBytes) / (1024.0 * 1024.0);
+            LOGI("Particles %8d, %s: %8.3f ms mean, %8.3f ms max per frame, %2d of %d sorts incremental, %6.2f MB uploaded per frame\n",
+                counts[c], runs[r].name, meanMs, maxMs, merges, frames + 1, uploadMB);
+
+            if (meanMs <= 1000.0f / 60.0f)
+                fits60[r] = counts[c];
+            if (meanMs <= 1000.0f / 30.0f)
+                fits30[r] = counts[c];
+        }
+    }
+
+    for (int32_t r = 0; r < numRuns; r++)
+    {
+        LOGI("Particles, %s: up to %d fit a 60 Hz frame, up to %d a 30 Hz frame (of the counts tried)\n",
+            runs[r].name, fits60[r], fits30[r]);
+    }
+
+    return passed;
+}
@@ -34,27 +34,50 @@
 
 #include "ParticleRenderer.h"
 #include "Shaders.h"
+#include "NV/NvLogs.h"
+#include "NvGLUtils/NvProfiler.h"
+#include <math.h>
+#include <string.h>
 
-ParticleRenderer::ParticleRenderer(bool isES2)
-    : m_vboArray(0)
-    , m_frameId(0)
-    , m_eboArray(NULL)
-    , m_bufferCount(2)
+ParticleRenderer::ParticleRenderer(bool isES2, int32_t count, bool hasIndexUint, bool gpuSort)
+    : m_writing(false)
 {
-    m_particleSystem = new ParticleSystem();
+    // 16 bit indices while they reach every particle, then 32 bit ones where the context
+    // has them, else the particles are written in sorted order and drawn without indices.
+    // The GPU sort draws 32 bit indices too, so it needs a context that has compute shaders
+    ParticleIndexMode indexMode = PARTICLE_INDEX_16;
+    if (count > 65536)
+        indexMode = hasIndexUint ? PARTICLE_INDEX_32 : PARTICLE_INDEX_NONE;
+    if (gpuSort)
+    {
+        if (m_gpuSort.init())
+            indexMode = PARTICLE_INDEX_GPU;
+        else
+            LOGI("Particles: no compute shaders, sorting on the CPU\n");
+    }
+    m_particleSystem = new ParticleSystem(count, indexMode);
+    LOGI("Particles: %d, %s\n", count, (indexMode == PARTICLE_INDEX_16) ? "16 bit indices" :
+        ((indexMode == PARTICLE_INDEX_32) ? "32 bit indices" :
+        ((indexMode == PARTICLE_INDEX_GPU) ? "GPU sorted indices" : "sorted vertices")));
+
+    // the grid covers the same area whatever the count, so the particles shrink as it grows
+    m_params.particleScale = PARTICLE_SCALE * sqrtf((float)DEFAULT_PARTICLE_COUNT / count);
 
     createShaders(isES2);
-    createVBOs();
-    createEBOs();
+    createBuffers();
 }
 
 ParticleRenderer::~ParticleRenderer()
 {
+    // the update may still be writing the mapped buffers
+    m_particleSystem->finish();
+    endWrite();
     delete m_particleSystem;
 
     deleteShaders();
-    deleteVBOs();
-    deleteEBOs();
+    m_positions.release();
+    m_indices.release();
+    m_gpuSort.release();
 }
 
 void ParticleRenderer::createShaders(bool isES2)
@@ -74,10 +97,11 @@ NvGLSLProgram& ParticleRenderer::getCameraViewProgram()
 
 void ParticleRenderer::drawPointsSorted(GLint positionAttrib, int32_t start, int32_t count)
 {
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboArray[m_frameId]);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboArray[m_frameId]);
+    glBindBuffer(GL_ARRAY_BUFFER, m_positions.getBuffer());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (m_particleSystem->getIndexMode() == PARTICLE_INDEX_GPU) ?
+        m_gpuSort.getValueBuffer() : m_indices.getBuffer());
 
-    glVertexAttribPointer(positionAttrib, 4, GL_FLOAT, GL_FALSE, 0, NULL);
+    glVertexAttribPointer(positionAttrib, 4, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)m_positions.getReadOffset());
     glEnableVertexAttribArray(positionAttrib);
 
     // Hack for OpenGL-as-GLES; need to avoid this
@@ -85,7 +109,21 @@ void ParticleRenderer::drawPointsSorted(GLint positionAttrib, int32_t start, int
     glEnable(GL_POINT_SPRITE);
     glEnable(GL_PROGRAM_POINT_SIZE);
 #endif
-    glDrawElements(GL_POINTS, count, GL_UNSIGNED_SHORT, (void*)(sizeof(GLushort)*start));
+    switch (m_particleSystem->getIndexMode())
+    {
+    case PARTICLE_INDEX_16:
+        glDrawElements(GL_POINTS, count, GL_UNSIGNED_SHORT, (void*)(m_indices.getReadOffset() + sizeof(GLushort)*start));
+        break;
+    case PARTICLE_INDEX_32:
+        glDrawElements(GL_POINTS, count, GL_UNSIGNED_INT, (void*)(m_indices.getReadOffset() + sizeof(GLuint)*start));
+        break;
+    case PARTICLE_INDEX_GPU:
+        glDrawElements(GL_POINTS, count, GL_UNSIGNED_INT, (void*)(sizeof(GLuint)*start));
+        break;
+    default:
+        glDrawArrays(GL_POINTS, start, count);
+        break;
+    }
 
     glDisableVertexAttribArray(positionAttrib);
 
@@ -106,7 +144,10 @@ void ParticleRenderer::drawSliceCameraView(SceneInfo& scene, int32_t i)
     if (i == 0) 
         m_cameraViewParticleProg->setUniforms(scene, m_params);
 
-    drawPointsSorted(m_cameraViewParticleProg->getPositionAndColorAttrib(), i*m_batchSize, m_batchSize);
+    // the last slice also draws the remainder of the division into slices
+    const int32_t first = i*m_batchSize;
+    const int32_t count = (i == (int32_t)m_params.numSlices - 1) ? getNumActive() - first : m_batchSize;
+    drawPointsSorted(m_cameraViewParticleProg->getPositionAndColorAttrib(), first, count);
 }
 
 void ParticleRenderer::renderParticles(SceneInfo& scene)
@@ -133,6 +174,9 @@ void ParticleRenderer::renderParticles(SceneInfo& scene)
         glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     }
 
+    if (m_particleSystem->getIndexMode() == PARTICLE_INDEX_GPU)
+        sortOnGPU(scene);
+
     glDepthMask(GL_FALSE);  // don't write depth
     glEnable(GL_BLEND);
 
@@ -145,84 +189,106 @@ void ParticleRenderer::renderParticles(SceneInfo& scene)
 
     glDepthMask(GL_TRUE);
     glDisable(GL_BLEND);
-}
 
-void ParticleRenderer::deleteVBOs()
-{
-    if (m_vboArray)
-    {
-        glDeleteBuffers(m_bufferCount, m_vboArray);
-        m_vboArray = 0;
-    }
+    // the slots drawn from may not be rewritten until the GPU is done with them
+    m_positions.fenceRead();
+    if (m_indices.getBuffer())
+        m_indices.fenceRead();
 }
 
-void ParticleRenderer::createVBOs()
+// sorts the positions this frame draws for this frame's view, straight from the vertex buffer
+void ParticleRenderer::sortOnGPU(SceneInfo& scene)
 {
-    deleteVBOs();
-
-    m_vboArray = new GLuint[m_bufferCount];
-    glGenBuffers(m_bufferCount, m_vboArray);
-
-    for (int32_t i = 0; i < m_bufferCount; ++i)
-    {
-        glBindBuffer(GL_ARRAY_BUFFER, m_vboArray[i]);
-        glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(float) * getNumActive(), NULL, GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        CHECK_GL_ERROR();
-    }
+    const vec3f axis = -scene.m_viewVector;
+    m_gpuSort.computeDepthKeys(m_positions.getBuffer(), m_positions.getReadOffset(), 4, getNumActive(), &axis.x);
+    m_gpuSort.sort();
+    CHECK_GL_ERROR();
 }
 
-void ParticleRenderer::deleteEBOs()
+void ParticleRenderer::createBuffers()
 {
-    if (m_eboArray)
+    // every slot starts with the particles as they were created, for the frames drawn
+    // before the first update lands
+    m_positions.init(GL_ARRAY_BUFFER, 4 * sizeof(float) * getNumActive(),
+        NvStreamingBuffer::DEFAULT_SLOT_COUNT, m_particleSystem->getPositions());
+    if (getIndexSize() > 0)
     {
-        glDeleteBuffers(m_bufferCount, m_eboArray);
-        m_eboArray = NULL;
+        m_indices.init(GL_ELEMENT_ARRAY_BUFFER, getIndexSize() * getNumActive(),
+            NvStreamingBuffer::DEFAULT_SLOT_COUNT, m_particleSystem->getSortedIndices());
     }
+    CHECK_GL_ERROR();
 }
 
-void ParticleRenderer::createEBOs()
+int32_t ParticleRenderer::getIndexSize()
 {
-    deleteEBOs();
-
-    // to avoid CPU<->GPU sync points when updating DYNAMIC buffers,
-    // use an array of buffers and use the least-recently-used one each frame.
-    m_eboArray = new GLuint[m_bufferCount];
-    glGenBuffers(m_bufferCount, m_eboArray);
-
-    for (int32_t i = 0; i < m_bufferCount; ++i)
+    switch (m_particleSystem->getIndexMode())
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboArray[i]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * getNumActive(), NULL, GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        CHECK_GL_ERROR();
+    case PARTICLE_INDEX_16:
+        return sizeof(GLushort);
+    case PARTICLE_INDEX_32:
+        return sizeof(GLuint);
+    default:
+        return 0;
     }
 }
 
-void ParticleRenderer::updateEBO()
+void ParticleRenderer::endWrite()
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboArray[m_frameId]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * getNumActive(), m_particleSystem->getSortedIndices(), GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    CHECK_GL_ERROR();
-}
+    if (!m_writing)
+        return;
 
-void ParticleRenderer::updateVBO()
-{
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_vboArray[m_frameId]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 4 * sizeof(float) * getNumActive(), m_particleSystem->getPositions(), GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    CHECK_GL_ERROR();
+    NV_PROFILE_SCOPE("Particles buffers");
+    m_positions.endWrite();
+    if (m_indices.getBuffer())
+        m_indices.endWrite();
+    m_writing = false;
 }
 
+// copies the particle system's results into the next slots; only needed when the update
+// could not write them there itself
 void ParticleRenderer::updateBuffers()
 {
-    updateVBO();
-    updateEBO();
+    if (m_writing)
+        return;
+
+    NV_PROFILE_SCOPE("Particles buffers");
+    void* positions = m_positions.beginWrite();
+    if (positions)
+        memcpy(positions, m_particleSystem->getPositions(), m_positions.getSlotSize());
+    m_positions.endWrite();
+
+    if (m_indices.getBuffer())
+    {
+        void* indices = m_indices.beginWrite();
+        if (indices)
+            memcpy(indices, m_particleSystem->getSortedIndices(), m_indices.getSlotSize());
+        m_indices.endWrite();
+    }
+    CHECK_GL_ERROR();
 }
 
 void ParticleRenderer::simulate(SceneInfo& scene, float frameElapsed)
 {
-    m_particleSystem->simulate(frameElapsed, scene.m_viewVector, scene.m_eyePos);
+    // the last update wrote the slots this frame draws
+    m_particleSystem->finish();
+    endWrite();
+
+    // Persistently mapped buffers stay usable for drawing while the update job writes the
+    // next slots, so the sort and the packing write straight into them.  Buffers mapped for
+    // each write cannot be drawn from while mapped, so the update writes the particle
+    // system's own buffers and updateBuffers() copies them in
+    ParticleTarget target;
+    target.positions = NULL;
+    target.indices = NULL;
+    if (m_positions.getMethod() == NvStreamingBuffer::METHOD_PERSISTENT)
+    {
+        NV_PROFILE_SCOPE("Particles buffers");
+        target.positions = (vec4f*)m_positions.beginWrite();
+        if (m_indices.getBuffer())
+            target.indices = m_indices.beginWrite();
+        m_writing = true;
+    }
+
+    m_particleSystem->simulate(frameElapsed, scene.m_viewVector, scene.m_eyePos, m_writing ? &target : NULL);
     m_batchSize = getNumActive() / (int32_t)m_params.numSlices;
 }
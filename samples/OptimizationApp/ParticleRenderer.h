@@ -39,6 +39,8 @@
 
 
 #include "NV/NvPlatformGL.h"
+#include "NvGLUtils/NvGPUSort.h"
+#include "NvGLUtils/NvStreamingBuffer.h"
 #include "SceneFBOs.h"
 #include "ParticleSystem.h"
 #include "SceneInfo.h"
@@ -84,7 +86,9 @@ public:
         float spriteAlpha;
     };
 
-    ParticleRenderer(bool isES2);
+    // hasIndexUint: whether 32 bit indices can be drawn (not ES2 without GL_OES_element_index_uint)
+    // gpuSort: sort on the GPU in compute shaders where the context has them, rather than on the CPU
+    ParticleRenderer(bool isES2, int32_t count, bool hasIndexUint, bool gpuSort);
     ~ParticleRenderer();
 
     void drawPointsSorted(GLint positionAttrib, int32_t start, int32_t count);
@@ -102,25 +106,23 @@ public:
         return m_particleSystem->getNumActive();
     }
 
-    void swapBuffers()
+    Params& getParams()
     {
-        m_frameId = (m_frameId + 1) % m_bufferCount;
+        return m_params;
     }
 
-    Params& getParams()
+    ParticleSystem& getParticleSystem()
     {
-        return m_params;
+        return *m_particleSystem;
     }
 
 private:
     void createShaders(bool isES2);
     void deleteShaders();
-    void createVBOs();
-    void createEBOs();
-    void deleteVBOs();
-    void deleteEBOs();
-    void updateEBO();
-    void updateVBO();
+    void sortOnGPU(SceneInfo& scene);
+    void createBuffers();
+    void endWrite();
+    int32_t getIndexSize();
 
     NvWritableFB& targetFBO(SceneInfo& s)
     {
@@ -136,10 +138,15 @@ private:
 
     CameraViewParticleProgram *m_cameraViewParticleProg;
 
-    GLuint* m_vboArray;
-    GLuint m_frameId;
-    GLuint* m_eboArray;
-    int32_t m_bufferCount;
+    // the positions and sorted indices, streamed through ring buffers fenced against the
+    // frames still drawing from them; no index buffer for PARTICLE_INDEX_NONE
+    NvStreamingBuffer m_positions;
+    NvStreamingBuffer m_indices;
+    // whether the update is writing straight into the next slots of the (persistently mapped) buffers
+    bool m_writing;
+
+    // sorts the indices of the positions being drawn for PARTICLE_INDEX_GPU
+    NvGPUSort m_gpuSort;
 };
 
 #endif // PARTICLE_RENDERER_H
@@ -32,10 +32,13 @@
 //
 //----------------------------------------------------------------------------------
 
-#include "R3/thread.h"
 #include "ParticleSystem.h"
-#include "IceRevisitedRadix.h"
 #include "Perlin/ImprovedNoise.h"
+#include "NvAppBase/NvFixedTimestep.h"
+#include "NvAppBase/NvIncrementalSort.h"
+#include "NvAppBase/NvJobSystem.h"
+#include "NvAppBase/NvRadixSort.h"
+#include "NvGLUtils/NvProfiler.h"
 #include <algorithm>
 #include <assert.h>
 
@@ -65,14 +68,17 @@ static vec3f truncate(const vec4f& v)
     return result;
 }
 
-class ParticleInitializer : public r3::Thread
+// Particles per parallelFor job in the per-particle loops
+static const int32_t PARTICLE_JOB_GRAIN = 1024;
+
+class ParticleInitializer
 {
 public:
-    ParticleInitializer();
+    ParticleInitializer(int32_t count, ParticleIndexMode indexMode);
     ~ParticleInitializer();
 
     int32_t getNumActive() const;
-    virtual void Run();
+    ParticleIndexMode getIndexMode() const { return m_indexMode; }
 
     // initialize particles in regular grid
     void initGrid(int32_t N);
@@ -80,53 +86,132 @@ public:
     // add some procedural noise
     void addNoise(float freq, float scale);
 
-    void setTime(float frameElapsed);
-    void simulate();
+    // starts advancing, sorting and packing the particles into the back buffers, or the
+    // target where it has pointers, as a job
+    void start(float frameElapsed, const vec3f& halfVector, const ParticleTarget* target);
+    // waits for the job and makes the back buffers the ones the renderer reads
+    void finish();
+
+    void simulate(float frameElapsed);
     void depthSortEfficient(const vec3f& halfVector);
 
-    vec4f *getPositions()                { return m_pos; }
-    GLushort* getSortedIndices()        { return m_sortedIndices16; }
+    vec4f *getPositions()                { return m_packed[m_front]; }
+    const void* getSortedIndices();
+
+    float getOverlap() const;
+    void resetOverlap();
 
 private:
     const float m_width;
 
-    vec4f *m_pos;
-    float *m_zs;
-    GLushort *m_sortedIndices16;
+    // the particles as separate arrays, so the advection and the depth keys run 4 wide;
+    // m_packed interleaves them for the vertex buffer
+    float *m_x;
+    float *m_y;
+    float *m_z;
+    float *m_noiseValue;
+
+    // the results are double buffered: the renderer reads m_front while the job writes the other
+    vec4f *m_packed[2];
+    GLushort *m_sortedIndices16[2];
+    GLuint *m_sortedIndices32[2];
+    int32_t m_front;
+
+    uint32_t *m_keys;
+    ParticleIndexMode m_indexMode;
     int32_t m_count;
-    RadixSort m_sorter;
+    NvIncrementalSort m_sorter;
 
     int32_t m_numActive;
-    r3::Condition m_timeCondition;    
-    r3::Condition m_updateGLCondition;
     ImprovedNoise m_noise;
-    float m_elapsedTime;
+
+    // advection runs in fixed steps, so the particles move the same however the frames fall
+    NvFixedTimestep m_steps;
+
+    // per-call state shared by the parallelFor range jobs
+    vec4f m_wind;
+
+    // the update job, its inputs and how much of it the frame had to wait for
+    NvJobCounter m_update;
+    bool m_pending;
+    float m_frameElapsed;
+    vec3f m_halfVector;
+    ParticleTarget m_target;
+    uint64_t m_updateNs;
+    uint64_t m_totalUpdateNs;
+    uint64_t m_totalWaitNs;
+
+    static void updateJob(void* data);
+    static void advectStep(void* data, float dt, int32_t step, int32_t steps);
+    static void advectRange(void* data, int32_t begin, int32_t end);
+    static void packRange(void* data, int32_t begin, int32_t end);
 };
 
-ParticleInitializer::ParticleInitializer(): 
-    m_pos(NULL), 
-    m_zs(NULL),
-    m_sortedIndices16(NULL),
-    m_numActive(0), 
-    m_width(480), 
-    m_elapsedTime(0.0f) 
+ParticleInitializer::ParticleInitializer(int32_t count, ParticleIndexMode indexMode): 
+    m_width(480),
+    m_front(0),
+    m_indexMode(indexMode),
+    m_count(count),
+    m_numActive(0),
+    m_pending(false),
+    m_frameElapsed(0.0f),
+    m_updateNs(0),
+    m_totalUpdateNs(0),
+    m_totalWaitNs(0)
 {
-    const int32_t N = GRID_RESOLUTION;
-    m_count = N * N;
-
-    m_pos = new vec4f [m_count];
-    m_zs = new float [m_count];
-    m_sortedIndices16 = new GLushort [m_count];
+    m_target.positions = NULL;
+    m_target.indices = NULL;
+
+    // the smallest square grid that holds the particles
+    int32_t N = (int32_t)sqrtf((float)m_count);
+    while (N * N < m_count)
+        N++;
+
+    m_x = new float [m_count];
+    m_y = new float [m_count];
+    m_z = new float [m_count];
+    m_noiseValue = new float [m_count];
+    m_keys = new uint32_t [m_count];
+    for (int32_t b = 0; b < 2; b++)
+    {
+        m_packed[b] = new vec4f [m_count];
+        m_sortedIndices16[b] = (m_indexMode == PARTICLE_INDEX_16) ? new GLushort [m_count] : NULL;
+        m_sortedIndices32[b] = (m_indexMode == PARTICLE_INDEX_32 || m_indexMode == PARTICLE_INDEX_NONE) ? new GLuint [m_count] : NULL;
+    }
 
-    initGrid(GRID_RESOLUTION);
+    initGrid(N);
     addNoise(0.01, 70.0);
+
+    // the positions the renderer starts from, before the first sort; packRange writes the back buffers
+    for (int32_t i = 0; i < m_count; i++)
+    {
+        if (m_sortedIndices16[1])
+            m_sortedIndices16[1][i] = (GLushort)i;
+        else if (m_sortedIndices32[1])
+            m_sortedIndices32[1][i] = i;
+    }
+    NvJobSystem::parallelFor(packRange, this, m_numActive, PARTICLE_JOB_GRAIN, "Particles pack");
+    m_front = 1;
+
+    m_steps.setStepFunction(advectStep, this, "Particles steps");
 }
 
 ParticleInitializer::~ParticleInitializer()
 {
-    delete [] m_pos;
-    delete [] m_zs;
-    delete [] m_sortedIndices16;
+    // the job may still be writing the buffers
+    finish();
+
+    delete [] m_x;
+    delete [] m_y;
+    delete [] m_z;
+    delete [] m_noiseValue;
+    delete [] m_keys;
+    for (int32_t b = 0; b < 2; b++)
+    {
+        delete [] m_packed[b];
+        delete [] m_sortedIndices16[b];
+        delete [] m_sortedIndices32[b];
+    }
 }
 
 int32_t ParticleInitializer::getNumActive() const
@@ -135,23 +220,26 @@ int32_t ParticleInitializer::getNumActive() const
     return result;
 }
 
-// virtual
-void ParticleInitializer::Run()
+const void* ParticleInitializer::getSortedIndices()
 {
-    bool running = true;
-    while (running)
-        simulate();
+    switch (m_indexMode)
+    {
+    case PARTICLE_INDEX_16:
+        return m_sortedIndices16[m_front];
+    case PARTICLE_INDEX_32:
+        return m_sortedIndices32[m_front];
+    default:
+        return NULL;
+    }
 }
 
-ParticleSystem::ParticleSystem()
+ParticleSystem::ParticleSystem(int32_t count, ParticleIndexMode indexMode)
 : m_pInit(NULL)
 {
-    // Although there is threading code for the init, it doesn't quite work because the VBO code in 
-    // ParticleRenderer grabs a copy of the positions *once* before they are initialized.  Disabled for now.
-    m_pInit = new ParticleInitializer();
-
-    // No multi-threading for now.
-    //m_pInit->Start();
+    // The per-frame update runs as a job behind the frame that draws the last one's results,
+    // and splits itself across the job system workers; the initial grid and noise are built
+    // once here, before the renderer copies the positions.
+    m_pInit = new ParticleInitializer(count, indexMode);
 }
 
 ParticleSystem::~ParticleSystem()
@@ -164,27 +252,47 @@ float saturate(float f)
     return std::min(1.0f, std::max(0.0f, f));
 }
 
-// initialize particles in regular grid.  Single threaded.
+// initialize particles in regular grid, up to the particle count.  Single threaded.
 void ParticleInitializer::initGrid(int32_t N)
 {
+    // noise coordinates of one row, for the batched fBm
+    float* xs = new float[N];
+    float* ys = new float[N];
+    float* zs = new float[N];
+    float* noise = new float[N];
+
     int32_t i = 0;
-    for (int32_t z=0; z < N; z++)
+    for (int32_t z=0; z < N && i < m_count; z++)
     {
-        for (int32_t x=0; x < N; x++)
+        const int32_t row = std::min(N, m_count - i);
+        for (int32_t x=0; x < row; x++)
         {
             vec3f p = vec3f(float(x), 0, float(z)) / vec3f(float(N), float(N), float(N));
             p = (p * 2.0f - 1.0f) * m_width;
             p.y = -1.0f;        // -2
 
-            const vec3f coords(p.x, p.y, p.z);
-            const float noise = 0.7f + fabs(m_noise.fBm(coords * 0.007)) * 2;
-            m_pos[i] = vec4f(p.x, p.y, p.z, noise);
-            i++;
+            const vec3f coords = vec3f(p.x, p.y, p.z) * 0.007;
+            xs[x] = coords.x;
+            ys[x] = coords.y;
+            zs[x] = coords.z;
+            m_x[i + x] = p.x;
+            m_y[i + x] = p.y;
+            m_z[i + x] = p.z;
         }
+
+        m_noise.fBm(xs, ys, zs, noise, row);
+        for (int32_t x=0; x < row; x++)
+            m_noiseValue[i + x] = 0.7f + fabs(noise[x]) * 2;
+        i += row;
     }
 
+    delete [] xs;
+    delete [] ys;
+    delete [] zs;
+    delete [] noise;
+
     m_numActive = i;
-    assert(m_numActive == N * N);
+    assert(m_numActive == m_count);
 }
 
 int32_t ParticleSystem::getNumActive() const
@@ -192,86 +300,191 @@ int32_t ParticleSystem::getNumActive() const
     return m_pInit->getNumActive();
 }
 
+ParticleIndexMode ParticleSystem::getIndexMode() const
+{
+    return m_pInit->getIndexMode();
+}
+
 // Single threaded.
 void ParticleInitializer::addNoise(float freq, float scale)
 {
-    for (int32_t i = 0; i < m_numActive; i++)
+    // batched fBm3f over blocks of particles
+    const int32_t BLOCK = 256;
+    float xs[BLOCK], ys[BLOCK], zs[BLOCK];
+    float nx[BLOCK], ny[BLOCK], nz[BLOCK];
+
+    for (int32_t begin = 0; begin < m_numActive; begin += BLOCK)
     {
-        const vec3f coords(truncate(m_pos[i]));
-        const vec3f noise = m_noise.fBm3f(coords * freq) * scale;
-        m_pos[i].x += noise.x;
-        m_pos[i].y += noise.y;
-        m_pos[i].z += noise.z;
+        const int32_t count = std::min(BLOCK, m_numActive - begin);
+        for (int32_t k = 0; k < count; k++)
+        {
+            xs[k] = m_x[begin + k] * freq;
+            ys[k] = m_y[begin + k] * freq;
+            zs[k] = m_z[begin + k] * freq;
+        }
+
+        m_noise.fBm3f(xs, ys, zs, nx, ny, nz, count);
+        for (int32_t k = 0; k < count; k++)
+        {
+            m_x[begin + k] += nx[k] * scale;
+            m_y[begin + k] += ny[k] * scale;
+            m_z[begin + k] += nz[k] * scale;
+        }
     }
 }
 
-void ParticleInitializer::setTime(float frameElapsed)
+void ParticleSystem::simulate(float frameElapsed, const vec3f& halfVector, const vec4f& eyePos,
+    const ParticleTarget* target)
 {
-    //m_timeCondition.Acquire();
-    m_elapsedTime += frameElapsed;
-    //m_timeCondition.Signal();
-    //m_timeCondition.Release();
+    // this frame draws the particles the last frame's job left, sorted for the last frame's
+    // view; the very first frame draws them as they were created
+    m_pInit->finish();
+
+    m_pInit->start(frameElapsed, halfVector, target);
 }
 
-void ParticleSystem::simulate(float frameElapsed, const vec3f& halfVector, const vec4f& eyePos)
+void ParticleSystem::finish()
 {
-    m_pInit->setTime(frameElapsed);
-    m_pInit->simulate();
+    m_pInit->finish();
+}
 
-    m_pInit->depthSortEfficient(halfVector);
+float ParticleSystem::getOverlap() const
+{
+    return m_pInit->getOverlap();
 }
 
-static void wrapPos(float width, vec4f& pos)
+void ParticleSystem::resetOverlap()
 {
-    if (pos.x < -width)
-        pos.x += 2*width;
-    if (pos.x > width)
-        pos.x -= 2*width;
+    m_pInit->resetOverlap();
+}
 
-    if (pos.z < -width)
-        pos.z += 2*width;
-    if (pos.z > width)
-        pos.z -= 2*width;
+void ParticleInitializer::updateJob(void* data)
+{
+    ParticleInitializer* init = (ParticleInitializer*)data;
+    const uint64_t startNs = NvProfiler::getTimeNs();
+    init->simulate(init->m_frameElapsed);
+    if (init->m_indexMode == PARTICLE_INDEX_GPU)
+        NvJobSystem::parallelFor(packRange, init, init->getNumActive(), PARTICLE_JOB_GRAIN, "Particles pack");
+    else
+        init->depthSortEfficient(init->m_halfVector);
+    init->m_updateNs = NvProfiler::getTimeNs() - startNs;
+}
+
+void ParticleInitializer::start(float frameElapsed, const vec3f& halfVector, const ParticleTarget* target)
+{
+    m_frameElapsed = frameElapsed;
+    m_halfVector = halfVector;
+    m_target.positions = target ? target->positions : NULL;
+    m_target.indices = (target && getSortedIndices()) ? target->indices : NULL;
+    m_pending = true;
+    NvJobSystem::run(updateJob, this, "Particles update", &m_update);
 }
 
-void ParticleInitializer::simulate()
+void ParticleInitializer::finish()
 {
-    //m_timeCondition.Acquire();
-    //m_timeCondition.Wait();
-    const float dt = m_elapsedTime;
-    //m_timeCondition.Release();
+    if (!m_pending)
+        return;
 
-    const vec4f wind(4.7f, 0.0f, 3.1f, 0.0f);
-    for (int32_t i = 0; i < getNumActive(); i++)
+    const uint64_t startNs = NvProfiler::getTimeNs();
     {
-        m_pos[i] += dt * wind;
-        wrapPos(m_width, m_pos[i]);
+        NV_PROFILE_SCOPE("Particles wait");
+        NvJobSystem::wait(&m_update);
     }
+    m_totalWaitNs += NvProfiler::getTimeNs() - startNs;
+    m_totalUpdateNs += m_updateNs;
 
-    //m_timeCondition.Acquire();
-    m_elapsedTime -= dt;
-    //m_timeCondition.Release();
+    m_front = 1 - m_front;
+    m_pending = false;
 }
 
-void ParticleInitializer::depthSortEfficient(const vec3f& halfVector)
+// the fraction of the update time that ran while the frame went on, rather than
+// while it waited; 0 when the job only ran once the frame came to wait for it
+float ParticleInitializer::getOverlap() const
 {
-    // calculate eye-space z
-    for (int32_t i = 0; i < getNumActive(); ++i)
-    {
-        float z = -dot(halfVector, truncate(m_pos[i]));  // project onto vector
-        m_zs[i] = z;
-    }
+    if (m_totalUpdateNs == 0 || m_totalWaitNs >= m_totalUpdateNs)
+        return 0.0f;
+    return 1.0f - (float)((double)m_totalWaitNs / m_totalUpdateNs);
+}
 
-    // sort
-    m_sorter.Sort(m_zs, getNumActive());
+void ParticleInitializer::resetOverlap()
+{
+    m_totalUpdateNs = 0;
+    m_totalWaitNs = 0;
+}
+
+// moves a coordinate by the wind, wrapping it back into [-width, width]; branch free, so the loops vectorize
+static inline float advectCoord(float p, float wind, float width)
+{
+    p += wind;
+    p += (p < -width) ? 2*width : 0.0f;
+    p -= (p > width) ? 2*width : 0.0f;
+    return p;
+}
+
+void ParticleInitializer::advectRange(void* data, int32_t begin, int32_t end)
+{
+    ParticleInitializer* init = (ParticleInitializer*)data;
+    const float width = init->m_width;
+    const float windX = init->m_wind.x;
+    const float windZ = init->m_wind.z;
+    float* x = init->m_x;
+    float* z = init->m_z;
+    for (int32_t i = begin; i < end; i++)
+        x[i] = advectCoord(x[i], windX, width);
+    for (int32_t i = begin; i < end; i++)
+        z[i] = advectCoord(z[i], windZ, width);
+}
 
-    const GLuint *sortedIndices32 = m_sorter.GetIndices();
-    for (int32_t i = 0; i < getNumActive(); ++i)
+void ParticleInitializer::advectStep(void* data, float dt, int32_t step, int32_t steps)
+{
+    ParticleInitializer* init = (ParticleInitializer*)data;
+    init->m_wind = dt * vec4f(4.7f, 0.0f, 3.1f, 0.0f);
+    NvJobSystem::parallelFor(advectRange, init, init->getNumActive(), PARTICLE_JOB_GRAIN, "Particles advect");
+}
+
+// interleaves the particles for the vertex buffer; in sorted order when there are no indices
+void ParticleInitializer::packRange(void* data, int32_t begin, int32_t end)
+{
+    ParticleInitializer* init = (ParticleInitializer*)data;
+    const int32_t back = 1 - init->m_front;
+    vec4f* packed = init->m_target.positions ? init->m_target.positions : init->m_packed[back];
+    if (init->m_indexMode == PARTICLE_INDEX_NONE)
+    {
+        const GLuint* order = init->m_sortedIndices32[back];
+        for (int32_t i = begin; i < end; i++)
+        {
+            const GLuint j = order[i];
+            packed[i] = vec4f(init->m_x[j], init->m_y[j], init->m_z[j], init->m_noiseValue[j]);
+        }
+    }
+    else
     {
-        m_sortedIndices16[i] = (GLushort) sortedIndices32[i];
+        for (int32_t i = begin; i < end; i++)
+            packed[i] = vec4f(init->m_x[i], init->m_y[i], init->m_z[i], init->m_noiseValue[i]);
     }
 }
 
+void ParticleInitializer::simulate(float frameElapsed)
+{
+    // the depth sort that follows needs the new positions, so the steps are not overlapped
+    m_steps.begin(frameElapsed, false);
+}
+
+void ParticleInitializer::depthSortEfficient(const vec3f& halfVector)
+{
+    // keys of the eye-space z, -dot(halfVector, pos), sorted straight into the indices.
+    // The particles drift and the view turns slowly, so most frames only merge a few keys into last frame's order
+    const vec3f axis = -halfVector;
+    const int32_t back = 1 - m_front;
+    NvRadixSort::computeDepthKeys(m_x, m_y, m_z, getNumActive(), &axis.x, m_keys);
+    if (m_indexMode == PARTICLE_INDEX_16)
+        m_sorter.sort(m_keys, getNumActive(), m_target.indices ? (GLushort*)m_target.indices : m_sortedIndices16[back]);
+    else
+        m_sorter.sort(m_keys, getNumActive(), m_target.indices ? (GLuint*)m_target.indices : m_sortedIndices32[back]);
+
+    NvJobSystem::parallelFor(packRange, this, getNumActive(), PARTICLE_JOB_GRAIN, "Particles pack");
+}
+
 static float distanceSqr(vec3f p1, vec3f p2)
 {
     vec3f vec = p1 - p2;
@@ -301,7 +514,7 @@ vec4f* ParticleSystem::getPositions()
     return m_pInit->getPositions();
 }
 
-GLushort* ParticleSystem::getSortedIndices()
+const void* ParticleSystem::getSortedIndices()
 {
     return m_pInit->getSortedIndices();
 }
@@ -50,20 +50,56 @@
 #define PARTICLE_SCALE 1.f
 #endif
 
+// The particle count unless -particles <n> is given.  The particles fill a square grid,
+// so larger counts are drawn smaller (see ParticleRenderer)
+#define DEFAULT_PARTICLE_COUNT (GRID_RESOLUTION * GRID_RESOLUTION)
+
+// How the depth sorted particles are drawn
+enum ParticleIndexMode
+{
+    PARTICLE_INDEX_16,      // 16 bit indices into the positions; up to 65536 particles
+    PARTICLE_INDEX_32,      // 32 bit indices (GL, ES3, or ES2 with GL_OES_element_index_uint)
+    PARTICLE_INDEX_NONE,    // no indices: the positions are written in sorted order and drawn as arrays
+    PARTICLE_INDEX_GPU      // no CPU sort: the renderer sorts 32 bit indices into the positions in compute shaders
+};
+
+// Where an update writes its results, e.g. mapped buffer memory.  Write-only; a NULL
+// pointer leaves those results in the particle system's own buffers
+struct ParticleTarget
+{
+    nv::vec4f* positions;   // xyz and noise of each particle, as getPositions()
+    void* indices;          // the sorted indices, as getSortedIndices(); unused without CPU indices
+};
+
 class ParticleInitializer;
 
 class ParticleSystem
 {
 public:
-    ParticleSystem();
+    ParticleSystem(int32_t count, ParticleIndexMode indexMode);
     ~ParticleSystem();
 
-    void simulate(float frameElapsed, const nv::vec3f& halfVector, const nv::vec4f& eyePos);
+    // Starts the update for a frame: advection, depth sort and packing run as a job while the
+    // frame is drawn.  The positions and indices are the last frame's until the next call.
+    // With a target, the update writes there instead, and the target must stay valid until finish()
+    void simulate(float frameElapsed, const nv::vec3f& halfVector, const nv::vec4f& eyePos,
+        const ParticleTarget* target = NULL);
+
+    // waits for the update started by simulate() and makes its results current
+    void finish();
+
+    // the fraction of the update time since resetOverlap() that ran alongside the frame
+    float getOverlap() const;
+    void resetOverlap();
 
     int32_t getNumActive() const;
+    ParticleIndexMode getIndexMode() const;
 
+    // xyz and noise of each particle, in sorted order for PARTICLE_INDEX_NONE
     nv::vec4f *getPositions();
-    GLushort* getSortedIndices();
+
+    // the sorted indices, GLushort or GLuint by index mode; NULL for PARTICLE_INDEX_NONE and PARTICLE_INDEX_GPU
+    const void* getSortedIndices();
  
 private:
     ParticleInitializer* m_pInit;
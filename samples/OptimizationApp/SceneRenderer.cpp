@@ -43,6 +43,27 @@ void MatrixStorage::multiply()
   m_modelViewProjection = m_projection*m_modelView;
 }
 
+// The auto quality ladder, cheapest first.  The particles render at their own low
+// resolution on top of the scene's, and the filter only matters when they are upsampled
+struct QualityLevel
+{
+    const char* name;
+    bool lowResScene;
+    bool lowResParticles;
+    bool crossBilateral;
+};
+
+static const QualityLevel QUALITY_LEVELS[] =
+{
+    { "low-res scene and particles, bilinear",  true,  true,  false },
+    { "low-res scene and particles",            true,  true,  true },
+    { "low-res particles, bilinear",            false, true,  false },
+    { "low-res particles",                      false, true,  true },
+    { "full-res",                               false, false, true },
+};
+
+static const int32_t QUALITY_LEVEL_COUNT = sizeof(QUALITY_LEVELS) / sizeof(QUALITY_LEVELS[0]);
+
 class ObjectSorter
 {
 public:
@@ -53,12 +74,13 @@ public:
     }
 };
 
-SceneRenderer::SceneRenderer(bool isES2)
+SceneRenderer::SceneRenderer(bool isES2, int32_t particleCount, bool hasIndexUint, bool gpuSort)
+: m_tuning(false)
 {
     initTimers();
 
     // Call this early to give it time to multi-thread init.
-    m_particles = new ParticleRenderer(isES2);
+    m_particles = new ParticleRenderer(isES2, particleCount, hasIndexUint, gpuSort);
 
     m_texStorage["floor"]       = NvImage::UploadTextureFromDDSFile("images/tex1.dds"); 
     m_texStorage["white_dummy"] = NvImage::UploadTextureFromDDSFile("images/white_dummy.dds"); 
@@ -109,6 +131,13 @@ SceneRenderer::SceneRenderer(bool isES2)
     m_scene.m_lightDiffuse = 0.85f;
 
     m_statsCountdown = STATS_FRAMES;
+
+    const char* levelNames[QUALITY_LEVEL_COUNT];
+    for (int32_t i = 0; i < QUALITY_LEVEL_COUNT; ++i)
+    {
+        levelNames[i] = QUALITY_LEVELS[i].name;
+    }
+    m_tuner.setLevels(levelNames, QUALITY_LEVEL_COUNT, getQualityLevel());
 }
 
 SceneRenderer::~SceneRenderer()
@@ -419,8 +448,6 @@ void SceneRenderer::renderFrame()
         m_upsampler->upsampleSceneColors(*m_fbos->m_backBufferFbo);
         CHECK_GL_ERROR();
     }
-
-    m_particles->swapBuffers();
 }
 
 // Have to deal with the fact that not all requested timer start/stop pairs
@@ -449,7 +476,8 @@ bool SceneRenderer::stats(char* buffer, int32_t size)
             "GPU Particles: %5.1f%%\n"
             "CPU Particles: %5.1f%%\n"
             "GPU Particles upsamp: %5.1f%%\n"
-            "CPU Particles upsamp: %5.1f%%\n",
+            "CPU Particles upsamp: %5.1f%%\n"
+            "Particle update overlap: %5.1f%%\n",
             ComputePercentage(m_GPUTimers[GPU_TIMER_SCENE_DEPTH], meanGPUTotal),
             100.f * m_CPUTimers[CPU_TIMER_SCENE_DEPTH].getScaledCycles()        / m_CPUTimers[CPU_TIMER_TOTAL].getScaledCycles(),
             ComputePercentage(m_GPUTimers[GPU_TIMER_SCENE_COLOR], meanGPUTotal),
@@ -459,7 +487,14 @@ bool SceneRenderer::stats(char* buffer, int32_t size)
             ComputePercentage(m_GPUTimers[GPU_TIMER_PARTICLES], meanGPUTotal),
             100.f * m_CPUTimers[CPU_TIMER_PARTICLES].getScaledCycles()          / m_CPUTimers[CPU_TIMER_TOTAL].getScaledCycles(),
             ComputePercentage(m_GPUTimers[GPU_TIMER_UPSAMPLE_PARTICLES], meanGPUTotal),
-            100.f * m_CPUTimers[CPU_TIMER_UPSAMPLE_PARTICLES].getScaledCycles() / m_CPUTimers[CPU_TIMER_TOTAL].getScaledCycles());
+            100.f * m_CPUTimers[CPU_TIMER_UPSAMPLE_PARTICLES].getScaledCycles() / m_CPUTimers[CPU_TIMER_TOTAL].getScaledCycles(),
+            100.f * m_particles->getParticleSystem().getOverlap());
+        m_particles->getParticleSystem().resetOverlap();
+
+        // the means of the frames since the last reset (the countdown runs STATS_FRAMES + 1 frames)
+        const int32_t gpuFrames = m_GPUTimers[GPU_TIMER_TOTAL].getStartStopCycles();
+        updateQuality((gpuFrames > 0) ? m_GPUTimers[GPU_TIMER_TOTAL].getScaledCycles() / gpuFrames : 0.0f,
+            1000.0f * m_CPUTimers[CPU_TIMER_TOTAL].getScaledCycles() / (STATS_FRAMES + 1));
 
         for (int32_t i = 0; i < GPU_TIMER_COUNT; ++i)
         {
@@ -477,4 +512,53 @@ bool SceneRenderer::stats(char* buffer, int32_t size)
         m_statsCountdown--;
         return false;
     }
-}
\ No newline at end of file
+}
+
+// the most expensive level that costs no more than the current settings on any knob
+int32_t SceneRenderer::getQualityLevel()
+{
+    const bool lowResScene = m_params.renderLowResolution;
+    const bool lowResParticles = getParticleParams()->renderLowResolution;
+    const bool crossBilateral = getUpsamplingParams()->useCrossBilateral;
+
+    for (int32_t i = QUALITY_LEVEL_COUNT - 1; i > 0; --i)
+    {
+        const QualityLevel& level = QUALITY_LEVELS[i];
+        if ((level.lowResScene || !lowResScene) &&
+            (level.lowResParticles || !lowResParticles) &&
+            (!level.crossBilateral || !level.lowResParticles || !lowResParticles || crossBilateral))
+            return i;
+    }
+    return 0;
+}
+
+void SceneRenderer::applyQualityLevel(int32_t index)
+{
+    const QualityLevel& level = QUALITY_LEVELS[index];
+    m_params.renderLowResolution = level.lowResScene;
+    getParticleParams()->renderLowResolution = level.lowResParticles;
+    getUpsamplingParams()->useCrossBilateral = level.crossBilateral;
+}
+
+void SceneRenderer::updateQuality(float gpuMs, float cpuMs)
+{
+    if (!m_params.autoQuality)
+    {
+        m_tuning = false;
+        return;
+    }
+
+    // the settings may have been changed by hand while the tuner was off
+    if (!m_tuning)
+    {
+        m_tuner.reset(getQualityLevel());
+        m_tuning = true;
+    }
+
+    NvQualityTuner::Params params = m_tuner.getParams();
+    params.budgetMs = m_params.frameBudgetMs;
+    m_tuner.setParams(params);
+
+    if (m_tuner.addWindow(gpuMs, cpuMs))
+        applyQualityLevel(m_tuner.getLevel());
+}
@@ -45,6 +45,7 @@
 #include "Terrain.h"
 #include "NvGLUtils/NvTimers.h"
 #include "NvGLUtils/NvSimpleFBO.h"
+#include "NvAppBase/NvQualityTuner.h"
 #include "NV/NvStopWatch.h"
 
 class OpaqueColorProgram;
@@ -85,15 +86,20 @@ public:
         Params()
         : useDepthPrepass(false)
         , renderLowResolution(false)
+        , autoQuality(false)
+        , frameBudgetMs(1000.0f / 60.0f)
         , backgroundColor(0.5f, 0.8f, 1.f)
         {
         }
         bool useDepthPrepass;
         bool renderLowResolution;
+        // pick the resolutions and the particle upsampling filter from the frame timers
+        bool autoQuality;
+        float frameBudgetMs;
         vec3f backgroundColor;
     };
 
-    SceneRenderer(bool isES2);
+    SceneRenderer(bool isES2, int32_t particleCount, bool hasIndexUint, bool gpuSort);
     ~SceneRenderer();
 
     void updateFrame(float frameElapsed);
@@ -166,6 +172,9 @@ private:
     void renderFullResSceneColor(const MatrixStorage&);
     void setupMatrices(MatrixStorage&);
     void renderParticles(const MatrixStorage&);
+    void updateQuality(float gpuMs, float cpuMs);
+    int32_t getQualityLevel();
+    void applyQualityLevel(int32_t level);
 
     std::vector<MeshObj>            m_models;
     Terrain*                        m_pTerrain;
@@ -182,6 +191,10 @@ private:
     const static int32_t STATS_FRAMES = 60;
     int32_t m_statsCountdown;
 
+    // steps the quality levels while Params::autoQuality is set, fed once per stats interval
+    NvQualityTuner m_tuner;
+    bool m_tuning;
+
     int32_t m_screenWidth;
     int32_t m_screenHeight;
     SceneFBOs *m_fbos;
@@ -0,0 +1,309 @@
+//----------------------------------------------------------------------------------
+// File:        OptimizationApp/SortBenchmark.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "SortBenchmark.h"
+#include "IceRevisitedRadix.h"
+#include "NvAppBase/NvIncrementalSort.h"
+#include "NvAppBase/NvJobSystem.h"
+#include "NvAppBase/NvRadixSort.h"
+#include "NV/NvLogs.h"
+#include "NV/NvStopWatch.h"
+#include <math.h>
+#include <string.h>
+
+// the particles are spread like the sample's, over a 960 unit cube
+static void randomPositions(float* pos, int32_t count)
+{
+    uint32_t seed = 12345;
+    for (int32_t i = 0; i < count * 4; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        pos[i] = ((seed >> 8) / (float)(1 << 24) * 2.0f - 1.0f) * 480.0f;
+    }
+}
+
+// a different view for every iteration, so RadixSort's temporal coherence check never hits
+static void viewAxis(int32_t iteration, float* axis)
+{
+    const float a = 0.7f * iteration;
+    axis[0] = cosf(a) * 0.8f;
+    axis[1] = -0.6f;
+    axis[2] = sinf(a) * 0.8f;
+}
+
+// the sample's original depth sort: scalar -dot(halfVector, pos), then RadixSort on the floats
+static void sortReference(RadixSort& sorter, const float* pos, int32_t count, const float* halfVector, float* zs)
+{
+    for (int32_t i = 0; i < count; i++)
+    {
+        const float* p = pos + i*4;
+        zs[i] = -(halfVector[0]*p[0] + halfVector[1]*p[1] + halfVector[2]*p[2]);
+    }
+    sorter.Sort(zs, (udword)count);
+}
+
+// frame after frame of particles blown by a wind, seen from a steady view and then from
+// one turning a quarter degree a frame: the incremental sort against a radix sort from
+// scratch, checked against it every frame
+static bool runCoherentSortBenchmark(NvStopWatch* stopWatch, float* pos, uint32_t* keys,
+    uint32_t* radixIndices, uint32_t* indices)
+{
+    const int32_t frames = 60;
+    bool passed = true;
+
+    for (int32_t run = 0; run < 6; run++)
+    {
+        const int32_t count = (run % 3 == 0) ? 10000 : ((run % 3 == 1) ? 100000 : 1000000);
+        const float turn = (run < 3) ? 0.0f : 0.25f * 3.14159265f / 180.0f;
+        randomPositions(pos, count);
+
+        NvRadixSort radix;
+        NvIncrementalSort incremental;
+        float radixMs = 0.0f, incrementalMs = 0.0f;
+        int32_t pathCounts[NvIncrementalSort::PATH_COUNT] = { 0 };
+        double moved = 0.0, shifted = 0.0;
+        int32_t mismatches = 0;
+        uint32_t seed = 6789;
+
+        for (int32_t f = 0; f < frames; f++)
+        {
+            // blow the particles along with the sample's wind, wrapping around the cube,
+            // and respawn one in a thousand
+            for (int32_t i = 0; i < count; i++)
+            {
+                float* p = pos + i*4;
+                seed = seed * 1664525 + 1013904223;
+                if ((seed >> 8) % 1000 == 0)
+                    p[1] = -p[1];
+                p[0] += 0.078f;
+                p[2] += 0.052f;
+                if (p[0] > 480.0f)
+                    p[0] -= 960.0f;
+                if (p[2] > 480.0f)
+                    p[2] -= 960.0f;
+            }
+
+            const float a = 0.3f + turn * f;
+            const float axis[3] = { -cosf(a) * 0.8f, 0.6f, -sinf(a) * 0.8f };
+            NvRadixSort::computeDepthKeys(pos, 4, count, axis, keys);
+
+            stopWatch->reset();
+            stopWatch->start();
+            radix.sort(keys, count, radixIndices);
+            stopWatch->stop();
+            // the first frame has no previous order, so it is left out of the timings
+            if (f > 0)
+                radixMs += stopWatch->getTime() * 1000.0f;
+
+            stopWatch->reset();
+            stopWatch->start();
+            incremental.sort(keys, count, indices);
+            stopWatch->stop();
+            if (f > 0)
+                incrementalMs += stopWatch->getTime() * 1000.0f;
+
+            pathCounts[incremental.getLastPath()]++;
+            moved += incremental.getLastMovedCount();
+            shifted += incremental.getLastShiftedCount();
+
+            // equal keys may be ordered differently, so compare the sorted keys
+            for (int32_t i = 0; i < count; i++)
+            {
+                if (keys[indices[i]] != keys[radixIndices[i]])
+                {
+                    mismatches++;
+                    break;
+                }
+            }
+        }
+
+        if (mismatches)
+        {
+            LOGE("Coherent sort %8d %s view: %d frames out of order\n", count, (turn > 0.0f) ? "turning" : "steady", mismatches);
+            passed = false;
+        }
+        else
+        {
+            LOGI("Coherent sort %8d %s view: radix %8.3f ms, incremental %8.3f ms %5.2fx (%d radix, %d sorted, %d merge; %.1f keys moved, %.1f shifted per frame)\n",
+                count, (turn > 0.0f) ? "turning" : "steady ", radixMs / (frames - 1), incrementalMs / (frames - 1),
+                radixMs / incrementalMs, pathCounts[NvIncrementalSort::PATH_RADIX], pathCounts[NvIncrementalSort::PATH_SORTED],
+                pathCounts[NvIncrementalSort::PATH_MERGE], moved / frames, shifted / frames);
+        }
+    }
+
+    return passed;
+}
+
+bool runSortBenchmark(NvStopWatch* stopWatch)
+{
+    const int32_t maxCount = 10000000;
+
+    // the default job system size is one worker less than the cores
+    NvJobSystem::restart(-1);
+    const int32_t cores = NvJobSystem::getWorkerCount() + 1;
+    int32_t threadCounts[4] = { 1, 2, 4, cores };
+    const int32_t numThreadCounts = (cores > 4) ? 4 : 3;
+
+    float* pos = new float[maxCount * 4];
+    float* zs = new float[maxCount];
+    uint32_t* keys = new uint32_t[maxCount];
+    uint32_t* scalarKeys = new uint32_t[maxCount];
+    uint32_t* indices = new uint32_t[maxCount];
+    uint32_t* firstIndices = new uint32_t[maxCount];
+    uint16_t* indices16 = new uint16_t[65536];
+    randomPositions(pos, maxCount);
+
+    bool passed = true;
+    LOGI("Sort benchmark: %d cores, %s depth keys\n", cores, NvRadixSort::getSIMDName());
+
+    for (int32_t count = 10000; count <= maxCount; count *= 10)
+    {
+        const int32_t iterations = (count >= 1000000) ? 4 : (4000000 / count);
+
+        RadixSort reference;
+        float axis[3];
+        stopWatch->reset();
+        stopWatch->start();
+        for (int32_t i = 0; i < iterations; i++)
+        {
+            viewAxis(i, axis);
+            sortReference(reference, pos, count, axis, zs);
+        }
+        stopWatch->stop();
+        const float referenceMs = stopWatch->getTime() * 1000.0f / iterations;
+        LOGI("Sort %8d reference:  %9.3f ms\n", count, referenceMs);
+
+        // the last view, sorted by RadixSort, for the ordering check
+        const udword* referenceIndices = reference.GetIndices();
+        const float negAxis[3] = { -axis[0], -axis[1], -axis[2] };
+
+        // SIMD keys must match the scalar ones
+        NvRadixSort::setSIMDEnabled(false);
+        NvRadixSort::computeDepthKeys(pos, 4, count, negAxis, scalarKeys);
+        NvRadixSort::setSIMDEnabled(true);
+        NvRadixSort::computeDepthKeys(pos, 4, count, negAxis, keys);
+        if (memcmp(keys, scalarKeys, sizeof(uint32_t)*count) != 0)
+        {
+            LOGE("Sort %8d: the SIMD depth keys differ from the scalar ones\n", count);
+            passed = false;
+        }
+
+        for (int32_t t = 0; t < numThreadCounts; t++)
+        {
+            NvJobSystem::restart(threadCounts[t] - 1);
+
+            NvRadixSort sorter;
+            float keysMs = 0.0f, sortMs = 0.0f;
+            for (int32_t i = 0; i < iterations; i++)
+            {
+                float iterAxis[3];
+                viewAxis(i, iterAxis);
+                iterAxis[0] = -iterAxis[0];
+                iterAxis[1] = -iterAxis[1];
+                iterAxis[2] = -iterAxis[2];
+
+                stopWatch->reset();
+                stopWatch->start();
+                NvRadixSort::computeDepthKeys(pos, 4, count, iterAxis, keys);
+                stopWatch->stop();
+                keysMs += stopWatch->getTime() * 1000.0f;
+
+                stopWatch->reset();
+                stopWatch->start();
+                sorter.sort(keys, count, indices);
+                stopWatch->stop();
+                sortMs += stopWatch->getTime() * 1000.0f;
+            }
+            keysMs /= iterations;
+            sortMs /= iterations;
+
+            // the same depths in the same order as RadixSort; equal depths may be ordered
+            // differently (RadixSort reverses equal negative floats), so count exact index matches
+            int32_t orderErrors = 0, sameIndices = 0;
+            for (int32_t i = 0; i < count; i++)
+            {
+                if (NvRadixSort::keyToFloat(keys[indices[i]]) != zs[referenceIndices[i]])
+                    orderErrors++;
+                if (indices[i] == referenceIndices[i])
+                    sameIndices++;
+            }
+
+            bool ok = (orderErrors == 0);
+            if (t == 0)
+                memcpy(firstIndices, indices, sizeof(uint32_t)*count);
+            else if (memcmp(firstIndices, indices, sizeof(uint32_t)*count) != 0)
+            {
+                LOGE("Sort %8d %2d threads: the indices differ from the single thread ones\n", count, threadCounts[t]);
+                ok = false;
+            }
+
+            if (count <= 65536)
+            {
+                sorter.sort(keys, count, indices16);
+                for (int32_t i = 0; i < count && ok; i++)
+                {
+                    if (indices16[i] != indices[i])
+                    {
+                        LOGE("Sort %8d: the 16 bit indices differ from the 32 bit ones\n", count);
+                        ok = false;
+                    }
+                }
+            }
+
+            if (orderErrors)
+                LOGE("Sort %8d %2d threads: %d particles out of RadixSort's order\n", count, threadCounts[t], orderErrors);
+            if (ok)
+            {
+                LOGI("Sort %8d %2d threads: %9.3f ms (keys %8.3f, sort %8.3f, %d passes, %d chunks) %5.2fx, %.4f%% same indices\n",
+                    count, threadCounts[t], keysMs + sortMs, keysMs, sortMs, sorter.getPassCount(), sorter.getChunkCount(),
+                    referenceMs / (keysMs + sortMs), 100.0 * sameIndices / count);
+            }
+            passed = passed && ok;
+        }
+    }
+
+    // the cores
+    NvJobSystem::restart(cores - 1);
+    passed = runCoherentSortBenchmark(stopWatch, pos, keys, firstIndices, indices) && passed;
+
+    delete [] pos;
+    delete [] zs;
+    delete [] keys;
+    delete [] scalarKeys;
+    delete [] indices;
+    delete [] firstIndices;
+    delete [] indices16;
+
+    return passed;
+}
@@ -35,19 +35,43 @@
 #include "NV/NvLogs.h"
 #include "ParticleRenderer.h"
 #include "Shaders.h"
+#include <math.h>
 
-ParticleRenderer::ParticleRenderer(bool isGL)
+ParticleRenderer::ParticleRenderer(bool isGL, int32_t count, bool hasIndexUint, bool gpuSort)
     : m_vbo(0)
     , m_frameId(0)
     , m_eboArray(NULL)
     , m_eboCount(2)
     , m_isGL(isGL)
+    , m_stateCalls(0)
+    , m_glCalls(0)
+    , m_drawCalls(0)
 {
-    m_particleSystem = new ParticleSystem();
+    // 16 bit indices while they reach every particle, then 32 bit ones where the context
+    // has them, else the particles are written in sorted order and drawn without indices.
+    // The GPU sort draws 32 bit indices too, so it needs a context that has compute shaders
+    ParticleIndexMode indexMode = PARTICLE_INDEX_16;
+    if (count > 65536)
+        indexMode = hasIndexUint ? PARTICLE_INDEX_32 : PARTICLE_INDEX_NONE;
+    if (gpuSort)
+    {
+        if (m_gpuSort.init())
+            indexMode = PARTICLE_INDEX_GPU;
+        else
+            LOGI("Particles: no compute shaders, sorting on the CPU\n");
+    }
+    m_particleSystem = new ParticleSystem(count, indexMode);
+    LOGI("Particles: %d, %s\n", count, (indexMode == PARTICLE_INDEX_16) ? "16 bit indices" :
+        ((indexMode == PARTICLE_INDEX_32) ? "32 bit indices" :
+        ((indexMode == PARTICLE_INDEX_GPU) ? "GPU sorted indices" : "sorted vertices")));
+
+    // the cube keeps its size whatever the count, so the particles shrink as it grows
+    m_params.particleScale = PARTICLE_SCALE * powf((float)DEFAULT_PARTICLE_COUNT / count, 1.0f / 3.0f);
 
     createShaders();
     createVBO();
     createEBOs();
+    m_sliceDraw.init();
 }
 
 ParticleRenderer::~ParticleRenderer()
@@ -57,6 +81,8 @@ ParticleRenderer::~ParticleRenderer()
     deleteShaders();
     deleteVBO();
     deleteEBOs();
+    m_sliceDraw.release();
+    m_gpuSort.release();
 }
 
 void ParticleRenderer::createShaders()
@@ -79,29 +105,7 @@ void ParticleRenderer::deleteShaders()
 #define GL_PROGRAM_POINT_SIZE                   0x8642
 #endif
 
-void ParticleRenderer::drawPointsSorted(GLint positionAttrib, int start, int count)
-{
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboArray[m_frameId]);
-
-    glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-    glEnableVertexAttribArray(positionAttrib);
-
-        CHECK_GL_ERROR();
-    if (m_isGL) {
-        glEnable(GL_POINT_SPRITE);
-        glEnable(GL_PROGRAM_POINT_SIZE);
-    }
-    glDrawElements(GL_POINTS, count, GL_UNSIGNED_SHORT, (void*)(sizeof(GLushort)*start));
-        CHECK_GL_ERROR();
-
-    glDisableVertexAttribArray(positionAttrib);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-}
-
-void ParticleRenderer::drawSliceCameraView(SceneInfo& scene, int i)
+void ParticleRenderer::drawSliceCameraView(SceneInfo& scene, int32_t first, int32_t count)
 {
     scene.m_fbos->m_particleFbo->bind();
 
@@ -117,14 +121,15 @@ void ParticleRenderer::drawSliceCameraView(SceneInfo& scene, int i)
     }
 
     m_cameraViewParticleProg->enable();
+    m_stateCalls += 4;
 
     // these uniforms are slice-invariant, so only set them for the first slice
-    if (i == 0) m_cameraViewParticleProg->setUniforms(scene, m_params);
+    if (first == 0) m_cameraViewParticleProg->setUniforms(scene, m_params);
 
-    drawPointsSorted(m_cameraViewParticleProg->getPositionAttrib(), i*m_batchSize, m_batchSize);
+    m_sliceDraw.draw(GL_POINTS, first, count);
 }
 
-void ParticleRenderer::drawSliceLightView(SceneInfo& scene, int i)
+void ParticleRenderer::drawSliceLightView(SceneInfo& scene, int32_t first, int32_t count)
 {
     scene.m_fbos->m_lightFbo->bind();
 
@@ -132,40 +137,84 @@ void ParticleRenderer::drawSliceLightView(SceneInfo& scene, int i)
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     m_lightViewParticleProg->enable();
+    m_stateCalls += 4;
 
     // these uniforms are slice-invariant, so only set them for the first slice
-    if (i == 0) m_lightViewParticleProg->setUniforms(scene, m_params);
+    if (first == 0) m_lightViewParticleProg->setUniforms(scene, m_params);
 
-    drawPointsSorted(m_lightViewParticleProg->getPositionAttrib(), i*m_batchSize, m_batchSize);
+    m_sliceDraw.draw(GL_POINTS, first, count);
 }
 
 void ParticleRenderer::renderParticles(SceneInfo& scene)
 {
+    m_stateCalls = 0;
+    m_sliceDraw.resetCallCount();
+
     // depth-test the particles against the low-res depth buffer
     glEnable(GL_DEPTH_TEST);
 
     glDepthMask(GL_FALSE);  // don't write depth
     glEnable(GL_BLEND);
+    m_stateCalls += 3;
 
-    // render slices
-    for(uint32_t i = 0; i < m_params.numSlices; ++i)
-    {
-        // draw slice from camera view, sampling light buffer
-        CHECK_GL_ERROR();
-        drawSliceCameraView(scene, i);
-        CHECK_GL_ERROR();
+    // point state is the same for every slice and pass, so it is set once
+    if (m_isGL) {
+        glEnable(GL_POINT_SPRITE);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        m_stateCalls += 2;
+    }
 
-        if (m_params.renderShadows)
+    // both passes draw the same vertices, so one vertex array feeds the position
+    // attribute of each program, and the slice ranges are set once for the frame
+    const ParticleIndexMode indexMode = m_particleSystem->getIndexMode();
+    const GLuint indexBuffer = (indexMode == PARTICLE_INDEX_GPU) ?
+        m_gpuSort.getValueBuffer() : ((getIndexSize() > 0) ? m_eboArray[m_frameId] : 0);
+    const GLint attribs[2] = { m_cameraViewParticleProg->getPositionAttrib(),
+        m_lightViewParticleProg->getPositionAttrib() };
+    m_sliceDraw.setVertices(m_vbo, 0, 3, indexBuffer, attribs, 2);
+
+    const int32_t numSlices = (int32_t)m_sliceFirst.size();
+    const GLenum indexType = (indexMode == PARTICLE_INDEX_16) ? GL_UNSIGNED_SHORT :
+        ((indexMode == PARTICLE_INDEX_NONE) ? 0 : GL_UNSIGNED_INT);
+    if (numSlices > 0)
+        m_sliceDraw.setRanges(&m_sliceFirst[0], &m_sliceCount[0], numSlices, indexType);
+    m_sliceDraw.bind();
+
+    if (m_params.renderShadows)
+    {
+        // each camera slice samples the shadows of the slices before it, so the
+        // passes alternate slice by slice
+        for (int32_t i = 0; i < numSlices; ++i)
         {
+            // draw slice from camera view, sampling light buffer
+            drawSliceCameraView(scene, i, 1);
+
             // draw slice from light view to light buffer, accumulating shadows
-            CHECK_GL_ERROR();
-            drawSliceLightView(scene, i);
-            CHECK_GL_ERROR();
+            drawSliceLightView(scene, i, 1);
         }
     }
+    else
+    {
+        // without shadows nothing is read between the slices, so they go in one draw
+        drawSliceCameraView(scene, 0, numSlices);
+    }
+    m_sliceDraw.unbind();
 
     glDepthMask(GL_TRUE);
     glDisable(GL_BLEND);
+    m_stateCalls += 2;
+    CHECK_GL_ERROR();
+
+    // the particle GL calls of this frame, logged when they change (e.g. with the slice count)
+    const uint32_t calls = m_stateCalls + m_sliceDraw.getCallCount();
+    const uint32_t draws = m_sliceDraw.getDrawCallCount();
+    if (calls != m_glCalls || draws != m_drawCalls)
+    {
+        LOGI("Particles: %u GL calls, %u draws for %d slices (%s draws)\n", calls, draws, numSlices,
+            NvMultiDraw::getMethodName(m_sliceDraw.getMethod()));
+    }
+    m_glCalls = calls;
+    m_drawCalls = draws;
 }
 
 void ParticleRenderer::deleteVBO()
@@ -188,6 +237,19 @@ void ParticleRenderer::createVBO()
     CHECK_GL_ERROR();
 }
 
+int32_t ParticleRenderer::getIndexSize()
+{
+    switch (m_particleSystem->getIndexMode())
+    {
+    case PARTICLE_INDEX_16:
+        return sizeof(GLushort);
+    case PARTICLE_INDEX_32:
+        return sizeof(GLuint);
+    default:
+        return 0;
+    }
+}
+
 void ParticleRenderer::deleteEBOs()
 {
     if (m_eboArray)
@@ -203,13 +265,14 @@ void ParticleRenderer::createEBOs()
 
     // to avoid CPU<->GPU sync points when updating DYNAMIC buffers,
     // use an array of buffers and use the least-recently-used one each frame.
+    // Without indices the buffers stay empty and unused.
     m_eboArray = new GLuint[m_eboCount];
     glGenBuffers(m_eboCount, m_eboArray);
 
     for (int i = 0; i < m_eboCount; ++i)
     {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboArray[i]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * getNumActive(), NULL, GL_DYNAMIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, getIndexSize() * getNumActive(), NULL, GL_DYNAMIC_DRAW);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
         CHECK_GL_ERROR();
     }
@@ -218,14 +281,54 @@ void ParticleRenderer::createEBOs()
 void ParticleRenderer::updateEBO()
 {
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboArray[m_frameId]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * getNumActive(), m_particleSystem->getSortedIndices(), GL_DYNAMIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, getIndexSize() * getNumActive(), m_particleSystem->getSortedIndices(), GL_DYNAMIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     CHECK_GL_ERROR();
 }
 
+void ParticleRenderer::updateVBO()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, 3 * sizeof(float) * getNumActive(), m_particleSystem->getPositions(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    CHECK_GL_ERROR();
+}
+
+void ParticleRenderer::updateBuffers()
+{
+    // the sorted order goes in the indices, or without them in the positions; the GPU
+    // sort leaves both as they are
+    if (m_particleSystem->getIndexMode() == PARTICLE_INDEX_GPU)
+        return;
+    if (getIndexSize() > 0)
+        updateEBO();
+    else
+        updateVBO();
+}
+
 void ParticleRenderer::depthSort(SceneInfo& scene)
 {
-    m_particleSystem->depthSort(scene.m_halfVector);
+    if (m_particleSystem->getIndexMode() == PARTICLE_INDEX_GPU)
+    {
+        // the same keys as the CPU sort, from the static vertex buffer
+        const vec3f axis = -scene.m_halfVector;
+        m_gpuSort.computeDepthKeys(m_vbo, 0, 3, getNumActive(), &axis.x);
+        m_gpuSort.sort();
+    }
+    else
+    {
+        m_particleSystem->depthSort(scene.m_halfVector);
+    }
 
-    m_batchSize = getNumActive() / (int)m_params.numSlices;
+    // equal slices of the sorted order; the last one also takes the remainder of the division
+    const int32_t count = getNumActive();
+    const int32_t batchSize = count / (int32_t)m_params.numSlices;
+    m_sliceFirst.resize(m_params.numSlices);
+    m_sliceCount.resize(m_params.numSlices);
+    for (uint32_t i = 0; i < m_params.numSlices; ++i)
+    {
+        m_sliceFirst[i] = i * batchSize;
+        m_sliceCount[i] = batchSize;
+    }
+    m_sliceCount[m_params.numSlices - 1] = count - m_sliceFirst[m_params.numSlices - 1];
 }
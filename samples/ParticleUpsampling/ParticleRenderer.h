@@ -38,9 +38,12 @@
 #include "NvFoundation.h"
 #include "NV/NvMath.h"
 #include "NV/NvPlatformGL.h"
+#include "NvGLUtils/NvGPUSort.h"
+#include "NvGLUtils/NvMultiDraw.h"
 #include "SceneFBOs.h"
 #include "ParticleSystem.h"
 #include "SceneInfo.h"
+#include <vector>
 
 class LightViewParticleProgram;
 class CameraViewParticleProgram;
@@ -82,15 +85,16 @@ public:
         float spriteAlpha;
     };
 
-    ParticleRenderer(bool isGL);
+    // hasIndexUint: whether 32 bit indices can be drawn (not ES2 without GL_OES_element_index_uint)
+    // gpuSort: sort on the GPU in compute shaders where the context has them, rather than on the CPU
+    ParticleRenderer(bool isGL, int32_t count, bool hasIndexUint, bool gpuSort);
     ~ParticleRenderer();
 
     void createShaders();
     void deleteShaders();
 
-    void drawPointsSorted(GLint positionAttrib, int32_t start, int32_t count);
-    void drawSliceCameraView(SceneInfo& scene, int32_t i);
-    void drawSliceLightView(SceneInfo& scene, int32_t i);
+    void drawSliceCameraView(SceneInfo& scene, int32_t first, int32_t count);
+    void drawSliceLightView(SceneInfo& scene, int32_t first, int32_t count);
 
     void depthSort(SceneInfo& scene);
     void renderParticles(SceneInfo& scene);
@@ -101,6 +105,9 @@ public:
     void deleteEBOs();
     void createEBOs();
     void updateEBO();
+    void updateVBO();
+    void updateBuffers();
+    int32_t getIndexSize();
 
     int32_t getNumActive()
     {
@@ -117,10 +124,17 @@ public:
         return m_params;
     }
 
+    // the GL calls and draws renderParticles made in the last frame
+    uint32_t getGLCallCount() const { return m_glCalls; }
+    uint32_t getDrawCallCount() const { return m_drawCalls; }
+
 private:
     Params m_params;
     ParticleSystem *m_particleSystem;
-    int32_t m_batchSize;
+
+    // the first index (or vertex) and the count of each slice
+    std::vector<GLint> m_sliceFirst;
+    std::vector<GLsizei> m_sliceCount;
 
     LightViewParticleProgram *m_lightViewParticleProg;
     CameraViewParticleProgram *m_cameraViewParticleProg;
@@ -130,6 +144,18 @@ private:
     GLuint *m_eboArray;
     int32_t m_eboCount;
     bool m_isGL;
+
+    // the vertex array both programs draw the slices from
+    NvMultiDraw m_sliceDraw;
+
+    // GL state calls made this frame outside the draws (uniform updates are not
+    // counted), and the totals of the last frame
+    uint32_t m_stateCalls;
+    uint32_t m_glCalls;
+    uint32_t m_drawCalls;
+
+    // sorts the indices of the static positions for PARTICLE_INDEX_GPU
+    NvGPUSort m_gpuSort;
 };
 
 #endif // PARTICLE_RENDERER_H
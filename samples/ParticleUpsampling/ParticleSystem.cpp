@@ -33,6 +33,7 @@
 //----------------------------------------------------------------------------------
 
 #include "ParticleSystem.h"
+#include <math.h>
 
 inline float frand()
 {
@@ -49,28 +50,45 @@ inline nv::vec3f randVec()
     return nv::vec3f(sfrand(), sfrand(), sfrand());
 }
 
-ParticleSystem::ParticleSystem()
-: m_numActive(0)
+ParticleSystem::ParticleSystem(int32_t count, ParticleIndexMode indexMode)
+: m_sortedIndices16(NULL)
+, m_sortedIndices32(NULL)
+, m_indexMode(indexMode)
+, m_count(count)
+, m_numActive(0)
 {
-    const int32_t N = GRID_RESOLUTION;
-    m_count = N * N * N;
+    // the smallest cube that holds the particles
+    int32_t N = (int32_t)powf((float)m_count, 1.0f / 3.0f);
+    while (N * N * N < m_count)
+        N++;
 
-    m_pos = new nv::vec3f [m_count];
-    m_zs = new float [m_count];
-    m_sortedIndices16 = new GLushort [m_count];
+    m_x = new float [m_count];
+    m_y = new float [m_count];
+    m_z = new float [m_count];
+    m_packed = new nv::vec3f [m_count];
+    m_keys = new uint32_t [m_count];
+    if (m_indexMode == PARTICLE_INDEX_16)
+        m_sortedIndices16 = new GLushort [m_count];
+    else if (m_indexMode != PARTICLE_INDEX_GPU)
+        m_sortedIndices32 = new GLuint [m_count];
 
     initGrid(N);
     addNoise(1.9, 1.0);
+    pack(false);
 }
 
 ParticleSystem::~ParticleSystem()
 {
-    delete [] m_pos;
-    delete [] m_zs;
+    delete [] m_x;
+    delete [] m_y;
+    delete [] m_z;
+    delete [] m_packed;
+    delete [] m_keys;
     delete [] m_sortedIndices16;
+    delete [] m_sortedIndices32;
 }
 
-// initialize particles in regular grid
+// initialize particles in regular grid, up to the particle count
 void ParticleSystem::initGrid(int32_t N)
 {
     const float r = 1.f;
@@ -85,7 +103,9 @@ void ParticleSystem::initGrid(int32_t N)
                 p = (p * 2.0f - 1.0f) * r;
                 if (i < m_count)
                 {
-                    m_pos[i] = p;
+                    m_x[i] = p.x;
+                    m_y[i] = p.y;
+                    m_z[i] = p.z;
                     i++;
                 }
             }
@@ -98,25 +118,47 @@ void ParticleSystem::addNoise(float freq, float scale)
 {
     for (int32_t i = 0; i < m_count; i++)
     {
-        m_pos[i] += m_noise.fBm3f(m_pos[i] * freq) * scale;
+        const nv::vec3f n = m_noise.fBm3f(nv::vec3f(m_x[i], m_y[i], m_z[i]) * freq) * scale;
+        m_x[i] += n.x;
+        m_y[i] += n.y;
+        m_z[i] += n.z;
     }
 }
 
-void ParticleSystem::depthSort(vec3f halfVector)
+// interleaves the positions for the vertex buffer, in sorted order if asked
+void ParticleSystem::pack(bool sorted)
 {
-    // calculate eye-space z
-    for (int32_t i = 0; i < m_numActive; ++i)
+    if (sorted)
+    {
+        for (int32_t i = 0; i < m_numActive; i++)
+        {
+            const GLuint j = m_sortedIndices32[i];
+            m_packed[i] = nv::vec3f(m_x[j], m_y[j], m_z[j]);
+        }
+    }
+    else
     {
-        float z = -dot(halfVector, m_pos[i]);  // project onto vector
-        m_zs[i] = z;
+        for (int32_t i = 0; i < m_numActive; i++)
+            m_packed[i] = nv::vec3f(m_x[i], m_y[i], m_z[i]);
     }
+}
 
-    // sort
-    m_sorter.Sort(m_zs, (udword)m_numActive);
-
-    const GLuint *sortedIndices32 = (GLuint*)m_sorter.GetIndices();
-    for (int32_t i = 0; i < m_numActive; ++i)
+void ParticleSystem::depthSort(vec3f halfVector)
+{
+    // keys of the eye-space z, -dot(halfVector, pos).  The particles are static, so while the
+    // view turns slowly most frames only merge a few keys into last frame's order
+    const vec3f axis = -halfVector;
+    NvRadixSort::computeDepthKeys(m_x, m_y, m_z, m_numActive, &axis.x, m_keys);
+    if (m_indexMode == PARTICLE_INDEX_16)
     {
-        m_sortedIndices16[i] = (GLushort) sortedIndices32[i];
+        m_sorter.sort(m_keys, m_numActive, m_sortedIndices16);
+    }
+    else
+    {
+        m_sorter.sort(m_keys, m_numActive, m_sortedIndices32);
+
+        // without indices the positions themselves go in sorted order, unless the order held
+        if (m_indexMode == PARTICLE_INDEX_NONE && m_sorter.getLastPath() != NvIncrementalSort::PATH_SORTED)
+            pack(true);
     }
 }
@@ -36,16 +36,17 @@
 #define PARTICLE_SYSTEM_H
 
 #include "NvFoundation.h"
-#include "IceRevisitedRadix.h"
 #include "NV/NvMath.h"
 #include "NV/NvPlatformGL.h"
+#include "NvAppBase/NvIncrementalSort.h"
 #include "Perlin/ImprovedNoise.h"
 
 using namespace nv;
 
-// The number of particles is GRID_RESOLUTION cubed.  Particles are arranged in a regular cube,
+// The default number of particles is GRID_RESOLUTION cubed.  Particles are arranged in a regular cube,
 // and then jittered by a high degree of noise.  If you increase the number of particles, their
-// size must be decreased to get a similar visual result and overdraw cost.
+// size must be decreased to get a similar visual result and overdraw cost; -particles <n> sets
+// the count, and the renderer scales the particles to match.
 #define HIGH_QUALITY 0
 #if HIGH_QUALITY
 #define GRID_RESOLUTION 32
@@ -55,10 +56,21 @@ using namespace nv;
 #define PARTICLE_SCALE 1.f
 #endif
 
+#define DEFAULT_PARTICLE_COUNT (GRID_RESOLUTION * GRID_RESOLUTION * GRID_RESOLUTION)
+
+// How the depth sorted particles are drawn
+enum ParticleIndexMode
+{
+    PARTICLE_INDEX_16,      // 16 bit indices into the positions; up to 65536 particles
+    PARTICLE_INDEX_32,      // 32 bit indices (GL, ES3, or ES2 with GL_OES_element_index_uint)
+    PARTICLE_INDEX_NONE,    // no indices: the positions are written in sorted order and drawn as arrays
+    PARTICLE_INDEX_GPU      // no CPU sort: the renderer sorts 32 bit indices into the positions in compute shaders
+};
+
 class ParticleSystem
 {
 public:
-    ParticleSystem();
+    ParticleSystem(int32_t count, ParticleIndexMode indexMode);
     ~ParticleSystem();
 
     // initialize particles in regular grid
@@ -70,14 +82,25 @@ public:
     // sort the particles along the halfVector direction
     void depthSort(vec3f halfVector);
     
+    // the positions for the vertex buffer; in sorted order for PARTICLE_INDEX_NONE
     vec3f *getPositions()
     {
-        return m_pos;
+        return m_packed;
     }
     
-    GLushort* getSortedIndices()
+    // the sorted indices, GLushort or GLuint by index mode; NULL for PARTICLE_INDEX_NONE and PARTICLE_INDEX_GPU
+    const void* getSortedIndices()
     {
-        return m_sortedIndices16;
+        if (m_indexMode == PARTICLE_INDEX_16)
+            return m_sortedIndices16;
+        else if (m_indexMode == PARTICLE_INDEX_32)
+            return m_sortedIndices32;
+        return NULL;
+    }
+
+    ParticleIndexMode getIndexMode()
+    {
+        return m_indexMode;
     }
 
     int32_t getNumActive()
@@ -86,15 +109,25 @@ public:
     }
 
 private:
-    vec3f *m_pos;
-    float *m_zs;
+    void pack(bool sorted);
+
+    // the particles as separate arrays, so the depth keys are computed 4 wide;
+    // m_packed interleaves them for the vertex buffer
+    float *m_x;
+    float *m_y;
+    float *m_z;
+    vec3f *m_packed;
+
+    uint32_t *m_keys;
     GLushort *m_sortedIndices16;
+    GLuint *m_sortedIndices32;
+    ParticleIndexMode m_indexMode;
 
     int32_t m_count;
     int32_t m_numActive;
 
     ImprovedNoise m_noise;
-    RadixSort m_sorter;
+    NvIncrementalSort m_sorter;
 };
 
 #endif // PARTICLE_SYSTEM_H
@@ -35,11 +35,14 @@
 #include "NvAppBase/NvFramerateCounter.h"
 #include "NvAppBase/NvInputTransformer.h"
 #include "NvAssetLoader/NvAssetLoader.h"
+#include "NvGLUtils/NvGPUSort.h"
 #include "NvUI/NvTweakBar.h"
 #include "NV/NvLogs.h"
 
 #include "SceneRenderer.h"
 
+#include <sstream>
+
 void printGLString(const char *name, GLenum s)
 {
     char *v = (char *) glGetString(s);
@@ -48,10 +51,38 @@ void printGLString(const char *name, GLenum s)
 
 
 ParticleUpsampling::ParticleUpsampling(NvPlatformContext* platform) : 
-    NvSampleApp(platform, "Particle Upsampling Sample")
+    NvSampleApp(platform, "Particle Upsampling Sample"),
+    m_particleCount(DEFAULT_PARTICLE_COUNT),
+    m_gpuSort(false),
+    m_autoQualityMs(0.0f)
 {
     // Required in all subclasses to avoid silent link issues
     forceLinkHack();
+
+    // -gpusorttest checks the compute shader sort and its CPU emulation, then exits
+    addBenchmarkMode("-gpusorttest", NvGPUSort::runSelfTest);
+
+    // -particles <n> sets the particle count
+    // -gpusort sorts the particles in compute shaders instead of on the CPU, where the context has them
+    // -autoquality <ms> picks the particle resolution and upsampling filter to fit a frame time budget
+    const std::vector<std::string>& cmd = platform->getCommandLine();
+    for (std::vector<std::string>::const_iterator it = cmd.begin(); it != cmd.end(); ++it)
+    {
+        if (0 == (*it).compare("-gpusort"))
+            m_gpuSort = true;
+        else if (0 == (*it).compare("-autoquality") && (it + 1) != cmd.end())
+        {
+            ++it;
+            std::stringstream(*it) >> m_autoQualityMs;
+        }
+        else if (0 == (*it).compare("-particles") && (it + 1) != cmd.end())
+        {
+            ++it;
+            std::stringstream(*it) >> m_particleCount;
+            if (m_particleCount < 1)
+                m_particleCount = DEFAULT_PARTICLE_COUNT;
+        }
+    }
 }
 
 ParticleUpsampling::~ParticleUpsampling()
@@ -80,6 +111,7 @@ void ParticleUpsampling::initUI(void)
         mTweakBar->addValue("renderShadows", m_sceneRenderer->getParticleParams()->renderShadows);
         mTweakBar->addValue("drawModel", m_sceneRenderer->getSceneParams()->drawModel);
         mTweakBar->addValue("useDepthPrepass", m_sceneRenderer->getSceneParams()->useDepthPrepass);
+        mTweakBar->addValue("autoQuality", m_sceneRenderer->getSceneParams()->autoQuality);
 
         mTweakBar->addPadding();
         NvTweakEnum<uint32_t> shadowSliceModes[] = {
@@ -138,7 +170,15 @@ void ParticleUpsampling::initRendering(void)
 
     NvAssetLoaderAddSearchPath("ParticleUpsampling");
 
-    m_sceneRenderer = new SceneRenderer(requireMinAPIVersion(NvGfxAPIVersionGL4(), false));
+    // ES2 draws 32 bit indices only with GL_OES_element_index_uint
+    const bool hasIndexUint = (getGLContext()->getConfiguration().apiVer != NvGfxAPIVersionES2())
+        || requireExtension("GL_OES_element_index_uint", false);
+    m_sceneRenderer = new SceneRenderer(requireMinAPIVersion(NvGfxAPIVersionGL4(), false), m_particleCount, hasIndexUint, m_gpuSort);
+    if (m_autoQualityMs > 0.0f)
+    {
+        m_sceneRenderer->getSceneParams()->autoQuality = true;
+        m_sceneRenderer->getSceneParams()->frameBudgetMs = m_autoQualityMs;
+    }
 
     CHECK_GL_ERROR();
 }
@@ -164,6 +204,7 @@ void ParticleUpsampling::draw(void)
     m_sceneRenderer->setEyeViewMatrix(translationMatrix * rotationMatrix);
 
     m_sceneRenderer->renderFrame();
+    m_sceneRenderer->updateQuality();
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glViewport(0, 0, m_width, m_height);
@@ -58,4 +58,7 @@ public:
 
 private:
     SceneRenderer *m_sceneRenderer;
+    int32_t m_particleCount;
+    bool m_gpuSort;
+    float m_autoQualityMs;
 };
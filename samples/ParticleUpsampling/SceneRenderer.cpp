@@ -37,8 +37,29 @@
 #include "NvModel/NvGLModel.h"
 #include "NvAssetLoader/NvAssetLoader.h"
 
-SceneRenderer::SceneRenderer(bool isGL)
+// The auto quality ladder, cheapest first.  The filter only matters when the
+// particles are upsampled
+struct QualityLevel
+{
+    const char* name;
+    uint32_t particleDownsample;
+    bool crossBilateral;
+};
+
+static const QualityLevel QUALITY_LEVELS[] =
+{
+    { "quarter-res particles, bilinear",    4, false },
+    { "quarter-res particles",              4, true },
+    { "half-res particles",                 2, true },
+    { "full-res particles",                 1, true },
+};
+
+static const int32_t QUALITY_LEVEL_COUNT = sizeof(QUALITY_LEVELS) / sizeof(QUALITY_LEVELS[0]);
+
+SceneRenderer::SceneRenderer(bool isGL, int32_t particleCount, bool hasIndexUint, bool gpuSort)
 : m_model(NULL)
+, m_statsCountdown(STATS_FRAMES)
+, m_tuning(false)
 {
     initTimers();
     loadModel();
@@ -47,13 +68,20 @@ SceneRenderer::SceneRenderer(bool isGL)
     m_opaqueDepthProg = new OpaqueDepthProgram();
 
     m_fbos = new SceneFBOs();
-    m_particles = new ParticleRenderer(isGL);
+    m_particles = new ParticleRenderer(isGL, particleCount, hasIndexUint, gpuSort);
     m_upsampler = new Upsampler(m_fbos, isGL);
 
     memset(&m_scene, 0, sizeof(m_scene));
     m_scene.setLightVector(vec3f(-0.70710683f, 0.50000000f, 0.49999994f));
     m_scene.setLightDistance(6.f);
     m_scene.m_fbos = m_fbos;
+
+    const char* levelNames[QUALITY_LEVEL_COUNT];
+    for (int32_t i = 0; i < QUALITY_LEVEL_COUNT; ++i)
+    {
+        levelNames[i] = QUALITY_LEVELS[i].name;
+    }
+    m_tuner.setLevels(levelNames, QUALITY_LEVEL_COUNT, getQualityLevel());
 }
 
 SceneRenderer::~SceneRenderer()
@@ -66,12 +94,15 @@ SceneRenderer::~SceneRenderer()
 
 void SceneRenderer::initTimers()
 {
-#if ENABLE_GPU_TIMERS
-    for (int i = 0; i < GPU_TIMER_COUNT; ++i)
+    for (int32_t i = 0; i < GPU_TIMER_COUNT; ++i)
     {
         m_GPUTimers[i].init();
     }
-#endif
+
+    for (int32_t i = 0; i < CPU_TIMER_COUNT; ++i)
+    {
+        m_CPUTimers[i].init();
+    }
 }
 
 void SceneRenderer::loadModelFromData(char *fileData)
@@ -257,6 +288,9 @@ void SceneRenderer::renderFullResSceneColor()
 
 void SceneRenderer::renderFrame()
 {
+    CPU_TIMER_SCOPE(CPU_TIMER_TOTAL);
+    GPU_TIMER_SCOPE(GPU_TIMER_TOTAL);
+
         CHECK_GL_ERROR();
     {
         m_scene.calcVectors();
@@ -265,30 +299,34 @@ void SceneRenderer::renderFrame()
         CHECK_GL_ERROR();
 
     {
-        m_particles->updateEBO();
+        m_particles->updateBuffers();
         CHECK_GL_ERROR();
     }
     
     {
         // render scene depth to buffer for particle to be depth tested against
+        CPU_TIMER_SCOPE(CPU_TIMER_SCENE_DEPTH);
+        GPU_TIMER_SCOPE(GPU_TIMER_SCENE_DEPTH);
         renderLowResSceneDepth();
         CHECK_GL_ERROR();
     }
 
-    // clear light buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fbos->m_lightFbo->fbo);
-    glClearColor(0.0, 0.0, 0.0, 0.0);
-    glClear(GL_COLOR_BUFFER_BIT);
+    {
+        CPU_TIMER_SCOPE(CPU_TIMER_PARTICLES);
+        GPU_TIMER_SCOPE(GPU_TIMER_PARTICLES);
+
+        // clear light buffer
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbos->m_lightFbo->fbo);
+        glClearColor(0.0, 0.0, 0.0, 0.0);
+        glClear(GL_COLOR_BUFFER_BIT);
 
         CHECK_GL_ERROR();
-    // clear volume image
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fbos->m_particleFbo->fbo);
-    glClearColor(0.0, 0.0, 0.0, 0.0);
-    glClear(GL_COLOR_BUFFER_BIT);
+        // clear volume image
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbos->m_particleFbo->fbo);
+        glClearColor(0.0, 0.0, 0.0, 0.0);
+        glClear(GL_COLOR_BUFFER_BIT);
         CHECK_GL_ERROR();
 
-    
-    {
         m_particles->renderParticles(m_scene);
         CHECK_GL_ERROR();
     }
@@ -296,18 +334,24 @@ void SceneRenderer::renderFrame()
     {
         // the opaque colors need to be rendered after the particles
         // for the particles to cast shadows on the opaque scene
+        CPU_TIMER_SCOPE(CPU_TIMER_SCENE_COLOR);
+        GPU_TIMER_SCOPE(GPU_TIMER_SCENE_COLOR);
         renderFullResSceneColor();
         CHECK_GL_ERROR();
     }
     
     {
         // upsample the particles & composite them on top of the opaque scene colors
+        CPU_TIMER_SCOPE(CPU_TIMER_UPSAMPLE_PARTICLES);
+        GPU_TIMER_SCOPE(GPU_TIMER_UPSAMPLE_PARTICLES);
         m_upsampler->upsampleParticleColors(m_scene);
         CHECK_GL_ERROR();
     }
     
     {
         // final bilinear upsampling from scene resolution to backbuffer resolution
+        CPU_TIMER_SCOPE(CPU_TIMER_UPSAMPLE_SCENE);
+        GPU_TIMER_SCOPE(GPU_TIMER_UPSAMPLE_SCENE);
         m_upsampler->upsampleSceneColors(m_scene);
         CHECK_GL_ERROR();
     }
@@ -315,3 +359,74 @@ void SceneRenderer::renderFrame()
     m_particles->swapBuffers();
 }
 
+// the most expensive level that costs no more than the current settings on any knob
+int32_t SceneRenderer::getQualityLevel()
+{
+    const uint32_t particleDownsample = m_fbos->m_params.particleDownsample;
+    const bool crossBilateral = m_upsampler->getParams().useCrossBilateral;
+
+    for (int32_t i = QUALITY_LEVEL_COUNT - 1; i > 0; --i)
+    {
+        const QualityLevel& level = QUALITY_LEVELS[i];
+        if ((level.particleDownsample >= particleDownsample) &&
+            (!level.crossBilateral || (level.particleDownsample == 1) || (particleDownsample == 1) || crossBilateral))
+            return i;
+    }
+    return 0;
+}
+
+void SceneRenderer::applyQualityLevel(int32_t index)
+{
+    const QualityLevel& level = QUALITY_LEVELS[index];
+    m_upsampler->getParams().useCrossBilateral = level.crossBilateral;
+    if (m_fbos->m_params.particleDownsample != level.particleDownsample)
+    {
+        m_fbos->m_params.particleDownsample = level.particleDownsample;
+        createScreenBuffers();
+    }
+}
+
+void SceneRenderer::updateQuality()
+{
+    if (m_statsCountdown > 0)
+    {
+        m_statsCountdown--;
+        return;
+    }
+    m_statsCountdown = STATS_FRAMES;
+
+    if (m_params.autoQuality)
+    {
+        // the settings may have been changed by hand while the tuner was off
+        if (!m_tuning)
+        {
+            m_tuner.reset(getQualityLevel());
+            m_tuning = true;
+        }
+
+        NvQualityTuner::Params params = m_tuner.getParams();
+        params.budgetMs = m_params.frameBudgetMs;
+        m_tuner.setParams(params);
+
+        // the means of the frames since the last reset; not every GPU result is back yet
+        const int32_t gpuFrames = m_GPUTimers[GPU_TIMER_TOTAL].getStartStopCycles();
+        const float gpuMs = (gpuFrames > 0) ? m_GPUTimers[GPU_TIMER_TOTAL].getScaledCycles() / gpuFrames : 0.0f;
+        const float cpuMs = 1000.0f * m_CPUTimers[CPU_TIMER_TOTAL].getScaledCycles() / (STATS_FRAMES + 1);
+        if (m_tuner.addWindow(gpuMs, cpuMs))
+            applyQualityLevel(m_tuner.getLevel());
+    }
+    else
+    {
+        m_tuning = false;
+    }
+
+    for (int32_t i = 0; i < GPU_TIMER_COUNT; ++i)
+    {
+        m_GPUTimers[i].reset();
+    }
+
+    for (int32_t i = 0; i < CPU_TIMER_COUNT; ++i)
+    {
+        m_CPUTimers[i].reset();
+    }
+}
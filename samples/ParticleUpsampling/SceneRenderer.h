@@ -35,9 +35,6 @@
 #ifndef SCENE_RENDERER_H
 #define SCENE_RENDERER_H
 
-//#define ENABLE_GPU_TIMERS 1
-//#define ENABLE_CPU_TIMERS 1
-
 #include "NvFoundation.h"
 #include "NV/NvPlatformGL.h"
 #include "ParticleRenderer.h"
@@ -45,11 +42,39 @@
 #include "SceneInfo.h"
 #include "NvGLUtils/NvGLSLProgram.h"
 #include "NvGLUtils/NvSimpleFBO.h"
+#include "NvGLUtils/NvTimers.h"
+#include "NvAppBase/NvQualityTuner.h"
 
 class OpaqueColorProgram;
 class OpaqueDepthProgram;
 class NvGLModel;
 
+typedef enum
+{
+    GPU_TIMER_SCENE_DEPTH = 0,
+    GPU_TIMER_PARTICLES,
+    GPU_TIMER_SCENE_COLOR,
+    GPU_TIMER_UPSAMPLE_PARTICLES,
+    GPU_TIMER_UPSAMPLE_SCENE,
+    GPU_TIMER_TOTAL,
+    GPU_TIMER_COUNT
+} GPUTimerId;
+
+typedef enum
+{
+    CPU_TIMER_SCENE_DEPTH = 0,
+    CPU_TIMER_PARTICLES,
+    CPU_TIMER_SCENE_COLOR,
+    CPU_TIMER_UPSAMPLE_PARTICLES,
+    CPU_TIMER_UPSAMPLE_SCENE,
+    CPU_TIMER_TOTAL,
+    CPU_TIMER_COUNT
+} CPUTimerId;
+
+#define GPU_TIMER_SCOPE(TIMER_ID) NvGPUTimerScope gpuTimer(&m_GPUTimers[TIMER_ID])
+
+#define CPU_TIMER_SCOPE(TIMER_ID) NvCPUTimerScope cpuTimer(&m_CPUTimers[TIMER_ID])
+
 class SceneRenderer
 {
 public:
@@ -58,15 +83,20 @@ public:
         Params()
         : drawModel(true)
         , useDepthPrepass(false)
+        , autoQuality(false)
+        , frameBudgetMs(1000.0f / 60.0f)
         , backgroundColor(0.5f, 0.8f, 1.0f)
         {
         }
         bool drawModel;
         bool useDepthPrepass;
+        // pick the particle resolution and upsampling filter from the frame timers
+        bool autoQuality;
+        float frameBudgetMs;
         nv::vec3f backgroundColor;
     };
 
-    SceneRenderer(bool isGL);
+    SceneRenderer(bool isGL, int32_t particleCount, bool hasIndexUint, bool gpuSort);
     ~SceneRenderer();
 
     void initTimers();
@@ -83,6 +113,9 @@ public:
     void renderFullResSceneColor();
     void renderFrame();
 
+    // call once per frame after renderFrame; feeds the tuner every STATS_FRAMES frames
+    void updateQuality();
+
     void reshapeWindow(int32_t w, int32_t h)
     {
         m_scene.setScreenSize(w, h);
@@ -135,18 +168,24 @@ public:
     }
 
 protected:
+    int32_t getQualityLevel();
+    void applyQualityLevel(int32_t level);
+
     Params m_params;
     NvGLModel *m_model;
     ParticleRenderer *m_particles;
     Upsampler *m_upsampler;
     SceneInfo m_scene;
 
-#if ENABLE_GPU_TIMERS
-    GPUTimer m_GPUTimers[GPU_TIMER_COUNT];
-#endif
-#if ENABLE_CPU_TIMERS
-    StopWatch m_CPUTimers[CPU_TIMER_COUNT];
-#endif
+    NvGPUTimer m_GPUTimers[GPU_TIMER_COUNT];
+    NvCPUTimer m_CPUTimers[CPU_TIMER_COUNT];
+
+    const static int32_t STATS_FRAMES = 60;
+    int32_t m_statsCountdown;
+
+    // steps the quality levels while Params::autoQuality is set
+    NvQualityTuner m_tuner;
+    bool m_tuning;
 
     int32_t m_screenWidth;
     int32_t m_screenHeight;
@@ -31,11 +31,13 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
 //----------------------------------------------------------------------------------
+// 2D array class
 
 #ifndef ARRAY2D_H
 #define ARRAY2D_H
 
 #include <NvFoundation.h>
+#include <string.h>
 
 
 inline int32_t mini(const int32_t a, const int32_t b)
@@ -53,76 +55,119 @@ inline int32_t clamp(int32_t x, int32_t a, int32_t b)
     return mini(maxi(x, a), b);
 }
 
-// 2d array
+// A rectangle of an Array2D (e.g. a tile), which it does not own.  Rows are getStride()
+// elements apart; cells outside the rectangle may be read if the array has them.
 template <class T>
-class Array2D
+class Array2DView
 {
 public:
     typedef T value_type;
 
-    Array2D()
+    Array2DView() : data(NULL), w(0), h(0), stride(0) {}
+
+    Array2DView(T *origin, int32_t width, int32_t height, int32_t rowStride)
+        : data(origin), w(width), h(height), stride(rowStride) {}
+
+    T & get(int32_t x, int32_t y) const
     {
-        data = NULL;
-        rowPointers = NULL;
-        w=h=0;
-        border = 0;
+        return data[y*stride + x];
     }
 
-    Array2D(int32_t width, int32_t height)
+    T * getRow(int32_t y) const
     {
-        data = NULL;
-        rowPointers = NULL;
-        init(width, height);
+        return data + y*stride;
     }
 
-    void init(int32_t width, int32_t height)
+    // a rectangle of this view, at (x, y) in its coordinates
+    Array2DView getView(int32_t x, int32_t y, int32_t width, int32_t height) const
     {
-        if(data) delete [] data;
-        if(rowPointers) delete [] rowPointers;
+        return Array2DView(data + y*stride + x, width, height, stride);
+    }
 
-        w = width;
-        h = height;
-        data = new T [w*h];
-        rowPointers = new T*[h];
-        for(int32_t i=0; i<h; i++)
-            rowPointers[i] = &data[i*w];
-        border = 0;
+    int32_t getWidth() const { return w; }
+    int32_t getHeight() const { return h; }
+    int32_t getStride() const { return stride; }
+
+public:
+    T *data;
+    int32_t w, h;
+    int32_t stride;
+};
+
+// 2d array
+//
+// Every row starts on a 64 byte boundary (a cache line, and a whole number of SIMD
+// registers), and rows are padded to keep it so.  The array may have a halo: cells
+// around the w x h interior, at -halo <= x < w+halo and -halo <= y < h+halo, so that
+// stencils can read past the edges without bounds checks.  The interior starts on the
+// boundary; the left halo cells sit in the padding before it.
+//
+// An array owns its cells and cannot be copied; swap() moves them between arrays.
+// sizeof(T) must divide 64.
+template <class T>
+class Array2D
+{
+public:
+    typedef T value_type;
+
+    enum { ALIGNMENT = 64 };
+
+    Array2D() : storage(NULL), data(NULL), w(0), h(0), halo(0), stride(0) {}
+
+    Array2D(int32_t width, int32_t height, int32_t haloCells = 0)
+        : storage(NULL), data(NULL)
+    {
+        init(width, height, haloCells);
+    }
+
+    ~Array2D()
+    {
+        delete [] storage;
     }
 
-    // create from external data
-    Array2D(T *ptr, int32_t width, int32_t height)
+    // (re)allocate, with every cell (and the halo) set to T()
+    void init(int32_t width, int32_t height, int32_t haloCells = 0)
     {
+        const int32_t align = ALIGNMENT / sizeof(T);
+        delete [] storage;
+
         w = width;
         h = height;
-        data = ptr;
-        border = 0;
+        halo = haloCells;
+        const int32_t lead = roundUp(halo, align);
+        stride = roundUp(lead + w + halo, align);
+
+        storage = new T [(h + 2*halo)*stride + align]();
+        T *base = storage + ((ALIGNMENT - ((size_t)storage & (ALIGNMENT-1))) & (ALIGNMENT-1)) / sizeof(T);
+        data = base + halo*stride + lead;
     }
 
-    ~Array2D()
+    void swap(Array2D& other)
     {
-        delete [] rowPointers;
-        delete [] data;
+        swapValue(storage, other.storage);
+        swapValue(data, other.data);
+        swapValue(w, other.w);
+        swapValue(h, other.h);
+        swapValue(halo, other.halo);
+        swapValue(stride, other.stride);
     }
 
     T get(int32_t x, int32_t y) const
     {
-        //return data[y*w+x];
-        return rowPointers[y][x];
+        return data[y*stride + x];
     }
 
     T & get(int32_t x, int32_t y)
     {
-        //return data[y*w+x];
-        return rowPointers[y][x];
+        return data[y*stride + x];
     }
 
-    // clamps to border
-    T & getBorder(int32_t x, int32_t y)
+    // T() outside the interior
+    T getBorder(int32_t x, int32_t y) const
     {
         if ((x < 0) || (y < 0) || (x > w-1) || (y > h-1)) {
-            return border;
+            return T();
         } else {
-            //return data[y*w+x];
             return get(x,y);
         }
     }
@@ -132,49 +177,112 @@ public:
     {
         x = clamp(x, 0, w-1);
         y = clamp(y, 0, h-1);
-        //return data[y*w+x];
         return get(x, y);
     }
 
-    T lerp(T a, T b, float t)
-    {
-        return a + t*(b - a);
-    }
-
-//    float getInterpolated(float x, float y)
-//    {
-//        int32_t ix = (int32_t) floorf(x);
-//        int32_t iy = (int32_t) floorf(y);
-//        float u = x - ix;
-//        float v = y - iy;
-//        return lerp( lerp(getClamp(ix, iy), getClamp(ix + 1, iy), u),
-//                     lerp(getClamp(ix, iy+1), getClamp(ix + 1, iy+1), u), v);
-//    }
-
     void set(int32_t x, int32_t y, T v)
     {
-        //data[y*w+x] = v;
-        rowPointers[y][x] = v;
+        data[y*stride + x] = v;
     }
 
     void setSafe(int32_t x, int32_t y, T v)
     {
         if ((x >= 0) && (y >= 0) && (x < w) && (y < h)) {
-            //data[y*w+x] = v;
-            rowPointers[y][x] = v;
+            data[y*stride + x] = v;
         }
     }
 
+    // row y (which may be a halo row); x indexes it as in get()
+    T * getRow(int32_t y)
+    {
+        return data + y*stride;
+    }
+
+    const T * getRow(int32_t y) const
+    {
+        return data + y*stride;
+    }
+
+    // the first interior cell; rows are getStride() elements apart
     T * getData()
     {
         return data;
     }
 
+    const T * getData() const
+    {
+        return data;
+    }
+
+    int32_t getWidth() const { return w; }
+    int32_t getHeight() const { return h; }
+    int32_t getHalo() const { return halo; }
+    int32_t getStride() const { return stride; }
+
+    size_t getMemoryBytes() const
+    {
+        return storage ? sizeof(T) * ((h + 2*halo)*stride + ALIGNMENT/sizeof(T)) : 0;
+    }
+
+    Array2DView<T> getView()
+    {
+        return Array2DView<T>(data, w, h, stride);
+    }
+
+    // a rectangle at (x, y); it may reach into the halo
+    Array2DView<T> getView(int32_t x, int32_t y, int32_t width, int32_t height)
+    {
+        return Array2DView<T>(data + y*stride + x, width, height, stride);
+    }
+
+    // set every cell, including the halo
+    void fill(T v)
+    {
+        for(int32_t y=-halo; y<h+halo; y++) {
+            T *row = getRow(y);
+            for(int32_t x=-halo; x<w+halo; x++)
+                row[x] = v;
+        }
+    }
+
+    // copy the interior out to / in from w*h tightly packed cells
+    void copyTo(T *dst) const
+    {
+        for(int32_t y=0; y<h; y++)
+            memcpy(dst + y*w, getRow(y), sizeof(T)*w);
+    }
+
+    void copyFrom(const T *src)
+    {
+        for(int32_t y=0; y<h; y++)
+            memcpy(getRow(y), src + y*w, sizeof(T)*w);
+    }
+
+private:
+    // not copyable; use swap()
+    Array2D(const Array2D&);
+    Array2D& operator=(const Array2D&);
+
+    static int32_t roundUp(int32_t x, int32_t multiple)
+    {
+        return (x + multiple-1) / multiple * multiple;
+    }
+
+    template <class V>
+    static void swapValue(V& a, V& b)
+    {
+        V t = a;
+        a = b;
+        b = t;
+    }
+
+    T *storage;
+
 public:
-    int32_t w, h;
-    T border;
-    T **rowPointers;
     T *data;
+    int32_t w, h;
+    int32_t halo;
+    int32_t stride;
 };
 
 #endif
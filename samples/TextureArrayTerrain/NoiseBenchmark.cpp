@@ -0,0 +1,175 @@
+//----------------------------------------------------------------------------------
+// File:        TextureArrayTerrain/NoiseBenchmark.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "NoiseBenchmark.h"
+#include "RidgedMultiFractal.h"
+#include "NV/NvStopWatch.h"
+#include "NV/NvLogs.h"
+#include <math.h>
+
+// Largest difference relative to the magnitude of the reference value (ridged heights go well above 1)
+static float maxRelativeDifference(const float* a, const float* ref, int32_t count)
+{
+    float diff = 0.0f;
+    for (int32_t i=0; i<count; i++)
+    {
+        const float d = fabsf(a[i] - ref[i]) / (1.0f + fabsf(ref[i]));
+        if (d > diff)
+            diff = d;
+    }
+    return diff;
+}
+
+static bool report(const char* name, int32_t count, float scalarSec, float batchSec, float error, float epsilon)
+{
+    const float scalarRate = count / scalarSec * 1.0e-6f;
+    const float batchRate = count / batchSec * 1.0e-6f;
+    if (error > epsilon)
+    {
+        LOGE("Noise benchmark %-14s max error %g exceeds %g\n", name, error, epsilon);
+        return false;
+    }
+
+    LOGI("Noise benchmark %-14s scalar %7.3f Mpoints/s, batched %7.3f Mpoints/s (%5.2fx), max error %g\n",
+        name, scalarRate, batchRate, batchRate / scalarRate, error);
+    return true;
+}
+
+bool runNoiseBenchmark(NvStopWatch* stopWatch)
+{
+#ifdef ANDROID
+    const int32_t count = 1 << 14;
+#else
+    const int32_t count = 1 << 16;
+#endif
+    // the batched kernels do the scalar operations in the same order; allow for compilers that contract to FMA
+    const float epsilon = 1e-5f;
+    const int32_t octaves = 8;
+    const float ridgeOffset = 0.7f;
+
+    ImprovedNoise gen;
+    float* x = new float[count];
+    float* y = new float[count];
+    float* z = new float[count];
+    float* ref = new float[count*3];
+    float* result = new float[count*3];
+
+    // deterministic points spread over many lattice cells, including negative ones
+    uint32_t seed = 12345;
+    for (int32_t i=0; i<count; i++)
+    {
+        float* coords[3] = { x, y, z };
+        for (int32_t c=0; c<3; c++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            coords[c][i] = ((float)(seed >> 8) / (float)(1 << 24)) * 64.0f - 32.0f;
+        }
+    }
+
+    bool passed = true;
+    float scalarSec, batchSec;
+
+    // noise
+    stopWatch->reset();
+    stopWatch->start();
+    for (int32_t i=0; i<count; i++)
+        ref[i] = gen.noise(x[i], y[i], z[i]);
+    stopWatch->stop();
+    scalarSec = stopWatch->getTime();
+
+    stopWatch->reset();
+    stopWatch->start();
+    gen.noise(x, y, z, result, count);
+    stopWatch->stop();
+    batchSec = stopWatch->getTime();
+    passed = report("noise", count, scalarSec, batchSec, maxRelativeDifference(result, ref, count), epsilon) && passed;
+
+    // fBm
+    stopWatch->reset();
+    stopWatch->start();
+    for (int32_t i=0; i<count; i++)
+        ref[i] = gen.fBm(vec3f(x[i], y[i], z[i]), octaves);
+    stopWatch->stop();
+    scalarSec = stopWatch->getTime();
+
+    stopWatch->reset();
+    stopWatch->start();
+    gen.fBm(x, y, z, result, count, octaves);
+    stopWatch->stop();
+    batchSec = stopWatch->getTime();
+    passed = report("fBm", count, scalarSec, batchSec, maxRelativeDifference(result, ref, count), epsilon) && passed;
+
+    // fBm3f, with the results interleaved per component block
+    stopWatch->reset();
+    stopWatch->start();
+    for (int32_t i=0; i<count; i++)
+    {
+        const vec3f r = gen.fBm3f(vec3f(x[i], y[i], z[i]));
+        ref[i] = r.x;
+        ref[count + i] = r.y;
+        ref[2*count + i] = r.z;
+    }
+    stopWatch->stop();
+    scalarSec = stopWatch->getTime();
+
+    stopWatch->reset();
+    stopWatch->start();
+    gen.fBm3f(x, y, z, result, result + count, result + 2*count, count);
+    stopWatch->stop();
+    batchSec = stopWatch->getTime();
+    passed = report("fBm3f", count, scalarSec, batchSec, maxRelativeDifference(result, ref, count*3), epsilon) && passed;
+
+    // hybridTerrain, as TerrainTileCache uses it
+    stopWatch->reset();
+    stopWatch->start();
+    for (int32_t i=0; i<count; i++)
+        ref[i] = hybridTerrain(gen, vec2f(x[i], y[i]), octaves, ridgeOffset);
+    stopWatch->stop();
+    scalarSec = stopWatch->getTime();
+
+    stopWatch->reset();
+    stopWatch->start();
+    hybridTerrain(gen, x, y, result, count, octaves, ridgeOffset);
+    stopWatch->stop();
+    batchSec = stopWatch->getTime();
+    passed = report("hybridTerrain", count, scalarSec, batchSec, maxRelativeDifference(result, ref, count), epsilon) && passed;
+
+    delete [] x;
+    delete [] y;
+    delete [] z;
+    delete [] ref;
+    delete [] result;
+
+    return passed;
+}
@@ -42,7 +42,7 @@
 
 // Ridged multifractal
 // See Kenton Musgrave (2002). "Texturing and Modeling, Third Edition: A Procedural Approach." Morgan Kaufmann.
-float ridge(float h, float offset)
+inline float ridge(float h, float offset)
 {
     float result = fabs(h);
     result = offset - result;
@@ -50,7 +50,7 @@ float ridge(float h, float offset)
     return result;
 }
 
-float ridgedMF(ImprovedNoise& gen, vec2f p, int32_t octaves, float lacunarity = 2.0, float gain = 0.5, float offset = 1.0)
+inline float ridgedMF(ImprovedNoise& gen, vec2f p, int32_t octaves, float lacunarity = 2.0, float gain = 0.5, float offset = 1.0)
 {
     // Hmmm... these hardcoded constants make it look nice.  Put on tweakable sliders?
     vec3f p3(p.x, p.y, 0.0);
@@ -58,13 +58,13 @@ float ridgedMF(ImprovedNoise& gen, vec2f p, int32_t octaves, float lacunarity =
     return ridge(f, offset);
 }
 
-float saturate(float f)
+inline float saturate(float f)
 {
     return std::min(1.0f, std::max(0.0f, f));
 }
 
 // mixture of ridged and fbm noise
-float hybridTerrain(ImprovedNoise& gen, vec2f x, int32_t octaves, float ridgeOffset)
+inline float hybridTerrain(ImprovedNoise& gen, vec2f x, int32_t octaves, float ridgeOffset)
 {
     const vec3f x3(x.x, x.y, 0.0);
     //const int32_t RIDGE_OCTAVES = g_ridgeOctaves;
@@ -93,4 +93,13 @@ float hybridTerrain(ImprovedNoise& gen, vec2f x, int32_t octaves, float ridgeOff
         */
 }
 
+// hybridTerrain for n points on the z=0 plane at once, using the batched (SIMD) fBm
+inline void hybridTerrain(ImprovedNoise& gen, const float* x, const float* y, float* result, int32_t n, int32_t octaves, float ridgeOffset)
+{
+    const float LACUNARITY = 2, GAIN = 0.5;
+    gen.fBm(x, y, NULL, result, n, octaves, LACUNARITY, GAIN);
+    for (int32_t i=0; i<n; i++)
+        result[i] = ridge(10.0f * result[i], ridgeOffset);
+}
+
 #endif
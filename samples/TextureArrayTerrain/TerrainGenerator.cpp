@@ -33,19 +33,17 @@
 //----------------------------------------------------------------------------------
 
 #include "TerrainGenerator.h"
-#include "NV/NvStopWatch.h"
 
-TerrainGenerator::TerrainGenerator(int32_t width, int32_t height, const nv::vec2f& offset, NvStopWatch* stopWatch)
-:m_simulation(width, height, offset), m_renderer(&m_simulation, offset), m_thread(&m_simulation, stopWatch)
+TerrainGenerator::TerrainGenerator(int32_t width, int32_t height, const nv::vec2f& offset, float extent, int32_t slotCount)
+:m_simulation(width, height, offset, extent), m_renderer(&m_simulation, offset)
 {
     //init the vbo's for rendering
-    m_renderer.initBuffers();
-    
-    //start the thread
-    m_thread.Start();
+    m_renderer.initBuffers(slotCount);
+}
 
-    //wait until the current thread has completed
-    TerrainSimThread::waitForAllThreads();
+TerrainGenerator::~TerrainGenerator()
+{
+    waitForSimulation();
 }
 
 TerrainSim& TerrainGenerator::getSimulation()
@@ -58,44 +56,57 @@ TerrainSimRenderer& TerrainGenerator::getRenderer()
     return m_renderer;
 }
 
-TerrainSimThread& TerrainGenerator::getThread()
+void TerrainGenerator::updateBufferData()
 {
-    return m_thread;
+    if (m_renderer.isUpdating() && m_simulationCounter.isDone())
+        m_renderer.endUpdate();
 }
 
-void TerrainGenerator::updateBufferData()
+int32_t TerrainGenerator::render(GLuint posXYHandle, GLuint heightHandle, GLuint normalHandle)
 {
-    m_renderer.updateBufferData();
+    return m_renderer.render(posXYHandle, heightHandle, normalHandle);
 }
 
-int32_t TerrainGenerator::render(GLuint posXYHandle, GLuint normalAndHeightHandle)
+void TerrainGenerator::simulateTask(void* data)
 {
-    return m_renderer.render(posXYHandle, normalAndHeightHandle);
+    ((TerrainSim*)data)->simulate();
+}
+
+void TerrainGenerator::startSimulation()
+{
+    // A pass that is still running picks up any newly dirtied params itself (see TerrainSim::simulate)
+    if (!m_simulationCounter.isDone())
+        return;
+
+    // the pass writes its vertices straight into the next slot of the renderer's VBO
+    m_renderer.beginUpdate();
+    NvJobSystem::run(simulateTask, &m_simulation, "TerrainSim::simulate", &m_simulationCounter);
 }
 
-void TerrainGenerator::resetThreadStopWatch()
+bool TerrainGenerator::isSimulationDone() const
 {
-    TerrainSimThread::getThreadStopWatch().reset();
+    return m_simulationCounter.isDone();
 }
 
-void TerrainGenerator::startThreadStopWatch()
+bool TerrainGenerator::isReady() const
 {
-    TerrainSimThread::getThreadStopWatch().start();
+    return m_renderer.hasData();
 }
 
-void TerrainGenerator::startSimulationThread()
+size_t TerrainGenerator::getGpuBytes() const
 {
-    m_thread.runSimulation();
+    return m_renderer.getGpuBytes();
 }
 
-void TerrainGenerator::waitForAllThreadsToExit()
+size_t TerrainGenerator::getCpuBytes() const
 {
-    TerrainSimThread::waitForAllThreadsToExit();
+    return sizeof(TerrainGenerator) + m_simulation.getMemoryBytes() + m_renderer.getCpuBytes();
 }
 
-void TerrainGenerator::syncAllSimulationThreads()
+void TerrainGenerator::waitForSimulation()
 {
-    TerrainSimThread::waitForAllThreads();
+    NvJobSystem::wait(&m_simulationCounter);
+    m_renderer.endUpdate();
 }
 
 bool TerrainGenerator::mapPointXZToGridPos(nv::vec3f point, nv::vec2f &gridPos)
@@ -39,39 +39,42 @@
 
 
 #include "TerrainSim.h"
-#include "TerrainSimThread.h"
 #include "TerrainSimRenderer.h"
+#include "NvAppBase/NvJobSystem.h"
 
 
-// A wrapper for the terrain surface simulation, thread handling and rendering.
+// A wrapper for the terrain surface simulation, job handling and rendering.
 class TerrainGenerator
 {
 public:
-    TerrainGenerator(int32_t width, int32_t height, const nv::vec2f& offset, NvStopWatch* stopWatch);
+    //the surface spans extent x extent noise units at offset; no simulation pass is started yet
+    TerrainGenerator(int32_t width, int32_t height, const nv::vec2f& offset, float extent = 1.0f,
+        int32_t slotCount = NvStreamingBuffer::DEFAULT_SLOT_COUNT);
+    ~TerrainGenerator();
 
     TerrainSim& getSimulation();
     TerrainSimRenderer& getRenderer();
-    TerrainSimThread& getThread();
     
-    //updates the VBO data
+    //makes the results of a finished simulation pass the ones rendered (call once per frame)
     void updateBufferData();
 
-    int32_t render(GLuint posXYHandle, GLuint normalAndHeightHandle);
+    int32_t render(GLuint posXYHandle, GLuint heightHandle, GLuint normalHandle);
 
-    //starts the underlying simulation thread for 1 loop and the thread goes to wait for the next call to this function
-    void startSimulationThread();
+    //queues one simulation pass on the job system; does nothing while the previous pass is still running
+    void startSimulation();
 
-    //pauses all the simulation threads
-    static void waitForAllThreadsToExit();
-    
-    //synchronizes all simulation threads (waits until all threads have completed simulation and reached wait.
-    static void syncAllSimulationThreads();
+    //true once the last queued simulation pass has completed
+    bool isSimulationDone() const;
+
+    //true once a simulation pass has completed and its results are rendered
+    bool isReady() const;
 
-    //starts the thread stopwatch for recording the time
-    static void startThreadStopWatch();
+    //GPU and CPU memory held by the surface
+    size_t getGpuBytes() const;
+    size_t getCpuBytes() const;
 
-    //resets the thread stopwatch
-    static void resetThreadStopWatch();
+    //blocks until the last queued simulation pass has completed and its results are rendered
+    void waitForSimulation();
 
     //maps a world-space 3D point on XZ plane to a grid position in the current surface grid (does nothing if the point lies outside the surface)
     bool mapPointXZToGridPos(nv::vec3f point, nv::vec2f &gridPos);
@@ -79,7 +82,9 @@ public:
 private:
     TerrainSim m_simulation;
     TerrainSimRenderer m_renderer;
-    TerrainSimThread m_thread;
+    NvJobCounter m_simulationCounter;
+
+    static void simulateTask(void* data);
 };
 
 #endif
@@ -33,23 +33,44 @@
 //----------------------------------------------------------------------------------
 
 #include "TerrainSim.h"
-#include "RidgedMultiFractal.h"
+#include "TerrainTileCache.h"
 #include "NV/NvLogs.h"
 
+#include <math.h>
+#include <string.h>
+
 #undef NDEBUG
 #include <assert.h>
 
-static ImprovedNoise g_noiseGen;
+// Floor of a / b, also for negative a.
+static int32_t floorDiv(int32_t a, int32_t b)
+{
+    return (a >= 0) ? (a / b) : -((b - 1 - a) / b);
+}
 
-TerrainSim::TerrainSim(int32_t w, int32_t h, const nv::vec2f& trans) :
+// Splits a pan in uv units into whole texels and the sub-texel remainder.  The remainder is quantized to
+// 1/PHASE_STEPS texel so that equal pans always produce equal tile keys.
+static const double PHASE_STEPS = 4096.0;
+
+static void splitPan(float pan, float texelSize, int32_t& whole, float& phase)
+{
+    const double fixed = floor((double)pan / texelSize * PHASE_STEPS + 0.5);
+    const double w = floor(fixed / PHASE_STEPS);
+    whole = (int32_t)w;
+    phase = (float)((fixed - w * PHASE_STEPS) / PHASE_STEPS);
+}
+
+TerrainSim::TerrainSim(int32_t w, int32_t h, const nv::vec2f& trans, float extent) :
     m_width(w),
     m_height(h),
-    m_recipW(1.0f / (float) (m_width-1)),
-    m_recipH(1.0f / (float) (m_height-1)),
+    m_extent(extent),
+    m_recipW(extent / (float) (m_width-1)),
+    m_recipH(extent / (float) (m_height-1)),
     m_translation(trans),
+    m_output(NULL),
     m_dirty(false)
 {
-    m_u.init(m_width,m_height);
+    m_u.init(m_width, m_height, 1);
     m_normals = new float[m_width*m_height*3];
     reset();
 }
@@ -61,20 +82,7 @@ TerrainSim::~TerrainSim()
 
 void TerrainSim::reset()
 {
-    int32_t size = m_width * m_height;
-    for(int32_t i=0; i<size; i++)
-        m_u.data[i] = 0.0f;
-}
-
-float TerrainSim::computeTerrain(int32_t x, int32_t y) const
-{
-    nv::vec2f uv((float)x * m_recipW, (float)y * m_recipH);
-
-    // Translation places this tile relative to all the others.  uvOffset is a user adjustable offset.
-    uv -= (m_translation + nv::vec2f(m_params.uvOffset));
-
-    const float h = (1+m_params.ridgeOffset) * hybridTerrain(g_noiseGen, uv, m_params.octaves, m_params.ridgeOffset);
-    return m_params.heightScale * h + m_params.heightOffset;
+    m_u.fill(0.0f);
 }
 
 void TerrainSim::simulate()
@@ -89,28 +97,60 @@ void TerrainSim::simulate()
     {
         m_dirty = false;
 
-        // Note that we deliberately allow the parameters to be asynchronously set while executing these for loops.  
-        // We maintain GUI interactivity with the compromise of visual discontinuities while the parameters are 
-        // being altered (which is acceptable).  A final outer while loop execution with m_dirty == false will
-        // fix the discontinuities after the params stop changing.
-        for(int32_t j=0; j<m_height; j++)
-            for(int32_t i=0; i<m_width; i++)
-                m_u.get(i, j) = computeTerrain(i,j);
-
-        // m_dirty may have been asynchronously set true by now.  If so, do another iteration round the while loop.
+        // Every tile of one pass has to come from the same parameters, so take a copy.  The GUI may change
+        // m_params meanwhile; that sets m_dirty again and we go round once more.
+        const Params params = m_params;
+        gatherHeights(params);
     }
 
     calcNormals();
 }
 
-float TerrainSim::getUnbounded(int32_t x, int32_t y) const
+void TerrainSim::gatherHeights(const Params& params)
 {
-    // Gradient calculation requires data outside that stored in m_u.  As an alternative, we could
-    // store a margin in m_u and make the triangle indexing more complex in TerrainSimRenderer.
-    if (x >= 0 && x < m_width && y >= 0 && y < m_height)
-        return m_u.get(x,y);
-    else
-        return computeTerrain(x,y);
+    const int32_t TILE_SIZE = TerrainTileCache::TILE_SIZE;
+    TerrainTileCache& cache = TerrainTileCache::get();
+
+    // Translation places this sim relative to all the others.  uvOffset is a user adjustable offset.  In texels,
+    // the whole part of the pan says which world texels we cover (sim texel x is world texel x - originX), the
+    // sub-texel part goes into the tile key with the noise params.
+    TerrainTileCache::Key key;
+    key.octaves = params.octaves;
+    key.ridgeOffset = params.ridgeOffset;
+    key.texelSizeX = m_recipW;
+    key.texelSizeY = m_recipH;
+
+    int32_t originX, originY;
+    splitPan(m_translation.x + params.uvOffset, m_recipW, originX, key.phaseX);
+    splitPan(m_translation.y + params.uvOffset, m_recipH, originY, key.phaseY);
+
+    // World texels covered, inclusive, including the one texel border needed by the normals
+    const int32_t x0 = -1 - originX, x1 = m_width - originX;
+    const int32_t y0 = -1 - originY, y1 = m_height - originY;
+
+    for (int32_t ty = floorDiv(y0, TILE_SIZE); ty <= floorDiv(y1, TILE_SIZE); ty++)
+    {
+        for (int32_t tx = floorDiv(x0, TILE_SIZE); tx <= floorDiv(x1, TILE_SIZE); tx++)
+        {
+            key.tileX = tx;
+            key.tileY = ty;
+            const TerrainTileCache::Tile* tile = cache.acquire(key);
+
+            // The part of the tile we cover
+            const int32_t sx0 = maxi(x0, tx*TILE_SIZE), sx1 = mini(x1, tx*TILE_SIZE + TILE_SIZE-1);
+            const int32_t sy0 = maxi(y0, ty*TILE_SIZE), sy1 = mini(y1, ty*TILE_SIZE + TILE_SIZE-1);
+
+            for (int32_t y = sy0; y <= sy1; y++)
+            {
+                const float* src = tile->heights + (y - ty*TILE_SIZE)*TILE_SIZE + (sx0 - tx*TILE_SIZE);
+                float* dst = &m_u.get(sx0 + originX, y + originY);
+                for (int32_t x = sx0; x <= sx1; x++)
+                    *dst++ = params.heightScale * *src++ + params.heightOffset;
+            }
+
+            cache.release(tile);
+        }
+    }
 }
 
 void TerrainSim::calcNormals()
@@ -121,8 +161,9 @@ void TerrainSim::calcNormals()
         ptr = m_normals + j*m_width*3;
         for(int32_t i=0; i<m_width; i++)
         {
-            const float dx = getUnbounded(i+1, j) - getUnbounded(i-1, j);    //dy/dx
-            const float dz = getUnbounded(i, j+1) - getUnbounded(i, j-1);    //dy/dz
+            // the halo holds the neighbouring tiles' edge texels, so no bounds checks
+            const float dx = m_u.get(i+1, j) - m_u.get(i-1, j);    //dy/dx
+            const float dz = m_u.get(i, j+1) - m_u.get(i, j-1);    //dy/dz
             nv::vec3f n(2.0f * dx, 1, 2.0f * dz);                            // Why the 2x?
             n = normalize(n);
 
@@ -132,6 +173,10 @@ void TerrainSim::calcNormals()
 
             assert(ptr <= m_normals + totalNormalElements());        // Don't overrun.
         }
+
+        // A row at a time, while it is still in the cache
+        if (m_output)
+            NvVertexPacking::writeNormals(m_u.getRow(j), m_normals + j*m_width*3, m_width, m_output + j*m_width*NvVertexPacking::getVertexSize());
     }
     assert(ptr == m_normals + totalNormalElements());        // Fill entire buffer with no underrun.
 }
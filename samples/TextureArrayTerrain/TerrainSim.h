@@ -41,6 +41,7 @@
 #include <iostream>
 #include "Array2D.h"
 #include "NV/NvMath.h"
+#include "NvGLUtils/NvVertexPacking.h"
 
 // Fill a height field with terrain-like heights using fBm and ridge noise, etc.  This is not really
 // the main point of the sample - which is terrain texturing.  But we need some plausible data on which
@@ -48,7 +49,8 @@
 class TerrainSim
 {
 public:
-    TerrainSim(int32_t w, int32_t h, const nv::vec2f& trans);
+    // The grid spans extent x extent noise units; trans places it (uv = texel * extent / (w-1) - trans).
+    TerrainSim(int32_t w, int32_t h, const nv::vec2f& trans, float extent = 1.0f);
     ~TerrainSim();
 
     // Flatten all heights to 0.
@@ -67,28 +69,39 @@ public:
     void setParams(const Params&);
     bool dirtyParams() { return m_dirty; }
 
-    // Populate with noise from fBm etc.  Calculate normals also.
+    // Populate with noise from fBm etc.  Calculate normals also.  The noise comes from the shared TerrainTileCache,
+    // so only tiles not generated before (by this sim or a neighbour) cost noise evaluations.
     void simulate();
 
+    // Also write the results of the following simulate() calls here, as NvVertexPacking::writeNormals() lays
+    // them out per vertex, e.g. straight into a mapped vertex buffer.  Write-only.  NULL to stop.
+    void setOutput(uint8_t* vertices) { m_output = vertices; }
+
     int32_t getWidth() { return m_width; }
     int32_t getHeight() { return m_height; }
-    float *getHeightField() { return m_u.data; }
+    float getExtent() const { return m_extent; }
+    const nv::vec2f& getTranslation() const { return m_translation; }
+    const Array2D<float>& getHeightField() const { return m_u; }
     float *getNormals() { return m_normals; }
 
     // Total numbers of floats (or whatever) in the arrays.
     size_t totalHeightFieldElements() const    { return m_width * m_height; }
     size_t totalNormalElements() const        { return m_width * m_height * 3; }
 
+    // CPU memory held by the simulation's arrays
+    size_t getMemoryBytes() const { return m_u.getMemoryBytes() + sizeof(float) * totalNormalElements(); }
+
 private:
     TerrainSim() {}
-    float getUnbounded(int32_t x, int32_t y) const;
-    float computeTerrain(int32_t x, int32_t y) const;
+    void gatherHeights(const Params& params);
     void calcNormals();
 
     int32_t m_width, m_height;
+    float m_extent;
     float m_recipW, m_recipH;
-    Array2D<float> m_u;
+    Array2D<float> m_u;         // with a one texel halo from the neighbouring tiles, for the normals
     float *m_normals;
+    uint8_t *m_output;
 
     nv::vec2f m_translation;
 
@@ -39,15 +39,9 @@
 
 //#undef NDEBUG
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
 
-#include "IBOBuild.h"
-
-void* (KHRONOS_APIENTRY *TerrainSimRenderer::glMapBufferRangePtr) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
-void (KHRONOS_APIENTRY *TerrainSimRenderer::glUnmapBufferPtr) (GLenum target);
-
-#ifndef GL_MAP_WRITE_BIT
-#define GL_MAP_WRITE_BIT                2
-#endif
 
 static void checkGlError(const char* op, const char* loc) {
     for (GLint error = glGetError(); error; error
@@ -59,48 +53,92 @@ static void checkGlError(const char* op, const char* loc) {
 TerrainSimRenderer::TerrainSimRenderer(TerrainSim *sim, const nv::vec2f& offset):
     m_simulation(sim),
     m_gridRenderPos(offset),
-    m_indexCount(0),
+    m_positionXZVBO(0),
+    m_indices(NULL),
+    m_staging(NULL),
+    m_mapped(NULL),
+    m_updating(false),
+    m_hasData(false),
+    m_skirtVertexCount(0),
+    m_skirtDepth(0.0f),
     m_vertexCount(0)
 {
 }
 
 TerrainSimRenderer::~TerrainSimRenderer()
 {
+    if (m_positionXZVBO)
+        glDeleteBuffers(1, &m_positionXZVBO);
+    NvGridIndexBuffer::release(m_indices);
+    delete [] m_staging;
 }
 
-void TerrainSimRenderer::setIndex(uint16_t *indices, int32_t i1, int32_t i2)
+size_t TerrainSimRenderer::nDynamicVertices() const
 {
-    assert(i1 < m_indexCount);
-    assert(i2 < m_vertexCount);
-    indices[i1] = (uint16_t) i2;
+    return m_simulation->totalHeightFieldElements() + m_skirtVertexCount;
 }
 
-size_t TerrainSimRenderer::nInterleavedDynamicElements() const
+size_t TerrainSimRenderer::nDynamicBytes() const
 {
-    assert(3 * m_simulation->totalHeightFieldElements() == m_simulation->totalNormalElements());
-    return m_simulation->totalHeightFieldElements() + m_simulation->totalNormalElements();
+    return NvVertexPacking::getVertexSize() * nDynamicVertices();
 }
 
-size_t TerrainSimRenderer::nInterleavedDynamicBytes() const
+size_t TerrainSimRenderer::getGpuBytes() const
 {
-    return sizeof(float) * nInterleavedDynamicElements();
+    return sizeof(float) * 2 * m_vertexCount + m_NormalsAndHeightsVBO.getSlotCount() * nDynamicBytes();
+}
+
+size_t TerrainSimRenderer::getCpuBytes() const
+{
+    return m_staging ? nDynamicBytes() : 0;
+}
+
+// The grid and the skirts hanging from its edges
+NvGridIndexBuffer::Desc TerrainSimRenderer::gridDesc() const
+{
+    NvGridIndexBuffer::Desc desc(m_simulation->getWidth(), m_simulation->getHeight());
+    desc.skirts = true;
+    return desc;
+}
+
+void TerrainSimRenderer::writeSkirts(uint8_t* pOut)
+{
+    const Array2D<float>& heights = m_simulation->getHeightField();
+    const float* pNormals = m_simulation->getNormals();
+    const int32_t w = m_simulation->getWidth();
+    const size_t vertexSize = NvVertexPacking::getVertexSize();
+
+    const NvGridIndexBuffer::Desc desc = gridDesc();
+    pOut += vertexSize * m_simulation->totalHeightFieldElements();
+    for (int32_t n=0; n<m_skirtVertexCount; n++)
+    {
+        const int32_t v = NvGridIndexBuffer::getSkirtVertex(desc, n);
+        const float height = heights.get(v % w, v / w) - m_skirtDepth;
+        NvVertexPacking::writeNormals(&height, pNormals + 3*v, 1, pOut);
+        pOut += vertexSize;
+    }
 }
 
-void TerrainSimRenderer::initBuffers()
+void TerrainSimRenderer::initBuffers(int32_t slotCount)
 {
     const int32_t w = m_simulation->getWidth();
     const int32_t h = m_simulation->getHeight();
 
-    // We normalize any tile to be 127/2 wide, regardless of the number of vertices.  This size
+    // We normalize one unit of noise space to be 127/2 wide, regardless of the number of vertices.  This size
     // is purely arbitrary; 1.0 might have been a better choice.
-    const float wScale = 127.0f * 0.5f / (float)(w-1);
-    const float hScale = 127.0f * 0.5f / (float)(h-1);
+    const float extent = m_simulation->getExtent();
+    const float wScale = 127.0f * 0.5f * extent / (float)(w-1);
+    const float hScale = 127.0f * 0.5f * extent / (float)(h-1);
 
     // This is essentially a world transform, baked into the vertex positions.
-    const float xTrans = -m_gridRenderPos.x * (w-1);
-    const float yTrans = -m_gridRenderPos.y * (w-1);
+    const float xTrans = -m_gridRenderPos.x * (w-1) / extent;
+    const float yTrans = -m_gridRenderPos.y * (h-1) / extent;
 
-    m_vertexCount = w*h;
+    // Deep enough to cover the height difference to a coarser neighbour, which grows with the vertex spacing
+    m_skirtVertexCount = 2*w + 2*h;
+    m_skirtDepth = std::min(2.0f * wScale, 6.0f);
+
+    m_vertexCount = w*h + m_skirtVertexCount;
     float *surfacexz = new float[2 * m_vertexCount];
     for(int32_t i=0; i<h; i++)
     {
@@ -110,6 +148,13 @@ void TerrainSimRenderer::initBuffers()
             surfacexz[i*w*2 + j*2 + 1] = wScale * ((float)j + xTrans);
         }
     }
+    const NvGridIndexBuffer::Desc desc = gridDesc();
+    for(int32_t n=0; n<m_skirtVertexCount; n++)
+    {
+        const int32_t v = NvGridIndexBuffer::getSkirtVertex(desc, n);
+        surfacexz[(w*h + n)*2 + 0] = surfacexz[v*2 + 0];
+        surfacexz[(w*h + n)*2 + 1] = surfacexz[v*2 + 1];
+    }
 
     glGenBuffers(1, &m_positionXZVBO);
     glBindBuffer(GL_ARRAY_BUFFER, m_positionXZVBO);
@@ -118,102 +163,125 @@ void TerrainSimRenderer::initBuffers()
     checkGlError("glGenBuffers m_positionXZVBO", "TerrainSimRenderer::initBuffers()");
     delete [] surfacexz;
 
-    //no of quads for a grid of wxh = (w-1)*(h-1);
-    //no of triangles = no of quads * 2;
-    //no of vertices = no of triangles * 3;
-
-    // This fn theoretically creates an optimal IB for a regular grid of quads.  I don't see any improvement
-    // in perf over the previous, naive implementation.  Either I'm invoking it with incorrect params and/or
-    // the bottleneck is elsewhere.
-    m_indexCount = 0;
-    const int32_t blockWidth = 32;
-    const bool doWarm = false;
-    uint16_t *indices = NULL;
-    gen_planar_quad_optimised_indices(w,h, &m_indexCount, &indices, blockWidth, doWarm);
-    assert(indices != NULL);
-    assert(m_indexCount > 0);
-    
-    glGenBuffers(1, &m_IBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t)*m_indexCount, indices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    checkGlError("glGenBuffers m_terrainIBO", "TerrainSimRenderer::initBuffers()");
-    delete [] indices;
-    
-    float* pFloats = new float[nInterleavedDynamicElements()];
-    convertDynamicAttrsToFloat(pFloats);
-    glGenBuffers(1, &m_NormalsAndHeightsVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_NormalsAndHeightsVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float)*nInterleavedDynamicElements(), pFloats, GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    checkGlError("glGenBuffers m_gradientsVBO", "TerrainSimRenderer::initBuffers()");
-    delete [] pFloats;
+    // The indices depend only on the grid size, so every tile of this size shares one buffer
+    m_indices = NvGridIndexBuffer::acquire(gridDesc());
+    assert(m_indices != NULL);
+    checkGlError("acquire grid indices", "TerrainSimRenderer::initBuffers()");
+
+    uint8_t* pVertices = new uint8_t[nDynamicBytes()];
+    packDynamicAttrs(pVertices);
+    writeSkirts(pVertices);
+    m_NormalsAndHeightsVBO.init(GL_ARRAY_BUFFER, nDynamicBytes(), slotCount, pVertices);
+    checkGlError("init m_NormalsAndHeightsVBO", "TerrainSimRenderer::initBuffers()");
+    delete [] pVertices;
 
-    LOGI("TerrainSimRenderer::initBuffers() for %d vertices, %d indices", m_vertexCount, m_indexCount);
+    // Too much spew with streamed tiles: LOGI("TerrainSimRenderer::initBuffers() for %d vertices, %d indices", m_vertexCount, m_indices->getIndexCount());
 }
 
 void TerrainSimRenderer::updateBufferData()
 {
-    // If this were a real application of dynamic data - such as a terrain engine with deformation - we ought to double-buffer
-    // the data to improve CPU-GPU concurrency.  Here, we only alter the data in response to user tweaks of the sliders
-    // and so it only needs to be fast enough to be interactive.  We omit double-buffering for the sake of simplicity.
-    glBindBuffer(GL_ARRAY_BUFFER, m_NormalsAndHeightsVBO);
-    void *ptr2 = glMapBufferRangePtr(GL_ARRAY_BUFFER, 0, nInterleavedDynamicBytes(), GL_MAP_WRITE_BIT);
-    int32_t error = glGetError();
-    if (error || !ptr2)
-        return;
+    endUpdate();
 
-    convertDynamicAttrsToFloat((float*)ptr2);
-    
-    glUnmapBufferPtr(GL_ARRAY_BUFFER);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    void *ptr = m_NormalsAndHeightsVBO.beginWrite();
+    if (ptr)
+    {
+        packDynamicAttrs((uint8_t*)ptr);
+        writeSkirts((uint8_t*)ptr);
+    }
+    m_NormalsAndHeightsVBO.endWrite();
+    m_hasData = true;
     checkGlError("end", "TerrainSimRenderer::updateBufferData()");
-
-    // Too much spew:
-    //LOGI("TerrainSimRenderer::updateBufferData() for %d vertices, m_current=%d", m_vertCount, m_current);
 }
 
-void TerrainSimRenderer::convertDynamicAttrsToFloat(float* pOut)
+void TerrainSimRenderer::beginUpdate()
 {
-    const float* pHeights = m_simulation->getHeightField();
-    const float* pNormals = m_simulation->getNormals();
-    const float* const pEndNormals = pNormals + m_simulation->totalNormalElements();
-    (void)pEndNormals; // This is only used in an assert, so we avoid the warning
-    const float* const pEndHeights = pHeights + m_simulation->totalHeightFieldElements();
+    endUpdate();
 
-    while (pHeights < pEndHeights)
+    // A simulation pass can outlast a frame.  A persistently mapped slot may stay mapped meanwhile;
+    // with the other methods the buffer cannot be drawn from while mapped, so write to memory first.
+    uint8_t* ptr = NULL;
+    if (m_NormalsAndHeightsVBO.getMethod() == NvStreamingBuffer::METHOD_PERSISTENT)
     {
-        // Interleaved normal and height is more efficient than separate VBOs: half4(x,y,z, height).
-        *pOut++ = *pNormals++;
-        *pOut++ = *pNormals++;
-        *pOut++ = *pNormals++;
-        assert(pNormals <= pEndNormals);
+        ptr = (uint8_t*)m_NormalsAndHeightsVBO.beginWrite();
+        m_mapped = ptr;
+    }
+    else
+    {
+        if (!m_staging)
+            m_staging = new uint8_t[nDynamicBytes()];
+        ptr = m_staging;
+    }
+
+    m_simulation->setOutput(ptr);
+    m_updating = true;
+}
+
+void TerrainSimRenderer::endUpdate()
+{
+    if (!m_updating)
+        return;
+
+    m_simulation->setOutput(NULL);
+    m_updating = false;
 
-        *pOut++ = *pHeights++;
+    // the simulation writes the grid; the skirts are copies of its edges
+    if (m_NormalsAndHeightsVBO.getMethod() == NvStreamingBuffer::METHOD_PERSISTENT)
+    {
+        if (m_mapped)
+            writeSkirts(m_mapped);
+        m_mapped = NULL;
+        m_NormalsAndHeightsVBO.endWrite();
     }
+    else
+    {
+        writeSkirts(m_staging);
+        void *ptr = m_NormalsAndHeightsVBO.beginWrite();
+        if (ptr)
+            memcpy(ptr, m_staging, nDynamicBytes());
+        m_NormalsAndHeightsVBO.endWrite();
+    }
+    m_hasData = true;
+    checkGlError("end", "TerrainSimRenderer::endUpdate()");
 }
 
-int32_t TerrainSimRenderer::render(GLuint posXYHandle, GLuint normalHeightHandle)
+void TerrainSimRenderer::packDynamicAttrs(uint8_t* pOut)
+{
+    assert(3 * m_simulation->totalHeightFieldElements() == m_simulation->totalNormalElements());
+
+    // Interleaved normal and height is more efficient than separate VBOs: half height and an
+    // octahedral normal in two bytes, a quarter of the float4(x,y,z, height) it replaces.
+    // Contexts without half float attributes get the float layout, 12 bytes.
+    const Array2D<float>& heights = m_simulation->getHeightField();
+    const int32_t w = m_simulation->getWidth();
+    const size_t rowBytes = NvVertexPacking::getVertexSize() * w;
+    for (int32_t j=0; j<m_simulation->getHeight(); j++)
+        NvVertexPacking::writeNormals(heights.getRow(j), m_simulation->getNormals() + j*w*3, w, pOut + j*rowBytes);
+}
+
+int32_t TerrainSimRenderer::render(GLuint posXYHandle, GLuint heightHandle, GLuint normalHandle)
 {
     glBindBuffer(GL_ARRAY_BUFFER, m_positionXZVBO);
     glVertexAttribPointer(posXYHandle, 2, GL_FLOAT, GL_FALSE, 0, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, m_NormalsAndHeightsVBO);
-    glVertexAttribPointer(normalHeightHandle, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, m_NormalsAndHeightsVBO.getBuffer());
+    NvVertexPacking::setAttribPointers(heightHandle, normalHandle, m_NormalsAndHeightsVBO.getReadOffset());
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     checkGlError("glBindBuffer vertices", "TerrainSimRenderer::render()");
 
     glEnableVertexAttribArray(posXYHandle);
-    glEnableVertexAttribArray(normalHeightHandle);
+    glEnableVertexAttribArray(heightHandle);
+    glEnableVertexAttribArray(normalHandle);
     checkGlError("attrs bound", "TerrainSimRenderer::render()");
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO);
-    checkGlError("glBindBuffer IBO", "TerrainSimRenderer::render()");
-
-    glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_SHORT, 0);
+    m_indices->draw();
+    checkGlError("draw", "TerrainSimRenderer::render()");
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     glDisableVertexAttribArray(posXYHandle);
-    glDisableVertexAttribArray(normalHeightHandle);
+    glDisableVertexAttribArray(heightHandle);
+    glDisableVertexAttribArray(normalHandle);
+
+    // the slot drawn from may not be rewritten until the GPU is done with it
+    m_NormalsAndHeightsVBO.fenceRead();
     
-    return m_indexCount;
+    return m_indices->getIndexCount();
 }
@@ -40,35 +40,52 @@
 
 #include "TerrainSim.h"
 #include "NV/NvPlatformGL.h"
-#include "KHR/khrplatform.h"
+#include "NvGLUtils/NvGridIndexBuffer.h"
+#include "NvGLUtils/NvStreamingBuffer.h"
+#include "NvGLUtils/NvVertexPacking.h"
 
 class half;
 
-// Own vertex buffer objects (VBOs) and index buffer (IBO) for the terrain surface.  The render method
-// binds them and issues the OGL draw call.
+// Own vertex buffer objects (VBOs) for the terrain surface and share the index buffer (IBO) of its grid size.
+// The render method binds them and issues the OGL draw call.
 class TerrainSimRenderer
 {
 public:
     TerrainSimRenderer(TerrainSim *sim, const nv::vec2f& offset);
     ~TerrainSimRenderer();
 
-    //init the Vertex Buffers
-    void initBuffers();
+    //init the Vertex Buffers; slotCount is the number of versions of the streamed vertices in flight
+    void initBuffers(int32_t slotCount = NvStreamingBuffer::DEFAULT_SLOT_COUNT);
 
-    //update the buffer data using round-robin VBO's
+    //copy the current simulation results into the next slot of the streamed VBO
     void updateBufferData();
 
-    //render the surface
-    int32_t render(GLuint posXYHandle, GLuint normalHeightHandle);
+    //have the simulation write its next results into the next slot of the streamed VBO;
+    //endUpdate() must follow once the simulation has finished
+    void beginUpdate();
+
+    //make the results written since beginUpdate() the ones rendered
+    void endUpdate();
+
+    //true between beginUpdate() and endUpdate()
+    bool isUpdating() const { return m_updating; }
 
-    static void* (KHRONOS_APIENTRY *glMapBufferRangePtr) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
-    static void (KHRONOS_APIENTRY *glUnmapBufferPtr) (GLenum target);
+    //true once the results of a simulation pass have been made the ones rendered
+    bool hasData() const { return m_hasData; }
+
+    //GPU and CPU memory held by the renderer's buffers
+    size_t getGpuBytes() const;
+    size_t getCpuBytes() const;
+
+    //render the surface
+    int32_t render(GLuint posXYHandle, GLuint heightHandle, GLuint normalHandle);
 
 private:
-    void setIndex(uint16_t *indices, int32_t i1, int32_t i2);
-    size_t nInterleavedDynamicElements() const;
-    size_t nInterleavedDynamicBytes() const;
-    void convertDynamicAttrsToFloat(float* pOut);
+    size_t nDynamicVertices() const;
+    size_t nDynamicBytes() const;
+    void packDynamicAttrs(uint8_t* pOut);
+    NvGridIndexBuffer::Desc gridDesc() const;
+    void writeSkirts(uint8_t* pOut);
 
     //pointer to the simulation object
     TerrainSim *m_simulation;
@@ -76,13 +93,32 @@ private:
     // Position in world space where the grid(surface) is rendered.
     nv::vec2f m_gridRenderPos;
 
-    // Handles to the water's XZ VBO and Index Buffers (static and do not change).
-    GLuint m_positionXZVBO, m_IBO;
+    // Handle to the terrain's XZ VBO (static and does not change).
+    GLuint m_positionXZVBO;
+
+    // The grid's indices, shared with every tile of the same size.
+    NvGridIndexBuffer* m_indices;
+
+    // The heights and surface normals packed into 32 bits per vertex (12 bytes without half float
+    // attributes), streamed from the simulation.
+    NvStreamingBuffer m_NormalsAndHeightsVBO;
+
+    // Where the simulation writes while an update spans frames and the VBO cannot stay mapped
+    // that long (anything but persistent mapping); copied into the VBO by endUpdate().
+    uint8_t* m_staging;
+
+    // The persistently mapped slot the simulation is writing to, between beginUpdate() and endUpdate()
+    uint8_t* m_mapped;
+
+    bool m_updating;
+    bool m_hasData;
 
-    // Handles to the surface normals and the height field elements interleaved.
-    GLuint m_NormalsAndHeightsVBO;
+    // Skirts hang from the grid edges, hiding the cracks to neighbouring tiles of a different resolution.
+    // Their vertices follow the grid's in both VBOs, one per edge vertex, m_skirtDepth below it.
+    int32_t m_skirtVertexCount;
+    float m_skirtDepth;
 
-    int32_t m_vertexCount, m_indexCount;
+    int32_t m_vertexCount;
 };
 
 
@@ -0,0 +1,398 @@
+//----------------------------------------------------------------------------------
+// File:        TextureArrayTerrain/TerrainStreamer.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "TerrainStreamer.h"
+#include "TerrainGenerator.h"
+#include "TerrainTileCache.h"
+#include "NvGLUtils/NvGridIndexBuffer.h"
+#include "NvGLUtils/NvProfiler.h"
+#include "NV/NvLogs.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+// Level 0 tiles span this many noise units; with 33 vertices that is the 0.5 world unit spacing of the
+// original 128x128 tiles.
+static const float FINEST_EXTENT = 0.25f;
+static const int32_t LEVEL_COUNT = 6;
+
+// Root tiles on each side of the one under the camera
+static const int32_t ROOT_RADIUS = 1;
+
+// World units per noise unit (see TerrainSimRenderer::initBuffers)
+static const float WORLD_PER_UNIT = 127.0f * 0.5f;
+
+// Heights stay roughly within [0, MAX_HEIGHT] for the GUI's parameter ranges
+static const float MAX_HEIGHT = 6.0f;
+
+// Bounds on the simulation passes in flight and started per update, which bound the per-frame cost
+static const int32_t MAX_GENERATING = 8;
+static const int32_t MAX_STARTS_PER_UPDATE = 4;
+
+bool TerrainStreamer::NodeKey::operator<(const NodeKey& rhs) const
+{
+    if (level != rhs.level) return level < rhs.level;
+    if (x != rhs.x)         return x < rhs.x;
+    return y < rhs.y;
+}
+
+TerrainStreamer::TerrainStreamer(int32_t tileVertices, int32_t maxTiles) :
+    m_tileVertices(tileVertices),
+    m_maxTiles(maxTiles),
+    m_maxPixelError(4.0f),
+    m_residentCount(0),
+    m_frame(0),
+    m_eyePos(0.0f, 0.0f, 0.0f),
+    m_pixelsPerUnit(1.0f)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+TerrainStreamer::~TerrainStreamer()
+{
+    for (NodeMap::iterator it = m_nodes.begin(); it != m_nodes.end(); ++it)
+    {
+        if (it->second.generator)
+        {
+            it->second.generator->waitForSimulation();
+            delete it->second.generator;
+        }
+    }
+}
+
+void TerrainStreamer::setParams(const TerrainSim::Params& params)
+{
+    m_params = params;
+    for (NodeMap::iterator it = m_nodes.begin(); it != m_nodes.end(); ++it)
+    {
+        if (it->second.generator)
+            it->second.generator->getSimulation().setParams(params);
+    }
+}
+
+float TerrainStreamer::getExtent(int32_t level) const
+{
+    return FINEST_EXTENT * (float)(1 << level);
+}
+
+// Projected vertex spacing of the tile in pixels, at its closest point to the eye
+float TerrainStreamer::getScreenError(const NodeKey& key) const
+{
+    // Tile x runs along world z and tile y along world x (see TerrainSimRenderer::initBuffers)
+    const float size = getExtent(key.level) * WORLD_PER_UNIT;
+    const float z0 = key.x * size, x0 = key.y * size;
+
+    const float dx = std::max(0.0f, std::max(x0 - m_eyePos.x, m_eyePos.x - (x0 + size)));
+    const float dz = std::max(0.0f, std::max(z0 - m_eyePos.z, m_eyePos.z - (z0 + size)));
+    const float dy = std::max(0.0f, std::max(-m_eyePos.y, m_eyePos.y - MAX_HEIGHT));
+    const float distance = std::max(1.0f, sqrtf(dx*dx + dy*dy + dz*dz));
+
+    const float spacing = size / (float)(m_tileVertices - 1);
+    return spacing * m_pixelsPerUnit / distance;
+}
+
+TerrainStreamer::Node& TerrainStreamer::touch(const NodeKey& key)
+{
+    NodeMap::iterator it = m_nodes.find(key);
+    if (it == m_nodes.end())
+    {
+        Node node;
+        node.generator = NULL;
+        node.requestTimeNs = NvProfiler::getTimeNs();
+        node.priority = 0.0f;
+        node.generating = false;
+        node.drawPending = false;
+        it = m_nodes.insert(NodeMap::value_type(key, node)).first;
+    }
+
+    it->second.lastUsed = m_frame;
+    return it->second;
+}
+
+bool TerrainStreamer::isReady(const Node& node) const
+{
+    return node.generator && node.generator->isReady();
+}
+
+void TerrainStreamer::request(const NodeKey& key, Node& node)
+{
+    // Tiles already generating are picked up by completeTiles()
+    if (node.generating)
+        return;
+
+    node.priority = getScreenError(key);
+    m_requests.push_back(key);
+}
+
+void TerrainStreamer::visit(const NodeKey& key)
+{
+    Node& node = touch(key);
+    if (!isReady(node))
+    {
+        request(key, node);
+        return;
+    }
+
+    // New params: regenerate, drawing the old vertices meanwhile
+    if (node.generator->getSimulation().dirtyParams())
+    {
+        if (!node.requestTimeNs)
+            node.requestTimeNs = NvProfiler::getTimeNs();
+        request(key, node);
+    }
+
+    if (key.level > 0 && getScreenError(key) > m_maxPixelError)
+    {
+        bool childrenReady = true;
+        for (int32_t c=0; c<4; c++)
+        {
+            const NodeKey child = { key.level-1, 2*key.x + (c & 1), 2*key.y + (c >> 1) };
+            Node& childNode = touch(child);
+            if (!isReady(childNode))
+            {
+                request(child, childNode);
+                childrenReady = false;
+            }
+        }
+
+        if (childrenReady)
+        {
+            for (int32_t c=0; c<4; c++)
+            {
+                const NodeKey child = { key.level-1, 2*key.x + (c & 1), 2*key.y + (c >> 1) };
+                visit(child);
+            }
+            return;
+        }
+    }
+
+    m_drawList.push_back(&node);
+}
+
+void TerrainStreamer::completeTiles()
+{
+    m_stats.completedTiles = 0;
+
+    for (size_t i=0; i<m_generating.size(); )
+    {
+        Node& node = m_nodes[m_generating[i]];
+        if (!node.generator->isSimulationDone())
+        {
+            i++;
+            continue;
+        }
+
+        node.generator->updateBufferData();
+        node.generating = false;
+        m_stats.completedTiles++;
+
+        // A pass started before a param change leaves the tile dirty; only the
+        // regenerated vertices end the wait
+        if (node.requestTimeNs && !node.generator->getSimulation().dirtyParams())
+            node.drawPending = true;
+
+        m_generating[i] = m_generating.back();
+        m_generating.pop_back();
+    }
+}
+
+// Frees the least recently used tile that is not wanted this update and not generating
+bool TerrainStreamer::evictOne()
+{
+    NodeMap::iterator oldest = m_nodes.end();
+    for (NodeMap::iterator it = m_nodes.begin(); it != m_nodes.end(); ++it)
+    {
+        const Node& node = it->second;
+        if (!node.generator || node.lastUsed == m_frame || node.generating)
+            continue;
+        if (oldest == m_nodes.end() || node.lastUsed < oldest->second.lastUsed)
+            oldest = it;
+    }
+
+    if (oldest == m_nodes.end())
+        return false;
+
+    oldest->second.generator->waitForSimulation();
+    delete oldest->second.generator;
+    m_nodes.erase(oldest);
+    m_residentCount--;
+    return true;
+}
+
+void TerrainStreamer::startTiles()
+{
+    // Largest screen error first; that is coarse tiles before their children and near before far
+    std::vector<std::pair<float, NodeKey> > order;
+    order.reserve(m_requests.size());
+    for (size_t i=0; i<m_requests.size(); i++)
+        order.push_back(std::make_pair(-m_nodes[m_requests[i]].priority, m_requests[i]));
+    std::sort(order.begin(), order.end());
+
+    int32_t started = 0;
+    size_t i = 0;
+    for (; i<order.size(); i++)
+    {
+        if ((int32_t)m_generating.size() >= MAX_GENERATING || started >= MAX_STARTS_PER_UPDATE)
+            break;
+
+        const NodeKey& key = order[i].second;
+        Node& node = m_nodes[key];
+        if (node.generating)
+            continue;
+
+        if (!node.generator)
+        {
+            if (m_residentCount >= m_maxTiles && !evictOne())
+                break;
+
+            const float extent = getExtent(key.level);
+            const nv::vec2f offset(-key.x * extent, -key.y * extent);
+
+            // Two versions of the vertices: regenerating after a param change keeps drawing the old ones
+            node.generator = new TerrainGenerator(m_tileVertices, m_tileVertices, offset, extent, 2);
+            node.generator->getSimulation().initParams(m_params);
+            m_residentCount++;
+        }
+
+        node.generator->startSimulation();
+        node.generating = true;
+        m_generating.push_back(key);
+        started++;
+    }
+
+    m_stats.queuedTiles = (int32_t)(order.size() - i);
+}
+
+void TerrainStreamer::updateStats()
+{
+    m_stats.residentTiles = m_residentCount;
+    m_stats.generatingTiles = (int32_t)m_generating.size();
+    m_stats.drawnTiles = (int32_t)m_drawList.size();
+
+    // The tiles share the index buffer of their grid size
+    m_stats.gpuBytes = NvGridIndexBuffer::getTotalBytes();
+    m_stats.cpuBytes = TerrainTileCache::get().getTileCount() * sizeof(TerrainTileCache::Tile);
+    for (NodeMap::iterator it = m_nodes.begin(); it != m_nodes.end(); ++it)
+    {
+        m_stats.cpuBytes += sizeof(Node);
+        if (it->second.generator)
+        {
+            m_stats.gpuBytes += it->second.generator->getGpuBytes();
+            m_stats.cpuBytes += it->second.generator->getCpuBytes();
+        }
+    }
+}
+
+void TerrainStreamer::update(const nv::vec3f& eyePos, float pixelsPerUnit)
+{
+    NV_PROFILE_SCOPE("TerrainStreamer::update");
+
+    m_frame++;
+    m_eyePos = eyePos;
+    m_pixelsPerUnit = pixelsPerUnit;
+
+    completeTiles();
+
+    // Select from the roots around the camera
+    m_requests.clear();
+    m_drawList.clear();
+    const int32_t rootLevel = LEVEL_COUNT - 1;
+    const float rootSize = getExtent(rootLevel) * WORLD_PER_UNIT;
+    const int32_t rootX = (int32_t)floorf(eyePos.z / rootSize);
+    const int32_t rootY = (int32_t)floorf(eyePos.x / rootSize);
+    for (int32_t y = rootY - ROOT_RADIUS; y <= rootY + ROOT_RADIUS; y++)
+    {
+        for (int32_t x = rootX - ROOT_RADIUS; x <= rootX + ROOT_RADIUS; x++)
+        {
+            const NodeKey root = { rootLevel, x, y };
+            visit(root);
+        }
+    }
+
+    startTiles();
+
+    // Forget wanted tiles that were never started and are not wanted any more
+    for (NodeMap::iterator it = m_nodes.begin(); it != m_nodes.end(); )
+    {
+        if (!it->second.generator && it->second.lastUsed != m_frame)
+            m_nodes.erase(it++);
+        else
+            ++it;
+    }
+
+    updateStats();
+}
+
+void TerrainStreamer::prime(const nv::vec3f& eyePos, float pixelsPerUnit)
+{
+    // Each round refines at least one more level; the per-update start limit may need a few more
+    for (int32_t round = 0; round < 256; round++)
+    {
+        update(eyePos, pixelsPerUnit);
+
+        // Nothing started: either everything is ready or the tile budget is full of wanted tiles
+        if (m_generating.empty())
+            break;
+
+        for (size_t i=0; i<m_generating.size(); i++)
+            m_nodes[m_generating[i]].generator->waitForSimulation();
+    }
+
+    LOGI("TerrainStreamer: primed %d tiles (%d drawn), %.1f MB GPU, %.1f MB CPU", m_stats.residentTiles, m_stats.drawnTiles,
+        m_stats.gpuBytes / (1024.0f * 1024.0f), m_stats.cpuBytes / (1024.0f * 1024.0f));
+}
+
+int32_t TerrainStreamer::render(GLuint posXYHandle, GLuint heightHandle, GLuint normalHandle)
+{
+    int32_t indices = 0;
+    for (size_t i=0; i<m_drawList.size(); i++)
+    {
+        Node& node = *m_drawList[i];
+        indices += node.generator->render(posXYHandle, heightHandle, normalHandle);
+
+        if (node.drawPending)
+        {
+            const float ms = (float)(NvProfiler::getTimeNs() - node.requestTimeNs) * 1.0e-6f;
+            m_stats.latencyMeanMs = (m_stats.latencyMeanMs == 0.0f) ? ms : (0.95f * m_stats.latencyMeanMs + 0.05f * ms);
+            m_stats.latencyMaxMs = std::max(m_stats.latencyMaxMs, ms);
+            node.requestTimeNs = 0;
+            node.drawPending = false;
+        }
+    }
+    return indices;
+}
@@ -0,0 +1,142 @@
+//----------------------------------------------------------------------------------
+// File:        TextureArrayTerrain/TerrainStreamer.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef _TERRAIN_STREAMER_
+#define _TERRAIN_STREAMER_
+
+#include <NvFoundation.h>
+
+
+#include <map>
+#include <vector>
+#include "TerrainSim.h"
+#include "NV/NvPlatformGL.h"
+
+class TerrainGenerator;
+
+// Streams an unbounded terrain around the camera as a quadtree of tiles.  Every tile has the same number of
+// vertices; a tile of level L spans twice the noise units of one of level L-1.  A 3x3 grid of root tiles of the
+// coarsest level follows the camera, and tiles are split while their vertex spacing projects to more than the
+// allowed screen error.  Missing tiles are generated as TerrainGenerator simulation passes on the job system,
+// the largest screen error first, a few per frame; until all four children of a tile are ready the tile itself
+// is drawn.  Tiles not drawn recently are evicted when the tile budget is full.
+class TerrainStreamer
+{
+public:
+    struct Stats
+    {
+        int32_t residentTiles;      // tiles holding vertex data or generating it
+        int32_t generatingTiles;    // simulation passes in flight
+        int32_t queuedTiles;        // tiles wanted but not started yet
+        int32_t drawnTiles;
+        int32_t completedTiles;     // passes that finished in the last update
+        float latencyMeanMs;        // from wanting a tile (new, or with new params) to the first draw of its
+                                    // generated vertices (running mean)
+        float latencyMaxMs;
+        size_t gpuBytes, cpuBytes;
+    };
+
+    // tileVertices: vertices along a tile edge; maxTiles: the tile budget
+    TerrainStreamer(int32_t tileVertices = 33, int32_t maxTiles = 256);
+    ~TerrainStreamer();
+
+    // New params regenerate the resident tiles as they are drawn, nearest first.
+    void setParams(const TerrainSim::Params& params);
+
+    // Max projected vertex spacing in pixels before a tile is split
+    void setMaxPixelError(float pixels) { m_maxPixelError = pixels; }
+
+    // Once per frame, before render: picks up finished tiles, selects the tiles to draw for a camera at eyePos,
+    // and starts generating missing ones.  pixelsPerUnit is the projected size in pixels of one world unit at
+    // distance one (viewport height / (2 tan(fovy / 2))).
+    void update(const nv::vec3f& eyePos, float pixelsPerUnit);
+
+    // Generates until the tiles update() would select for this camera are all ready.  Blocks.
+    void prime(const nv::vec3f& eyePos, float pixelsPerUnit);
+
+    // Draws the tiles selected by the last update.  Returns the number of indices drawn.
+    int32_t render(GLuint posXYHandle, GLuint heightHandle, GLuint normalHandle);
+
+    const Stats& getStats() const { return m_stats; }
+
+private:
+    struct NodeKey
+    {
+        int32_t level, x, y;
+
+        bool operator<(const NodeKey& rhs) const;
+    };
+
+    struct Node
+    {
+        TerrainGenerator* generator;    // NULL until generation starts
+        uint32_t lastUsed;              // update in which the node was last selected or wanted
+        uint64_t requestTimeNs;         // when the node's pending vertices were first wanted, 0 once they are drawn
+        bool drawPending;               // generated vertices not drawn yet; the latency is taken at that draw
+        float priority;
+        bool generating;                // a simulation pass is in flight or not yet picked up
+    };
+
+    typedef std::map<NodeKey, Node> NodeMap;
+
+    float getExtent(int32_t level) const;
+    float getScreenError(const NodeKey& key) const;
+    Node& touch(const NodeKey& key);
+    bool isReady(const Node& node) const;
+    void request(const NodeKey& key, Node& node);
+    void visit(const NodeKey& key);
+    void completeTiles();
+    void startTiles();
+    bool evictOne();
+    void updateStats();
+
+    int32_t m_tileVertices;
+    int32_t m_maxTiles;
+    float m_maxPixelError;
+    TerrainSim::Params m_params;
+
+    NodeMap m_nodes;
+    std::vector<NodeKey> m_requests;
+    std::vector<NodeKey> m_generating;
+    std::vector<Node*> m_drawList;
+    int32_t m_residentCount;
+
+    uint32_t m_frame;
+    nv::vec3f m_eyePos;
+    float m_pixelsPerUnit;
+
+    Stats m_stats;
+};
+
+#endif
@@ -0,0 +1,181 @@
+//----------------------------------------------------------------------------------
+// File:        TextureArrayTerrain/TerrainTileCache.cpp
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "TerrainTileCache.h"
+#include "RidgedMultiFractal.h"
+
+#undef NDEBUG
+#include <assert.h>
+
+static ImprovedNoise g_noiseGen;
+
+// 1024 tiles of 32x32 floats is 4MB, enough for the 3x3 sims several times over.
+static const int32_t DEFAULT_MAX_TILES = 1024;
+
+bool TerrainTileCache::Key::operator<(const Key& rhs) const
+{
+    if (tileX != rhs.tileX)                 return tileX < rhs.tileX;
+    if (tileY != rhs.tileY)                 return tileY < rhs.tileY;
+    if (octaves != rhs.octaves)             return octaves < rhs.octaves;
+    if (ridgeOffset != rhs.ridgeOffset)     return ridgeOffset < rhs.ridgeOffset;
+    if (phaseX != rhs.phaseX)               return phaseX < rhs.phaseX;
+    if (phaseY != rhs.phaseY)               return phaseY < rhs.phaseY;
+    if (texelSizeX != rhs.texelSizeX)       return texelSizeX < rhs.texelSizeX;
+    return texelSizeY < rhs.texelSizeY;
+}
+
+TerrainTileCache::TerrainTileCache(int32_t maxTiles) :
+    m_maxTiles(maxTiles),
+    m_useClock(0),
+    m_generated(0),
+    m_reused(0)
+{
+}
+
+TerrainTileCache::~TerrainTileCache()
+{
+    for (TileMap::iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+    {
+        assert(it->second->refs == 0);
+        delete it->second;
+    }
+}
+
+TerrainTileCache& TerrainTileCache::get()
+{
+    static TerrainTileCache cache(DEFAULT_MAX_TILES);
+    return cache;
+}
+
+const TerrainTileCache::Tile* TerrainTileCache::acquire(const Key& key)
+{
+    r3::ScopedMutex lock(m_lock);
+
+    TileMap::iterator it = m_tiles.find(key);
+    if (it != m_tiles.end())
+    {
+        Tile* tile = it->second;
+        tile->refs++;
+        tile->lastUse = ++m_useClock;
+        m_reused++;
+
+        // Another sim got here first and is still filling it in
+        while (!tile->ready)
+            m_lock.Wait();
+        return tile;
+    }
+
+    if ((int32_t)m_tiles.size() >= m_maxTiles)
+        evict();
+
+    Tile* tile = new Tile;
+    tile->key = key;
+    tile->refs = 1;
+    tile->lastUse = ++m_useClock;
+    tile->ready = false;
+    m_tiles[key] = tile;
+    m_generated++;
+
+    // The noise is the expensive part; let the other sims at the cache meanwhile.
+    {
+        r3::ScopedMutexReverse unlock(m_lock);
+        generate(*tile);
+    }
+
+    tile->ready = true;
+    m_lock.Broadcast();
+    return tile;
+}
+
+void TerrainTileCache::release(const Tile* tile)
+{
+    r3::ScopedMutex lock(m_lock);
+    assert(tile->refs > 0);
+    const_cast<Tile*>(tile)->refs--;
+}
+
+void TerrainTileCache::evict()
+{
+    // Drop the least recently used tile nobody holds.  If they are all held, the cache just grows for a while.
+    TileMap::iterator oldest = m_tiles.end();
+    for (TileMap::iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+    {
+        const Tile* tile = it->second;
+        if (tile->refs == 0 && (oldest == m_tiles.end() || tile->lastUse < oldest->second->lastUse))
+            oldest = it;
+    }
+
+    if (oldest != m_tiles.end())
+    {
+        delete oldest->second;
+        m_tiles.erase(oldest);
+    }
+}
+
+void TerrainTileCache::takeStats(int32_t& generated, int32_t& reused)
+{
+    r3::ScopedMutex lock(m_lock);
+    generated = m_generated;
+    reused = m_reused;
+    m_generated = m_reused = 0;
+}
+
+int32_t TerrainTileCache::getTileCount()
+{
+    r3::ScopedMutex lock(m_lock);
+    return (int32_t)m_tiles.size();
+}
+
+void TerrainTileCache::generate(Tile& tile)
+{
+    const Key& key = tile.key;
+    const int32_t x0 = key.tileX * TILE_SIZE;
+    const int32_t y0 = key.tileY * TILE_SIZE;
+
+    // One row of the tile per batched noise call
+    float u[TILE_SIZE], v[TILE_SIZE];
+    for (int32_t j=0; j<TILE_SIZE; j++)
+    {
+        float* h = tile.heights + j*TILE_SIZE;
+        for (int32_t i=0; i<TILE_SIZE; i++)
+        {
+            u[i] = ((float)(x0+i) - key.phaseX) * key.texelSizeX;
+            v[i] = ((float)(y0+j) - key.phaseY) * key.texelSizeY;
+        }
+
+        hybridTerrain(g_noiseGen, u, v, h, TILE_SIZE, key.octaves, key.ridgeOffset);
+        for (int32_t i=0; i<TILE_SIZE; i++)
+            h[i] *= (1+key.ridgeOffset);
+    }
+}
@@ -0,0 +1,107 @@
+//----------------------------------------------------------------------------------
+// File:        TextureArrayTerrain/TerrainTileCache.h
+// SDK Version: v1.2 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef _TERRAIN_TILE_CACHE_
+#define _TERRAIN_TILE_CACHE_
+
+#include <NvFoundation.h>
+
+
+#include <map>
+#include "R3/thread.h"
+
+// Caches the raw terrain noise in fixed size tiles of world texels, so that a TerrainSim only evaluates the fractal
+// for texels nobody has generated before.  Tiles are shared between all the TerrainSims (neighbouring sims overlap at
+// their edges and need each other's border texels for normals) and survive panning: a pan by whole texels maps onto
+// the same tiles, just at different places in the sim.  Height scale and offset are applied when a tile is copied
+// out, so changing those never regenerates anything.
+class TerrainTileCache
+{
+public:
+    // Tiles are TILE_SIZE x TILE_SIZE texels.
+    static const int32_t TILE_SIZE = 32;
+
+    // Everything the noise in one tile depends on.
+    struct Key
+    {
+        int32_t octaves;
+        float ridgeOffset;
+        float texelSizeX, texelSizeY;   // uv distance between neighbouring texels
+        float phaseX, phaseY;           // sub-texel part of the pan, in texels [0,1)
+        int32_t tileX, tileY;           // tile coordinate; texel X of the world lies in tile floor(X / TILE_SIZE)
+
+        bool operator<(const Key& rhs) const;
+    };
+
+    struct Tile
+    {
+        Key key;
+        float heights[TILE_SIZE * TILE_SIZE];   // unscaled, row-major
+
+    private:
+        friend class TerrainTileCache;
+        int32_t refs;
+        uint32_t lastUse;
+        bool ready;
+    };
+
+    TerrainTileCache(int32_t maxTiles);
+    ~TerrainTileCache();
+
+    // The cache shared by all the terrain sims.
+    static TerrainTileCache& get();
+
+    // Returns the tile for key, generating it first if it is not cached.  If another thread is already generating
+    // it, waits for that instead.  Every acquire must be matched with a release.  Thread-safe.
+    const Tile* acquire(const Key& key);
+    void release(const Tile* tile);
+
+    // Tiles generated and reused by acquire since the last call.
+    void takeStats(int32_t& generated, int32_t& reused);
+    int32_t getTileCount();
+
+private:
+    typedef std::map<Key, Tile*> TileMap;
+
+    void evict();
+    static void generate(Tile& tile);
+
+    r3::Condition m_lock;
+    TileMap m_tiles;
+    int32_t m_maxTiles;
+    uint32_t m_useClock;
+    int32_t m_generated, m_reused;
+};
+
+#endif
@@ -35,9 +35,13 @@
 #include "NV/NvStopWatch.h"
 #include "NvAssetLoader/NvAssetLoader.h"
 #include "NV/NvLogs.h"
-#include "TerrainGenerator.h"
+#include "TerrainStreamer.h"
+#include "TerrainTileCache.h"
+#include "NoiseBenchmark.h"
 #include "TextureArrayTerrain.h"
+#include "NvGLUtils/NvGridIndexBuffer.h"
 #include "NvGLUtils/NvImage.h"
+#include "NvGLUtils/NvVertexPacking.h"
 #include "NvUI/NvTweakBar.h"
 #include <assert.h>
 
@@ -92,7 +96,8 @@ void TextureArrayTerrain::SkyShader::derivedInitShaderParameters()
 TextureArrayTerrain::TerrainShader::TerrainShader(const char *vertexProgramPath, 
     const char *fragmentProgramPath ) :
     BaseShader(vertexProgramPath, fragmentProgramPath),        
-    m_normalAndHeightAttrHandle(-1),
+    m_heightAttrHandle(-1),
+    m_normalAttrHandle(-1),
     m_terrainTexHandle(-1),
     m_modelViewMatrixHandle(-1),
     m_interpOffsetHandle(-1)
@@ -102,7 +107,8 @@ TextureArrayTerrain::TerrainShader::TerrainShader(const char *vertexProgramPath,
 // virtual
 void TextureArrayTerrain::TerrainShader::derivedInitShaderParameters()
 {
-    m_normalAndHeightAttrHandle = getAttribLocation("g_vNormalAndHeight");
+    m_heightAttrHandle          = getAttribLocation("g_vHeight");
+    m_normalAttrHandle          = getAttribLocation("g_vNormal");
     m_modelViewMatrixHandle     = getUniformLocation("g_modelViewMatrix");
     m_terrainTexHandle          = getUniformLocation("g_terrainTex");
     m_interpOffsetHandle         = getUniformLocation("g_interpOffset");
@@ -111,7 +117,13 @@ void TextureArrayTerrain::TerrainShader::derivedInitShaderParameters()
 TextureArrayTerrain::TextureArrayTerrain(NvPlatformContext* platform) : 
     NvSampleApp(platform, "Texture Array Terrain"),
     m_pSkyShader(NULL),
-    m_pTerrainShader(NULL)
+    m_pTerrainShader(NULL),
+    m_pTerrain(NULL),
+    m_tilesRegeneratedText(NULL),
+    m_residentTilesText(NULL),
+    m_tileLatencyText(NULL),
+    m_terrainMemoryText(NULL),
+    m_statsFrame(0)
 {
     // Initialize some view parameters
     m_transformer->setRotationVec(nv::vec3f(0.0f, NV_PI*0.25f, 0.0f));
@@ -119,6 +131,9 @@ TextureArrayTerrain::TextureArrayTerrain(NvPlatformContext* platform) :
     m_transformer->setMaxTranslationVel(30.0f);
     m_transformer->setMotionMode(NvCameraMotionType::FIRST_PERSON);
 
+    // -noisebench times the batched terrain noise against the scalar noise, then exits
+    addBenchmarkMode("-noisebench", runNoiseBenchmark);
+
     // Required in all subclasses to avoid silent link issues
     forceLinkHack();
 }
@@ -150,6 +165,36 @@ void TextureArrayTerrain::initUI(void) {
         mTweakBar->addValue("Height Offset:", m_simParams.heightOffset, 0.0f, 6.0f);
         mTweakBar->addValue("Coord Offset:", m_simParams.uvOffset, 0.0f, 50.0f);
     }
+
+    // statistics
+    if (mFPSText) {
+        NvUIRect tr;
+        mFPSText->GetScreenRect(tr);
+        const float lineHeight = tr.height+8;
+        m_residentTilesText = new NvUIValueText("Resident tiles", NvUIFontFamily::SANS, mFPSText->GetFontSize(), NvUITextAlign::RIGHT,
+                                        (uint32_t)0, NvUITextAlign::RIGHT);
+        m_residentTilesText->SetColor(NV_PACKED_COLOR(0x30, 0xD0, 0xD0, 0xB0));
+        m_residentTilesText->SetShadow();
+        mUIWindow->Add(m_residentTilesText, tr.left, tr.top+lineHeight);
+
+        m_tileLatencyText = new NvUIValueText("Tile latency ms", NvUIFontFamily::SANS, mFPSText->GetFontSize(), NvUITextAlign::RIGHT,
+                                        0.0f, 1, NvUITextAlign::RIGHT);
+        m_tileLatencyText->SetColor(NV_PACKED_COLOR(0x30, 0xD0, 0xD0, 0xB0));
+        m_tileLatencyText->SetShadow();
+        mUIWindow->Add(m_tileLatencyText, tr.left, tr.top+2*lineHeight);
+
+        m_terrainMemoryText = new NvUIValueText("Terrain MB", NvUIFontFamily::SANS, mFPSText->GetFontSize(), NvUITextAlign::RIGHT,
+                                        0.0f, 1, NvUITextAlign::RIGHT);
+        m_terrainMemoryText->SetColor(NV_PACKED_COLOR(0x30, 0xD0, 0xD0, 0xB0));
+        m_terrainMemoryText->SetShadow();
+        mUIWindow->Add(m_terrainMemoryText, tr.left, tr.top+3*lineHeight);
+
+        m_tilesRegeneratedText = new NvUIValueText("Noise tiles generated", NvUIFontFamily::SANS, mFPSText->GetFontSize(), NvUITextAlign::RIGHT,
+                                        (uint32_t)0, NvUITextAlign::RIGHT);
+        m_tilesRegeneratedText->SetColor(NV_PACKED_COLOR(0x30, 0xD0, 0xD0, 0xB0));
+        m_tilesRegeneratedText->SetShadow();
+        mUIWindow->Add(m_tilesRegeneratedText, tr.left, tr.top+4*lineHeight);
+    }
 }
 
 void TextureArrayTerrain::initRendering(void) {
@@ -162,46 +207,6 @@ void TextureArrayTerrain::initRendering(void) {
         return;
     }
 
-    if ( api.majVersion >= 3 ) {
-        TerrainSimRenderer::glUnmapBufferPtr = (void (KHRONOS_APIENTRY *)(GLenum))
-            getGLContext()->getGLProcAddress("glUnmapBuffer");
-    }
-    else
-    {
-        TerrainSimRenderer::glUnmapBufferPtr = NULL;
-    }
-
-    if( requireExtension( "GL_NV_map_buffer_range", false ) )
-    {
-        TerrainSimRenderer::glMapBufferRangePtr = (void* (KHRONOS_APIENTRY *)(GLenum, GLintptr, GLsizeiptr, GLbitfield))
-            getGLContext()->getGLProcAddress("glMapBufferRangeNV");
-
-        if (!TerrainSimRenderer::glUnmapBufferPtr)
-        {
-            TerrainSimRenderer::glUnmapBufferPtr = (void (KHRONOS_APIENTRY *)(GLenum))
-                getGLContext()->getGLProcAddress("glUnmapBufferNV");
-        }
-    }
-    else if( requireExtension( "GL_EXT_map_buffer_range", false ) )
-    {
-        TerrainSimRenderer::glMapBufferRangePtr = (void* (KHRONOS_APIENTRY *)(GLenum, GLintptr, GLsizeiptr, GLbitfield))
-            getGLContext()->getGLProcAddress("glMapBufferRangeEXT");
-
-        if (!TerrainSimRenderer::glUnmapBufferPtr)
-        {
-            TerrainSimRenderer::glUnmapBufferPtr = (void (KHRONOS_APIENTRY *)(GLenum))
-                getGLContext()->getGLProcAddress("glUnmapBufferNV");
-        }
-    }
-    else
-    {
-        TerrainSimRenderer::glMapBufferRangePtr = (void* (KHRONOS_APIENTRY *)(GLenum, GLintptr, GLsizeiptr, GLbitfield))
-            getGLContext()->getGLProcAddress("glMapBufferRange");
-
-        TerrainSimRenderer::glUnmapBufferPtr = (void (KHRONOS_APIENTRY *)(GLenum))
-            getGLContext()->getGLProcAddress("glUnmapBuffer");
-    }
-
 #ifdef GL_OES_texture_3D
     if (requireExtension("GL_EXT_texture_array", false)) {
         glTexImage3DOES = (void (KHRONOS_APIENTRY *)(GLenum, GLint, GLint, GLsizei, GLsizei, GLsizei, GLint, GLenum, GLenum, const GLvoid*))
@@ -245,8 +250,8 @@ void TextureArrayTerrain::initRendering(void) {
     checkGlError("initShaders");
     LOGI("Loaded shaders");
 
-    const int32_t tileWidth = 128, tileHeight = 128;
-    initTerrainSurfaces(tileWidth, tileHeight, NUM_TILES);
+    const int32_t tileVertices = 33, maxTiles = 256;
+    initTerrainSurfaces(tileVertices, maxTiles);
     checkGlError("initTerrainSurfaces");
 
     glEnable(GL_DEPTH_TEST);
@@ -288,7 +293,7 @@ void TextureArrayTerrain::initRendering(void) {
 
 void TextureArrayTerrain::reshape(int32_t width, int32_t height)
 {
-    nv::perspective(m_projectionMatrix, 60.0f * TO_RADIANS,    (float) m_width / (float) m_height, 1.0f, 150.0f);
+    nv::perspective(m_projectionMatrix, 60.0f * TO_RADIANS,    (float) m_width / (float) m_height, 1.0f, 1000.0f);
 
     glViewport( 0, 0, (GLint) width, (GLint) height );
 
@@ -296,7 +301,7 @@ void TextureArrayTerrain::reshape(int32_t width, int32_t height)
     nv::perspective(m_projectionMatrix, NV_PI / 3.0f,
                     static_cast<float>(NvSampleApp::m_width) /
                     static_cast<float>(NvSampleApp::m_height),
-                    1.0f, 150.0f);
+                    1.0f, 1000.0f);
     m_inverseProjMatrix = nv::inverse(m_projectionMatrix);
 
     CHECK_GL_ERROR();
@@ -322,6 +327,7 @@ void TextureArrayTerrain::draw(void)
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     drawTerrainSurfaces();
+    updateTileStats();
 
     // Sky box last with depth test enabled to avoid unnecessary fill.
     const nv::matrix4f invViewMatrix = nv::inverse(m_viewMatrix);
@@ -361,58 +367,75 @@ void TextureArrayTerrain::destroyShaders()
     m_pTerrainShader = NULL;
 }
 
-void TextureArrayTerrain::updateBufferData()
+void TextureArrayTerrain::updateTileStats()
 {
-    for(int32_t i=0; i<NUM_TILES; i++)
-        m_ppTerrain[i]->updateBufferData();
+    // Noise tiles the simulation jobs generated (rather than found in the cache) since the last frame
+    int32_t generated, reused;
+    TerrainTileCache::get().takeStats(generated, reused);
+
+    if (m_tilesRegeneratedText)
+        m_tilesRegeneratedText->SetValue((uint32_t)generated);
+
+    const TerrainStreamer::Stats& stats = m_pTerrain->getStats();
+    const float terrainMB = (stats.gpuBytes + stats.cpuBytes) / (1024.0f * 1024.0f);
+
+    if (m_residentTilesText)
+        m_residentTilesText->SetValue((uint32_t)stats.residentTiles);
+    if (m_tileLatencyText)
+        m_tileLatencyText->SetValue(stats.latencyMeanMs);
+    if (m_terrainMemoryText)
+        m_terrainMemoryText->SetValue(terrainMB);
+
+    // A summary every couple of seconds while tiles are streaming in
+    m_statsFrame++;
+    if (stats.completedTiles > 0 && m_statsFrame >= 120)
+    {
+        m_statsFrame = 0;
+        LOGI("Terrain: %d resident, %d drawn, %d generating, %d queued, request to draw %.1f ms (max %.1f), %.1f MB; "
+            "noise tiles: %d generated, %d reused, %d cached",
+            stats.residentTiles, stats.drawnTiles, stats.generatingTiles, stats.queuedTiles,
+            stats.latencyMeanMs, stats.latencyMaxMs, terrainMB,
+            generated, reused, TerrainTileCache::get().getTileCount());
+    }
 }
 
-void TextureArrayTerrain::initTerrainSurfaces(int32_t w, int32_t h, int32_t numTiles)
+nv::vec3f TextureArrayTerrain::getEyePosition()
 {
-    TerrainSimThread::resetCounter();
-
-    m_ppTerrain = new TerrainGenerator*[numTiles];
-
-    const int32_t tilesOnEdge = (int32_t)sqrtf((float)numTiles);
-    const float halfTilesOnEdge = (float) tilesOnEdge / 2.0f;
-    assert(tilesOnEdge*tilesOnEdge == numTiles);
+    const nv::matrix4f invViewMatrix = nv::inverse(m_viewMatrix);
+    return nv::vec3f(invViewMatrix._array[12], invViewMatrix._array[13], invViewMatrix._array[14]);
+}
 
-    for (int32_t x=0; x<tilesOnEdge; ++x)
-    {
-        for (int32_t y=0; y<tilesOnEdge; ++y)
-        {
-            // This is a translation that positions each tile uniquely in a grid layout.  We have this instead of a model matrix.
-            const nv::vec2f offset(x-halfTilesOnEdge+1.0f, y-halfTilesOnEdge+1.0f);
-            const int32_t i = x+y*tilesOnEdge;
+float TextureArrayTerrain::getPixelsPerUnit()
+{
+    // Matches the 60 degree vertical field of view set up in reshape.  m_height is not set until the
+    // first reshape, which comes after initRendering
+    return (float)getGLContext()->height() * 0.5f / tanf(30.0f * TO_RADIANS);
+}
 
-            LOGI("Creating tile at offset (%f,%f)", offset.x, offset.y);
-            m_ppTerrain[i] = new TerrainGenerator(w, h, offset, createStopWatch());
+void TextureArrayTerrain::initTerrainSurfaces(int32_t tileVertices, int32_t maxTiles)
+{
+    m_pTerrain = new TerrainStreamer(tileVertices, maxTiles);
+    m_pTerrain->setParams(m_simParams);
 
-            // Copy our master set of params down to every sim.
-            m_ppTerrain[i]->getSimulation().initParams(m_simParams);
-        }
-    }
-        
-    LOGI("\nCreated %d terrain tile(s) with resolution [%dx%d]\n", numTiles, w, h);
+    // Generate what the first frame draws up front, so the sample does not start on an empty world
+    m_viewMatrix = m_transformer->getModelViewMat();
+    m_pTerrain->prime(getEyePosition(), getPixelsPerUnit());
+
+    const TerrainStreamer::Stats& stats = m_pTerrain->getStats();
+    LOGI("\nPrimed %d terrain tile(s) with resolution [%dx%d], %.1f MB\n", stats.residentTiles, tileVertices, tileVertices,
+        (stats.gpuBytes + stats.cpuBytes) / (1024.0f * 1024.0f));
+    LOGI("Terrain indices: %d KB in %d shared buffer(s), %d KB if unshared\n", (int32_t)(NvGridIndexBuffer::getTotalBytes() / 1024),
+        NvGridIndexBuffer::getBufferCount(), (int32_t)(NvGridIndexBuffer::getUnsharedBytes() / 1024));
+    LOGI("Terrain vertices: %d bytes streamed per vertex (%d as float4), %s\n",
+        (int32_t)NvVertexPacking::getVertexSize(), (int32_t)(4 * sizeof(float)),
+        NvVertexPacking::isSupported() ? NvVertexPacking::getSIMDName() : "no half float attributes");
 }
 
 // Nothing in the native template seems to call this?  Should it?  Probably.
 void TextureArrayTerrain::deleteTerrainSurfaces()
 {
-    if (!m_ppTerrain)
-        return;
-
-    for(int32_t i=0; i<NUM_TILES; i++)
-        m_ppTerrain[i]->getThread().stop();
-
-    TerrainGenerator::syncAllSimulationThreads();
-    TerrainGenerator::waitForAllThreadsToExit();
-
-    for(int32_t i=0; i<NUM_TILES; i++)
-        delete m_ppTerrain[i];
-
-    delete [] m_ppTerrain;
-    m_ppTerrain = NULL;
+    delete m_pTerrain;
+    m_pTerrain = NULL;
 }
 
 void TextureArrayTerrain::drawSkyBox(const nv::matrix4f& invViewMatrix)
@@ -480,17 +503,14 @@ void TextureArrayTerrain::renderTerrainSurfaces()
     printMatrixLog(appState().m_normalMatrix);
     */
 
-    int32_t nVtx = 0;
-    for(int32_t i=0; i<NUM_TILES; i++)
-    {
-        nVtx = m_ppTerrain[i]->render(pShader->m_positionAttrHandle, pShader->m_normalAndHeightAttrHandle);
-        // Too much spew: LOGI("Number of terrain vertices=%d", nVtx);
-        checkGlError("glDrawElements", "renderTerrainSurfaces");
-    }
+    int32_t nVtx = m_pTerrain->render(pShader->m_positionAttrHandle, pShader->m_heightAttrHandle, pShader->m_normalAttrHandle);
+    // Too much spew: LOGI("Number of terrain vertices=%d", nVtx);
+    checkGlError("glDrawElements", "renderTerrainSurfaces");
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glDisableVertexAttribArray(pShader->m_positionAttrHandle);
-    glDisableVertexAttribArray(pShader->m_normalAndHeightAttrHandle);
+    glDisableVertexAttribArray(pShader->m_heightAttrHandle);
+    glDisableVertexAttribArray(pShader->m_normalAttrHandle);
     glBindTexture(GL_TEXTURE_2D_ARRAY_EXT, 0);
     glUseProgram(0);
     checkGlError("end", "renderTerrainSurfaces");
@@ -498,20 +518,11 @@ void TextureArrayTerrain::renderTerrainSurfaces()
 
 void TextureArrayTerrain::drawTerrainSurfaces()
 {
-    // Multi-threaded start all simulation threads
-    for(int32_t i=0; i<NUM_TILES; i++)
-    {
-        m_ppTerrain[i]->getSimulation().setParams(m_simParams);
-
-        if( m_ppTerrain[i]->getSimulation().dirtyParams() )
-        {
-            m_ppTerrain[i]->startSimulationThread();
-        }
-    }
-    
-    // Note this update is not sychronised with the sim threads.  I don't care if the rendered result is a bit
-    // inconsistent while the GUI is being manipulated.
-    updateBufferData();
+    // Picks up finished tiles, selects the tiles to draw for this camera and queues jobs for the missing
+    // ones.  Tiles still generating are covered by their parent, so the GUI stays interactive while the
+    // terrain catches up.
+    m_pTerrain->setParams(m_simParams);
+    m_pTerrain->update(getEyePosition(), getPixelsPerUnit());
     renderTerrainSurfaces();
 }
 
@@ -43,7 +43,7 @@
 class NvStopWatch;
 class NvFramerateCounter;
 
-class TerrainGenerator;
+class TerrainStreamer;
 
 class TextureArrayTerrain : public NvSampleApp
 {
@@ -90,7 +90,8 @@ private:
             const char *fragmentProgramPath );
 
         virtual void derivedInitShaderParameters();
-        GLint m_normalAndHeightAttrHandle;
+        GLint m_heightAttrHandle;
+        GLint m_normalAttrHandle;
         GLint m_terrainTexHandle;
         GLint m_modelViewMatrixHandle;
         GLint m_interpOffsetHandle;
@@ -98,12 +99,14 @@ private:
     
     void createShaders();
     void destroyShaders();
-    void updateBufferData();
-    void initTerrainSurfaces(int32_t w, int32_t h, int32_t numTiles);
+    void initTerrainSurfaces(int32_t tileVertices, int32_t maxTiles);
     void deleteTerrainSurfaces();
     void drawSkyBox(const nv::matrix4f& invViewMatrix);
     void drawTerrainSurfaces();
     void renderTerrainSurfaces();
+    void updateTileStats();
+    nv::vec3f getEyePosition();
+    float getPixelsPerUnit();
 
     bool m_showOptions;
 
@@ -122,12 +125,16 @@ private:
 
     bool m_pausedByPerfHUD;
 
-    TerrainGenerator **m_ppTerrain;
+    TerrainStreamer* m_pTerrain;
+
+    NvUIValueText* m_tilesRegeneratedText;
+    NvUIValueText* m_residentTilesText;
+    NvUIValueText* m_tileLatencyText;
+    NvUIValueText* m_terrainMemoryText;
+    int32_t m_statsFrame;
 
     GLuint m_SkyTexture;
     GLuint m_TerrainTexture;
 
-    const static int32_t NUM_TILES = 9;
-
     bool m_paused;
 };
\ No newline at end of file
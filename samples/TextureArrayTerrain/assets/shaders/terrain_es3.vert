@@ -36,15 +36,25 @@ uniform mat4 g_modelViewMatrix;
 uniform mat4 g_projectionMatrix;
 
 in vec2  g_vPosition;            // Static attrs: only stores XZ here, Y below.
-in vec4  g_vNormalAndHeight;        // Dynamic attrs: interleaved is most efficient.
+in float g_vHeight;              // Dynamic attrs: interleaved is most efficient, half (or float) height...
+in vec2  g_vNormal;              // ...and the normal, octahedral in two signed bytes (or floats).
 
 out vec4 texCoord;
 out vec3 normal;
 
+// Inverse of the octahedral mapping in NvVertexPacking, y up
+vec3 decodeNormal(vec2 e)
+{
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (n.y < 0.0)
+        n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
 void main()
 {
-    normal = g_vNormalAndHeight.xyz;
-    float height = g_vNormalAndHeight.w;
+    normal = decodeNormal(g_vNormal);
+    float height = g_vHeight;
     
     vec4 vPosEyeSpace = g_modelViewMatrix * vec4(g_vPosition.x, height, g_vPosition.y, 1.0);
     gl_Position = g_projectionMatrix * vPosEyeSpace;
@@ -52,7 +62,7 @@ void main()
     float u = g_vPosition.x / 8.0;
     float v = g_vPosition.y / 8.0;
     float slice = height / 1.5;
-    float cliff = smoothstep(0.1, 0.8, 1.0-g_vNormalAndHeight.y);
+    float cliff = smoothstep(0.1, 0.8, 1.0-normal.y);
     
     // Snow starts to fade into the slice below it.
     float snowSlice = 2.0;
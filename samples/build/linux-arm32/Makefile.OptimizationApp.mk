@@ -1,11 +1,14 @@
 # Makefile generated by XPJ for linux-arm32
 -include Makefile.custom
 ProjectName = OptimizationApp
+OptimizationApp_cppfiles   += ./../../OptimizationApp/AutoQualityTest.cpp
 OptimizationApp_cppfiles   += ./../../OptimizationApp/IceRevisitedRadix.cpp
 OptimizationApp_cppfiles   += ./../../OptimizationApp/OptimizationApp.cpp
+OptimizationApp_cppfiles   += ./../../OptimizationApp/ParticleBenchmark.cpp
 OptimizationApp_cppfiles   += ./../../OptimizationApp/ParticleRenderer.cpp
 OptimizationApp_cppfiles   += ./../../OptimizationApp/ParticleSystem.cpp
 OptimizationApp_cppfiles   += ./../../OptimizationApp/SceneRenderer.cpp
+OptimizationApp_cppfiles   += ./../../OptimizationApp/SortBenchmark.cpp
 OptimizationApp_cppfiles   += ./../../OptimizationApp/Terrain.cpp
 OptimizationApp_cppfiles   += ./../../OptimizationApp/Upsampler.cpp
 OptimizationApp_cppfiles   += ./../../OptimizationApp/scene.cpp
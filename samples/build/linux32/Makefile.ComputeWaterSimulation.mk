@@ -4,8 +4,8 @@ ProjectName = ComputeWaterSimulation
 ComputeWaterSimulation_cppfiles   += ./../../ComputeWaterSimulation/ComputeWaterSimulation.cpp
 ComputeWaterSimulation_cppfiles   += ./../../ComputeWaterSimulation/Wave.cpp
 ComputeWaterSimulation_cppfiles   += ./../../ComputeWaterSimulation/WaveSim.cpp
+ComputeWaterSimulation_cppfiles   += ./../../ComputeWaterSimulation/WaveSimBenchmark.cpp
 ComputeWaterSimulation_cppfiles   += ./../../ComputeWaterSimulation/WaveSimRenderer.cpp
-ComputeWaterSimulation_cppfiles   += ./../../ComputeWaterSimulation/WaveSimThread.cpp
 ComputeWaterSimulation_cppfiles   += ./../../ComputeWaterSimulation/noise.cpp
 
 ComputeWaterSimulation_cpp_debug_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.debug.P, $(ComputeWaterSimulation_cppfiles)))))
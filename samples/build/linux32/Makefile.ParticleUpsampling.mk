@@ -1,7 +1,6 @@
 # Makefile generated by XPJ for linux32
 -include Makefile.custom
 ProjectName = ParticleUpsampling
-ParticleUpsampling_cppfiles   += ./../../ParticleUpsampling/IceRevisitedRadix.cpp
 ParticleUpsampling_cppfiles   += ./../../ParticleUpsampling/ParticleRenderer.cpp
 ParticleUpsampling_cppfiles   += ./../../ParticleUpsampling/ParticleSystem.cpp
 ParticleUpsampling_cppfiles   += ./../../ParticleUpsampling/ParticleUpsampling.cpp
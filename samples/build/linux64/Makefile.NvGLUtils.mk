@@ -4,11 +4,20 @@ ProjectName = NvGLUtils
 NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/BlockDXT.cpp
 NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/ColorBlock.cpp
 NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvFilePtr.cpp
+NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvGLSLPreprocessor.cpp
 NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvGLSLProgram.cpp
+NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvGLSLProgramRegistry.cpp
+NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvGLSLShaderWatcher.cpp
+NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvGPUSort.cpp
+NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvGridIndexBuffer.cpp
 NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvImage.cpp
 NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvImageDDS.cpp
 NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvImageGL.cpp
+NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvMultiDraw.cpp
+NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvProfiler.cpp
+NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvStreamingBuffer.cpp
 NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvTimers.cpp
+NvGLUtils_cppfiles   += ./../../../extensions/src/NvGLUtils/NvVertexPacking.cpp
 
 NvGLUtils_cpp_debug_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.debug.P, $(NvGLUtils_cppfiles)))))
 NvGLUtils_c_debug_dep      = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.debug.P, $(NvGLUtils_cfiles)))))
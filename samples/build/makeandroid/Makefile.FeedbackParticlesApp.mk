@@ -1,8 +1,10 @@
 # Makefile generated by XPJ for android
 -include Makefile.custom
 ProjectName = FeedbackParticlesApp
+FeedbackParticlesApp_cppfiles   += ./../../FeedbackParticlesApp/CPUParticles.cpp
 FeedbackParticlesApp_cppfiles   += ./../../FeedbackParticlesApp/FeedbackParticlesApp.cpp
 FeedbackParticlesApp_cppfiles   += ./../../FeedbackParticlesApp/FeedbackParticlesScene.cpp
+FeedbackParticlesApp_cppfiles   += ./../../FeedbackParticlesApp/ParticleBenchmark.cpp
 FeedbackParticlesApp_cppfiles   += ./../../FeedbackParticlesApp/ParticleSystem.cpp
 FeedbackParticlesApp_cppfiles   += ./../../FeedbackParticlesApp/TextureUtils.cpp
 FeedbackParticlesApp_cppfiles   += ./../../FeedbackParticlesApp/Utils.cpp
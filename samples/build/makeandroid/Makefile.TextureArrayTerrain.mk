@@ -1,10 +1,12 @@
 # Makefile generated by XPJ for android
 -include Makefile.custom
 ProjectName = TextureArrayTerrain
+TextureArrayTerrain_cppfiles   += ./../../TextureArrayTerrain/NoiseBenchmark.cpp
 TextureArrayTerrain_cppfiles   += ./../../TextureArrayTerrain/TerrainGenerator.cpp
 TextureArrayTerrain_cppfiles   += ./../../TextureArrayTerrain/TerrainSim.cpp
 TextureArrayTerrain_cppfiles   += ./../../TextureArrayTerrain/TerrainSimRenderer.cpp
-TextureArrayTerrain_cppfiles   += ./../../TextureArrayTerrain/TerrainSimThread.cpp
+TextureArrayTerrain_cppfiles   += ./../../TextureArrayTerrain/TerrainStreamer.cpp
+TextureArrayTerrain_cppfiles   += ./../../TextureArrayTerrain/TerrainTileCache.cpp
 TextureArrayTerrain_cppfiles   += ./../../TextureArrayTerrain/TextureArrayTerrain.cpp
 
 TextureArrayTerrain_cpp_debug_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.debug.P, $(TextureArrayTerrain_cppfiles)))))
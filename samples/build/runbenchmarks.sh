@@ -0,0 +1,149 @@
+#!/bin/bash
+#----------------------------------------------------------------------------------
+# File:        build/runbenchmarks.sh
+# SDK Version: v1.2
+# Email:       gameworks@nvidia.com
+# Site:        http://developer.nvidia.com/
+#
+# Copyright (c) 2014, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+#----------------------------------------------------------------------------------
+#
+# Runs each Linux sample headless (EGL pbuffer, no window or X display) in test
+# mode for a fixed number of frames at a fixed resolution, and combines the
+# per-sample frame time reports into report.json and report.txt.
+#
+# Works with a software rasterizer (e.g. Mesa llvmpipe), so CPU-side frame cost
+# can be tracked on machines without a GPU.
+#
+# usage: runbenchmarks.sh [options] [sample ...]
+#   -platform <dir>    binary directory under samples/bin (default linux64)
+#   -frames <n>        timed frames per sample (default 300)
+#   -size <w>x<h>      render resolution (default 1280x720)
+#   -out <dir>         output directory (default ./benchmarks)
+#   -baseline <dir>    compare against <dir>/<sample>.json from an earlier run
+#   -tolerance <pct>   allowed regression against the baseline (default 5)
+#   -timeout <sec>     per-sample time limit (default 600)
+# With no samples listed, every release binary in the platform directory is run.
+# Exits with status 1 if any sample fails, crashes or regresses.
+
+PLATFORM=linux64
+FRAMES=300
+WIDTH=1280
+HEIGHT=720
+OUT=./benchmarks
+BASELINE=
+TOLERANCE=5
+TIMEOUT=600
+SAMPLES=
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -platform) PLATFORM="$2"; shift ;;
+        -frames) FRAMES="$2"; shift ;;
+        -size) WIDTH="${2%x*}"; HEIGHT="${2#*x}"; shift ;;
+        -out) OUT="$2"; shift ;;
+        -baseline) BASELINE="$2"; shift ;;
+        -tolerance) TOLERANCE="$2"; shift ;;
+        -timeout) TIMEOUT="$2"; shift ;;
+        -*) echo "unknown option $1" >&2; exit 2 ;;
+        *) SAMPLES="$SAMPLES $1" ;;
+    esac
+    shift
+done
+
+BINDIR="$(cd "$(dirname "$0")/../bin/$PLATFORM" 2>/dev/null && pwd)"
+if [ -z "$BINDIR" ]; then
+    echo "no binaries in samples/bin/$PLATFORM; build the samples first" >&2
+    exit 2
+fi
+
+mkdir -p "$OUT"
+OUT="$(cd "$OUT" && pwd)"
+[ -n "$BASELINE" ] && BASELINE="$(cd "$BASELINE" && pwd)"
+
+if [ -z "$SAMPLES" ]; then
+    # release binaries only; debug builds carry a trailing D
+    for f in "$BINDIR"/*; do
+        name="$(basename "$f")"
+        if [ -x "$f" ] && [ -f "$f" ] && [ -e "$BINDIR/${name}D" -o "${name%D}" = "$name" ]; then
+            SAMPLES="$SAMPLES $name"
+        fi
+    done
+fi
+
+FAILED=0
+JSON="$OUT/report.json"
+TEXT="$OUT/report.txt"
+
+echo "{" > "$JSON"
+echo "  \"platform\": \"$PLATFORM\", \"frames\": $FRAMES, \"width\": $WIDTH, \"height\": $HEIGHT," >> "$JSON"
+echo "  \"samples\": {" >> "$JSON"
+printf "%-28s %-10s %s\n" "sample" "status" "CPU frame ms" > "$TEXT"
+
+first=1
+for name in $SAMPLES; do
+    echo "=== $name"
+    rm -f "$OUT/$name.txt" "$OUT/$name.json" "$OUT/$name.csv"
+
+    args="-headless -w $WIDTH -h $HEIGHT -testmode 1e9 $OUT/$name -testframes $FRAMES"
+    if [ -n "$BASELINE" ] && [ -f "$BASELINE/$name.json" ]; then
+        args="$args -baseline $BASELINE/$name.json -tolerance $TOLERANCE"
+    fi
+
+    # samples find their assets relative to the binary directory
+    (cd "$BINDIR" && timeout "$TIMEOUT" "./$name" $args) > "$OUT/$name.out" 2>&1
+    status=$?
+
+    case $status in
+        0) result=ok ;;
+        1) result=regressed ;;
+        124) result=timeout ;;
+        *) result="crashed($status)" ;;
+    esac
+    [ -f "$OUT/$name.json" ] || { [ $status -eq 0 ] && result=noreport; }
+    [ "$result" != ok ] && FAILED=1
+
+    [ $first -eq 0 ] && echo "    ," >> "$JSON"
+    first=0
+    echo "    \"$name\": { \"status\": \"$result\", \"report\":" >> "$JSON"
+    if [ -f "$OUT/$name.json" ]; then
+        cat "$OUT/$name.json" >> "$JSON"
+    else
+        echo "null" >> "$JSON"
+    fi
+    echo "    }" >> "$JSON"
+
+    summary="$(grep -m1 "^CPU frame ms:" "$OUT/$name.txt" 2>/dev/null | sed 's/^CPU frame ms: //')"
+    printf "%-28s %-10s %s\n" "$name" "$result" "$summary" >> "$TEXT"
+done
+
+echo "  }" >> "$JSON"
+echo "}" >> "$JSON"
+
+cat "$TEXT"
+exit $FAILED